@@ -0,0 +1,48 @@
+#!/bin/bash
+# Renders every scene found in a folder with tcomposer, once per thread count,
+# and collects the JSON reports written by tcomposer's -benchmark qualifier.
+#
+#   benchmark.sh <tcomposer> <scenes folder> <output folder> [thread counts]
+#
+# If the scenes folder doesn't exist, the synthetic scene set (vector, strokes,
+# tlv, fxdag, particles, bokeh, pegbars, plastic) is first written there by
+# tcomposer's -makebenchmarkscenes switch.
+#
+# Thread counts default to "1 all". Runs headless: no X server nor GPU needed.
+# Extra tcomposer options (e.g. "-shrink 2" or "-maxtilesize 64") can be
+# passed through the TCOMPOSER_ARGS environment variable.
+
+if [ $# -lt 3 ]; then
+    echo "usage: $0 <tcomposer> <scenes folder> <output folder> [thread counts]"
+    exit 1
+fi
+
+TCOMPOSER=$1
+SCENES=$2
+OUTPUT=$3
+shift 3
+THREADS=${@:-1 all}
+
+export QT_QPA_PLATFORM=offscreen
+
+if [ ! -d "$SCENES" ]; then
+    echo "== Writing the benchmark scenes to $SCENES"
+    "$TCOMPOSER" -makebenchmarkscenes "$SCENES" || exit 1
+fi
+
+mkdir -p "$OUTPUT/renders" "$OUTPUT/reports"
+
+STATUS=0
+for SCENE in "$SCENES"/*.tnz; do
+    NAME=$(basename "$SCENE" .tnz)
+    for N in $THREADS; do
+        echo "== $NAME, $N threads"
+        "$TCOMPOSER" "$SCENE" \
+            -o "$OUTPUT/renders/$NAME.tif" \
+            -nthreads $N \
+            -benchmark "$OUTPUT/reports/${NAME}_$N.json" \
+            $TCOMPOSER_ARGS || STATUS=1
+    done
+done
+
+exit $STATUS
@@ -9,6 +9,14 @@
 #include "trop.h"
 #include "tpixelutils.h"
 
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QMutex>
+
+#include <algorithm>
+#include <thread>
+
 /*
   The entire content of this file is ridden with LEAKS. A bug has been filed,
   will hopefully
@@ -51,8 +59,45 @@ static char swapByte(unsigned char src) {
   return out;
 }
 
+//----------------------------------------------------------------------------
+
+namespace {
+
+// Layer records and channel offsets of the PSDs read so far. Every layer level
+// taken from a PSD builds its own reader (and a parser, which builds another
+// one): they all share the index of the file instead of scanning it again.
+// Entries are never freed, since the layer records they point to are shared by
+// live readers.
+struct PsdIndex {
+  qint64 m_size;
+  QDateTime m_lastModified;
+  TPSDHeaderInfo m_headerInfo;
+  std::vector<psdByte> m_layerDataPos;
+};
+
+QMutex indexMutex;
+std::map<TFilePath, PsdIndex> indexTable;
+
+#if (defined(x64) || defined(__LP64__))
+bool memoryMapping = true;
+#else
+bool memoryMapping = false;  // spare the address space
+#endif
+
+}  // namespace
+
+//----------------------------------------------------------------------------
+
+void TPSDReader::enableMemoryMapping(bool enabled) { memoryMapping = enabled; }
+
+bool TPSDReader::isMemoryMappingEnabled() { return memoryMapping; }
+
 TPSDReader::TPSDReader(const TFilePath &path)
-    : m_shrinkX(1), m_shrinkY(1), m_region(TRect()) {
+    : m_shrinkX(1)
+    , m_shrinkY(1)
+    , m_region(TRect())
+    , m_mappedData(0)
+    , m_mappedSize(0) {
   m_layerId    = 0;
   QString name = path.getName().c_str();
   name.append(path.getDottedType().c_str());
@@ -62,12 +107,43 @@ TPSDReader::TPSDReader(const TFilePath &path)
   m_path = path.getParentDir() + TFilePath(name.toStdString());
   // m_path = path;
   QMutexLocker sl(&m_mutex);
+  QFileInfo fileInfo(m_path.getQString());
+  {
+    QMutexLocker il(&indexMutex);
+    std::map<TFilePath, PsdIndex>::const_iterator it = indexTable.find(m_path);
+    if (it != indexTable.end() && it->second.m_size == fileInfo.size() &&
+        it->second.m_lastModified == fileInfo.lastModified()) {
+      m_headerInfo   = it->second.m_headerInfo;
+      m_layerDataPos = it->second.m_layerDataPos;
+      return;
+    }
+  }
   openFile();
   if (!doInfo()) {
     fclose(m_file);
     throw TImageException(m_path, "Do PSD INFO ERROR");
   }
   fclose(m_file);
+
+  // layers data follow the last layer record, in the same order
+  if (m_headerInfo.layersCount > 0) {
+    TPSDLayerInfo *lilast = &m_headerInfo.linfo[m_headerInfo.layersCount - 1];
+    psdByte pos           = lilast->additionalpos + lilast->additionallen;
+    m_layerDataPos.resize(m_headerInfo.layersCount);
+    for (int i = 0; i < m_headerInfo.layersCount; i++) {
+      m_layerDataPos[i] = pos;
+      TPSDLayerInfo *li = &m_headerInfo.linfo[i];
+      for (int ch = 0; ch < li->channels; ch++) pos += li->chan[ch].length;
+    }
+  }
+
+  PsdIndex index;
+  index.m_size         = fileInfo.size();
+  index.m_lastModified = fileInfo.lastModified();
+  index.m_headerInfo   = m_headerInfo;
+  index.m_layerDataPos = m_layerDataPos;
+  QMutexLocker il(&indexMutex);
+  indexTable[m_path] = index;
 }
 TPSDReader::~TPSDReader() {
   /*for(int i=0; i<m_headerInfo.layersCount;i++)
@@ -324,19 +400,8 @@ void TPSDReader::doImage(TRasterP &rasP, int layerId) {
   psdByte imageDataEnd;
   // retrieve start data pos
   psdByte startPos = ftell(m_file);
-  if (m_headerInfo.layersCount > 0) {
-    struct TPSDLayerInfo *lilast =
-        &m_headerInfo.linfo[m_headerInfo.layersCount - 1];
-    startPos = lilast->additionalpos + lilast->additionallen;
-  }
-  if (layerIndex > 0) {
-    for (int j = 0; j < layerIndex; j++) {
-      struct TPSDLayerInfo *liprev = &m_headerInfo.linfo[j];
-      for (int ch = 0; ch < liprev->channels; ch++) {
-        startPos += liprev->chan[ch].length;
-      }
-    }
-  }
+  if (m_headerInfo.layersCount > 0)
+    startPos = m_layerDataPos[std::max(layerIndex, 0)];
   fseek(m_file, startPos, SEEK_SET);
 
   long pixw    = li ? li->right - li->left : m_headerInfo.cols;
@@ -396,19 +461,34 @@ void TPSDReader::doImage(TRasterP &rasP, int layerId) {
   }
 
   if (!li || m_headerInfo.linfoBlockEmpty) {  // merged channel
-    TPSDChannelInfo *mergedChans =
-        (TPSDChannelInfo *)mymalloc(channels * sizeof(struct TPSDChannelInfo));
+    std::vector<TPSDChannelInfo> mergedChans(channels);
+    for (ch = 0; ch < channels; ++ch) {
+      mergedChans[ch].rowpos    = NULL;
+      mergedChans[ch].unzipdata = NULL;
+    }
 
-    readChannel(m_file, NULL, mergedChans, channels, &m_headerInfo);
+    readChannel(m_file, NULL, &mergedChans[0], channels, &m_headerInfo);
     imageDataEnd = ftell(m_file);
-    readImageData(rasP, NULL, mergedChans, tnzchannels, rows, cols);
-    free(mergedChans);
+    readImageData(rasP, NULL, &mergedChans[0], tnzchannels, rows, cols);
+    for (ch = 0; ch < channels; ++ch) {
+      free(mergedChans[ch].rowpos);
+      free(mergedChans[ch].unzipdata);
+    }
   } else {
+    // the layer records may be shared with other readers: decode through a
+    // copy of the channels info
+    std::vector<TPSDChannelInfo> chans(li->chan, li->chan + channels);
     for (ch = 0; ch < channels; ++ch) {
-      readChannel(m_file, li, li->chan + ch, 1, &m_headerInfo);
+      chans[ch].rowpos    = NULL;
+      chans[ch].unzipdata = NULL;
+      readChannel(m_file, li, &chans[ch], 1, &m_headerInfo);
     }
     imageDataEnd = ftell(m_file);
-    readImageData(rasP, li, li->chan, tnzchannels, rows, cols);
+    readImageData(rasP, li, &chans[0], tnzchannels, rows, cols);
+    for (ch = 0; ch < channels; ++ch) {
+      free(chans[ch].rowpos);
+      free(chans[ch].unzipdata);
+    }
   }
   fseek(m_file, imageDataEnd, SEEK_SET);
 
@@ -434,7 +514,16 @@ void TPSDReader::load(TRasterImageP &img, int layerId) {
   try {
     TRasterP rasP;
     openFile();
+    QFile mappedFile(m_path.getQString());
+    m_mappedData = 0;
+    m_mappedSize = 0;
+    if (memoryMapping && mappedFile.open(QIODevice::ReadOnly)) {
+      m_mappedData = mappedFile.map(0, mappedFile.size());
+      m_mappedSize = m_mappedData ? mappedFile.size() : 0;
+    }
     doImage(rasP, layerId);
+    m_mappedData = 0;
+    m_mappedSize = 0;
     fclose(m_file);
     /*
     // do savebox
@@ -492,6 +581,56 @@ void TPSDReader::load(TRasterImageP &img, int layerId) {
   }
 }
 
+// Reads the compressed rows needed from the RLE channels in one go, then
+// unpacks the channels in parallel. readrow() will just copy the rows out.
+void TPSDReader::unpackRleChannels(TPSDChannelInfo *chan, const int *map,
+                                   int chancount, psdPixel firstRow,
+                                   psdPixel step, psdPixel count) {
+  if (count <= 0) return;
+
+  std::vector<TPSDChannelInfo *> chans;
+  std::vector<const unsigned char *> rledata;
+  std::vector<psdByte> datapos;
+  std::vector<std::vector<unsigned char>> buffers;
+  buffers.reserve(chancount);
+
+  for (int ch = 0; ch < chancount; ++ch) {
+    if (map[ch] < 0 || map[ch] > chancount) continue;
+    TPSDChannelInfo *c = chan + map[ch];
+    if (c->comptype != RLECOMP || c->unzipdata || firstRow >= c->rows)
+      continue;
+
+    psdPixel lastRow = std::min(firstRow + (count - 1) * step, c->rows - 1);
+    psdByte begin    = c->rowpos[firstRow];
+    psdByte end      = c->rowpos[lastRow + 1];
+    if (end <= begin) continue;
+
+    const unsigned char *data;
+    if (m_mappedData && end <= m_mappedSize)
+      data = m_mappedData + begin;
+    else {
+      buffers.push_back(std::vector<unsigned char>(end - begin));
+      fseek(m_file, begin, SEEK_SET);
+      fread(&buffers.back()[0], 1, end - begin, m_file);
+      data = &buffers.back()[0];
+    }
+
+    c->unzipdata = (unsigned char *)calloc(c->rows, c->rowbytes);
+    if (!c->unzipdata) continue;
+    chans.push_back(c);
+    rledata.push_back(data);
+    datapos.push_back(begin);
+  }
+  if (chans.empty()) return;
+
+  std::vector<std::thread> threads;
+  for (int i = 1; i < (int)chans.size(); ++i)
+    threads.push_back(std::thread(unpackrows, chans[i], rledata[i], datapos[i],
+                                  firstRow, step, count));
+  unpackrows(chans[0], rledata[0], datapos[0], firstRow, step, count);
+  for (int i = 0; i < (int)threads.size(); ++i) threads[i].join();
+}
+
 int TPSDReader::getLayerInfoIndexById(int layerId) {
   int layerIndex = -1;
   for (int i = 0; i < m_headerInfo.layersCount; i++) {
@@ -653,6 +792,8 @@ void TPSDReader::readImageData(TRasterP &rasP, TPSDLayerInfo *li,
   // prima.
   int rowOffset = std::abs(sby1) % m_shrinkY;
   int rowCount  = rowOffset;
+  unpackRleChannels(chan, map, chancount, rowOffset, m_shrinkY,
+                    smallRas->getLy());
   // if(m_shrinkY==3) rowCount--;
   for (j = 0; j < smallRas->getLy(); j++) {
     for (ch = 0; ch < chancount; ++ch) {
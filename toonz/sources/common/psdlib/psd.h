@@ -150,6 +150,9 @@ class DVAPI TPSDReader {
   int m_shrinkX;
   int m_shrinkY;
   TRect m_region;
+  std::vector<psdByte> m_layerDataPos;  // file offset of each layer's data
+  const unsigned char *m_mappedData;    // whole file, while mapped by load()
+  psdByte m_mappedSize;
 
 public:
   TPSDReader(const TFilePath &path);
@@ -171,6 +174,11 @@ public:
   }
   void setRegion(TRect region) { m_region = region; }
 
+  // Read compressed layer data through a memory mapping of the file instead
+  // of stdio. Enabled by default on 64-bit builds.
+  static void enableMemoryMapping(bool enabled);
+  static bool isMemoryMappingEnabled();
+
   int getShrinkX() { return m_shrinkX; }
   int getShrinkY() { return m_shrinkY; }
   TRect getRegion() { return m_region; }
@@ -191,6 +199,8 @@ private:
 
   void readImageData(TRasterP &rasP, TPSDLayerInfo *li, TPSDChannelInfo *chan,
                      int chancount, psdPixel rows, psdPixel cols);
+  void unpackRleChannels(TPSDChannelInfo *chan, const int *map, int chancount,
+                         psdPixel firstRow, psdPixel step, psdPixel count);
   int m_error;
   TThread::Mutex m_mutex;
   int openFile();
@@ -17,6 +17,14 @@ void readrow(FILE *psd, TPSDChannelInfo *chan,
 
   int seekres = 0;
 
+  if (chan->unzipdata) {
+    if (row < chan->rows)
+      memcpy(inbuffer, chan->unzipdata + chan->rowbytes * row, chan->rowbytes);
+    else
+      memset(inbuffer, 0, chan->rowbytes);
+    return;
+  }
+
   switch (chan->comptype) {
   case RAWDATA: /* uncompressed */
     pos                  = chan->filepos + chan->rowbytes * row;
@@ -33,8 +41,8 @@ void readrow(FILE *psd, TPSDChannelInfo *chan,
     break;
   case ZIPWITHPREDICTION:
   case ZIPWITHOUTPREDICTION:
-    memcpy(inbuffer, chan->unzipdata + chan->rowbytes * row, chan->rowbytes);
-    return;
+    // decompressed by readChannel() into unzipdata, if at all
+    break;
   }
   // if we don't recognise the compression type, skip the row
   // FIXME: or would it be better to use the last valid type seen?
@@ -49,6 +57,20 @@ void readrow(FILE *psd, TPSDChannelInfo *chan,
   }
 }
 
+void unpackrows(TPSDChannelInfo *chan, const unsigned char *rledata,
+                psdByte datapos, psdPixel first, psdPixel step,
+                psdPixel count) {
+  psdPixel row = first;
+  for (psdPixel i = 0; i < count && row < chan->rows; ++i, row += step) {
+    unsigned char *in =
+        (unsigned char *)rledata + (chan->rowpos[row] - datapos);
+    unsigned char *out = chan->unzipdata + chan->rowbytes * row;
+    psdPixel n         = unpackrow(out, in, chan->rowbytes,
+                           chan->rowpos[row + 1] - chan->rowpos[row]);
+    if (n < chan->rowbytes) memset(out + n, 0, chan->rowbytes - n);
+  }
+}
+
 int unpackrow(unsigned char *out, unsigned char *in, psdPixel outlen,
               psdPixel inlen) {
   psdPixel i, len;
@@ -24,12 +24,19 @@ struct TPSDChannelInfo {
   psdByte length;   // channel byte count in file
   psdByte filepos;  // file offset of channel data (AFTER compression type)
   psdByte *rowpos;  // row data file positions (RLE ONLY)
-  unsigned char *unzipdata;  // uncompressed data (ZIP ONLY)
+  unsigned char *unzipdata;  // uncompressed data (ZIP, or RLE unpacked in bulk)
 };
 
 int unpackrow(unsigned char *out, unsigned char *in, psdPixel outlen,
               psdPixel inlen);
 
+// Unpacks rows first, first + step, ... (count of them) of an RLE channel into
+// its unzipdata buffer. rledata holds the compressed bytes of those rows, and
+// its first byte lies at file position datapos.
+void unpackrows(TPSDChannelInfo *chan, const unsigned char *rledata,
+                psdByte datapos, psdPixel first, psdPixel step,
+                psdPixel count);
+
 void readrow(FILE *psd, TPSDChannelInfo *chan, psdPixel rowIndex,
              unsigned char *inbuffer, unsigned char *outbuffer);
 
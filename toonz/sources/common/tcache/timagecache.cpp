@@ -1788,6 +1788,8 @@ UINT TImageCache::getDiskUsage() const { return 0; }
 //------------------------------------------------------------------------------
 
 UINT TImageCache::getMemUsage(const std::string &id) const {
+  TThread::MutexLocker sl(&m_imp->m_mutex);
+
   std::map<std::string, CacheItemP>::iterator it =
       m_imp->m_uncompressedItems.find(id);
   if (it != m_imp->m_uncompressedItems.end()) return it->second->getSize();
@@ -1802,6 +1804,8 @@ UINT TImageCache::getMemUsage(const std::string &id) const {
 //! Returns the uncompressed image size (in KB) of the image associated with
 //! passd id, or 0 if none was found.
 UINT TImageCache::getUncompressedMemUsage(const std::string &id) const {
+  TThread::MutexLocker sl(&m_imp->m_mutex);
+
   std::map<std::string, CacheItemP>::iterator it =
       m_imp->m_uncompressedItems.find(id);
   if (it != m_imp->m_uncompressedItems.end()) return it->second->getSize();
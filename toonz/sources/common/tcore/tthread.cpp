@@ -15,6 +15,9 @@
 // STL includes
 #include <set>
 #include <deque>
+#include <atomic>
+#include <memory>
+#include <algorithm>
 
 // tcg includes
 #include "tcg/tcg_pool.h"
@@ -26,6 +29,9 @@
 #include <QWaitCondition>
 #include <QMetaType>
 #include <QCoreApplication>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QSemaphore>
 
 //==============================================================================
 
@@ -171,6 +177,104 @@ void TThread::shutdown() { Executor::shutdown(); }
 
 //==============================================================================
 
+//==========================================
+//    Row bands
+//------------------------------------------
+
+namespace {
+
+//! Images with fewer pixels are not worth the hand-off to other threads.
+const int c_minPixelsPerBand = 256 * 256;
+
+//! The threads helping runInRanges() callers. Its size (the ideal thread
+//! count) bounds the helpers of all concurrent calls together.
+Q_GLOBAL_STATIC(QThreadPool, bandsPool)
+
+//---------------------------------------------------------------------
+
+//! The state shared by a runInRanges() call and its pool tasks. Tasks may
+//! start after the call has returned, so it is reference-counted - but they
+//! only touch m_bandFunc through bands they claimed, which the call waits for.
+struct BandsJob {
+  const std::function<void(int, int)> *m_bandFunc;
+  int m_ly, m_bandsCount;
+  std::atomic<int> m_nextBand;
+  QSemaphore m_bandsDone;
+
+  BandsJob(const std::function<void(int, int)> &bandFunc, int ly,
+           int bandsCount)
+      : m_bandFunc(&bandFunc)
+      , m_ly(ly)
+      , m_bandsCount(bandsCount)
+      , m_nextBand(0) {}
+
+  //! Claims and processes the next band. Returns false when none is left.
+  bool runNextBand() {
+    int b = m_nextBand++;
+    if (b >= m_bandsCount) return false;
+
+    (*m_bandFunc)(m_ly * b / m_bandsCount, m_ly * (b + 1) / m_bandsCount);
+    m_bandsDone.release();
+    return true;
+  }
+};
+
+//---------------------------------------------------------------------
+
+class BandsTask final : public QRunnable {
+  std::shared_ptr<BandsJob> m_job;
+
+public:
+  BandsTask(const std::shared_ptr<BandsJob> &job) : m_job(job) {}
+
+  void run() override {
+    while (m_job->runNextBand()) {
+    }
+  }
+};
+
+}  // namespace
+
+//---------------------------------------------------------------------
+
+void TThread::runInBands(int lx, int ly,
+                         const std::function<void(int, int)> &bandFunc) {
+  int bandsCount =
+      std::min(QThread::idealThreadCount(),
+               (int)std::min<double>(ly, (double)lx * ly / c_minPixelsPerBand));
+  runInRanges(ly, bandsCount, bandFunc);
+}
+
+//---------------------------------------------------------------------
+
+void TThread::runInRanges(int count, int rangesCount,
+                          const std::function<void(int, int)> &rangeFunc) {
+  if (count <= 0) return;
+
+  rangesCount = std::min(rangesCount, count);
+  if (rangesCount <= 1) {
+    rangeFunc(0, count);
+    return;
+  }
+
+  std::shared_ptr<BandsJob> job(new BandsJob(rangeFunc, count, rangesCount));
+
+  // Helpers are only started on idle pool threads - never queued, as the
+  // calling thread takes any band they would have waited for
+  int helpersCount = std::min(rangesCount, QThread::idealThreadCount());
+  for (int t = 1; t < helpersCount; ++t) {
+    std::unique_ptr<BandsTask> task(new BandsTask(job));
+    if (!bandsPool()->tryStart(task.get())) break;
+    task.release();
+  }
+
+  while (job->runNextBand()) {
+  }
+  job->m_bandsDone.acquire(rangesCount);
+}
+
+//==============================================================================
+
 namespace TThread {
 
 //==============================================================================
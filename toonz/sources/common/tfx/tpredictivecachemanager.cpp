@@ -2,8 +2,11 @@
 
 #include "trenderer.h"
 #include "trasterfx.h"
+#include "tsystem.h"
+#include "tlogger.h"
 
 #include <algorithm>
+#include <set>
 
 #include "tpredictivecachemanager.h"
 
@@ -44,11 +47,36 @@ TPredictiveCacheManager *TPredictiveCacheManager::instance() {
 struct PredictionData {
   const ResourceDeclaration *m_decl;
   int m_usageCount;
+  std::set<double> m_frames;  //!< Frames requesting the resource
 
-  PredictionData(const ResourceDeclaration *declaration)
-      : m_decl(declaration), m_usageCount(1) {}
+  PredictionData(const ResourceDeclaration *declaration, double frame)
+      : m_decl(declaration), m_usageCount(1) {
+    m_frames.insert(frame);
+  }
 };
 
+//-------------------------------------------------------------------------
+
+namespace {
+
+// Estimated memory (in KB) retained by a resource once all its predicted
+// tiles have been calculated.
+TINT64 retainedMemory(const ResourceDeclaration *decl, int bpp) {
+  TINT64 result = 0;
+
+  std::vector<ResourceDeclaration::TileData>::const_iterator it;
+  for (it = decl->m_tiles.begin(); it != decl->m_tiles.end(); ++it) {
+    const TRectD &rect = it->m_rect;
+    if (rect.x1 <= rect.x0 || rect.y1 <= rect.y0) continue;
+
+    result += ((TINT64)rect.getLx() * (TINT64)rect.getLy() * (bpp >> 3)) >> 10;
+  }
+
+  return result;
+}
+
+}  // namespace
+
 //============================================================================================
 
 //=====================================
@@ -59,14 +87,20 @@ class TPredictiveCacheManager::Imp {
 public:
   int m_renderStatus;
   bool m_enabled;
+  int m_maxTileSize;
+  int m_bpp;
 
   std::map<TCacheResourceP, PredictionData> m_resources;
   QMutex m_mutex;
 
+  TPredictiveCacheManager::SharingStats m_stats;
+
 public:
   Imp()
       : m_renderStatus(TRenderer::IDLE)
-      , m_enabled(TRenderer::instance().isPrecomputingEnabled()) {}
+      , m_enabled(TRenderer::instance().isPrecomputingEnabled())
+      , m_maxTileSize(0)
+      , m_bpp(32) {}
 
   void run(TCacheResourceP &resource, const std::string &alias, const TFxP &fx,
            double frame, const TRenderSettings &rs,
@@ -92,6 +126,10 @@ private:
                             const TFxP &fx, double frame,
                             const TRenderSettings &rs,
                             ResourceDeclaration *resData);
+
+public:
+  void releaseUnsharedResources();
+  void enforceMemoryBudget();
 };
 
 //************************************************************************************************
@@ -107,11 +145,30 @@ TPredictiveCacheManager::~TPredictiveCacheManager() {}
 
 //---------------------------------------------------------------------------
 
-void TPredictiveCacheManager::setMaxTileSize(int maxTileSize) {}
+int TPredictiveCacheManager::getMaxTileSize() const {
+  return m_imp->m_maxTileSize;
+}
 
 //---------------------------------------------------------------------------
 
-void TPredictiveCacheManager::setBPP(int bpp) {}
+int TPredictiveCacheManager::getBPP() const { return m_imp->m_bpp; }
+
+//---------------------------------------------------------------------------
+
+void TPredictiveCacheManager::setMaxTileSize(int maxTileSize) {
+  m_imp->m_maxTileSize = maxTileSize;
+}
+
+//---------------------------------------------------------------------------
+
+void TPredictiveCacheManager::setBPP(int bpp) { m_imp->m_bpp = bpp; }
+
+//---------------------------------------------------------------------------
+
+const TPredictiveCacheManager::SharingStats &
+TPredictiveCacheManager::getSharingStats() const {
+  return m_imp->m_stats;
+}
 
 //---------------------------------------------------------------------------
 
@@ -152,11 +209,13 @@ void TPredictiveCacheManager::Imp::getResourceTestRun(
   std::map<TCacheResourceP, PredictionData>::iterator it =
       m_resources.find(resource);
 
-  if (it != m_resources.end())
+  if (it != m_resources.end()) {
     it->second.m_usageCount++;
-  else {
+    it->second.m_frames.insert(frame);
+  } else {
     // Already initializes usageCount at 1
-    m_resources.insert(std::make_pair(resource, PredictionData(resData)));
+    m_resources.insert(
+        std::make_pair(resource, PredictionData(resData, frame)));
   }
 }
 
@@ -198,23 +257,108 @@ void TPredictiveCacheManager::onRenderStatusStart(int renderStatus) {
 
 //---------------------------------------------------------------------------
 
+void TPredictiveCacheManager::Imp::releaseUnsharedResources() {
+  // All resources which have just 1 computation tile, which is also
+  // referenced only once, are released.
+
+  std::map<TCacheResourceP, PredictionData>::iterator it;
+  for (it = m_resources.begin(); it != m_resources.end();) {
+    const ResourceDeclaration *decl = it->second.m_decl;
+
+    m_stats.m_requestedEvaluations += it->second.m_usageCount;
+
+    if (decl->m_tiles.size() == 1 && decl->m_tiles[0].m_refCount == 1) {
+      std::map<TCacheResourceP, PredictionData>::iterator jt = it++;
+      m_resources.erase(jt);
+    } else
+      it++;
+  }
+}
+
+//---------------------------------------------------------------------------
+
+void TPredictiveCacheManager::Imp::enforceMemoryBudget() {
+  typedef std::map<TCacheResourceP, PredictionData>::iterator ResourceIt;
+
+  struct Candidate {
+    ResourceIt m_it;
+    TINT64 m_memory;
+    int m_saved;
+
+    // Sorts candidates by decreasing saved evaluations per retained KB
+    bool operator<(const Candidate &other) const {
+      return (double)m_saved * (other.m_memory + 1) >
+             (double)other.m_saved * (m_memory + 1);
+    }
+  };
+
+  std::vector<Candidate> candidates;
+  candidates.reserve(m_resources.size());
+
+  TINT64 totalMemory = 0;
+
+  ResourceIt it;
+  for (it = m_resources.begin(); it != m_resources.end(); ++it) {
+    Candidate candidate = {it, retainedMemory(it->second.m_decl, m_bpp),
+                           std::max(it->second.m_usageCount - 1, 0)};
+
+    totalMemory += candidate.m_memory;
+    candidates.push_back(candidate);
+  }
+
+  // Shared results may take at most half of the currently free physical
+  // memory. The remaining part is left to the actual fx computations.
+  TINT64 budget = TSystem::getFreeMemorySize(true) / 2;
+
+  if (totalMemory > budget) {
+    std::stable_sort(candidates.begin(), candidates.end());
+
+    // Drop the least convenient results first. Once released here, the
+    // associated nodes are simply recomputed whenever requested.
+    while (!candidates.empty() && totalMemory > budget) {
+      const Candidate &candidate = candidates.back();
+
+      totalMemory -= candidate.m_memory;
+      m_resources.erase(candidate.m_it);
+      ++m_stats.m_droppedResults;
+
+      candidates.pop_back();
+    }
+  }
+
+  std::vector<Candidate>::iterator ct;
+  for (ct = candidates.begin(); ct != candidates.end(); ++ct) {
+    const PredictionData &data = ct->m_it->second;
+
+    ++m_stats.m_sharedResults;
+    if (data.m_frames.size() > 1) ++m_stats.m_crossFrameResults;
+
+    m_stats.m_savedEvaluations += ct->m_saved;
+  }
+
+  m_stats.m_retainedMemory = totalMemory;
+}
+
+//---------------------------------------------------------------------------
+
 void TPredictiveCacheManager::onRenderStatusEnd(int renderStatus) {
   switch (renderStatus) {
   case TRenderer::TESTRUN:
+    m_imp->m_stats = SharingStats();
 
-    // All resources which have just 1 computation tile, which is also
-    // referenced
-    // only once, are released.
+    m_imp->releaseUnsharedResources();
+    m_imp->enforceMemoryBudget();
 
-    std::map<TCacheResourceP, PredictionData>::iterator it;
-    for (it = m_imp->m_resources.begin(); it != m_imp->m_resources.end();) {
-      const ResourceDeclaration *decl = it->second.m_decl;
+    if (m_imp->m_stats.m_savedEvaluations > 0) {
+      const SharingStats &stats = m_imp->m_stats;
 
-      if (decl->m_tiles.size() == 1 && decl->m_tiles[0].m_refCount == 1) {
-        std::map<TCacheResourceP, PredictionData>::iterator jt = it++;
-        m_imp->m_resources.erase(jt);
-      } else
-        it++;
+      TLogger::debug() << "Render sharing: " << stats.m_savedEvaluations
+                       << " of " << stats.m_requestedEvaluations
+                       << " node evaluations saved by "
+                       << stats.m_sharedResults << " shared results ("
+                       << stats.m_crossFrameResults << " across frames, "
+                       << stats.m_droppedResults << " dropped, "
+                       << (int)(stats.m_retainedMemory >> 10) << " MB)";
     }
   }
 }
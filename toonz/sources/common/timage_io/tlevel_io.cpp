@@ -9,9 +9,13 @@
 
 // STD includes
 #include <map>
+#include <memory>
 
 // Qt includes
 #include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QMutex>
 
 #include "tlevel_io.h"
 
@@ -30,6 +34,61 @@ std::map<QString, std::pair<TLevelWriterCreateProc *, bool>> LevelWriterTable;
 
 //-----------------------------------------------------------
 
+namespace {
+
+/*
+  Files of a folder grouped by level name. Scenes tend to keep lots of
+  image sequences in a few shared folders: the index is built with a single
+  listing and reused by all the levels in the folder until it changes.
+*/
+struct FolderIndex {
+  QDateTime m_modified, m_listed;
+  std::map<TFilePath, std::vector<TFilePath>> m_levels;
+};
+
+typedef std::shared_ptr<const FolderIndex> FolderIndexP;
+
+QMutex FolderIndexMutex;
+std::map<std::wstring, FolderIndexP> FolderIndexTable;
+
+// Folder timestamps may be as coarse as 2 seconds (FAT, some NFS servers),
+// so a listing taken right after a change could still miss later files
+const qint64 c_timestampResolution = 2000;
+
+FolderIndexP getFolderIndex(const TFilePath &folder) {
+  QDateTime modified = QFileInfo(folder.getQString()).lastModified();
+
+  {
+    QMutexLocker locker(&FolderIndexMutex);
+
+    std::map<std::wstring, FolderIndexP>::iterator it =
+        FolderIndexTable.find(folder.getWideString());
+    if (it != FolderIndexTable.end() && it->second->m_modified == modified &&
+        modified.msecsTo(it->second->m_listed) >= c_timestampResolution)
+      return it->second;
+  }
+
+  // Listing happens outside the lock, so that levels in different folders
+  // do not wait for each other
+  std::shared_ptr<FolderIndex> index(new FolderIndex);
+  index->m_modified = modified;
+  index->m_listed   = QDateTime::currentDateTime();
+
+  TFilePathSet files =
+      TSystem::readDirectory(folder, false, true, true);  // Could throw
+  for (TFilePathSet::iterator it = files.begin(); it != files.end(); ++it)
+    index->m_levels[TFilePath(it->getLevelName())].push_back(*it);
+
+  QMutexLocker locker(&FolderIndexMutex);
+  FolderIndexTable[folder.getWideString()] = index;
+
+  return index;
+}
+
+}  // namespace
+
+//-----------------------------------------------------------
+
 TLevelReader::TLevelReader(const TFilePath &path)
     : TSmartObject(m_classCode)
     , m_info(0)
@@ -90,6 +149,13 @@ const TImageInfo *TLevelReader::getImageInfo(TFrameId fid) {
 
 //-----------------------------------------------------------
 
+void TLevelReader::invalidateFolderIndex(const TFilePath &folder) {
+  QMutexLocker locker(&FolderIndexMutex);
+  FolderIndexTable.erase(folder.getWideString());
+}
+
+//-----------------------------------------------------------
+
 const TImageInfo *TLevelReader::getImageInfo() {
   if (m_info) return m_info;
   TLevelP level = loadInfo();
@@ -104,20 +170,25 @@ TLevelP TLevelReader::loadInfo() {
   TFilePath levelName(m_path.getLevelName());
   //  cout << "Parent dir = '" << parentDir << "'" << endl;
   //  cout << "Level name = '" << levelName << "'" << endl;
-  TFilePathSet files;
+  FolderIndexP index;
   try {
-    files = TSystem::readDirectory(parentDir, false, true, true);
+    index = getFolderIndex(parentDir);
   } catch (...) {
     throw TImageException(m_path, "unable to read directory content");
   }
   TLevelP level;
   vector<TFilePath> data;
-  for (TFilePathSet::iterator it = files.begin(); it != files.end(); it++) {
-    TFilePath ln(it->getLevelName());
-    // cout << "try " << *it << "  " << it->getLevelName() <<  endl;
-    if (levelName == TFilePath(it->getLevelName())) {
-      level->setFrame(it->getFrame(), TImageP());
-      data.push_back(*it);
+  std::map<TFilePath, std::vector<TFilePath>>::const_iterator lt =
+      index->m_levels.find(levelName);
+  if (lt != index->m_levels.end()) {
+    const std::vector<TFilePath> &files = lt->second;
+    for (std::vector<TFilePath>::const_iterator it = files.begin();
+         it != files.end(); it++) {
+      // TFilePath ordering ignores case, while equality may not
+      if (levelName == TFilePath(it->getLevelName())) {
+        level->setFrame(it->getFrame(), TImageP());
+        data.push_back(*it);
+      }
     }
   }
   if (!data.empty()) {
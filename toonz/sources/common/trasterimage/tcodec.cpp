@@ -16,9 +16,10 @@
 #include "lz4frame.h"
 #endif
 
-#include <QDir>
-#include <QProcess>
-#include <QCoreApplication>
+#include "lzoconf.h"
+#include "lzo1x.h"
+
+#include <vector>
 
 using namespace std;
 
@@ -569,31 +570,25 @@ void TRasterCodecLz4::decompress(const TRasterP &compressedRas,
 
 namespace {
 
-bool lzoCompress(const QByteArray src, QByteArray &dst) {
-  QDir exeDir(QCoreApplication::applicationDirPath());
-  QString compressExe = exeDir.filePath("lzocompress");
-  QProcess process;
-  process.start(compressExe, QStringList() << QString::number(src.size()));
-  if (!process.waitForStarted()) return false;
-  process.write(src);
-  if (!process.waitForFinished()) return false;
-  dst = process.readAll();
-  return process.exitCode() == 0;
+bool initLzo() {
+  static const bool initialized = (lzo_init() == LZO_E_OK);
+  return initialized;
 }
 
-bool lzoDecompress(const QByteArray src, int dstSize, QByteArray &dst) {
-  QDir exeDir(QCoreApplication::applicationDirPath());
-  QString decompressExe = exeDir.filePath("lzodecompress");
-  QProcess process;
-  process.start(decompressExe, QStringList() << QString::number(dstSize)
-                                             << QString::number(src.size()));
-  if (!process.waitForStarted()) return false;
-  process.write(src);
-  if (!process.waitForFinished()) return false;
-  dst = process.readAll();
-  return process.exitCode() == 0 && dst.size() == dstSize;
+// Worst case expansion of LZO1X on incompressible data (see LZO.FAQ)
+inline size_t lzoCompressBound(size_t size) {
+  return size + size / 16 + 64 + 3;
 }
+
+bool lzoDecompress(const UCHAR *src, size_t srcSize, UCHAR *dst,
+                   size_t dstSize) {
+  if (!initLzo()) return false;
+
+  lzo_uint outSize = dstSize;
+  int ret = lzo1x_decompress_safe(src, srcSize, dst, &outSize, NULL);
+  return ret == LZO_E_OK && outSize == dstSize;
 }
+}  // namespace
 
 //------------------------------------------------------------------------------
 
@@ -617,20 +612,10 @@ UINT TRasterCodecLZO::doCompress(const TRasterP &inRas, int allocUnit,
 
   assert(inRas->getLx() == inRas->getWrap());
 
-  size_t inDataSize = inRas->getLx() * inRas->getLy() * inRas->getPixelSize();
-
-  // compress data
-  inRas->lock();
-  char *inData = (char *)inRas->getRawData();
-  QByteArray compressedBuffer;
-  if (!lzoCompress(QByteArray(inData, inDataSize), compressedBuffer))
-    throw TException("LZO compression failed");
+  if (!initLzo()) throw TException("LZO initialization failed");
 
-  inRas->unlock();
-
-  size_t maxReqSize = compressedBuffer.size();  // we have just done the
-                                                // compression: we know the
-                                                // actual size
+  size_t inDataSize = inRas->getLx() * inRas->getLy() * inRas->getPixelSize();
+  size_t maxReqSize = lzoCompressBound(inDataSize);
 
   if (m_useCache) {
     if (m_cacheId == "")
@@ -652,16 +637,25 @@ UINT TRasterCodecLZO::doCompress(const TRasterP &inRas, int allocUnit,
       m_raster = outRas;
   }
 
-  size_t outSize = maxReqSize;
   outRas->lock();
-  char *buffer = (char *)outRas->getRawData();  // Change cast types, if needed
+  UCHAR *buffer = outRas->getRawData();
   if (!buffer) {
     outRas->unlock();
     return 0;
   }
-  memcpy(buffer, compressedBuffer.data(), outSize);
+
+  std::vector<lzo_align_t> wrkmem(
+      (LZO1X_1_MEM_COMPRESS + sizeof(lzo_align_t) - 1) / sizeof(lzo_align_t));
+
+  inRas->lock();
+  lzo_uint outSize = 0;
+  int ret = lzo1x_1_compress(inRas->getRawData(), inDataSize, buffer, &outSize,
+                             &wrkmem[0]);
+  inRas->unlock();
   outRas->unlock();
 
+  if (ret != LZO_E_OK) throw TException("LZO compression failed");
+
   return outSize;
 }
 
@@ -711,36 +705,23 @@ bool TRasterCodecLZO::decompress(const UCHAR *inData, TINT32 inDataSize,
 
   int outDataSize = header->getRasterSize();
 
-  char *mc = (char *)inData + headerSize;
-  int ds   = inDataSize - headerSize;
-
-  size_t outSize = outDataSize;  // Calculate output buffer size
-
-  QByteArray decompressedBuffer;
-  if (!lzoDecompress(QByteArray(mc, ds), outSize, decompressedBuffer))
-    throw TException("LZO decompression failed");
+  const UCHAR *mc = inData + headerSize;
+  int ds          = inDataSize - headerSize;
 
+  // decompress straight into the raster
   outRas->lock();
-  memcpy(outRas->getRawData(), decompressedBuffer.data(),
-         decompressedBuffer.size());
-  bool rc = true;
-
+  bool ok = lzoDecompress(mc, ds, outRas->getRawData(), outDataSize);
   outRas->unlock();
 
-  /*
-if (rc != true)                                     // Check success code here
-{
-if (safeMode)
-return false;
-else
-{
-throw TException("decompress... something goes bad");
-return false;
-}
-}
-  */
+  if (!ok) {
+    if (safeMode)
+      return false;
+    else {
+      throw TException("LZO decompression failed");
+      return false;
+    }
+  }
 
-  assert(outSize == (size_t)outDataSize);
   return true;
 }
 
@@ -767,26 +748,13 @@ void TRasterCodecLZO::decompress(const TRasterP &compressedRas,
 
   int outDataSize = header.getRasterSize();
 
-  char *mc = (char *)inData + headerSize;
-  int ds   = inDataSize - headerSize;
-
-  size_t outSize = outDataSize;  // Calculate output buffer size
-
-  char *outData = (char *)outRas->getRawData();
+  const UCHAR *mc = inData + headerSize;
+  int ds          = inDataSize - headerSize;
 
-  QByteArray decompressedBuffer;
-  if (!lzoDecompress(QByteArray(mc, ds), outSize, decompressedBuffer))
-    throw TException("LZO decompression failed");
   outRas->lock();
-  memcpy(outRas->getRawData(), decompressedBuffer.data(),
-         decompressedBuffer.size());
-  bool rc = true;
-
+  bool ok = lzoDecompress(mc, ds, outRas->getRawData(), outDataSize);
   outRas->unlock();
   compressedRas->unlock();
 
-  if (rc != true)  // Check success code here
-    throw TException("decompress... something goes bad");
-
-  assert(outSize == (size_t)outDataSize);
+  if (!ok) throw TException("LZO decompression failed");
 }
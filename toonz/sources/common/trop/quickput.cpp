@@ -4,12 +4,15 @@
 #include "loop_macros.h"
 #include "tpixelutils.h"
 #include "quickputP.h"
+#include "tthread.h"
 
 #ifndef TNZCORE_LIGHT
 #include "tpalette.h"
 #include "tcolorstyles.h"
 #endif
 
+#include <vector>
+
 /*
 #ifndef __sgi
 #include <algorithm>
@@ -36,6 +39,20 @@ void quickResample_optimized(const TRasterP &dn, const TRasterP &up,
 
 namespace {
 
+/*! Splits the dn scanlines [y0, y1] in horizontal bands and calls
+    \b putRows(bandY0, bandY1) on each of them, in parallel when the area to
+    be drawn is big enough. Every scanline is computed from its own index
+    only, so the result does not depend on the split.
+*/
+template <typename Func>
+void putInBands(int y0, int y1, int lx, const Func &putRows) {
+  TThread::runInBands(lx, y1 - y0 + 1, [&](int bandY0, int bandY1) {
+    putRows(y0 + bandY0, y0 + bandY1 - 1);
+  });
+}
+
+//-----------------------------------------------------------------------------
+
 inline TPixel32 applyColorScale(const TPixel32 &color,
                                 const TPixel32 &colorScale,
                                 bool toBePremultiplied = false) {
@@ -133,199 +150,201 @@ void doQuickPutFilter(const TRaster32P &dn, const TRaster32P &up,
   int upWrap = up->getWrap();
   dn->lock();
   up->lock();
-  TPixel32 *dnRow     = dn->pixels(yMin);
   TPixel32 *upBasePix = up->pixels();
 
   //  scorre le scanline di boundingBoxD
-  for (int y = yMin; y <= yMax; y++, dnRow += dnWrap) {
-    //	(1)    equazione k-parametrica della y-esima
-    //               scanline di boundingBoxD:
-    //	       (xMin, y) + k*(1, 0),  k = 0, ..., (xMax - xMin)
-
-    //	(2)    equazione k-parametrica dell'immagine mediante
-    //               invAff di (1):
-    //	       invAff*(xMin, y) + k*(deltaXD, deltaYD),
-    //	       k = kMin, ..., kMax
-    //               con 0 <= kMin <= kMax <= (xMax - xMin)
-
-    //  calcola kMin, kMax per la scanline corrente intersecando la (2)
-    //  con i lati di up
-
-    //  il segmento [a, b] di up e' la controimmagine mediante aff
-    //  della porzione di scanline  [ (xMin, y), (xMax, y) ] di dn
-
-    //        TPointD b = invAff*TPointD(xMax, y);
-    TPointD a = invAff * TPointD(xMin, y);
-
-    //	(xL0, yL0) sono le coordinate di a in versione "TLonghizzata"
-    //	0 <= xL0 + k*deltaXL
-    //          <= (up->getLx() - 2)*(1<<PADN), 0
-    //          <= kMinX
-    //          <= kMin
-    //          <= k
-    //          <= kMax
-    //          <= kMaxX
-    //          <= (xMax - xMin)
-    //
-    //	0 <= yL0 + k*deltaYL
-    //          <= (up->getLy() - 2)*(1<<PADN), 0
-    //          <= kMinY
-    //          <= kMin
-    //          <= k
-    //          <= kMax
-    //          <= kMaxY
-    //          <= (yMax - yMin)
-    int xL0 = tround(a.x * (1 << PADN));  //  xL0 inizializzato
-    int yL0 = tround(a.y * (1 << PADN));  //  yL0 inizializzato
-
-    //  calcola kMinX, kMaxX, kMinY, kMaxY
-    int kMinX = 0, kMaxX = xMax - xMin;  //  clipping su dn
-    int kMinY = 0, kMaxY = yMax - yMin;  //  clipping su dn
-
-    //        0 <= xL0 + k*deltaXL <= (up->getLx() - 2)*(1<<PADN)
-    //                   <=>
-    //        0 <= xL0 + k*deltaXL <= lxPred
-    //
-    //
-    //	0 <= yL0 + k*deltaYL <= (up->getLy() - 2)*(1<<PADN)
-    //                   <=>
-    //        0 <= yL0 + k*deltaYL <= lyPred
-
-    //  calcola kMinX, kMaxX
-    if (deltaXL == 0) {
-      //  [a, b] verticale esterno ad up contratto
-      if ((xL0 < 0) || (lxPred < xL0)) continue;
-      //  altrimenti usa solo
-      //  kMinY, kMaxY ((deltaXL != 0) || (deltaYL != 0))
-    } else if (deltaXL > 0) {
-      if (lxPred < xL0)  //  [a, b] esterno ad up+(bordo destro)
-        continue;
-
-      kMaxX = (lxPred - xL0) / deltaXL;  //  floor
-      if (xL0 < 0) {
-        kMinX = ((-xL0) + deltaXL - 1) / deltaXL;  //  ceil
-      }
-    } else  //  (deltaXL < 0)
-    {
-      if (xL0 < 0)  //  [a, b] esterno ad up contratto
-        continue;
-
-      kMaxX = xL0 / (-deltaXL);  //  floor
-      if (lxPred < xL0) {
-        kMinX = (xL0 - lxPred - deltaXL - 1) / (-deltaXL);  //  ceil
+  putInBands(yMin, yMax, xMax - xMin + 1, [&](int y0, int y1) {
+    TPixel32 *dnRow = dn->pixels(y0);
+    for (int y = y0; y <= y1; y++, dnRow += dnWrap) {
+      //	(1)    equazione k-parametrica della y-esima
+      //               scanline di boundingBoxD:
+      //	       (xMin, y) + k*(1, 0),  k = 0, ..., (xMax - xMin)
+
+      //	(2)    equazione k-parametrica dell'immagine mediante
+      //               invAff di (1):
+      //	       invAff*(xMin, y) + k*(deltaXD, deltaYD),
+      //	       k = kMin, ..., kMax
+      //               con 0 <= kMin <= kMax <= (xMax - xMin)
+
+      //  calcola kMin, kMax per la scanline corrente intersecando la (2)
+      //  con i lati di up
+
+      //  il segmento [a, b] di up e' la controimmagine mediante aff
+      //  della porzione di scanline  [ (xMin, y), (xMax, y) ] di dn
+
+      //        TPointD b = invAff*TPointD(xMax, y);
+      TPointD a = invAff * TPointD(xMin, y);
+
+      //	(xL0, yL0) sono le coordinate di a in versione "TLonghizzata"
+      //	0 <= xL0 + k*deltaXL
+      //          <= (up->getLx() - 2)*(1<<PADN), 0
+      //          <= kMinX
+      //          <= kMin
+      //          <= k
+      //          <= kMax
+      //          <= kMaxX
+      //          <= (xMax - xMin)
+      //
+      //	0 <= yL0 + k*deltaYL
+      //          <= (up->getLy() - 2)*(1<<PADN), 0
+      //          <= kMinY
+      //          <= kMin
+      //          <= k
+      //          <= kMax
+      //          <= kMaxY
+      //          <= (yMax - yMin)
+      int xL0 = tround(a.x * (1 << PADN));  //  xL0 inizializzato
+      int yL0 = tround(a.y * (1 << PADN));  //  yL0 inizializzato
+
+      //  calcola kMinX, kMaxX, kMinY, kMaxY
+      int kMinX = 0, kMaxX = xMax - xMin;  //  clipping su dn
+      int kMinY = 0, kMaxY = yMax - yMin;  //  clipping su dn
+
+      //        0 <= xL0 + k*deltaXL <= (up->getLx() - 2)*(1<<PADN)
+      //                   <=>
+      //        0 <= xL0 + k*deltaXL <= lxPred
+      //
+      //
+      //	0 <= yL0 + k*deltaYL <= (up->getLy() - 2)*(1<<PADN)
+      //                   <=>
+      //        0 <= yL0 + k*deltaYL <= lyPred
+
+      //  calcola kMinX, kMaxX
+      if (deltaXL == 0) {
+        //  [a, b] verticale esterno ad up contratto
+        if ((xL0 < 0) || (lxPred < xL0)) continue;
+        //  altrimenti usa solo
+        //  kMinY, kMaxY ((deltaXL != 0) || (deltaYL != 0))
+      } else if (deltaXL > 0) {
+        if (lxPred < xL0)  //  [a, b] esterno ad up+(bordo destro)
+          continue;
+
+        kMaxX = (lxPred - xL0) / deltaXL;  //  floor
+        if (xL0 < 0) {
+          kMinX = ((-xL0) + deltaXL - 1) / deltaXL;  //  ceil
+        }
+      } else  //  (deltaXL < 0)
+      {
+        if (xL0 < 0)  //  [a, b] esterno ad up contratto
+          continue;
+
+        kMaxX = xL0 / (-deltaXL);  //  floor
+        if (lxPred < xL0) {
+          kMinX = (xL0 - lxPred - deltaXL - 1) / (-deltaXL);  //  ceil
+        }
       }
-    }
 
-    //  calcola kMinY, kMaxY
-    if (deltaYL == 0) {
-      //  [a, b] orizzontale esterno ad up contratto
-      if ((yL0 < 0) || (lyPred < yL0)) continue;
-      //  altrimenti usa solo
-      //  kMinX, kMaxX ((deltaXL != 0) || (deltaYL != 0))
-    } else if (deltaYL > 0) {
-      if (lyPred < yL0)  //  [a, b] esterno ad up contratto
-        continue;
-
-      kMaxY = (lyPred - yL0) / deltaYL;  //  floor
-      if (yL0 < 0) {
-        kMinY = ((-yL0) + deltaYL - 1) / deltaYL;  //  ceil
-      }
-    } else  //  (deltaYL < 0)
-    {
-      if (yL0 < 0)  //  [a, b] esterno ad up contratto
-        continue;
-
-      kMaxY = yL0 / (-deltaYL);  //  floor
-      if (lyPred < yL0) {
-        kMinY = (yL0 - lyPred - deltaYL - 1) / (-deltaYL);  //  ceil
+      //  calcola kMinY, kMaxY
+      if (deltaYL == 0) {
+        //  [a, b] orizzontale esterno ad up contratto
+        if ((yL0 < 0) || (lyPred < yL0)) continue;
+        //  altrimenti usa solo
+        //  kMinX, kMaxX ((deltaXL != 0) || (deltaYL != 0))
+      } else if (deltaYL > 0) {
+        if (lyPred < yL0)  //  [a, b] esterno ad up contratto
+          continue;
+
+        kMaxY = (lyPred - yL0) / deltaYL;  //  floor
+        if (yL0 < 0) {
+          kMinY = ((-yL0) + deltaYL - 1) / deltaYL;  //  ceil
+        }
+      } else  //  (deltaYL < 0)
+      {
+        if (yL0 < 0)  //  [a, b] esterno ad up contratto
+          continue;
+
+        kMaxY = yL0 / (-deltaYL);  //  floor
+        if (lyPred < yL0) {
+          kMinY = (yL0 - lyPred - deltaYL - 1) / (-deltaYL);  //  ceil
+        }
       }
-    }
 
-    //  calcola kMin, kMax effettuando anche il clipping su dn
-    int kMin = std::max({kMinX, kMinY, (int)0});
-    int kMax = std::min({kMaxX, kMaxY, xMax - xMin});
+      //  calcola kMin, kMax effettuando anche il clipping su dn
+      int kMin = std::max({kMinX, kMinY, (int)0});
+      int kMax = std::min({kMaxX, kMaxY, xMax - xMin});
 
-    TPixel32 *dnPix    = dnRow + xMin + kMin;
-    TPixel32 *dnEndPix = dnRow + xMin + kMax + 1;
+      TPixel32 *dnPix    = dnRow + xMin + kMin;
+      TPixel32 *dnEndPix = dnRow + xMin + kMax + 1;
 
-    //  (xL, yL) sono le coordinate (inizializzate per il round)
-    //  in versione "TLonghizzata"
-    //	del pixel corrente di up
-    int xL = xL0 + (kMin - 1) * deltaXL;  //  inizializza xL
-    int yL = yL0 + (kMin - 1) * deltaYL;  //  inizializza yL
+      //  (xL, yL) sono le coordinate (inizializzate per il round)
+      //  in versione "TLonghizzata"
+      //	del pixel corrente di up
+      int xL = xL0 + (kMin - 1) * deltaXL;  //  inizializza xL
+      int yL = yL0 + (kMin - 1) * deltaYL;  //  inizializza yL
 
-    //  scorre i pixel sulla y-esima scanline di boundingBoxD
-    for (; dnPix < dnEndPix; ++dnPix) {
-      xL += deltaXL;
-      yL += deltaYL;
+      //  scorre i pixel sulla y-esima scanline di boundingBoxD
+      for (; dnPix < dnEndPix; ++dnPix) {
+        xL += deltaXL;
+        yL += deltaYL;
 
-      //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN))
-      //  e' approssimato con (xI, yI)
-      int xI = xL >> PADN;  //	troncato
-      int yI = yL >> PADN;  //	troncato
+        //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN))
+        //  e' approssimato con (xI, yI)
+        int xI = xL >> PADN;  //	troncato
+        int yI = yL >> PADN;  //	troncato
 
-      assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
-             (yI <= up->getLy() - 1));
+        assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
+               (yI <= up->getLy() - 1));
 
-      //  (xI, yI)
-      TPixel32 *upPix00 = upBasePix + (yI * upWrap + xI);
+        //  (xI, yI)
+        TPixel32 *upPix00 = upBasePix + (yI * upWrap + xI);
 
-      //  (xI + 1, yI)
-      TPixel32 *upPix10 = upPix00 + 1;
+        //  (xI + 1, yI)
+        TPixel32 *upPix10 = upPix00 + 1;
 
-      //  (xI, yI + 1)
-      TPixel32 *upPix01 = upPix00 + upWrap;
+        //  (xI, yI + 1)
+        TPixel32 *upPix01 = upPix00 + upWrap;
 
-      //  (xI + 1, yI + 1)
-      TPixel32 *upPix11 = upPix00 + upWrap + 1;
+        //  (xI + 1, yI + 1)
+        TPixel32 *upPix11 = upPix00 + upWrap + 1;
 
-      //  filtro bilineare 4 pixels: calcolo dei pesi
-      int xWeight1 = (xL & MASKN);
-      int xWeight0 = (1 << PADN) - xWeight1;
-      int yWeight1 = (yL & MASKN);
-      int yWeight0 = (1 << PADN) - yWeight1;
+        //  filtro bilineare 4 pixels: calcolo dei pesi
+        int xWeight1 = (xL & MASKN);
+        int xWeight0 = (1 << PADN) - xWeight1;
+        int yWeight1 = (yL & MASKN);
+        int yWeight0 = (1 << PADN) - yWeight1;
 
-      //  filtro bilineare 4 pixels: media pesata sui singoli canali
-      int rColDownTmp =
-          (xWeight0 * (upPix00->r) + xWeight1 * ((upPix10)->r)) >> PADN;
+        //  filtro bilineare 4 pixels: media pesata sui singoli canali
+        int rColDownTmp =
+            (xWeight0 * (upPix00->r) + xWeight1 * ((upPix10)->r)) >> PADN;
 
-      int gColDownTmp =
-          (xWeight0 * (upPix00->g) + xWeight1 * ((upPix10)->g)) >> PADN;
+        int gColDownTmp =
+            (xWeight0 * (upPix00->g) + xWeight1 * ((upPix10)->g)) >> PADN;
 
-      int bColDownTmp =
-          (xWeight0 * (upPix00->b) + xWeight1 * ((upPix10)->b)) >> PADN;
+        int bColDownTmp =
+            (xWeight0 * (upPix00->b) + xWeight1 * ((upPix10)->b)) >> PADN;
 
-      int rColUpTmp =
-          (xWeight0 * ((upPix01)->r) + xWeight1 * ((upPix11)->r)) >> PADN;
+        int rColUpTmp =
+            (xWeight0 * ((upPix01)->r) + xWeight1 * ((upPix11)->r)) >> PADN;
 
-      int gColUpTmp =
-          (xWeight0 * ((upPix01)->g) + xWeight1 * ((upPix11)->g)) >> PADN;
+        int gColUpTmp =
+            (xWeight0 * ((upPix01)->g) + xWeight1 * ((upPix11)->g)) >> PADN;
 
-      int bColUpTmp =
-          (xWeight0 * ((upPix01)->b) + xWeight1 * ((upPix11)->b)) >> PADN;
+        int bColUpTmp =
+            (xWeight0 * ((upPix01)->b) + xWeight1 * ((upPix11)->b)) >> PADN;
 
-      unsigned char rCol =
-          (unsigned char)((yWeight0 * rColDownTmp + yWeight1 * rColUpTmp) >>
-                          PADN);
+        unsigned char rCol =
+            (unsigned char)((yWeight0 * rColDownTmp + yWeight1 * rColUpTmp) >>
+                            PADN);
 
-      unsigned char gCol =
-          (unsigned char)((yWeight0 * gColDownTmp + yWeight1 * gColUpTmp) >>
-                          PADN);
+        unsigned char gCol =
+            (unsigned char)((yWeight0 * gColDownTmp + yWeight1 * gColUpTmp) >>
+                            PADN);
 
-      unsigned char bCol =
-          (unsigned char)((yWeight0 * bColDownTmp + yWeight1 * bColUpTmp) >>
-                          PADN);
+        unsigned char bCol =
+            (unsigned char)((yWeight0 * bColDownTmp + yWeight1 * bColUpTmp) >>
+                            PADN);
 
-      TPixel32 upPix = TPixel32(rCol, gCol, bCol, upPix00->m);
+        TPixel32 upPix = TPixel32(rCol, gCol, bCol, upPix00->m);
 
-      if (upPix.m == 0)
-        continue;
-      else if (upPix.m == 255)
-        *dnPix = upPix;
-      else
-        *dnPix = quickOverPix(*dnPix, upPix);
+        if (upPix.m == 0)
+          continue;
+        else if (upPix.m == 255)
+          *dnPix = upPix;
+        else
+          *dnPix = quickOverPix(*dnPix, upPix);
+      }
     }
-  }
+  });
   dn->unlock();
   up->unlock();
 }
@@ -400,166 +419,168 @@ void doQuickPutNoFilter(const TRaster32P &dn, const TRaster32P &up,
   dn->lock();
   up->lock();
 
-  TPixel32 *dnRow     = dn->pixels(yMin);
   TPixel32 *upBasePix = up->pixels();
 
   //  scorre le scanline di boundingBoxD
-  for (int y = yMin; y <= yMax; y++, dnRow += dnWrap) {
-    //  (1)  equazione k-parametrica della y-esima scanline di boundingBoxD:
-    //       (xMin, y) + k*(1, 0),  k = 0, ..., (xMax - xMin)
-
-    //  (2)  equazione k-parametrica dell'immagine mediante invAff di (1):
-    //       invAff*(xMin, y) + k*(deltaXD, deltaYD),
-    //       k = kMin, ..., kMax con 0 <= kMin <= kMax <= (xMax - xMin)
-
-    //  calcola kMin, kMax per la scanline corrente
-    //  intersecando la (2) con i lati di up
-
-    //  il segmento [a, b] di up e' la controimmagine mediante aff della
-    //  porzione di scanline  [ (xMin, y), (xMax, y) ] di dn
-
-    //  TPointD b = invAff*TPointD(xMax, y);
-    TPointD a = invAff * TPointD(xMin, y);
-
-    //  (xL0, yL0) sono le coordinate di a (inizializzate per il round)
-    //  in versione "TLonghizzata"
-    //  0 <= xL0 + k*deltaXL
-    //    <  up->getLx()*(1<<PADN)
-    //
-    //  0 <= kMinX
-    //    <= kMin
-    //    <= k
-    //    <= kMax
-    //    <= kMaxX
-    //    <= (xMax - xMin)
-    //
-    //  0 <= yL0 + k*deltaYL
-    //    < up->getLy()*(1<<PADN)
-
-    //  0 <= kMinY
-    //    <= kMin
-    //    <= k
-    //    <= kMax
-    //    <= kMaxY
-    //    <= (xMax - xMin)
-
-    //  xL0 inizializzato per il round
-    int xL0 = tround((a.x + 0.5) * (1 << PADN));
-
-    //  yL0 inizializzato per il round
-    int yL0 = tround((a.y + 0.5) * (1 << PADN));
-
-    //  calcola kMinX, kMaxX, kMinY, kMaxY
-    int kMinX = 0, kMaxX = xMax - xMin;  //  clipping su dn
-    int kMinY = 0, kMaxY = xMax - xMin;  //  clipping su dn
-
-    //  0 <= xL0 + k*deltaXL
-    //    < up->getLx()*(1<<PADN)
-    //           <=>
-    //  0 <= xL0 + k*deltaXL
-    //    <= lxPred
-    //
-    //  0 <= yL0 + k*deltaYL
-    //    < up->getLy()*(1<<PADN)
-    //           <=>
-    //  0 <= yL0 + k*deltaYL
-    //    <= lyPred
-
-    //  calcola kMinX, kMaxX
-    if (deltaXL == 0) {
-      // [a, b] verticale esterno ad up+(bordo destro/basso)
-      if ((xL0 < 0) || (lxPred < xL0)) continue;
-      //  altrimenti usa solo
-      //  kMinY, kMaxY ((deltaXL != 0) || (deltaYL != 0))
-    } else if (deltaXL > 0) {
-      //  [a, b] esterno ad up+(bordo destro/basso)
-      if (lxPred < xL0) continue;
-
-      kMaxX = (lxPred - xL0) / deltaXL;  //  floor
-      if (xL0 < 0) {
-        kMinX = ((-xL0) + deltaXL - 1) / deltaXL;  //  ceil
-      }
-    } else  //  (deltaXL < 0)
-    {
-      //  [a, b] esterno ad up+(bordo destro/basso)
-      if (xL0 < 0) continue;
-
-      kMaxX = xL0 / (-deltaXL);  //  floor
-      if (lxPred < xL0) {
-        kMinX = (xL0 - lxPred - deltaXL - 1) / (-deltaXL);  //  ceil
+  putInBands(yMin, yMax, xMax - xMin + 1, [&](int y0, int y1) {
+    TPixel32 *dnRow = dn->pixels(y0);
+    for (int y = y0; y <= y1; y++, dnRow += dnWrap) {
+      //  (1)  equazione k-parametrica della y-esima scanline di boundingBoxD:
+      //       (xMin, y) + k*(1, 0),  k = 0, ..., (xMax - xMin)
+
+      //  (2)  equazione k-parametrica dell'immagine mediante invAff di (1):
+      //       invAff*(xMin, y) + k*(deltaXD, deltaYD),
+      //       k = kMin, ..., kMax con 0 <= kMin <= kMax <= (xMax - xMin)
+
+      //  calcola kMin, kMax per la scanline corrente
+      //  intersecando la (2) con i lati di up
+
+      //  il segmento [a, b] di up e' la controimmagine mediante aff della
+      //  porzione di scanline  [ (xMin, y), (xMax, y) ] di dn
+
+      //  TPointD b = invAff*TPointD(xMax, y);
+      TPointD a = invAff * TPointD(xMin, y);
+
+      //  (xL0, yL0) sono le coordinate di a (inizializzate per il round)
+      //  in versione "TLonghizzata"
+      //  0 <= xL0 + k*deltaXL
+      //    <  up->getLx()*(1<<PADN)
+      //
+      //  0 <= kMinX
+      //    <= kMin
+      //    <= k
+      //    <= kMax
+      //    <= kMaxX
+      //    <= (xMax - xMin)
+      //
+      //  0 <= yL0 + k*deltaYL
+      //    < up->getLy()*(1<<PADN)
+
+      //  0 <= kMinY
+      //    <= kMin
+      //    <= k
+      //    <= kMax
+      //    <= kMaxY
+      //    <= (xMax - xMin)
+
+      //  xL0 inizializzato per il round
+      int xL0 = tround((a.x + 0.5) * (1 << PADN));
+
+      //  yL0 inizializzato per il round
+      int yL0 = tround((a.y + 0.5) * (1 << PADN));
+
+      //  calcola kMinX, kMaxX, kMinY, kMaxY
+      int kMinX = 0, kMaxX = xMax - xMin;  //  clipping su dn
+      int kMinY = 0, kMaxY = xMax - xMin;  //  clipping su dn
+
+      //  0 <= xL0 + k*deltaXL
+      //    < up->getLx()*(1<<PADN)
+      //           <=>
+      //  0 <= xL0 + k*deltaXL
+      //    <= lxPred
+      //
+      //  0 <= yL0 + k*deltaYL
+      //    < up->getLy()*(1<<PADN)
+      //           <=>
+      //  0 <= yL0 + k*deltaYL
+      //    <= lyPred
+
+      //  calcola kMinX, kMaxX
+      if (deltaXL == 0) {
+        // [a, b] verticale esterno ad up+(bordo destro/basso)
+        if ((xL0 < 0) || (lxPred < xL0)) continue;
+        //  altrimenti usa solo
+        //  kMinY, kMaxY ((deltaXL != 0) || (deltaYL != 0))
+      } else if (deltaXL > 0) {
+        //  [a, b] esterno ad up+(bordo destro/basso)
+        if (lxPred < xL0) continue;
+
+        kMaxX = (lxPred - xL0) / deltaXL;  //  floor
+        if (xL0 < 0) {
+          kMinX = ((-xL0) + deltaXL - 1) / deltaXL;  //  ceil
+        }
+      } else  //  (deltaXL < 0)
+      {
+        //  [a, b] esterno ad up+(bordo destro/basso)
+        if (xL0 < 0) continue;
+
+        kMaxX = xL0 / (-deltaXL);  //  floor
+        if (lxPred < xL0) {
+          kMinX = (xL0 - lxPred - deltaXL - 1) / (-deltaXL);  //  ceil
+        }
       }
-    }
 
-    //  calcola kMinY, kMaxY
-    if (deltaYL == 0) {
-      //  [a, b] orizzontale esterno ad up+(bordo destro/basso)
-      if ((yL0 < 0) || (lyPred < yL0)) continue;
-      // altrimenti usa solo
-      // kMinX, kMaxX ((deltaXL != 0) || (deltaYL != 0))
-    } else if (deltaYL > 0) {
-      //  [a, b] esterno ad up+(bordo destro/basso)
-      if (lyPred < yL0) continue;
-
-      kMaxY = (lyPred - yL0) / deltaYL;  //  floor
-      if (yL0 < 0) {
-        kMinY = ((-yL0) + deltaYL - 1) / deltaYL;  //  ceil
-      }
-    } else  //  (deltaYL < 0)
-    {
-      //  [a, b] esterno ad up+(bordo destro/basso)
-      if (yL0 < 0) continue;
-
-      kMaxY = yL0 / (-deltaYL);  //  floor
-      if (lyPred < yL0) {
-        kMinY = (yL0 - lyPred - deltaYL - 1) / (-deltaYL);  //  ceil
+      //  calcola kMinY, kMaxY
+      if (deltaYL == 0) {
+        //  [a, b] orizzontale esterno ad up+(bordo destro/basso)
+        if ((yL0 < 0) || (lyPred < yL0)) continue;
+        // altrimenti usa solo
+        // kMinX, kMaxX ((deltaXL != 0) || (deltaYL != 0))
+      } else if (deltaYL > 0) {
+        //  [a, b] esterno ad up+(bordo destro/basso)
+        if (lyPred < yL0) continue;
+
+        kMaxY = (lyPred - yL0) / deltaYL;  //  floor
+        if (yL0 < 0) {
+          kMinY = ((-yL0) + deltaYL - 1) / deltaYL;  //  ceil
+        }
+      } else  //  (deltaYL < 0)
+      {
+        //  [a, b] esterno ad up+(bordo destro/basso)
+        if (yL0 < 0) continue;
+
+        kMaxY = yL0 / (-deltaYL);  //  floor
+        if (lyPred < yL0) {
+          kMinY = (yL0 - lyPred - deltaYL - 1) / (-deltaYL);  //  ceil
+        }
       }
-    }
-
-    //  calcola kMin, kMax effettuando anche il clippind su dn
-    int kMin = std::max({kMinX, kMinY, (int)0});
-    int kMax = std::min({kMaxX, kMaxY, xMax - xMin});
-
-    TPixel32 *dnPix    = dnRow + xMin + kMin;
-    TPixel32 *dnEndPix = dnRow + xMin + kMax + 1;
-
-    //  (xL, yL) sono le coordinate (inizializzate per il round)
-    //  in versione "TLonghizzata" del pixel corrente di up
-    int xL = xL0 + (kMin - 1) * deltaXL;  //  inizializza xL
-    int yL = yL0 + (kMin - 1) * deltaYL;  //  inizializza yL
-
-    //  scorre i pixel sulla y-esima scanline di boundingBoxD
-    for (; dnPix < dnEndPix; ++dnPix) {
-      xL += deltaXL;
-      yL += deltaYL;
-
-      //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e'
-      //  approssimato con (xI, yI)
-      int xI = xL >> PADN;  //  round
-      int yI = yL >> PADN;  //  round
-
-      assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
-             (yI <= up->getLy() - 1));
-
-      TPixel32 upPix = *(upBasePix + (yI * upWrap + xI));
-
-      if (firstColumn) upPix.m = 255;
-      if (upPix.m == 0 || (whiteTransp && upPix == TPixel::White)) continue;
-
-      if (colorScale != TPixel32::Black)
-        upPix = applyColorScale(upPix, colorScale, doPremultiply);
 
-      if (doRasterDarkenBlendedView)
-        *dnPix = quickOverPixDarkenBlended(*dnPix, upPix);
-      else {
-        if (upPix.m == 255)
-          *dnPix = upPix;
-        else if (doPremultiply)
-          *dnPix = quickOverPixPremult(*dnPix, upPix);
-        else
-          *dnPix = quickOverPix(*dnPix, upPix);
+      //  calcola kMin, kMax effettuando anche il clippind su dn
+      int kMin = std::max({kMinX, kMinY, (int)0});
+      int kMax = std::min({kMaxX, kMaxY, xMax - xMin});
+
+      TPixel32 *dnPix    = dnRow + xMin + kMin;
+      TPixel32 *dnEndPix = dnRow + xMin + kMax + 1;
+
+      //  (xL, yL) sono le coordinate (inizializzate per il round)
+      //  in versione "TLonghizzata" del pixel corrente di up
+      int xL = xL0 + (kMin - 1) * deltaXL;  //  inizializza xL
+      int yL = yL0 + (kMin - 1) * deltaYL;  //  inizializza yL
+
+      //  scorre i pixel sulla y-esima scanline di boundingBoxD
+      for (; dnPix < dnEndPix; ++dnPix) {
+        xL += deltaXL;
+        yL += deltaYL;
+
+        //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e'
+        //  approssimato con (xI, yI)
+        int xI = xL >> PADN;  //  round
+        int yI = yL >> PADN;  //  round
+
+        assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
+               (yI <= up->getLy() - 1));
+
+        TPixel32 upPix = *(upBasePix + (yI * upWrap + xI));
+
+        if (firstColumn) upPix.m = 255;
+        if (upPix.m == 0 || (whiteTransp && upPix == TPixel::White)) continue;
+
+        if (colorScale != TPixel32::Black)
+          upPix = applyColorScale(upPix, colorScale, doPremultiply);
+
+        if (doRasterDarkenBlendedView)
+          *dnPix = quickOverPixDarkenBlended(*dnPix, upPix);
+        else {
+          if (upPix.m == 255)
+            *dnPix = upPix;
+          else if (doPremultiply)
+            *dnPix = quickOverPixPremult(*dnPix, upPix);
+          else
+            *dnPix = quickOverPix(*dnPix, upPix);
+        }
       }
     }
-  }
+  });
   dn->unlock();
   up->unlock();
 }
@@ -633,159 +654,161 @@ void doQuickPutNoFilter(const TRaster32P &dn, const TRaster64P &up,
   dn->lock();
   up->lock();
 
-  TPixel32 *dnRow     = dn->pixels(yMin);
   TPixel64 *upBasePix = up->pixels();
 
   //  scorre le scanline di boundingBoxD
-  for (int y = yMin; y <= yMax; y++, dnRow += dnWrap) {
-    //  (1)  equazione k-parametrica della y-esima scanline di boundingBoxD:
-    //       (xMin, y) + k*(1, 0),  k = 0, ..., (xMax - xMin)
-
-    //  (2)  equazione k-parametrica dell'immagine mediante invAff di (1):
-    //       invAff*(xMin, y) + k*(deltaXD, deltaYD),
-    //       k = kMin, ..., kMax con 0 <= kMin <= kMax <= (xMax - xMin)
-
-    //  calcola kMin, kMax per la scanline corrente
-    //  intersecando la (2) con i lati di up
-
-    //  il segmento [a, b] di up e' la controimmagine mediante aff della
-    //  porzione di scanline  [ (xMin, y), (xMax, y) ] di dn
-
-    //  TPointD b = invAff*TPointD(xMax, y);
-    TPointD a = invAff * TPointD(xMin, y);
-
-    //  (xL0, yL0) sono le coordinate di a (inizializzate per il round)
-    //  in versione "TLonghizzata"
-    //  0 <= xL0 + k*deltaXL
-    //    <  up->getLx()*(1<<PADN)
-    //
-    //  0 <= kMinX
-    //    <= kMin
-    //    <= k
-    //    <= kMax
-    //    <= kMaxX
-    //    <= (xMax - xMin)
-    //
-    //  0 <= yL0 + k*deltaYL
-    //    < up->getLy()*(1<<PADN)
-
-    //  0 <= kMinY
-    //    <= kMin
-    //    <= k
-    //    <= kMax
-    //    <= kMaxY
-    //    <= (xMax - xMin)
-
-    //  xL0 inizializzato per il round
-    int xL0 = tround((a.x + 0.5) * (1 << PADN));
-
-    //  yL0 inizializzato per il round
-    int yL0 = tround((a.y + 0.5) * (1 << PADN));
-
-    //  calcola kMinX, kMaxX, kMinY, kMaxY
-    int kMinX = 0, kMaxX = xMax - xMin;  //  clipping su dn
-    int kMinY = 0, kMaxY = xMax - xMin;  //  clipping su dn
-
-    //  0 <= xL0 + k*deltaXL
-    //    < up->getLx()*(1<<PADN)
-    //           <=>
-    //  0 <= xL0 + k*deltaXL
-    //    <= lxPred
-    //
-    //  0 <= yL0 + k*deltaYL
-    //    < up->getLy()*(1<<PADN)
-    //           <=>
-    //  0 <= yL0 + k*deltaYL
-    //    <= lyPred
-
-    //  calcola kMinX, kMaxX
-    if (deltaXL == 0) {
-      // [a, b] verticale esterno ad up+(bordo destro/basso)
-      if ((xL0 < 0) || (lxPred < xL0)) continue;
-      //  altrimenti usa solo
-      //  kMinY, kMaxY ((deltaXL != 0) || (deltaYL != 0))
-    } else if (deltaXL > 0) {
-      //  [a, b] esterno ad up+(bordo destro/basso)
-      if (lxPred < xL0) continue;
-
-      kMaxX = (lxPred - xL0) / deltaXL;  //  floor
-      if (xL0 < 0) {
-        kMinX = ((-xL0) + deltaXL - 1) / deltaXL;  //  ceil
+  putInBands(yMin, yMax, xMax - xMin + 1, [&](int y0, int y1) {
+    TPixel32 *dnRow = dn->pixels(y0);
+    for (int y = y0; y <= y1; y++, dnRow += dnWrap) {
+      //  (1)  equazione k-parametrica della y-esima scanline di boundingBoxD:
+      //       (xMin, y) + k*(1, 0),  k = 0, ..., (xMax - xMin)
+
+      //  (2)  equazione k-parametrica dell'immagine mediante invAff di (1):
+      //       invAff*(xMin, y) + k*(deltaXD, deltaYD),
+      //       k = kMin, ..., kMax con 0 <= kMin <= kMax <= (xMax - xMin)
+
+      //  calcola kMin, kMax per la scanline corrente
+      //  intersecando la (2) con i lati di up
+
+      //  il segmento [a, b] di up e' la controimmagine mediante aff della
+      //  porzione di scanline  [ (xMin, y), (xMax, y) ] di dn
+
+      //  TPointD b = invAff*TPointD(xMax, y);
+      TPointD a = invAff * TPointD(xMin, y);
+
+      //  (xL0, yL0) sono le coordinate di a (inizializzate per il round)
+      //  in versione "TLonghizzata"
+      //  0 <= xL0 + k*deltaXL
+      //    <  up->getLx()*(1<<PADN)
+      //
+      //  0 <= kMinX
+      //    <= kMin
+      //    <= k
+      //    <= kMax
+      //    <= kMaxX
+      //    <= (xMax - xMin)
+      //
+      //  0 <= yL0 + k*deltaYL
+      //    < up->getLy()*(1<<PADN)
+
+      //  0 <= kMinY
+      //    <= kMin
+      //    <= k
+      //    <= kMax
+      //    <= kMaxY
+      //    <= (xMax - xMin)
+
+      //  xL0 inizializzato per il round
+      int xL0 = tround((a.x + 0.5) * (1 << PADN));
+
+      //  yL0 inizializzato per il round
+      int yL0 = tround((a.y + 0.5) * (1 << PADN));
+
+      //  calcola kMinX, kMaxX, kMinY, kMaxY
+      int kMinX = 0, kMaxX = xMax - xMin;  //  clipping su dn
+      int kMinY = 0, kMaxY = xMax - xMin;  //  clipping su dn
+
+      //  0 <= xL0 + k*deltaXL
+      //    < up->getLx()*(1<<PADN)
+      //           <=>
+      //  0 <= xL0 + k*deltaXL
+      //    <= lxPred
+      //
+      //  0 <= yL0 + k*deltaYL
+      //    < up->getLy()*(1<<PADN)
+      //           <=>
+      //  0 <= yL0 + k*deltaYL
+      //    <= lyPred
+
+      //  calcola kMinX, kMaxX
+      if (deltaXL == 0) {
+        // [a, b] verticale esterno ad up+(bordo destro/basso)
+        if ((xL0 < 0) || (lxPred < xL0)) continue;
+        //  altrimenti usa solo
+        //  kMinY, kMaxY ((deltaXL != 0) || (deltaYL != 0))
+      } else if (deltaXL > 0) {
+        //  [a, b] esterno ad up+(bordo destro/basso)
+        if (lxPred < xL0) continue;
+
+        kMaxX = (lxPred - xL0) / deltaXL;  //  floor
+        if (xL0 < 0) {
+          kMinX = ((-xL0) + deltaXL - 1) / deltaXL;  //  ceil
+        }
+      } else  //  (deltaXL < 0)
+      {
+        //  [a, b] esterno ad up+(bordo destro/basso)
+        if (xL0 < 0) continue;
+
+        kMaxX = xL0 / (-deltaXL);  //  floor
+        if (lxPred < xL0) {
+          kMinX = (xL0 - lxPred - deltaXL - 1) / (-deltaXL);  //  ceil
+        }
       }
-    } else  //  (deltaXL < 0)
-    {
-      //  [a, b] esterno ad up+(bordo destro/basso)
-      if (xL0 < 0) continue;
-
-      kMaxX = xL0 / (-deltaXL);  //  floor
-      if (lxPred < xL0) {
-        kMinX = (xL0 - lxPred - deltaXL - 1) / (-deltaXL);  //  ceil
-      }
-    }
 
-    //  calcola kMinY, kMaxY
-    if (deltaYL == 0) {
-      //  [a, b] orizzontale esterno ad up+(bordo destro/basso)
-      if ((yL0 < 0) || (lyPred < yL0)) continue;
-      // altrimenti usa solo
-      // kMinX, kMaxX ((deltaXL != 0) || (deltaYL != 0))
-    } else if (deltaYL > 0) {
-      //  [a, b] esterno ad up+(bordo destro/basso)
-      if (lyPred < yL0) continue;
-
-      kMaxY = (lyPred - yL0) / deltaYL;  //  floor
-      if (yL0 < 0) {
-        kMinY = ((-yL0) + deltaYL - 1) / deltaYL;  //  ceil
+      //  calcola kMinY, kMaxY
+      if (deltaYL == 0) {
+        //  [a, b] orizzontale esterno ad up+(bordo destro/basso)
+        if ((yL0 < 0) || (lyPred < yL0)) continue;
+        // altrimenti usa solo
+        // kMinX, kMaxX ((deltaXL != 0) || (deltaYL != 0))
+      } else if (deltaYL > 0) {
+        //  [a, b] esterno ad up+(bordo destro/basso)
+        if (lyPred < yL0) continue;
+
+        kMaxY = (lyPred - yL0) / deltaYL;  //  floor
+        if (yL0 < 0) {
+          kMinY = ((-yL0) + deltaYL - 1) / deltaYL;  //  ceil
+        }
+      } else  //  (deltaYL < 0)
+      {
+        //  [a, b] esterno ad up+(bordo destro/basso)
+        if (yL0 < 0) continue;
+
+        kMaxY = yL0 / (-deltaYL);  //  floor
+        if (lyPred < yL0) {
+          kMinY = (yL0 - lyPred - deltaYL - 1) / (-deltaYL);  //  ceil
+        }
       }
-    } else  //  (deltaYL < 0)
-    {
-      //  [a, b] esterno ad up+(bordo destro/basso)
-      if (yL0 < 0) continue;
-
-      kMaxY = yL0 / (-deltaYL);  //  floor
-      if (lyPred < yL0) {
-        kMinY = (yL0 - lyPred - deltaYL - 1) / (-deltaYL);  //  ceil
-      }
-    }
-
-    //  calcola kMin, kMax effettuando anche il clippind su dn
-    int kMin = std::max({kMinX, kMinY, (int)0});
-    int kMax = std::min({kMaxX, kMaxY, xMax - xMin});
-
-    TPixel32 *dnPix    = dnRow + xMin + kMin;
-    TPixel32 *dnEndPix = dnRow + xMin + kMax + 1;
-
-    //  (xL, yL) sono le coordinate (inizializzate per il round)
-    //  in versione "TLonghizzata" del pixel corrente di up
-    int xL = xL0 + (kMin - 1) * deltaXL;  //  inizializza xL
-    int yL = yL0 + (kMin - 1) * deltaYL;  //  inizializza yL
-
-    //  scorre i pixel sulla y-esima scanline di boundingBoxD
-    for (; dnPix < dnEndPix; ++dnPix) {
-      xL += deltaXL;
-      yL += deltaYL;
-
-      //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e'
-      //  approssimato con (xI, yI)
-      int xI = xL >> PADN;  //  round
-      int yI = yL >> PADN;  //  round
 
-      assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
-             (yI <= up->getLy() - 1));
-
-      TPixel64 *upPix           = upBasePix + (yI * upWrap + xI);
-      if (firstColumn) upPix->m = 65535;
-      if (upPix->m == 0)
-        continue;
-      else if (upPix->m == 65535)
-        *dnPix = PixelConverter<TPixel32>::from(*upPix);
-      else if (doPremultiply)
-        *dnPix =
-            quickOverPixPremult(*dnPix, PixelConverter<TPixel32>::from(*upPix));
-      else
-        *dnPix = quickOverPix(*dnPix, PixelConverter<TPixel32>::from(*upPix));
+      //  calcola kMin, kMax effettuando anche il clippind su dn
+      int kMin = std::max({kMinX, kMinY, (int)0});
+      int kMax = std::min({kMaxX, kMaxY, xMax - xMin});
+
+      TPixel32 *dnPix    = dnRow + xMin + kMin;
+      TPixel32 *dnEndPix = dnRow + xMin + kMax + 1;
+
+      //  (xL, yL) sono le coordinate (inizializzate per il round)
+      //  in versione "TLonghizzata" del pixel corrente di up
+      int xL = xL0 + (kMin - 1) * deltaXL;  //  inizializza xL
+      int yL = yL0 + (kMin - 1) * deltaYL;  //  inizializza yL
+
+      //  scorre i pixel sulla y-esima scanline di boundingBoxD
+      for (; dnPix < dnEndPix; ++dnPix) {
+        xL += deltaXL;
+        yL += deltaYL;
+
+        //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e'
+        //  approssimato con (xI, yI)
+        int xI = xL >> PADN;  //  round
+        int yI = yL >> PADN;  //  round
+
+        assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
+               (yI <= up->getLy() - 1));
+
+        TPixel64 *upPix           = upBasePix + (yI * upWrap + xI);
+        if (firstColumn) upPix->m = 65535;
+        if (upPix->m == 0)
+          continue;
+        else if (upPix->m == 65535)
+          *dnPix = PixelConverter<TPixel32>::from(*upPix);
+        else if (doPremultiply)
+          *dnPix = quickOverPixPremult(
+              *dnPix, PixelConverter<TPixel32>::from(*upPix));
+        else
+          *dnPix = quickOverPix(*dnPix, PixelConverter<TPixel32>::from(*upPix));
+      }
     }
-  }
+  });
   dn->unlock();
   up->unlock();
 }
@@ -835,109 +858,111 @@ void doQuickPutNoFilter(const TRaster32P &dn, const TRasterGR8P &up,
   dn->lock();
   up->lock();
 
-  TPixel32 *dnRow      = dn->pixels(yMin);
   TPixelGR8 *upBasePix = up->pixels();
 
-  for (int y = yMin; y <= yMax; y++, dnRow += dnWrap) {
-    TPointD a = invAff * TPointD(xMin, y);
+  putInBands(yMin, yMax, xMax - xMin + 1, [&](int y0, int y1) {
+    TPixel32 *dnRow = dn->pixels(y0);
+    for (int y = y0; y <= y1; y++, dnRow += dnWrap) {
+      TPointD a = invAff * TPointD(xMin, y);
 
-    int xL0 = tround((a.x + 0.5) * (1 << PADN));
+      int xL0 = tround((a.x + 0.5) * (1 << PADN));
 
-    int yL0 = tround((a.y + 0.5) * (1 << PADN));
+      int yL0 = tround((a.y + 0.5) * (1 << PADN));
 
-    int kMinX = 0, kMaxX = xMax - xMin;  //  clipping su dn
-    int kMinY = 0, kMaxY = xMax - xMin;  //  clipping su dn
+      int kMinX = 0, kMaxX = xMax - xMin;  //  clipping su dn
+      int kMinY = 0, kMaxY = xMax - xMin;  //  clipping su dn
 
-    if (deltaXL == 0) {
-      if ((xL0 < 0) || (lxPred < xL0)) continue;
-    } else if (deltaXL > 0) {
-      if (lxPred < xL0) continue;
+      if (deltaXL == 0) {
+        if ((xL0 < 0) || (lxPred < xL0)) continue;
+      } else if (deltaXL > 0) {
+        if (lxPred < xL0) continue;
 
-      kMaxX = (lxPred - xL0) / deltaXL;  //  floor
-      if (xL0 < 0) {
-        kMinX = ((-xL0) + deltaXL - 1) / deltaXL;  //  ceil
-      }
-    } else  //  (deltaXL < 0)
-    {
-      //  [a, b] esterno ad up+(bordo destro/basso)
-      if (xL0 < 0) continue;
-
-      kMaxX = xL0 / (-deltaXL);  //  floor
-      if (lxPred < xL0) {
-        kMinX = (xL0 - lxPred - deltaXL - 1) / (-deltaXL);  //  ceil
-      }
-    }
+        kMaxX = (lxPred - xL0) / deltaXL;  //  floor
+        if (xL0 < 0) {
+          kMinX = ((-xL0) + deltaXL - 1) / deltaXL;  //  ceil
+        }
+      } else  //  (deltaXL < 0)
+      {
+        //  [a, b] esterno ad up+(bordo destro/basso)
+        if (xL0 < 0) continue;
 
-    //  calcola kMinY, kMaxY
-    if (deltaYL == 0) {
-      //  [a, b] orizzontale esterno ad up+(bordo destro/basso)
-      if ((yL0 < 0) || (lyPred < yL0)) continue;
-      // altrimenti usa solo
-      // kMinX, kMaxX ((deltaXL != 0) || (deltaYL != 0))
-    } else if (deltaYL > 0) {
-      //  [a, b] esterno ad up+(bordo destro/basso)
-      if (lyPred < yL0) continue;
-
-      kMaxY = (lyPred - yL0) / deltaYL;  //  floor
-      if (yL0 < 0) {
-        kMinY = ((-yL0) + deltaYL - 1) / deltaYL;  //  ceil
-      }
-    } else  //  (deltaYL < 0)
-    {
-      //  [a, b] esterno ad up+(bordo destro/basso)
-      if (yL0 < 0) continue;
-
-      kMaxY = yL0 / (-deltaYL);  //  floor
-      if (lyPred < yL0) {
-        kMinY = (yL0 - lyPred - deltaYL - 1) / (-deltaYL);  //  ceil
+        kMaxX = xL0 / (-deltaXL);  //  floor
+        if (lxPred < xL0) {
+          kMinX = (xL0 - lxPred - deltaXL - 1) / (-deltaXL);  //  ceil
+        }
       }
-    }
-
-    //  calcola kMin, kMax effettuando anche il clippind su dn
-    int kMin = std::max({kMinX, kMinY, (int)0});
-    int kMax = std::min({kMaxX, kMaxY, xMax - xMin});
-
-    TPixel32 *dnPix    = dnRow + xMin + kMin;
-    TPixel32 *dnEndPix = dnRow + xMin + kMax + 1;
-
-    //  (xL, yL) sono le coordinate (inizializzate per il round)
-    //  in versione "TLonghizzata" del pixel corrente di up
-    int xL = xL0 + (kMin - 1) * deltaXL;  //  inizializza xL
-    int yL = yL0 + (kMin - 1) * deltaYL;  //  inizializza yL
-
-    //  scorre i pixel sulla y-esima scanline di boundingBoxD
-    for (; dnPix < dnEndPix; ++dnPix) {
-      xL += deltaXL;
-      yL += deltaYL;
-
-      //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e'
-      //  approssimato con (xI, yI)
-      int xI = xL >> PADN;  //  round
-      int yI = yL >> PADN;  //  round
 
-      assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
-             (yI <= up->getLy() - 1));
-
-      TPixelGR8 *upPix = upBasePix + (yI * upWrap + xI);
-      if (colorScale == TPixel32::Black) {
-        if (upPix->value == 0)
-          dnPix->r = dnPix->g = dnPix->b = 0;
-        else if (upPix->value == 255)
-          dnPix->r = dnPix->g = dnPix->b = upPix->value;
-        else
-          *dnPix = quickOverPix(*dnPix, *upPix);
-        dnPix->m = 255;
-      } else {
-        TPixel32 upPix32(upPix->value, upPix->value, upPix->value, 255);
-        upPix32 = applyColorScale(upPix32, colorScale);
+      //  calcola kMinY, kMaxY
+      if (deltaYL == 0) {
+        //  [a, b] orizzontale esterno ad up+(bordo destro/basso)
+        if ((yL0 < 0) || (lyPred < yL0)) continue;
+        // altrimenti usa solo
+        // kMinX, kMaxX ((deltaXL != 0) || (deltaYL != 0))
+      } else if (deltaYL > 0) {
+        //  [a, b] esterno ad up+(bordo destro/basso)
+        if (lyPred < yL0) continue;
+
+        kMaxY = (lyPred - yL0) / deltaYL;  //  floor
+        if (yL0 < 0) {
+          kMinY = ((-yL0) + deltaYL - 1) / deltaYL;  //  ceil
+        }
+      } else  //  (deltaYL < 0)
+      {
+        //  [a, b] esterno ad up+(bordo destro/basso)
+        if (yL0 < 0) continue;
+
+        kMaxY = yL0 / (-deltaYL);  //  floor
+        if (lyPred < yL0) {
+          kMinY = (yL0 - lyPred - deltaYL - 1) / (-deltaYL);  //  ceil
+        }
+      }
 
-        if (upPix32.m == 255)
-          *dnPix = upPix32;
-        else
-          *dnPix = quickOverPix(*dnPix, upPix32);
+      //  calcola kMin, kMax effettuando anche il clippind su dn
+      int kMin = std::max({kMinX, kMinY, (int)0});
+      int kMax = std::min({kMaxX, kMaxY, xMax - xMin});
+
+      TPixel32 *dnPix    = dnRow + xMin + kMin;
+      TPixel32 *dnEndPix = dnRow + xMin + kMax + 1;
+
+      //  (xL, yL) sono le coordinate (inizializzate per il round)
+      //  in versione "TLonghizzata" del pixel corrente di up
+      int xL = xL0 + (kMin - 1) * deltaXL;  //  inizializza xL
+      int yL = yL0 + (kMin - 1) * deltaYL;  //  inizializza yL
+
+      //  scorre i pixel sulla y-esima scanline di boundingBoxD
+      for (; dnPix < dnEndPix; ++dnPix) {
+        xL += deltaXL;
+        yL += deltaYL;
+
+        //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e'
+        //  approssimato con (xI, yI)
+        int xI = xL >> PADN;  //  round
+        int yI = yL >> PADN;  //  round
+
+        assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
+               (yI <= up->getLy() - 1));
+
+        TPixelGR8 *upPix = upBasePix + (yI * upWrap + xI);
+        if (colorScale == TPixel32::Black) {
+          if (upPix->value == 0)
+            dnPix->r = dnPix->g = dnPix->b = 0;
+          else if (upPix->value == 255)
+            dnPix->r = dnPix->g = dnPix->b = upPix->value;
+          else
+            *dnPix = quickOverPix(*dnPix, *upPix);
+          dnPix->m = 255;
+        } else {
+          TPixel32 upPix32(upPix->value, upPix->value, upPix->value, 255);
+          upPix32 = applyColorScale(upPix32, colorScale);
+
+          if (upPix32.m == 255)
+            *dnPix = upPix32;
+          else
+            *dnPix = quickOverPix(*dnPix, upPix32);
+        }
       }
     }
-  }
+  });
   dn->unlock();
   up->unlock();
 }
@@ -1120,97 +1145,97 @@ void doQuickPutFilter(const TRaster32P &dn, const TRaster32P &up, double sx,
   up->lock();
 
   TPixel32 *upBasePix = up->pixels();
-  TPixel32 *dnRow     = dn->pixels(yMin + kMinY);
 
   //  (xL, yL) sono le coordinate (inizializzate per il round)
   //  in versione "TLonghizzata" del pixel corrente di up
 
-  //  inizializza yL
-  int yL = yL0 + (kMinY - 1) * deltaYL;
-
   //  scorre le scanline di boundingBoxD
-  for (int kY = kMinY; kY <= kMaxY; kY++, dnRow += dnWrap) {
-    //  inizializza xL
-    int xL = xL0 + (kMinX - 1) * deltaXL;
-    yL += deltaYL;
-    //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e' approssimato
-    //  con (xI, yI)
-    int yI = yL >> PADN;  //  troncato
+  putInBands(kMinY, kMaxY, kMaxX - kMinX + 1, [&](int kY0, int kY1) {
+    TPixel32 *dnRow = dn->pixels(yMin + kY0);
+    int yL          = yL0 + (kY0 - 1) * deltaYL;
+    for (int kY = kY0; kY <= kY1; kY++, dnRow += dnWrap) {
+      //  inizializza xL
+      int xL = xL0 + (kMinX - 1) * deltaXL;
+      yL += deltaYL;
+      //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e' approssimato
+      //  con (xI, yI)
+      int yI = yL >> PADN;  //  troncato
 
-    //  filtro bilineare 4 pixels: calcolo degli y-pesi
-    int yWeight1 = (yL & MASKN);
-    int yWeight0 = (1 << PADN) - yWeight1;
+      //  filtro bilineare 4 pixels: calcolo degli y-pesi
+      int yWeight1 = (yL & MASKN);
+      int yWeight0 = (1 << PADN) - yWeight1;
 
-    TPixel32 *dnPix    = dnRow + xMin + kMinX;
-    TPixel32 *dnEndPix = dnRow + xMin + kMaxX + 1;
+      TPixel32 *dnPix    = dnRow + xMin + kMinX;
+      TPixel32 *dnEndPix = dnRow + xMin + kMaxX + 1;
 
-    //  scorre i pixel sulla (yMin + kY)-esima scanline di dn
-    for (; dnPix < dnEndPix; ++dnPix) {
-      xL += deltaXL;
-      //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e'
-      //  approssimato con (xI, yI)
-      int xI = xL >> PADN;  //  troncato
+      //  scorre i pixel sulla (yMin + kY)-esima scanline di dn
+      for (; dnPix < dnEndPix; ++dnPix) {
+        xL += deltaXL;
+        //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e'
+        //  approssimato con (xI, yI)
+        int xI = xL >> PADN;  //  troncato
 
-      assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
-             (yI <= up->getLy() - 1));
+        assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
+               (yI <= up->getLy() - 1));
 
-      //  (xI, yI)
-      TPixel32 *upPix00 = upBasePix + (yI * upWrap + xI);
+        //  (xI, yI)
+        TPixel32 *upPix00 = upBasePix + (yI * upWrap + xI);
 
-      //  (xI + 1, yI)
-      TPixel32 *upPix10 = upPix00 + 1;
+        //  (xI + 1, yI)
+        TPixel32 *upPix10 = upPix00 + 1;
 
-      //  (xI, yI + 1)
-      TPixel32 *upPix01 = upPix00 + upWrap;
+        //  (xI, yI + 1)
+        TPixel32 *upPix01 = upPix00 + upWrap;
 
-      //  (xI + 1, yI + 1)
-      TPixel32 *upPix11 = upPix00 + upWrap + 1;
+        //  (xI + 1, yI + 1)
+        TPixel32 *upPix11 = upPix00 + upWrap + 1;
 
-      //  filtro bilineare 4 pixels: calcolo degli x-pesi
-      int xWeight1 = (xL & MASKN);
-      int xWeight0 = (1 << PADN) - xWeight1;
+        //  filtro bilineare 4 pixels: calcolo degli x-pesi
+        int xWeight1 = (xL & MASKN);
+        int xWeight0 = (1 << PADN) - xWeight1;
 
-      //  filtro bilineare 4 pixels: media pesata sui singoli canali
-      int rColDownTmp =
-          (xWeight0 * (upPix00->r) + xWeight1 * ((upPix10)->r)) >> PADN;
+        //  filtro bilineare 4 pixels: media pesata sui singoli canali
+        int rColDownTmp =
+            (xWeight0 * (upPix00->r) + xWeight1 * ((upPix10)->r)) >> PADN;
 
-      int gColDownTmp =
-          (xWeight0 * (upPix00->g) + xWeight1 * ((upPix10)->g)) >> PADN;
+        int gColDownTmp =
+            (xWeight0 * (upPix00->g) + xWeight1 * ((upPix10)->g)) >> PADN;
 
-      int bColDownTmp =
-          (xWeight0 * (upPix00->b) + xWeight1 * ((upPix10)->b)) >> PADN;
+        int bColDownTmp =
+            (xWeight0 * (upPix00->b) + xWeight1 * ((upPix10)->b)) >> PADN;
 
-      int rColUpTmp =
-          (xWeight0 * ((upPix01)->r) + xWeight1 * ((upPix11)->r)) >> PADN;
+        int rColUpTmp =
+            (xWeight0 * ((upPix01)->r) + xWeight1 * ((upPix11)->r)) >> PADN;
 
-      int gColUpTmp =
-          (xWeight0 * ((upPix01)->g) + xWeight1 * ((upPix11)->g)) >> PADN;
+        int gColUpTmp =
+            (xWeight0 * ((upPix01)->g) + xWeight1 * ((upPix11)->g)) >> PADN;
 
-      int bColUpTmp =
-          (xWeight0 * ((upPix01)->b) + xWeight1 * ((upPix11)->b)) >> PADN;
+        int bColUpTmp =
+            (xWeight0 * ((upPix01)->b) + xWeight1 * ((upPix11)->b)) >> PADN;
 
-      unsigned char rCol =
-          (unsigned char)((yWeight0 * rColDownTmp + yWeight1 * rColUpTmp) >>
-                          PADN);
+        unsigned char rCol =
+            (unsigned char)((yWeight0 * rColDownTmp + yWeight1 * rColUpTmp) >>
+                            PADN);
 
-      unsigned char gCol =
-          (unsigned char)((yWeight0 * gColDownTmp + yWeight1 * gColUpTmp) >>
-                          PADN);
+        unsigned char gCol =
+            (unsigned char)((yWeight0 * gColDownTmp + yWeight1 * gColUpTmp) >>
+                            PADN);
 
-      unsigned char bCol =
-          (unsigned char)((yWeight0 * bColDownTmp + yWeight1 * bColUpTmp) >>
-                          PADN);
+        unsigned char bCol =
+            (unsigned char)((yWeight0 * bColDownTmp + yWeight1 * bColUpTmp) >>
+                            PADN);
 
-      TPixel32 upPix = TPixel32(rCol, gCol, bCol, upPix00->m);
+        TPixel32 upPix = TPixel32(rCol, gCol, bCol, upPix00->m);
 
-      if (upPix.m == 0)
-        continue;
-      else if (upPix.m == 255)
-        *dnPix = upPix;
-      else
-        *dnPix = quickOverPix(*dnPix, upPix);
+        if (upPix.m == 0)
+          continue;
+        else if (upPix.m == 255)
+          *dnPix = upPix;
+        else
+          *dnPix = quickOverPix(*dnPix, upPix);
+      }
     }
-  }
+  });
   dn->unlock();
   up->unlock();
 }
@@ -1397,58 +1422,58 @@ void doQuickPutNoFilter(const TRaster32P &dn, const TRaster32P &up, double sx,
   up->lock();
 
   TPixel32 *upBasePix = up->pixels();
-  TPixel32 *dnRow     = dn->pixels(yMin + kMinY);
 
   //  (xL, yL) sono le coordinate (inizializzate per il round)
   //  in versione "TLonghizzata" del pixel corrente di up
 
-  //  inizializza yL
-  int yL = yL0 + (kMinY - 1) * deltaYL;
-
   //  scorre le scanline di boundingBoxD
-  for (int kY = kMinY; kY <= kMaxY; kY++, dnRow += dnWrap) {
-    //  inizializza xL
-    int xL = xL0 + (kMinX - 1) * deltaXL;
-    yL += deltaYL;
+  putInBands(kMinY, kMaxY, kMaxX - kMinX + 1, [&](int kY0, int kY1) {
+    TPixel32 *dnRow = dn->pixels(yMin + kY0);
+    int yL          = yL0 + (kY0 - 1) * deltaYL;
+    for (int kY = kY0; kY <= kY1; kY++, dnRow += dnWrap) {
+      //  inizializza xL
+      int xL = xL0 + (kMinX - 1) * deltaXL;
+      yL += deltaYL;
 
-    //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e' approssimato
-    //  con (xI, yI)
-    int yI = yL >> PADN;  //  round
+      //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e' approssimato
+      //  con (xI, yI)
+      int yI = yL >> PADN;  //  round
 
-    TPixel32 *dnPix    = dnRow + xMin + kMinX;
-    TPixel32 *dnEndPix = dnRow + xMin + kMaxX + 1;
+      TPixel32 *dnPix    = dnRow + xMin + kMinX;
+      TPixel32 *dnEndPix = dnRow + xMin + kMaxX + 1;
 
-    //  scorre i pixel sulla (yMin + kY)-esima scanline di dn
-    for (; dnPix < dnEndPix; ++dnPix) {
-      xL += deltaXL;
-      //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e'
-      //  approssimato con (xI, yI)
-      int xI = xL >> PADN;  //	round
+      //  scorre i pixel sulla (yMin + kY)-esima scanline di dn
+      for (; dnPix < dnEndPix; ++dnPix) {
+        xL += deltaXL;
+        //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e'
+        //  approssimato con (xI, yI)
+        int xI = xL >> PADN;  //	round
 
-      assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
-             (yI <= up->getLy() - 1));
+        assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
+               (yI <= up->getLy() - 1));
 
-      TPixel32 upPix = *(upBasePix + (yI * upWrap + xI));
+        TPixel32 upPix = *(upBasePix + (yI * upWrap + xI));
 
-      if (firstColumn) upPix.m = TPixel32::maxChannelValue;
+        if (firstColumn) upPix.m = TPixel32::maxChannelValue;
 
-      if (upPix.m == 0 || (whiteTransp && upPix == TPixel::White)) continue;
+        if (upPix.m == 0 || (whiteTransp && upPix == TPixel::White)) continue;
 
-      if (colorScale != TPixel32::Black)
-        upPix = applyColorScale(upPix, colorScale, doPremultiply);
+        if (colorScale != TPixel32::Black)
+          upPix = applyColorScale(upPix, colorScale, doPremultiply);
 
-      if (doRasterDarkenBlendedView)
-        *dnPix = quickOverPixDarkenBlended(*dnPix, upPix);
-      else {
-        if (upPix.m == 255)
-          *dnPix = upPix;
-        else if (doPremultiply)
-          *dnPix = quickOverPixPremult(*dnPix, upPix);
-        else
-          *dnPix = quickOverPix(*dnPix, upPix);
+        if (doRasterDarkenBlendedView)
+          *dnPix = quickOverPixDarkenBlended(*dnPix, upPix);
+        else {
+          if (upPix.m == 255)
+            *dnPix = upPix;
+          else if (doPremultiply)
+            *dnPix = quickOverPixPremult(*dnPix, upPix);
+          else
+            *dnPix = quickOverPix(*dnPix, upPix);
+        }
       }
     }
-  }
+  });
   dn->unlock();
   up->unlock();
 }
@@ -1538,54 +1563,55 @@ void doQuickPutNoFilter(const TRaster32P &dn, const TRasterGR8P &up, double sx,
   up->lock();
 
   TPixelGR8 *upBasePix = up->pixels();
-  TPixel32 *dnRow      = dn->pixels(yMin + kMinY);
-
-  int yL = yL0 + (kMinY - 1) * deltaYL;
-
-  for (int kY = kMinY; kY <= kMaxY; kY++, dnRow += dnWrap) {
-    //  inizializza xL
-    int xL = xL0 + (kMinX - 1) * deltaXL;
-    yL += deltaYL;
 
-    //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e' approssimato
-    //  con (xI, yI)
-    int yI = yL >> PADN;  //  round
+  putInBands(kMinY, kMaxY, kMaxX - kMinX + 1, [&](int kY0, int kY1) {
+    TPixel32 *dnRow = dn->pixels(yMin + kY0);
+    int yL          = yL0 + (kY0 - 1) * deltaYL;
+    for (int kY = kY0; kY <= kY1; kY++, dnRow += dnWrap) {
+      //  inizializza xL
+      int xL = xL0 + (kMinX - 1) * deltaXL;
+      yL += deltaYL;
 
-    TPixel32 *dnPix    = dnRow + xMin + kMinX;
-    TPixel32 *dnEndPix = dnRow + xMin + kMaxX + 1;
+      //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e' approssimato
+      //  con (xI, yI)
+      int yI = yL >> PADN;  //  round
 
-    //  scorre i pixel sulla (yMin + kY)-esima scanline di dn
-    for (; dnPix < dnEndPix; ++dnPix) {
-      xL += deltaXL;
-      int xI = xL >> PADN;  //	round
+      TPixel32 *dnPix    = dnRow + xMin + kMinX;
+      TPixel32 *dnEndPix = dnRow + xMin + kMaxX + 1;
 
-      assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
-             (yI <= up->getLy() - 1));
+      //  scorre i pixel sulla (yMin + kY)-esima scanline di dn
+      for (; dnPix < dnEndPix; ++dnPix) {
+        xL += deltaXL;
+        int xI = xL >> PADN;  //	round
 
-      TPixelGR8 *upPix = upBasePix + (yI * upWrap + xI);
-      if (colorScale == TPixel32::Black) {
-        dnPix->r = dnPix->g = dnPix->b = upPix->value;
-        dnPix->m                       = 255;
-      } else {
-        TPixel32 upPix32(upPix->value, upPix->value, upPix->value, 255);
-        upPix32 = applyColorScale(upPix32, colorScale);
+        assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
+               (yI <= up->getLy() - 1));
 
-        if (upPix32.m == 255)
-          *dnPix = upPix32;
-        else
-          *dnPix = quickOverPix(*dnPix, upPix32);
+        TPixelGR8 *upPix = upBasePix + (yI * upWrap + xI);
+        if (colorScale == TPixel32::Black) {
+          dnPix->r = dnPix->g = dnPix->b = upPix->value;
+          dnPix->m                       = 255;
+        } else {
+          TPixel32 upPix32(upPix->value, upPix->value, upPix->value, 255);
+          upPix32 = applyColorScale(upPix32, colorScale);
+
+          if (upPix32.m == 255)
+            *dnPix = upPix32;
+          else
+            *dnPix = quickOverPix(*dnPix, upPix32);
+        }
+
+        /*
+  if (upPix->value == 0)
+  dnPix->r = dnPix->g = dnPix->b = dnPix->m = upPix->value;
+  else if (upPix->value == 255)
+  dnPix->r = dnPix->g = dnPix->b = dnPix->m = upPix->value;
+  else
+  *dnPix = quickOverPix(*dnPix, *upPix);
+  */
       }
-
-      /*
-if (upPix->value == 0)
-dnPix->r = dnPix->g = dnPix->b = dnPix->m = upPix->value;
-else if (upPix->value == 255)
-dnPix->r = dnPix->g = dnPix->b = dnPix->m = upPix->value;
-else
-*dnPix = quickOverPix(*dnPix, *upPix);
-*/
     }
-  }
+  });
   dn->unlock();
   up->unlock();
 }
@@ -1653,196 +1679,198 @@ void doQuickResampleFilter(const TRaster32P &dn, const TRaster32P &up,
   dn->lock();
   up->lock();
 
-  TPixel32 *dnRow     = dn->pixels(yMin);
   TPixel32 *upBasePix = up->pixels();
 
   //  scorre le scanline di boundingBoxD
-  for (int y = yMin; y <= yMax; y++, dnRow += dnWrap) {
-    //  (1)  equazione k-parametrica della y-esima scanline di boundingBoxD:
-    //         (xMin, y) + k*(1, 0),  k = 0, ..., (xMax - xMin)
-    //
-    //  (2)  equazione k-parametrica dell'immagine mediante invAff di (1):
-    //         invAff*(xMin, y) + k*(deltaXD, deltaYD),
-    //           k = kMin, ..., kMax
-    //           con 0 <= kMin <= kMax <= (xMax - xMin)
-
-    //  calcola kMin, kMax per la scanline corrente intersecando
-    //  la (2) con i lati di up
-
-    //  il segmento [a, b] di up e' la controimmagine mediante aff della
-    //  porzione di scanline  [ (xMin, y), (xMax, y) ] di dn
-
-    //  TPointD b = invAff*TPointD(xMax, y);
-    TPointD a = invAff * TPointD(xMin, y);
-
-    //  (xL0, yL0) sono le coordinate di a in versione "TLonghizzata"
-    //  0 <= xL0 + k*deltaXL
-    //    <= (up->getLx() - 2)*(1<<PADN),
-    //  0 <= kMinX
-    //    <= kMin
-    //    <= k
-    //    <= kMax
-    //    <= kMaxX
-    //    <= (xMax - xMin)
-
-    //  0 <= yL0 + k*deltaYL
-    //    <= (up->getLy() - 2)*(1<<PADN),
-    //  0 <= kMinY
-    //    <= kMin
-    //    <= k
-    //    <= kMax
-    //    <= kMaxY
-    //    <= (xMax - xMin)
-
-    //  xL0 inizializzato
-    int xL0 = tround(a.x * (1 << PADN));
-
-    //  yL0 inizializzato
-    int yL0 = tround(a.y * (1 << PADN));
-
-    //  calcola kMinX, kMaxX, kMinY, kMaxY
-    int kMinX = 0, kMaxX = xMax - xMin;  //  clipping su dn
-    int kMinY = 0, kMaxY = xMax - xMin;  //  clipping su dn
-
-    //  0 <= xL0 + k*deltaXL <= (up->getLx() - 2)*(1<<PADN)
-    //             <=>
-    //  0 <= xL0 + k*deltaXL <= lxPred
-
-    //  0 <= yL0 + k*deltaYL <= (up->getLy() - 2)*(1<<PADN)
-    //             <=>
-    //  0 <= yL0 + k*deltaYL <= lyPred
-
-    //  calcola kMinX, kMaxX
-    if (deltaXL == 0) {
-      //  [a, b] verticale esterno ad up contratto
-      if ((xL0 < 0) || (lxPred < xL0)) continue;
-      //  altrimenti usa solo
-      //  kMinY, kMaxY ((deltaXL != 0) || (deltaYL != 0))
-    } else if (deltaXL > 0) {
-      //  [a, b] esterno ad up+(bordo destro)
-      if (lxPred < xL0) continue;
-
-      kMaxX = (lxPred - xL0) / deltaXL;  //  floor
-      if (xL0 < 0) {
-        kMinX = ((-xL0) + deltaXL - 1) / deltaXL;  //  ceil
-      }
-    } else  //  (deltaXL < 0)
-    {
-      //  [a, b] esterno ad up contratto
-      if (xL0 < 0) continue;
-
-      kMaxX = xL0 / (-deltaXL);  //  floor
-      if (lxPred < xL0) {
-        kMinX = (xL0 - lxPred - deltaXL - 1) / (-deltaXL);  //  ceil
+  putInBands(yMin, yMax, xMax - xMin + 1, [&](int y0, int y1) {
+    TPixel32 *dnRow = dn->pixels(y0);
+    for (int y = y0; y <= y1; y++, dnRow += dnWrap) {
+      //  (1)  equazione k-parametrica della y-esima scanline di boundingBoxD:
+      //         (xMin, y) + k*(1, 0),  k = 0, ..., (xMax - xMin)
+      //
+      //  (2)  equazione k-parametrica dell'immagine mediante invAff di (1):
+      //         invAff*(xMin, y) + k*(deltaXD, deltaYD),
+      //           k = kMin, ..., kMax
+      //           con 0 <= kMin <= kMax <= (xMax - xMin)
+
+      //  calcola kMin, kMax per la scanline corrente intersecando
+      //  la (2) con i lati di up
+
+      //  il segmento [a, b] di up e' la controimmagine mediante aff della
+      //  porzione di scanline  [ (xMin, y), (xMax, y) ] di dn
+
+      //  TPointD b = invAff*TPointD(xMax, y);
+      TPointD a = invAff * TPointD(xMin, y);
+
+      //  (xL0, yL0) sono le coordinate di a in versione "TLonghizzata"
+      //  0 <= xL0 + k*deltaXL
+      //    <= (up->getLx() - 2)*(1<<PADN),
+      //  0 <= kMinX
+      //    <= kMin
+      //    <= k
+      //    <= kMax
+      //    <= kMaxX
+      //    <= (xMax - xMin)
+
+      //  0 <= yL0 + k*deltaYL
+      //    <= (up->getLy() - 2)*(1<<PADN),
+      //  0 <= kMinY
+      //    <= kMin
+      //    <= k
+      //    <= kMax
+      //    <= kMaxY
+      //    <= (xMax - xMin)
+
+      //  xL0 inizializzato
+      int xL0 = tround(a.x * (1 << PADN));
+
+      //  yL0 inizializzato
+      int yL0 = tround(a.y * (1 << PADN));
+
+      //  calcola kMinX, kMaxX, kMinY, kMaxY
+      int kMinX = 0, kMaxX = xMax - xMin;  //  clipping su dn
+      int kMinY = 0, kMaxY = xMax - xMin;  //  clipping su dn
+
+      //  0 <= xL0 + k*deltaXL <= (up->getLx() - 2)*(1<<PADN)
+      //             <=>
+      //  0 <= xL0 + k*deltaXL <= lxPred
+
+      //  0 <= yL0 + k*deltaYL <= (up->getLy() - 2)*(1<<PADN)
+      //             <=>
+      //  0 <= yL0 + k*deltaYL <= lyPred
+
+      //  calcola kMinX, kMaxX
+      if (deltaXL == 0) {
+        //  [a, b] verticale esterno ad up contratto
+        if ((xL0 < 0) || (lxPred < xL0)) continue;
+        //  altrimenti usa solo
+        //  kMinY, kMaxY ((deltaXL != 0) || (deltaYL != 0))
+      } else if (deltaXL > 0) {
+        //  [a, b] esterno ad up+(bordo destro)
+        if (lxPred < xL0) continue;
+
+        kMaxX = (lxPred - xL0) / deltaXL;  //  floor
+        if (xL0 < 0) {
+          kMinX = ((-xL0) + deltaXL - 1) / deltaXL;  //  ceil
+        }
+      } else  //  (deltaXL < 0)
+      {
+        //  [a, b] esterno ad up contratto
+        if (xL0 < 0) continue;
+
+        kMaxX = xL0 / (-deltaXL);  //  floor
+        if (lxPred < xL0) {
+          kMinX = (xL0 - lxPred - deltaXL - 1) / (-deltaXL);  //  ceil
+        }
       }
-    }
 
-    //  calcola kMinY, kMaxY
-    if (deltaYL == 0) {
-      // [a, b] orizzontale esterno ad up contratto
-      if ((yL0 < 0) || (lyPred < yL0)) continue;
-      //  altrimenti usa solo
-      //  kMinX, kMaxX ((deltaXL != 0) || (deltaYL != 0))
-    } else if (deltaYL > 0) {
-      //  [a, b] esterno ad up contratto
-      if (lyPred < yL0) continue;
-
-      kMaxY = (lyPred - yL0) / deltaYL;  //  floor
-      if (yL0 < 0) {
-        kMinY = ((-yL0) + deltaYL - 1) / deltaYL;  //  ceil
-      }
-    } else  //  (deltaYL < 0)
-    {
-      //  [a, b] esterno ad up contratto
-      if (yL0 < 0) continue;
-
-      kMaxY = yL0 / (-deltaYL);  //  floor
-      if (lyPred < yL0) {
-        kMinY = (yL0 - lyPred - deltaYL - 1) / (-deltaYL);  //  ceil
+      //  calcola kMinY, kMaxY
+      if (deltaYL == 0) {
+        // [a, b] orizzontale esterno ad up contratto
+        if ((yL0 < 0) || (lyPred < yL0)) continue;
+        //  altrimenti usa solo
+        //  kMinX, kMaxX ((deltaXL != 0) || (deltaYL != 0))
+      } else if (deltaYL > 0) {
+        //  [a, b] esterno ad up contratto
+        if (lyPred < yL0) continue;
+
+        kMaxY = (lyPred - yL0) / deltaYL;  //  floor
+        if (yL0 < 0) {
+          kMinY = ((-yL0) + deltaYL - 1) / deltaYL;  //  ceil
+        }
+      } else  //  (deltaYL < 0)
+      {
+        //  [a, b] esterno ad up contratto
+        if (yL0 < 0) continue;
+
+        kMaxY = yL0 / (-deltaYL);  //  floor
+        if (lyPred < yL0) {
+          kMinY = (yL0 - lyPred - deltaYL - 1) / (-deltaYL);  //  ceil
+        }
       }
-    }
-
-    //  calcola kMin, kMax effettuando anche il clippind su dn
-    int kMin = std::max({kMinX, kMinY, (int)0});
-    int kMax = std::min({kMaxX, kMaxY, xMax - xMin});
-
-    TPixel32 *dnPix    = dnRow + xMin + kMin;
-    TPixel32 *dnEndPix = dnRow + xMin + kMax + 1;
-
-    //  (xL, yL) sono le coordinate (inizializzate per il round)
-    //  in versione "longhizzata" del pixel corrente di up
-    int xL = xL0 + (kMin - 1) * deltaXL;  //  inizializza xL
-    int yL = yL0 + (kMin - 1) * deltaYL;  //  inizializza yL
-
-    //  scorre i pixel sulla y-esima scanline di boundingBoxD
-    for (; dnPix < dnEndPix; ++dnPix) {
-      xL += deltaXL;
-      yL += deltaYL;
-      //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e'
-      //  approssimato con (xI, yI)
-      int xI = xL >> PADN;  //	troncato
-      int yI = yL >> PADN;  //	troncato
-
-      assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
-             (yI <= up->getLy() - 1));
-
-      //  (xI, yI)
-      TPixel32 *upPix00 = upBasePix + (yI * upWrap + xI);
 
-      //  (xI + 1, yI)
-      TPixel32 *upPix10 = upPix00 + 1;
-
-      //  (xI, yI + 1)
-      TPixel32 *upPix01 = upPix00 + upWrap;
-
-      //  (xI + 1, yI + 1)
-      TPixel32 *upPix11 = upPix00 + upWrap + 1;
-
-      //  filtro bilineare 4 pixels: calcolo dei pesi
-      int xWeight1 = (xL & MASKN);
-      int xWeight0 = (1 << PADN) - xWeight1;
-      int yWeight1 = (yL & MASKN);
-      int yWeight0 = (1 << PADN) - yWeight1;
-
-      //  filtro bilineare 4 pixels: media pesata sui singoli canali
-      int rColDownTmp =
-          (xWeight0 * (upPix00->r) + xWeight1 * ((upPix10)->r)) >> PADN;
-
-      int gColDownTmp =
-          (xWeight0 * (upPix00->g) + xWeight1 * ((upPix10)->g)) >> PADN;
-
-      int bColDownTmp =
-          (xWeight0 * (upPix00->b) + xWeight1 * ((upPix10)->b)) >> PADN;
-
-      int mColDownTmp =
-          (xWeight0 * (upPix00->m) + xWeight1 * ((upPix10)->m)) >> PADN;
-
-      int rColUpTmp =
-          (xWeight0 * ((upPix01)->r) + xWeight1 * ((upPix11)->r)) >> PADN;
-
-      int gColUpTmp =
-          (xWeight0 * ((upPix01)->g) + xWeight1 * ((upPix11)->g)) >> PADN;
-
-      int bColUpTmp =
-          (xWeight0 * ((upPix01)->b) + xWeight1 * ((upPix11)->b)) >> PADN;
-
-      int mColUpTmp =
-          (xWeight0 * ((upPix01)->m) + xWeight1 * ((upPix11)->m)) >> PADN;
-
-      dnPix->r =
-          (unsigned char)((yWeight0 * rColDownTmp + yWeight1 * rColUpTmp) >>
-                          PADN);
-      dnPix->g =
-          (unsigned char)((yWeight0 * gColDownTmp + yWeight1 * gColUpTmp) >>
-                          PADN);
-      dnPix->b =
-          (unsigned char)((yWeight0 * bColDownTmp + yWeight1 * bColUpTmp) >>
-                          PADN);
-      dnPix->m =
-          (unsigned char)((yWeight0 * mColDownTmp + yWeight1 * mColUpTmp) >>
-                          PADN);
+      //  calcola kMin, kMax effettuando anche il clippind su dn
+      int kMin = std::max({kMinX, kMinY, (int)0});
+      int kMax = std::min({kMaxX, kMaxY, xMax - xMin});
+
+      TPixel32 *dnPix    = dnRow + xMin + kMin;
+      TPixel32 *dnEndPix = dnRow + xMin + kMax + 1;
+
+      //  (xL, yL) sono le coordinate (inizializzate per il round)
+      //  in versione "longhizzata" del pixel corrente di up
+      int xL = xL0 + (kMin - 1) * deltaXL;  //  inizializza xL
+      int yL = yL0 + (kMin - 1) * deltaYL;  //  inizializza yL
+
+      //  scorre i pixel sulla y-esima scanline di boundingBoxD
+      for (; dnPix < dnEndPix; ++dnPix) {
+        xL += deltaXL;
+        yL += deltaYL;
+        //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e'
+        //  approssimato con (xI, yI)
+        int xI = xL >> PADN;  //	troncato
+        int yI = yL >> PADN;  //	troncato
+
+        assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
+               (yI <= up->getLy() - 1));
+
+        //  (xI, yI)
+        TPixel32 *upPix00 = upBasePix + (yI * upWrap + xI);
+
+        //  (xI + 1, yI)
+        TPixel32 *upPix10 = upPix00 + 1;
+
+        //  (xI, yI + 1)
+        TPixel32 *upPix01 = upPix00 + upWrap;
+
+        //  (xI + 1, yI + 1)
+        TPixel32 *upPix11 = upPix00 + upWrap + 1;
+
+        //  filtro bilineare 4 pixels: calcolo dei pesi
+        int xWeight1 = (xL & MASKN);
+        int xWeight0 = (1 << PADN) - xWeight1;
+        int yWeight1 = (yL & MASKN);
+        int yWeight0 = (1 << PADN) - yWeight1;
+
+        //  filtro bilineare 4 pixels: media pesata sui singoli canali
+        int rColDownTmp =
+            (xWeight0 * (upPix00->r) + xWeight1 * ((upPix10)->r)) >> PADN;
+
+        int gColDownTmp =
+            (xWeight0 * (upPix00->g) + xWeight1 * ((upPix10)->g)) >> PADN;
+
+        int bColDownTmp =
+            (xWeight0 * (upPix00->b) + xWeight1 * ((upPix10)->b)) >> PADN;
+
+        int mColDownTmp =
+            (xWeight0 * (upPix00->m) + xWeight1 * ((upPix10)->m)) >> PADN;
+
+        int rColUpTmp =
+            (xWeight0 * ((upPix01)->r) + xWeight1 * ((upPix11)->r)) >> PADN;
+
+        int gColUpTmp =
+            (xWeight0 * ((upPix01)->g) + xWeight1 * ((upPix11)->g)) >> PADN;
+
+        int bColUpTmp =
+            (xWeight0 * ((upPix01)->b) + xWeight1 * ((upPix11)->b)) >> PADN;
+
+        int mColUpTmp =
+            (xWeight0 * ((upPix01)->m) + xWeight1 * ((upPix11)->m)) >> PADN;
+
+        dnPix->r =
+            (unsigned char)((yWeight0 * rColDownTmp + yWeight1 * rColUpTmp) >>
+                            PADN);
+        dnPix->g =
+            (unsigned char)((yWeight0 * gColDownTmp + yWeight1 * gColUpTmp) >>
+                            PADN);
+        dnPix->b =
+            (unsigned char)((yWeight0 * bColDownTmp + yWeight1 * bColUpTmp) >>
+                            PADN);
+        dnPix->m =
+            (unsigned char)((yWeight0 * mColDownTmp + yWeight1 * mColUpTmp) >>
+                            PADN);
+      }
     }
-  }
+  });
   dn->unlock();
   up->unlock();
 }
@@ -1888,105 +1916,108 @@ void doQuickResampleFilter(const TRaster32P &dn, const TRasterGR8P &up,
   dn->lock();
   up->lock();
 
-  TPixel32 *dnRow      = dn->pixels(yMin);
   TPixelGR8 *upBasePix = up->pixels();
 
-  for (int y = yMin; y <= yMax; y++, dnRow += dnWrap) {
-    TPointD a = invAff * TPointD(xMin, y);
-    int xL0   = tround(a.x * (1 << PADN));
-    int yL0   = tround(a.y * (1 << PADN));
-    int kMinX = 0, kMaxX = xMax - xMin;  //  clipping su dn
-    int kMinY = 0, kMaxY = xMax - xMin;  //  clipping su dn
-
-    if (deltaXL == 0) {
-      if ((xL0 < 0) || (lxPred < xL0)) continue;
-    } else if (deltaXL > 0) {
-      if (lxPred < xL0) continue;
-
-      kMaxX = (lxPred - xL0) / deltaXL;  //  floor
-      if (xL0 < 0) {
-        kMinX = ((-xL0) + deltaXL - 1) / deltaXL;  //  ceil
-      }
-    } else {
-      if (xL0 < 0) continue;
+  putInBands(yMin, yMax, xMax - xMin + 1, [&](int y0, int y1) {
+    TPixel32 *dnRow = dn->pixels(y0);
+    for (int y = y0; y <= y1; y++, dnRow += dnWrap) {
+      TPointD a = invAff * TPointD(xMin, y);
+      int xL0   = tround(a.x * (1 << PADN));
+      int yL0   = tround(a.y * (1 << PADN));
+      int kMinX = 0, kMaxX = xMax - xMin;  //  clipping su dn
+      int kMinY = 0, kMaxY = xMax - xMin;  //  clipping su dn
+
+      if (deltaXL == 0) {
+        if ((xL0 < 0) || (lxPred < xL0)) continue;
+      } else if (deltaXL > 0) {
+        if (lxPred < xL0) continue;
+
+        kMaxX = (lxPred - xL0) / deltaXL;  //  floor
+        if (xL0 < 0) {
+          kMinX = ((-xL0) + deltaXL - 1) / deltaXL;  //  ceil
+        }
+      } else {
+        if (xL0 < 0) continue;
 
-      kMaxX = xL0 / (-deltaXL);  //  floor
-      if (lxPred < xL0) {
-        kMinX = (xL0 - lxPred - deltaXL - 1) / (-deltaXL);  //  ceil
+        kMaxX = xL0 / (-deltaXL);  //  floor
+        if (lxPred < xL0) {
+          kMinX = (xL0 - lxPred - deltaXL - 1) / (-deltaXL);  //  ceil
+        }
       }
-    }
-
-    if (deltaYL == 0) {
-      if ((yL0 < 0) || (lyPred < yL0)) continue;
-    } else if (deltaYL > 0) {
-      if (lyPred < yL0) continue;
 
-      kMaxY = (lyPred - yL0) / deltaYL;  //  floor
-      if (yL0 < 0) {
-        kMinY = ((-yL0) + deltaYL - 1) / deltaYL;  //  ceil
+      if (deltaYL == 0) {
+        if ((yL0 < 0) || (lyPred < yL0)) continue;
+      } else if (deltaYL > 0) {
+        if (lyPred < yL0) continue;
+
+        kMaxY = (lyPred - yL0) / deltaYL;  //  floor
+        if (yL0 < 0) {
+          kMinY = ((-yL0) + deltaYL - 1) / deltaYL;  //  ceil
+        }
+      } else  //  (deltaYL < 0)
+      {
+        if (yL0 < 0) continue;
+
+        kMaxY = yL0 / (-deltaYL);  //  floor
+        if (lyPred < yL0) {
+          kMinY = (yL0 - lyPred - deltaYL - 1) / (-deltaYL);  //  ceil
+        }
       }
-    } else  //  (deltaYL < 0)
-    {
-      if (yL0 < 0) continue;
 
-      kMaxY = yL0 / (-deltaYL);  //  floor
-      if (lyPred < yL0) {
-        kMinY = (yL0 - lyPred - deltaYL - 1) / (-deltaYL);  //  ceil
-      }
-    }
+      int kMin = std::max({kMinX, kMinY, (int)0});
+      int kMax = std::min({kMaxX, kMaxY, xMax - xMin});
 
-    int kMin = std::max({kMinX, kMinY, (int)0});
-    int kMax = std::min({kMaxX, kMaxY, xMax - xMin});
+      TPixel32 *dnPix    = dnRow + xMin + kMin;
+      TPixel32 *dnEndPix = dnRow + xMin + kMax + 1;
 
-    TPixel32 *dnPix    = dnRow + xMin + kMin;
-    TPixel32 *dnEndPix = dnRow + xMin + kMax + 1;
+      int xL = xL0 + (kMin - 1) * deltaXL;  //  inizializza xL
+      int yL = yL0 + (kMin - 1) * deltaYL;  //  inizializza yL
 
-    int xL = xL0 + (kMin - 1) * deltaXL;  //  inizializza xL
-    int yL = yL0 + (kMin - 1) * deltaYL;  //  inizializza yL
+      for (; dnPix < dnEndPix; ++dnPix) {
+        xL += deltaXL;
+        yL += deltaYL;
 
-    for (; dnPix < dnEndPix; ++dnPix) {
-      xL += deltaXL;
-      yL += deltaYL;
-
-      int xI = xL >> PADN;  //	troncato
-      int yI = yL >> PADN;  //	troncato
+        int xI = xL >> PADN;  //	troncato
+        int yI = yL >> PADN;  //	troncato
 
-      assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
-             (yI <= up->getLy() - 1));
+        assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
+               (yI <= up->getLy() - 1));
 
-      //  (xI, yI)
-      TPixelGR8 *upPix00 = upBasePix + (yI * upWrap + xI);
+        //  (xI, yI)
+        TPixelGR8 *upPix00 = upBasePix + (yI * upWrap + xI);
 
-      //  (xI + 1, yI)
-      TPixelGR8 *upPix10 = upPix00 + 1;
+        //  (xI + 1, yI)
+        TPixelGR8 *upPix10 = upPix00 + 1;
 
-      //  (xI, yI + 1)
-      TPixelGR8 *upPix01 = upPix00 + upWrap;
+        //  (xI, yI + 1)
+        TPixelGR8 *upPix01 = upPix00 + upWrap;
 
-      //  (xI + 1, yI + 1)
-      TPixelGR8 *upPix11 = upPix00 + upWrap + 1;
+        //  (xI + 1, yI + 1)
+        TPixelGR8 *upPix11 = upPix00 + upWrap + 1;
 
-      //  filtro bilineare 4 pixels: calcolo dei pesi
-      int xWeight1 = (xL & MASKN);
-      int xWeight0 = (1 << PADN) - xWeight1;
-      int yWeight1 = (yL & MASKN);
-      int yWeight0 = (1 << PADN) - yWeight1;
+        //  filtro bilineare 4 pixels: calcolo dei pesi
+        int xWeight1 = (xL & MASKN);
+        int xWeight0 = (1 << PADN) - xWeight1;
+        int yWeight1 = (yL & MASKN);
+        int yWeight0 = (1 << PADN) - yWeight1;
 
-      //  filtro bilineare 4 pixels: media pesata sui singoli canali
-      int colDownTmp =
-          (xWeight0 * (upPix00->value) + xWeight1 * ((upPix10)->value)) >> PADN;
+        //  filtro bilineare 4 pixels: media pesata sui singoli canali
+        int colDownTmp =
+            (xWeight0 * (upPix00->value) + xWeight1 * ((upPix10)->value)) >>
+            PADN;
 
-      int colUpTmp =
-          (xWeight0 * ((upPix01)->value) + xWeight1 * ((upPix11)->value)) >>
-          PADN;
+        int colUpTmp =
+            (xWeight0 * ((upPix01)->value) + xWeight1 * ((upPix11)->value)) >>
+            PADN;
 
-      dnPix->r = dnPix->g = dnPix->b =
-          (unsigned char)((yWeight0 * colDownTmp + yWeight1 * colUpTmp) >>
-                          PADN);
+        dnPix->r = dnPix->g = dnPix->b =
+            (unsigned char)((yWeight0 * colDownTmp + yWeight1 * colUpTmp) >>
+                            PADN);
 
-      dnPix->m = 255;
+        dnPix->m = 255;
+      }
     }
-  }
+  });
   dn->unlock();
   up->unlock();
 }
@@ -2036,70 +2067,72 @@ void doQuickResampleColorFilter(const TRaster32P &dn, const TRaster32P &up,
   dn->lock();
   up->lock();
 
-  TPixel32 *dnRow     = dn->pixels(yMin);
   TPixel32 *upBasePix = up->pixels();
 
-  for (int y = yMin; y <= yMax; y++, dnRow += dnWrap) {
-    TPointD a = invAff * TPointD(xMin, y);
-    int xL0   = tround((a.x + 0.5) * (1 << PADN));
-    int yL0   = tround((a.y + 0.5) * (1 << PADN));
-    int kMinX = 0, kMaxX = xMax - xMin;  //  clipping su dn
-    int kMinY = 0, kMaxY = xMax - xMin;  //  clipping su dn
-    if (deltaXL == 0) {
-      if ((xL0 < 0) || (lxPred < xL0)) continue;
-    } else if (deltaXL > 0) {
-      if (lxPred < xL0) continue;
-
-      kMaxX              = (lxPred - xL0) / deltaXL;          //  floor
-      if (xL0 < 0) kMinX = ((-xL0) + deltaXL - 1) / deltaXL;  //  ceil
-    } else                                                    //  (deltaXL < 0)
-    {
-      if (xL0 < 0) continue;
-      kMaxX = xL0 / (-deltaXL);  //  floor
-      if (lxPred < xL0)
-        kMinX = (xL0 - lxPred - deltaXL - 1) / (-deltaXL);  //  ceil
-    }
-    if (deltaYL == 0) {
-      if ((yL0 < 0) || (lyPred < yL0)) continue;
-    } else if (deltaYL > 0) {
-      if (lyPred < yL0) continue;
-
-      kMaxY              = (lyPred - yL0) / deltaYL;          //  floor
-      if (yL0 < 0) kMinY = ((-yL0) + deltaYL - 1) / deltaYL;  //  ceil
-    } else                                                    //  (deltaYL < 0)
-    {
-      if (yL0 < 0) continue;
-
-      kMaxY = yL0 / (-deltaYL);  //  floor
-      if (lyPred < yL0)
-        kMinY = (yL0 - lyPred - deltaYL - 1) / (-deltaYL);  //  ceil
-    }
-    int kMin           = std::max({kMinX, kMinY, (int)0});
-    int kMax           = std::min({kMaxX, kMaxY, xMax - xMin});
-    TPixel32 *dnPix    = dnRow + xMin + kMin;
-    TPixel32 *dnEndPix = dnRow + xMin + kMax + 1;
-    int xL             = xL0 + (kMin - 1) * deltaXL;  //  inizializza xL
-    int yL             = yL0 + (kMin - 1) * deltaYL;  //  inizializza yL
-    for (; dnPix < dnEndPix; ++dnPix) {
-      xL += deltaXL;
-      yL += deltaYL;
-      int xI = xL >> PADN;  //  round
-      int yI = yL >> PADN;  //  round
-
-      assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
-             (yI <= up->getLy() - 1));
-
-      if (colorMask == TRop::MChan)
-        dnPix->r = dnPix->g = dnPix->b = (upBasePix + (yI * upWrap + xI))->m;
-      else {
-        TPixel32 *pix = upBasePix + (yI * upWrap + xI);
-        dnPix->r      = ((colorMask & TRop::RChan) ? pix->r : 0);
-        dnPix->g      = ((colorMask & TRop::GChan) ? pix->g : 0);
-        dnPix->b      = ((colorMask & TRop::BChan) ? pix->b : 0);
+  putInBands(yMin, yMax, xMax - xMin + 1, [&](int y0, int y1) {
+    TPixel32 *dnRow = dn->pixels(y0);
+    for (int y = y0; y <= y1; y++, dnRow += dnWrap) {
+      TPointD a = invAff * TPointD(xMin, y);
+      int xL0   = tround((a.x + 0.5) * (1 << PADN));
+      int yL0   = tround((a.y + 0.5) * (1 << PADN));
+      int kMinX = 0, kMaxX = xMax - xMin;  //  clipping su dn
+      int kMinY = 0, kMaxY = xMax - xMin;  //  clipping su dn
+      if (deltaXL == 0) {
+        if ((xL0 < 0) || (lxPred < xL0)) continue;
+      } else if (deltaXL > 0) {
+        if (lxPred < xL0) continue;
+
+        kMaxX              = (lxPred - xL0) / deltaXL;          //  floor
+        if (xL0 < 0) kMinX = ((-xL0) + deltaXL - 1) / deltaXL;  //  ceil
+      } else  //  (deltaXL < 0)
+      {
+        if (xL0 < 0) continue;
+        kMaxX = xL0 / (-deltaXL);  //  floor
+        if (lxPred < xL0)
+          kMinX = (xL0 - lxPred - deltaXL - 1) / (-deltaXL);  //  ceil
+      }
+      if (deltaYL == 0) {
+        if ((yL0 < 0) || (lyPred < yL0)) continue;
+      } else if (deltaYL > 0) {
+        if (lyPred < yL0) continue;
+
+        kMaxY              = (lyPred - yL0) / deltaYL;          //  floor
+        if (yL0 < 0) kMinY = ((-yL0) + deltaYL - 1) / deltaYL;  //  ceil
+      } else  //  (deltaYL < 0)
+      {
+        if (yL0 < 0) continue;
+
+        kMaxY = yL0 / (-deltaYL);  //  floor
+        if (lyPred < yL0)
+          kMinY = (yL0 - lyPred - deltaYL - 1) / (-deltaYL);  //  ceil
+      }
+      int kMin           = std::max({kMinX, kMinY, (int)0});
+      int kMax           = std::min({kMaxX, kMaxY, xMax - xMin});
+      TPixel32 *dnPix    = dnRow + xMin + kMin;
+      TPixel32 *dnEndPix = dnRow + xMin + kMax + 1;
+      int xL             = xL0 + (kMin - 1) * deltaXL;  //  inizializza xL
+      int yL             = yL0 + (kMin - 1) * deltaYL;  //  inizializza yL
+      for (; dnPix < dnEndPix; ++dnPix) {
+        xL += deltaXL;
+        yL += deltaYL;
+        int xI = xL >> PADN;  //  round
+        int yI = yL >> PADN;  //  round
+
+        assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
+               (yI <= up->getLy() - 1));
+
+        if (colorMask == TRop::MChan)
+          dnPix->r = dnPix->g = dnPix->b = (upBasePix + (yI * upWrap + xI))->m;
+        else {
+          TPixel32 *pix = upBasePix + (yI * upWrap + xI);
+          dnPix->r      = ((colorMask & TRop::RChan) ? pix->r : 0);
+          dnPix->g      = ((colorMask & TRop::GChan) ? pix->g : 0);
+          dnPix->b      = ((colorMask & TRop::BChan) ? pix->b : 0);
+        }
+        dnPix->m = 255;
       }
-      dnPix->m = 255;
     }
-  }
+  });
   dn->unlock();
   up->unlock();
 }
@@ -2153,71 +2186,73 @@ void doQuickResampleColorFilter(const TRaster32P &dn, const TRaster64P &up,
   dn->lock();
   up->lock();
 
-  TPixel32 *dnRow     = dn->pixels(yMin);
   TPixel64 *upBasePix = up->pixels();
 
-  for (int y = yMin; y <= yMax; y++, dnRow += dnWrap) {
-    TPointD a = invAff * TPointD(xMin, y);
-    int xL0   = tround((a.x + 0.5) * (1 << PADN));
-    int yL0   = tround((a.y + 0.5) * (1 << PADN));
-    int kMinX = 0, kMaxX = xMax - xMin;  //  clipping su dn
-    int kMinY = 0, kMaxY = xMax - xMin;  //  clipping su dn
-    if (deltaXL == 0) {
-      if ((xL0 < 0) || (lxPred < xL0)) continue;
-    } else if (deltaXL > 0) {
-      if (lxPred < xL0) continue;
-
-      kMaxX              = (lxPred - xL0) / deltaXL;          //  floor
-      if (xL0 < 0) kMinX = ((-xL0) + deltaXL - 1) / deltaXL;  //  ceil
-    } else                                                    //  (deltaXL < 0)
-    {
-      if (xL0 < 0) continue;
-      kMaxX = xL0 / (-deltaXL);  //  floor
-      if (lxPred < xL0)
-        kMinX = (xL0 - lxPred - deltaXL - 1) / (-deltaXL);  //  ceil
-    }
-    if (deltaYL == 0) {
-      if ((yL0 < 0) || (lyPred < yL0)) continue;
-    } else if (deltaYL > 0) {
-      if (lyPred < yL0) continue;
-
-      kMaxY              = (lyPred - yL0) / deltaYL;          //  floor
-      if (yL0 < 0) kMinY = ((-yL0) + deltaYL - 1) / deltaYL;  //  ceil
-    } else                                                    //  (deltaYL < 0)
-    {
-      if (yL0 < 0) continue;
-
-      kMaxY = yL0 / (-deltaYL);  //  floor
-      if (lyPred < yL0)
-        kMinY = (yL0 - lyPred - deltaYL - 1) / (-deltaYL);  //  ceil
-    }
-    int kMin           = std::max({kMinX, kMinY, (int)0});
-    int kMax           = std::min({kMaxX, kMaxY, xMax - xMin});
-    TPixel32 *dnPix    = dnRow + xMin + kMin;
-    TPixel32 *dnEndPix = dnRow + xMin + kMax + 1;
-    int xL             = xL0 + (kMin - 1) * deltaXL;  //  inizializza xL
-    int yL             = yL0 + (kMin - 1) * deltaYL;  //  inizializza yL
-    for (; dnPix < dnEndPix; ++dnPix) {
-      xL += deltaXL;
-      yL += deltaYL;
-      int xI = xL >> PADN;  //  round
-      int yI = yL >> PADN;  //  round
-
-      assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
-             (yI <= up->getLy() - 1));
-
-      if (colorMask == TRop::MChan)
-        dnPix->r = dnPix->g = dnPix->b =
-            byteFromUshort((upBasePix + (yI * upWrap + xI))->m);
-      else {
-        TPixel64 *pix = upBasePix + (yI * upWrap + xI);
-        dnPix->r = byteFromUshort(((colorMask & TRop::RChan) ? pix->r : 0));
-        dnPix->g = byteFromUshort(((colorMask & TRop::GChan) ? pix->g : 0));
-        dnPix->b = byteFromUshort(((colorMask & TRop::BChan) ? pix->b : 0));
+  putInBands(yMin, yMax, xMax - xMin + 1, [&](int y0, int y1) {
+    TPixel32 *dnRow = dn->pixels(y0);
+    for (int y = y0; y <= y1; y++, dnRow += dnWrap) {
+      TPointD a = invAff * TPointD(xMin, y);
+      int xL0   = tround((a.x + 0.5) * (1 << PADN));
+      int yL0   = tround((a.y + 0.5) * (1 << PADN));
+      int kMinX = 0, kMaxX = xMax - xMin;  //  clipping su dn
+      int kMinY = 0, kMaxY = xMax - xMin;  //  clipping su dn
+      if (deltaXL == 0) {
+        if ((xL0 < 0) || (lxPred < xL0)) continue;
+      } else if (deltaXL > 0) {
+        if (lxPred < xL0) continue;
+
+        kMaxX              = (lxPred - xL0) / deltaXL;          //  floor
+        if (xL0 < 0) kMinX = ((-xL0) + deltaXL - 1) / deltaXL;  //  ceil
+      } else  //  (deltaXL < 0)
+      {
+        if (xL0 < 0) continue;
+        kMaxX = xL0 / (-deltaXL);  //  floor
+        if (lxPred < xL0)
+          kMinX = (xL0 - lxPred - deltaXL - 1) / (-deltaXL);  //  ceil
+      }
+      if (deltaYL == 0) {
+        if ((yL0 < 0) || (lyPred < yL0)) continue;
+      } else if (deltaYL > 0) {
+        if (lyPred < yL0) continue;
+
+        kMaxY              = (lyPred - yL0) / deltaYL;          //  floor
+        if (yL0 < 0) kMinY = ((-yL0) + deltaYL - 1) / deltaYL;  //  ceil
+      } else  //  (deltaYL < 0)
+      {
+        if (yL0 < 0) continue;
+
+        kMaxY = yL0 / (-deltaYL);  //  floor
+        if (lyPred < yL0)
+          kMinY = (yL0 - lyPred - deltaYL - 1) / (-deltaYL);  //  ceil
+      }
+      int kMin           = std::max({kMinX, kMinY, (int)0});
+      int kMax           = std::min({kMaxX, kMaxY, xMax - xMin});
+      TPixel32 *dnPix    = dnRow + xMin + kMin;
+      TPixel32 *dnEndPix = dnRow + xMin + kMax + 1;
+      int xL             = xL0 + (kMin - 1) * deltaXL;  //  inizializza xL
+      int yL             = yL0 + (kMin - 1) * deltaYL;  //  inizializza yL
+      for (; dnPix < dnEndPix; ++dnPix) {
+        xL += deltaXL;
+        yL += deltaYL;
+        int xI = xL >> PADN;  //  round
+        int yI = yL >> PADN;  //  round
+
+        assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
+               (yI <= up->getLy() - 1));
+
+        if (colorMask == TRop::MChan)
+          dnPix->r = dnPix->g = dnPix->b =
+              byteFromUshort((upBasePix + (yI * upWrap + xI))->m);
+        else {
+          TPixel64 *pix = upBasePix + (yI * upWrap + xI);
+          dnPix->r = byteFromUshort(((colorMask & TRop::RChan) ? pix->r : 0));
+          dnPix->g = byteFromUshort(((colorMask & TRop::GChan) ? pix->g : 0));
+          dnPix->b = byteFromUshort(((colorMask & TRop::BChan) ? pix->b : 0));
+        }
+        dnPix->m = 255;
       }
-      dnPix->m = 255;
     }
-  }
+  });
   dn->unlock();
   up->unlock();
 }
@@ -2391,93 +2426,95 @@ void doQuickResampleFilter(const TRaster32P &dn, const TRaster32P &up,
   dn->lock();
   up->lock();
   TPixel32 *upBasePix = up->pixels();
-  TPixel32 *dnRow     = dn->pixels(yMin + kMinY);
 
   //  (xL, yL) sono le coordinate (inizializzate per il round)
   //  in versione "TLonghizzata"
   //  del pixel corrente di up
-  int yL = yL0 + (kMinY - 1) * deltaYL;  //  inizializza yL
 
   //  scorre le scanline di boundingBoxD
-  for (int kY = kMinY; kY <= kMaxY; kY++, dnRow += dnWrap) {
-    int xL = xL0 + (kMinX - 1) * deltaXL;  //  inizializza xL
-    yL += deltaYL;
-    //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e' approssimato
-    //  con (xI, yI)
-    int yI = yL >> PADN;  //  troncato
-
-    //  filtro bilineare 4 pixels: calcolo degli y-pesi
-    int yWeight1 = (yL & MASKN);
-    int yWeight0 = (1 << PADN) - yWeight1;
-
-    TPixel32 *dnPix    = dnRow + xMin + kMinX;
-    TPixel32 *dnEndPix = dnRow + xMin + kMaxX + 1;
-
-    //  scorre i pixel sulla (yMin + kY)-esima scanline di dn
-    for (; dnPix < dnEndPix; ++dnPix) {
-      xL += deltaXL;
-      //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e'
-      //  approssimato con (xI, yI)
-      int xI = xL >> PADN;  //  troncato
-
-      assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
-             (yI <= up->getLy() - 1));
-
-      //  (xI, yI)
-      TPixel32 *upPix00 = upBasePix + (yI * upWrap + xI);
-
-      //  (xI + 1, yI)
-      TPixel32 *upPix10 = upPix00 + 1;
-
-      //  (xI, yI + 1)
-      TPixel32 *upPix01 = upPix00 + upWrap;
-
-      //  (xI + 1, yI + 1)
-      TPixel32 *upPix11 = upPix00 + upWrap + 1;
-
-      //  filtro bilineare 4 pixels: calcolo degli x-pesi
-      int xWeight1 = (xL & MASKN);
-      int xWeight0 = (1 << PADN) - xWeight1;
-
-      //  filtro bilineare 4 pixels: media pesata sui singoli canali
-      int rColDownTmp =
-          (xWeight0 * (upPix00->r) + xWeight1 * ((upPix10)->r)) >> PADN;
-
-      int gColDownTmp =
-          (xWeight0 * (upPix00->g) + xWeight1 * ((upPix10)->g)) >> PADN;
-
-      int bColDownTmp =
-          (xWeight0 * (upPix00->b) + xWeight1 * ((upPix10)->b)) >> PADN;
-
-      int mColDownTmp =
-          (xWeight0 * (upPix00->m) + xWeight1 * ((upPix10)->m)) >> PADN;
-
-      int rColUpTmp =
-          (xWeight0 * ((upPix01)->r) + xWeight1 * ((upPix11)->r)) >> PADN;
-
-      int gColUpTmp =
-          (xWeight0 * ((upPix01)->g) + xWeight1 * ((upPix11)->g)) >> PADN;
-
-      int bColUpTmp =
-          (xWeight0 * ((upPix01)->b) + xWeight1 * ((upPix11)->b)) >> PADN;
-
-      int mColUpTmp =
-          (xWeight0 * ((upPix01)->m) + xWeight1 * ((upPix11)->m)) >> PADN;
-
-      dnPix->r =
-          (unsigned char)((yWeight0 * rColDownTmp + yWeight1 * rColUpTmp) >>
-                          PADN);
-      dnPix->g =
-          (unsigned char)((yWeight0 * gColDownTmp + yWeight1 * gColUpTmp) >>
-                          PADN);
-      dnPix->b =
-          (unsigned char)((yWeight0 * bColDownTmp + yWeight1 * bColUpTmp) >>
-                          PADN);
-      dnPix->m =
-          (unsigned char)((yWeight0 * mColDownTmp + yWeight1 * mColUpTmp) >>
-                          PADN);
+  putInBands(kMinY, kMaxY, kMaxX - kMinX + 1, [&](int kY0, int kY1) {
+    TPixel32 *dnRow = dn->pixels(yMin + kY0);
+    int yL          = yL0 + (kY0 - 1) * deltaYL;
+    for (int kY = kY0; kY <= kY1; kY++, dnRow += dnWrap) {
+      int xL = xL0 + (kMinX - 1) * deltaXL;  //  inizializza xL
+      yL += deltaYL;
+      //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e' approssimato
+      //  con (xI, yI)
+      int yI = yL >> PADN;  //  troncato
+
+      //  filtro bilineare 4 pixels: calcolo degli y-pesi
+      int yWeight1 = (yL & MASKN);
+      int yWeight0 = (1 << PADN) - yWeight1;
+
+      TPixel32 *dnPix    = dnRow + xMin + kMinX;
+      TPixel32 *dnEndPix = dnRow + xMin + kMaxX + 1;
+
+      //  scorre i pixel sulla (yMin + kY)-esima scanline di dn
+      for (; dnPix < dnEndPix; ++dnPix) {
+        xL += deltaXL;
+        //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e'
+        //  approssimato con (xI, yI)
+        int xI = xL >> PADN;  //  troncato
+
+        assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
+               (yI <= up->getLy() - 1));
+
+        //  (xI, yI)
+        TPixel32 *upPix00 = upBasePix + (yI * upWrap + xI);
+
+        //  (xI + 1, yI)
+        TPixel32 *upPix10 = upPix00 + 1;
+
+        //  (xI, yI + 1)
+        TPixel32 *upPix01 = upPix00 + upWrap;
+
+        //  (xI + 1, yI + 1)
+        TPixel32 *upPix11 = upPix00 + upWrap + 1;
+
+        //  filtro bilineare 4 pixels: calcolo degli x-pesi
+        int xWeight1 = (xL & MASKN);
+        int xWeight0 = (1 << PADN) - xWeight1;
+
+        //  filtro bilineare 4 pixels: media pesata sui singoli canali
+        int rColDownTmp =
+            (xWeight0 * (upPix00->r) + xWeight1 * ((upPix10)->r)) >> PADN;
+
+        int gColDownTmp =
+            (xWeight0 * (upPix00->g) + xWeight1 * ((upPix10)->g)) >> PADN;
+
+        int bColDownTmp =
+            (xWeight0 * (upPix00->b) + xWeight1 * ((upPix10)->b)) >> PADN;
+
+        int mColDownTmp =
+            (xWeight0 * (upPix00->m) + xWeight1 * ((upPix10)->m)) >> PADN;
+
+        int rColUpTmp =
+            (xWeight0 * ((upPix01)->r) + xWeight1 * ((upPix11)->r)) >> PADN;
+
+        int gColUpTmp =
+            (xWeight0 * ((upPix01)->g) + xWeight1 * ((upPix11)->g)) >> PADN;
+
+        int bColUpTmp =
+            (xWeight0 * ((upPix01)->b) + xWeight1 * ((upPix11)->b)) >> PADN;
+
+        int mColUpTmp =
+            (xWeight0 * ((upPix01)->m) + xWeight1 * ((upPix11)->m)) >> PADN;
+
+        dnPix->r =
+            (unsigned char)((yWeight0 * rColDownTmp + yWeight1 * rColUpTmp) >>
+                            PADN);
+        dnPix->g =
+            (unsigned char)((yWeight0 * gColDownTmp + yWeight1 * gColUpTmp) >>
+                            PADN);
+        dnPix->b =
+            (unsigned char)((yWeight0 * bColDownTmp + yWeight1 * bColUpTmp) >>
+                            PADN);
+        dnPix->m =
+            (unsigned char)((yWeight0 * mColDownTmp + yWeight1 * mColUpTmp) >>
+                            PADN);
+      }
     }
-  }
+  });
   dn->unlock();
   up->unlock();
 }
@@ -2650,67 +2687,70 @@ void doQuickResampleFilter(const TRaster32P &dn, const TRasterGR8P &up,
   dn->lock();
   up->lock();
   TPixelGR8 *upBasePix = up->pixels();
-  TPixel32 *dnRow      = dn->pixels(yMin + kMinY);
 
   //  (xL, yL) sono le coordinate (inizializzate per il round)
   //  in versione "TLonghizzata"
   //  del pixel corrente di up
-  int yL = yL0 + (kMinY - 1) * deltaYL;  //  inizializza yL
 
   //  scorre le scanline di boundingBoxD
-  for (int kY = kMinY; kY <= kMaxY; kY++, dnRow += dnWrap) {
-    int xL = xL0 + (kMinX - 1) * deltaXL;  //  inizializza xL
-    yL += deltaYL;
-    //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e' approssimato
-    //  con (xI, yI)
-    int yI = yL >> PADN;  //  troncato
+  putInBands(kMinY, kMaxY, kMaxX - kMinX + 1, [&](int kY0, int kY1) {
+    TPixel32 *dnRow = dn->pixels(yMin + kY0);
+    int yL          = yL0 + (kY0 - 1) * deltaYL;
+    for (int kY = kY0; kY <= kY1; kY++, dnRow += dnWrap) {
+      int xL = xL0 + (kMinX - 1) * deltaXL;  //  inizializza xL
+      yL += deltaYL;
+      //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e' approssimato
+      //  con (xI, yI)
+      int yI = yL >> PADN;  //  troncato
 
-    //  filtro bilineare 4 pixels: calcolo degli y-pesi
-    int yWeight1 = (yL & MASKN);
-    int yWeight0 = (1 << PADN) - yWeight1;
+      //  filtro bilineare 4 pixels: calcolo degli y-pesi
+      int yWeight1 = (yL & MASKN);
+      int yWeight0 = (1 << PADN) - yWeight1;
 
-    TPixel32 *dnPix    = dnRow + xMin + kMinX;
-    TPixel32 *dnEndPix = dnRow + xMin + kMaxX + 1;
+      TPixel32 *dnPix    = dnRow + xMin + kMinX;
+      TPixel32 *dnEndPix = dnRow + xMin + kMaxX + 1;
 
-    //  scorre i pixel sulla (yMin + kY)-esima scanline di dn
-    for (; dnPix < dnEndPix; ++dnPix) {
-      xL += deltaXL;
-      //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e'
-      //  approssimato con (xI, yI)
-      int xI = xL >> PADN;  //  troncato
+      //  scorre i pixel sulla (yMin + kY)-esima scanline di dn
+      for (; dnPix < dnEndPix; ++dnPix) {
+        xL += deltaXL;
+        //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e'
+        //  approssimato con (xI, yI)
+        int xI = xL >> PADN;  //  troncato
 
-      assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
-             (yI <= up->getLy() - 1));
+        assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
+               (yI <= up->getLy() - 1));
 
-      //  (xI, yI)
-      TPixelGR8 *upPix00 = upBasePix + (yI * upWrap + xI);
+        //  (xI, yI)
+        TPixelGR8 *upPix00 = upBasePix + (yI * upWrap + xI);
 
-      //  (xI + 1, yI)
-      TPixelGR8 *upPix10 = upPix00 + 1;
+        //  (xI + 1, yI)
+        TPixelGR8 *upPix10 = upPix00 + 1;
 
-      //  (xI, yI + 1)
-      TPixelGR8 *upPix01 = upPix00 + upWrap;
+        //  (xI, yI + 1)
+        TPixelGR8 *upPix01 = upPix00 + upWrap;
 
-      //  (xI + 1, yI + 1)
-      TPixelGR8 *upPix11 = upPix00 + upWrap + 1;
+        //  (xI + 1, yI + 1)
+        TPixelGR8 *upPix11 = upPix00 + upWrap + 1;
 
-      //  filtro bilineare 4 pixels: calcolo degli x-pesi
-      int xWeight1 = (xL & MASKN);
-      int xWeight0 = (1 << PADN) - xWeight1;
+        //  filtro bilineare 4 pixels: calcolo degli x-pesi
+        int xWeight1 = (xL & MASKN);
+        int xWeight0 = (1 << PADN) - xWeight1;
 
-      //  filtro bilineare 4 pixels: media pesata sui singoli canali
-      int colDownTmp =
-          (xWeight0 * (upPix00->value) + xWeight1 * (upPix10->value)) >> PADN;
+        //  filtro bilineare 4 pixels: media pesata sui singoli canali
+        int colDownTmp =
+            (xWeight0 * (upPix00->value) + xWeight1 * (upPix10->value)) >> PADN;
 
-      int colUpTmp =
-          (xWeight0 * ((upPix01)->value) + xWeight1 * (upPix11->value)) >> PADN;
+        int colUpTmp =
+            (xWeight0 * ((upPix01)->value) + xWeight1 * (upPix11->value)) >>
+            PADN;
 
-      dnPix->m = 255;
-      dnPix->r = dnPix->g = dnPix->b =
-          (unsigned char)((yWeight0 * colDownTmp + yWeight1 * colUpTmp) >>
-                          PADN);
+        dnPix->m = 255;
+        dnPix->r = dnPix->g = dnPix->b =
+            (unsigned char)((yWeight0 * colDownTmp + yWeight1 * colUpTmp) >>
+                            PADN);
+      }
     }
-  }
+  });
   dn->unlock();
   up->unlock();
 }
@@ -2876,36 +2916,38 @@ void doQuickResampleNoFilter(const TRasterPT<PIX> &dn, const TRasterPT<PIX> &up,
   up->lock();
 
   PIX *upBasePix = up->pixels();
-  PIX *dnRow     = dn->pixels(yMin + kMinY);
 
   //  (xL, yL) sono le coordinate (inizializzate per il round)
   //  in versione "TLonghizzata" del pixel corrente di up
-  int yL = yL0 + (kMinY - 1) * deltaYL;  //  inizializza yL
 
   //  scorre le scanline di boundingBoxD
-  for (int kY = kMinY; kY <= kMaxY; kY++, dnRow += dnWrap) {
-    int xL = xL0 + (kMinX - 1) * deltaXL;  //  inizializza xL
-    yL += deltaYL;
-    //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e' approssimato
-    //  con (xI, yI)
-    int yI = yL >> PADN;  //  round
-
-    PIX *dnPix    = dnRow + xMin + kMinX;
-    PIX *dnEndPix = dnRow + xMin + kMaxX + 1;
-
-    //  scorre i pixel sulla (yMin + kY)-esima scanline di dn
-    for (; dnPix < dnEndPix; ++dnPix) {
-      xL += deltaXL;
-      //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e'
-      //  approssimato con (xI, yI)
-      int xI = xL >> PADN;  //  round
-
-      assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
-             (yI <= up->getLy() - 1));
-
-      *dnPix = *(upBasePix + (yI * upWrap + xI));
+  putInBands(kMinY, kMaxY, kMaxX - kMinX + 1, [&](int kY0, int kY1) {
+    PIX *dnRow = dn->pixels(yMin + kY0);
+    int yL     = yL0 + (kY0 - 1) * deltaYL;
+    for (int kY = kY0; kY <= kY1; kY++, dnRow += dnWrap) {
+      int xL = xL0 + (kMinX - 1) * deltaXL;  //  inizializza xL
+      yL += deltaYL;
+      //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e' approssimato
+      //  con (xI, yI)
+      int yI = yL >> PADN;  //  round
+
+      PIX *dnPix    = dnRow + xMin + kMinX;
+      PIX *dnEndPix = dnRow + xMin + kMaxX + 1;
+
+      //  scorre i pixel sulla (yMin + kY)-esima scanline di dn
+      for (; dnPix < dnEndPix; ++dnPix) {
+        xL += deltaXL;
+        //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e'
+        //  approssimato con (xI, yI)
+        int xI = xL >> PADN;  //  round
+
+        assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
+               (yI <= up->getLy() - 1));
+
+        *dnPix = *(upBasePix + (yI * upWrap + xI));
+      }
     }
-  }
+  });
 
   dn->unlock();
   up->unlock();
@@ -3003,186 +3045,189 @@ void doQuickPutCmapped(const TRaster32P &dn, const TRasterCM32P &up,
   dn->lock();
   up->lock();
 
-  TPixel32 *dnRow       = dn->pixels(yMin);
   TPixelCM32 *upBasePix = up->pixels();
 
   //  scorre le scanline di boundingBoxD
-  for (int y = yMin; y <= yMax; y++, dnRow += dnWrap) {
-    //  (1)  equazione k-parametrica della y-esima scanline di boundingBoxD:
-    //       (xMin, y) + k*(1, 0),  k = 0, ..., (xMax - xMin)
-
-    //  (2)  equazione k-parametrica dell'immagine mediante invAff di (1):
-    //       invAff*(xMin, y) + k*(deltaXD, deltaYD),
-    //       k = kMin, ..., kMax con 0 <= kMin <= kMax <= (xMax - xMin)
-
-    //  calcola kMin, kMax per la scanline corrente
-    //  intersecando la (2) con i lati di up
-
-    //  il segmento [a, b] di up e' la controimmagine mediante aff della
-    //  porzione di scanline  [ (xMin, y), (xMax, y) ] di dn
-
-    //  TPointD b = invAff*TPointD(xMax, y);
-    TPointD a = invAff * TPointD(xMin, y);
-
-    //  (xL0, yL0) sono le coordinate di a (inizializzate per il round)
-    //  in versione "TLonghizzata"
-    //  0 <= xL0 + k*deltaXL
-    //    <  up->getLx()*(1<<PADN)
-    //
-    //  0 <= kMinX
-    //    <= kMin
-    //    <= k
-    //    <= kMax
-    //    <= kMaxX
-    //    <= (xMax - xMin)
-    //
-    //  0 <= yL0 + k*deltaYL
-    //    < up->getLy()*(1<<PADN)
-
-    //  0 <= kMinY
-    //    <= kMin
-    //    <= k
-    //    <= kMax
-    //    <= kMaxY
-    //    <= (xMax - xMin)
-
-    //  xL0 inizializzato per il round
-    int xL0 = tround((a.x + 0.5) * (1 << PADN));
-
-    //  yL0 inizializzato per il round
-    int yL0 = tround((a.y + 0.5) * (1 << PADN));
-
-    //  calcola kMinX, kMaxX, kMinY, kMaxY
-    int kMinX = 0, kMaxX = xMax - xMin;  //  clipping su dn
-    int kMinY = 0, kMaxY = xMax - xMin;  //  clipping su dn
-
-    //  0 <= xL0 + k*deltaXL
-    //    < up->getLx()*(1<<PADN)
-    //           <=>
-    //  0 <= xL0 + k*deltaXL
-    //    <= lxPred
-    //
-    //  0 <= yL0 + k*deltaYL
-    //    < up->getLy()*(1<<PADN)
-    //           <=>
-    //  0 <= yL0 + k*deltaYL
-    //    <= lyPred
-
-    //  calcola kMinX, kMaxX
-    if (deltaXL == 0) {
-      // [a, b] verticale esterno ad up+(bordo destro/basso)
-      if ((xL0 < 0) || (lxPred < xL0)) continue;
-      //  altrimenti usa solo
-      //  kMinY, kMaxY ((deltaXL != 0) || (deltaYL != 0))
-    } else if (deltaXL > 0) {
-      //  [a, b] esterno ad up+(bordo destro/basso)
-      if (lxPred < xL0) continue;
-
-      kMaxX = (lxPred - xL0) / deltaXL;  //  floor
-      if (xL0 < 0) {
-        kMinX = ((-xL0) + deltaXL - 1) / deltaXL;  //  ceil
-      }
-    } else  //  (deltaXL < 0)
-    {
-      //  [a, b] esterno ad up+(bordo destro/basso)
-      if (xL0 < 0) continue;
-
-      kMaxX = xL0 / (-deltaXL);  //  floor
-      if (lxPred < xL0) {
-        kMinX = (xL0 - lxPred - deltaXL - 1) / (-deltaXL);  //  ceil
+  putInBands(yMin, yMax, xMax - xMin + 1, [&](int y0, int y1) {
+    TPixel32 *dnRow = dn->pixels(y0);
+    for (int y = y0; y <= y1; y++, dnRow += dnWrap) {
+      //  (1)  equazione k-parametrica della y-esima scanline di boundingBoxD:
+      //       (xMin, y) + k*(1, 0),  k = 0, ..., (xMax - xMin)
+
+      //  (2)  equazione k-parametrica dell'immagine mediante invAff di (1):
+      //       invAff*(xMin, y) + k*(deltaXD, deltaYD),
+      //       k = kMin, ..., kMax con 0 <= kMin <= kMax <= (xMax - xMin)
+
+      //  calcola kMin, kMax per la scanline corrente
+      //  intersecando la (2) con i lati di up
+
+      //  il segmento [a, b] di up e' la controimmagine mediante aff della
+      //  porzione di scanline  [ (xMin, y), (xMax, y) ] di dn
+
+      //  TPointD b = invAff*TPointD(xMax, y);
+      TPointD a = invAff * TPointD(xMin, y);
+
+      //  (xL0, yL0) sono le coordinate di a (inizializzate per il round)
+      //  in versione "TLonghizzata"
+      //  0 <= xL0 + k*deltaXL
+      //    <  up->getLx()*(1<<PADN)
+      //
+      //  0 <= kMinX
+      //    <= kMin
+      //    <= k
+      //    <= kMax
+      //    <= kMaxX
+      //    <= (xMax - xMin)
+      //
+      //  0 <= yL0 + k*deltaYL
+      //    < up->getLy()*(1<<PADN)
+
+      //  0 <= kMinY
+      //    <= kMin
+      //    <= k
+      //    <= kMax
+      //    <= kMaxY
+      //    <= (xMax - xMin)
+
+      //  xL0 inizializzato per il round
+      int xL0 = tround((a.x + 0.5) * (1 << PADN));
+
+      //  yL0 inizializzato per il round
+      int yL0 = tround((a.y + 0.5) * (1 << PADN));
+
+      //  calcola kMinX, kMaxX, kMinY, kMaxY
+      int kMinX = 0, kMaxX = xMax - xMin;  //  clipping su dn
+      int kMinY = 0, kMaxY = xMax - xMin;  //  clipping su dn
+
+      //  0 <= xL0 + k*deltaXL
+      //    < up->getLx()*(1<<PADN)
+      //           <=>
+      //  0 <= xL0 + k*deltaXL
+      //    <= lxPred
+      //
+      //  0 <= yL0 + k*deltaYL
+      //    < up->getLy()*(1<<PADN)
+      //           <=>
+      //  0 <= yL0 + k*deltaYL
+      //    <= lyPred
+
+      //  calcola kMinX, kMaxX
+      if (deltaXL == 0) {
+        // [a, b] verticale esterno ad up+(bordo destro/basso)
+        if ((xL0 < 0) || (lxPred < xL0)) continue;
+        //  altrimenti usa solo
+        //  kMinY, kMaxY ((deltaXL != 0) || (deltaYL != 0))
+      } else if (deltaXL > 0) {
+        //  [a, b] esterno ad up+(bordo destro/basso)
+        if (lxPred < xL0) continue;
+
+        kMaxX = (lxPred - xL0) / deltaXL;  //  floor
+        if (xL0 < 0) {
+          kMinX = ((-xL0) + deltaXL - 1) / deltaXL;  //  ceil
+        }
+      } else  //  (deltaXL < 0)
+      {
+        //  [a, b] esterno ad up+(bordo destro/basso)
+        if (xL0 < 0) continue;
+
+        kMaxX = xL0 / (-deltaXL);  //  floor
+        if (lxPred < xL0) {
+          kMinX = (xL0 - lxPred - deltaXL - 1) / (-deltaXL);  //  ceil
+        }
       }
-    }
 
-    //  calcola kMinY, kMaxY
-    if (deltaYL == 0) {
-      //  [a, b] orizzontale esterno ad up+(bordo destro/basso)
-      if ((yL0 < 0) || (lyPred < yL0)) continue;
-      // altrimenti usa solo
-      // kMinX, kMaxX ((deltaXL != 0) || (deltaYL != 0))
-    } else if (deltaYL > 0) {
-      //  [a, b] esterno ad up+(bordo destro/basso)
-      if (lyPred < yL0) continue;
-
-      kMaxY = (lyPred - yL0) / deltaYL;  //  floor
-      if (yL0 < 0) {
-        kMinY = ((-yL0) + deltaYL - 1) / deltaYL;  //  ceil
-      }
-    } else  //  (deltaYL < 0)
-    {
-      //  [a, b] esterno ad up+(bordo destro/basso)
-      if (yL0 < 0) continue;
-
-      kMaxY = yL0 / (-deltaYL);  //  floor
-      if (lyPred < yL0) {
-        kMinY = (yL0 - lyPred - deltaYL - 1) / (-deltaYL);  //  ceil
+      //  calcola kMinY, kMaxY
+      if (deltaYL == 0) {
+        //  [a, b] orizzontale esterno ad up+(bordo destro/basso)
+        if ((yL0 < 0) || (lyPred < yL0)) continue;
+        // altrimenti usa solo
+        // kMinX, kMaxX ((deltaXL != 0) || (deltaYL != 0))
+      } else if (deltaYL > 0) {
+        //  [a, b] esterno ad up+(bordo destro/basso)
+        if (lyPred < yL0) continue;
+
+        kMaxY = (lyPred - yL0) / deltaYL;  //  floor
+        if (yL0 < 0) {
+          kMinY = ((-yL0) + deltaYL - 1) / deltaYL;  //  ceil
+        }
+      } else  //  (deltaYL < 0)
+      {
+        //  [a, b] esterno ad up+(bordo destro/basso)
+        if (yL0 < 0) continue;
+
+        kMaxY = yL0 / (-deltaYL);  //  floor
+        if (lyPred < yL0) {
+          kMinY = (yL0 - lyPred - deltaYL - 1) / (-deltaYL);  //  ceil
+        }
       }
-    }
-
-    //  calcola kMin, kMax effettuando anche il clippind su dn
-    int kMin = std::max({kMinX, kMinY, (int)0});
-    int kMax = std::min({kMaxX, kMaxY, xMax - xMin});
-
-    TPixel32 *dnPix    = dnRow + xMin + kMin;
-    TPixel32 *dnEndPix = dnRow + xMin + kMax + 1;
-
-    //  (xL, yL) sono le coordinate (inizializzate per il round)
-    //  in versione "TLonghizzata" del pixel corrente di up
-    int xL = xL0 + (kMin - 1) * deltaXL;  //  inizializza xL
-    int yL = yL0 + (kMin - 1) * deltaYL;  //  inizializza yL
 
-    //  scorre i pixel sulla y-esima scanline di boundingBoxD
-    for (; dnPix < dnEndPix; ++dnPix) {
-      xL += deltaXL;
-      yL += deltaYL;
-
-      //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e'
-      //  approssimato con (xI, yI)
-      int xI = xL >> PADN;  //  round
-      int yI = yL >> PADN;  //  round
-
-      assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
-             (yI <= up->getLy() - 1));
-
-      TPixelCM32 *upPix = upBasePix + (yI * upWrap + xI);
-      int t             = upPix->getTone();
-      int p             = upPix->getPaint();
-
-      if (t == 0xff && p == 0)
-        continue;
-      else {
-        int i = upPix->getInk();
-        TPixel32 colorUp;
-        if (inksOnly) switch (t) {
-          case 0:
-            colorUp = colors[i];
-            break;
-          case 255:
-            colorUp = TPixel::Transparent;
-            break;
-          default:
-            colorUp = antialias(colors[i], 255 - t);
-            break;
-          }
-        else
-          switch (t) {
-          case 0:
-            colorUp = colors[i];
-            break;
-          case 255:
-            colorUp = colors[p];
-            break;
-          default:
-            colorUp = blend(colors[i], colors[p], t, TPixelCM32::getMaxTone());
-            break;
-          }
-
-        if (colorUp.m == 255)
-          *dnPix = colorUp;
-        else if (colorUp.m != 0)
-          *dnPix = quickOverPix(*dnPix, colorUp);
+      //  calcola kMin, kMax effettuando anche il clippind su dn
+      int kMin = std::max({kMinX, kMinY, (int)0});
+      int kMax = std::min({kMaxX, kMaxY, xMax - xMin});
+
+      TPixel32 *dnPix    = dnRow + xMin + kMin;
+      TPixel32 *dnEndPix = dnRow + xMin + kMax + 1;
+
+      //  (xL, yL) sono le coordinate (inizializzate per il round)
+      //  in versione "TLonghizzata" del pixel corrente di up
+      int xL = xL0 + (kMin - 1) * deltaXL;  //  inizializza xL
+      int yL = yL0 + (kMin - 1) * deltaYL;  //  inizializza yL
+
+      //  scorre i pixel sulla y-esima scanline di boundingBoxD
+      for (; dnPix < dnEndPix; ++dnPix) {
+        xL += deltaXL;
+        yL += deltaYL;
+
+        //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e'
+        //  approssimato con (xI, yI)
+        int xI = xL >> PADN;  //  round
+        int yI = yL >> PADN;  //  round
+
+        assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
+               (yI <= up->getLy() - 1));
+
+        TPixelCM32 *upPix = upBasePix + (yI * upWrap + xI);
+        int t             = upPix->getTone();
+        int p             = upPix->getPaint();
+
+        if (t == 0xff && p == 0)
+          continue;
+        else {
+          int i = upPix->getInk();
+          TPixel32 colorUp;
+          if (inksOnly) switch (t) {
+            case 0:
+              colorUp = colors[i];
+              break;
+            case 255:
+              colorUp = TPixel::Transparent;
+              break;
+            default:
+              colorUp = antialias(colors[i], 255 - t);
+              break;
+            }
+          else
+            switch (t) {
+            case 0:
+              colorUp = colors[i];
+              break;
+            case 255:
+              colorUp = colors[p];
+              break;
+            default:
+              colorUp =
+                  blend(colors[i], colors[p], t, TPixelCM32::getMaxTone());
+              break;
+            }
+
+          if (colorUp.m == 255)
+            *dnPix = colorUp;
+          else if (colorUp.m != 0)
+            *dnPix = quickOverPix(*dnPix, colorUp);
+        }
       }
     }
-  }
+  });
   dn->unlock();
   up->unlock();
 }
@@ -3250,121 +3295,125 @@ void doQuickPutCmapped(const TRaster32P &dn, const TRasterCM32P &up,
   dn->lock();
   up->lock();
 
-  TPixel32 *dnRow       = dn->pixels(yMin);
   TPixelCM32 *upBasePix = up->pixels();
-  for (int y = yMin; y <= yMax; y++, dnRow += dnWrap) {
-    TPointD a = invAff * TPointD(xMin, y);
-    int xL0   = tround((a.x + 0.5) * (1 << PADN));
-    int yL0   = tround((a.y + 0.5) * (1 << PADN));
-    int kMinX = 0, kMaxX = xMax - xMin;
-    int kMinY = 0, kMaxY = xMax - xMin;
-    if (deltaXL == 0) {
-      if ((xL0 < 0) || (lxPred < xL0)) continue;
-    } else if (deltaXL > 0) {
-      if (lxPred < xL0) continue;
-
-      kMaxX              = (lxPred - xL0) / deltaXL;          //  floor
-      if (xL0 < 0) kMinX = ((-xL0) + deltaXL - 1) / deltaXL;  //  ceil
-    } else {
-      if (xL0 < 0) continue;
-
-      kMaxX = xL0 / (-deltaXL);  //  floor
-      if (lxPred < xL0)
-        kMinX = (xL0 - lxPred - deltaXL - 1) / (-deltaXL);  //  ceil
-    }
-    if (deltaYL == 0) {
-      if ((yL0 < 0) || (lyPred < yL0)) continue;
-    } else if (deltaYL > 0) {
-      if (lyPred < yL0) continue;
-
-      kMaxY              = (lyPred - yL0) / deltaYL;
-      if (yL0 < 0) kMinY = ((-yL0) + deltaYL - 1) / deltaYL;
-    } else {
-      if (yL0 < 0) continue;
-      kMaxY = yL0 / (-deltaYL);  //  floor
-      if (lyPred < yL0)
-        kMinY = (yL0 - lyPred - deltaYL - 1) / (-deltaYL);  //  ceil
-    }
-    int kMin = std::max({kMinX, kMinY, (int)0});
-    int kMax = std::min({kMaxX, kMaxY, xMax - xMin});
-
-    TPixel32 *dnPix    = dnRow + xMin + kMin;
-    TPixel32 *dnEndPix = dnRow + xMin + kMax + 1;
-    int xL             = xL0 + (kMin - 1) * deltaXL;
-    int yL             = yL0 + (kMin - 1) * deltaYL;
-    for (; dnPix < dnEndPix; ++dnPix) {
-      xL += deltaXL;
-      yL += deltaYL;
-      int xI = xL >> PADN;
-      int yI = yL >> PADN;
-      assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
-             (yI <= up->getLy() - 1));
-      TPixelCM32 *upPix = upBasePix + (yI * upWrap + xI);
-      int t             = upPix->getTone();
-      int p             = upPix->getPaint();
-
-      if (t == 0xff && p == 0)
-        continue;
-      else {
-        int i = upPix->getInk();
-        TPixel32 colorUp;
-        if (s.m_inksOnly) switch (t) {
-          case 0:
-            colorUp = (i == s.m_inkIndex) ? TPixel::Red : inks[i];
-            break;
-          case 255:
-            colorUp = TPixel::Transparent;
-            break;
-          default: {
-            TPixel inkColor;
-            if (i == s.m_inkIndex) {
-              inkColor = TPixel::Red;
-              if (p == 0) {
-                t = t / 2;  // transparency check(for a bug!) darken
-                            // semitrasparent pixels; ghibli likes it, and wants
-                            // it also for ink checks...
-                // otherwise, ramps goes always from reds towards grey...
-              }
-            } else
-              inkColor = inks[i];
-
-            colorUp = antialias(inkColor, 255 - t);
-            break;
-          }
-          }
-        else
-          switch (t) {
-          case 0:
-            colorUp = (i == s.m_inkIndex) ? TPixel::Red : inks[i];
-            break;
-          case 255:
-            colorUp = (p == s.m_paintIndex) ? TPixel::Red : paints[p];
-            break;
-          default: {
-            TPixel paintColor = (p == s.m_paintIndex) ? TPixel::Red : paints[p];
-            TPixel inkColor;
-            if (i == s.m_inkIndex) {
-              inkColor = TPixel::Red;
-              if (p == 0) {
-                paintColor = TPixel::Transparent;
-              }
-            } else
-              inkColor = inks[i];
-
-            if (s.m_transparencyCheck) t = t / 2;
-
-            colorUp = blend(inkColor, paintColor, t, TPixelCM32::getMaxTone());
-            break;
-          }
-          }
-
-        if (colorUp.m == 255)
-          *dnPix = colorUp;
-        else if (colorUp.m != 0)
-          *dnPix = quickOverPix(*dnPix, colorUp);
+  putInBands(yMin, yMax, xMax - xMin + 1, [&](int y0, int y1) {
+    TPixel32 *dnRow = dn->pixels(y0);
+    for (int y = y0; y <= y1; y++, dnRow += dnWrap) {
+      TPointD a = invAff * TPointD(xMin, y);
+      int xL0   = tround((a.x + 0.5) * (1 << PADN));
+      int yL0   = tround((a.y + 0.5) * (1 << PADN));
+      int kMinX = 0, kMaxX = xMax - xMin;
+      int kMinY = 0, kMaxY = xMax - xMin;
+      if (deltaXL == 0) {
+        if ((xL0 < 0) || (lxPred < xL0)) continue;
+      } else if (deltaXL > 0) {
+        if (lxPred < xL0) continue;
+
+        kMaxX              = (lxPred - xL0) / deltaXL;          //  floor
+        if (xL0 < 0) kMinX = ((-xL0) + deltaXL - 1) / deltaXL;  //  ceil
+      } else {
+        if (xL0 < 0) continue;
+
+        kMaxX = xL0 / (-deltaXL);  //  floor
+        if (lxPred < xL0)
+          kMinX = (xL0 - lxPred - deltaXL - 1) / (-deltaXL);  //  ceil
+      }
+      if (deltaYL == 0) {
+        if ((yL0 < 0) || (lyPred < yL0)) continue;
+      } else if (deltaYL > 0) {
+        if (lyPred < yL0) continue;
+
+        kMaxY              = (lyPred - yL0) / deltaYL;
+        if (yL0 < 0) kMinY = ((-yL0) + deltaYL - 1) / deltaYL;
+      } else {
+        if (yL0 < 0) continue;
+        kMaxY = yL0 / (-deltaYL);  //  floor
+        if (lyPred < yL0)
+          kMinY = (yL0 - lyPred - deltaYL - 1) / (-deltaYL);  //  ceil
+      }
+      int kMin = std::max({kMinX, kMinY, (int)0});
+      int kMax = std::min({kMaxX, kMaxY, xMax - xMin});
+
+      TPixel32 *dnPix    = dnRow + xMin + kMin;
+      TPixel32 *dnEndPix = dnRow + xMin + kMax + 1;
+      int xL             = xL0 + (kMin - 1) * deltaXL;
+      int yL             = yL0 + (kMin - 1) * deltaYL;
+      for (; dnPix < dnEndPix; ++dnPix) {
+        xL += deltaXL;
+        yL += deltaYL;
+        int xI = xL >> PADN;
+        int yI = yL >> PADN;
+        assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
+               (yI <= up->getLy() - 1));
+        TPixelCM32 *upPix = upBasePix + (yI * upWrap + xI);
+        int t             = upPix->getTone();
+        int p             = upPix->getPaint();
+
+        if (t == 0xff && p == 0)
+          continue;
+        else {
+          int i = upPix->getInk();
+          TPixel32 colorUp;
+          if (s.m_inksOnly) switch (t) {
+            case 0:
+              colorUp = (i == s.m_inkIndex) ? TPixel::Red : inks[i];
+              break;
+            case 255:
+              colorUp = TPixel::Transparent;
+              break;
+            default: {
+              TPixel inkColor;
+              if (i == s.m_inkIndex) {
+                inkColor = TPixel::Red;
+                if (p == 0) {
+                  t = t / 2;  // transparency check(for a bug!) darken
+                              // semitrasparent pixels; ghibli likes it, and
+                              // wants it also for ink checks...
+                  // otherwise, ramps goes always from reds towards grey...
+                }
+              } else
+                inkColor = inks[i];
+
+              colorUp = antialias(inkColor, 255 - t);
+              break;
+            }
+            }
+          else
+            switch (t) {
+            case 0:
+              colorUp = (i == s.m_inkIndex) ? TPixel::Red : inks[i];
+              break;
+            case 255:
+              colorUp = (p == s.m_paintIndex) ? TPixel::Red : paints[p];
+              break;
+            default: {
+              TPixel paintColor =
+                  (p == s.m_paintIndex) ? TPixel::Red : paints[p];
+              TPixel inkColor;
+              if (i == s.m_inkIndex) {
+                inkColor = TPixel::Red;
+                if (p == 0) {
+                  paintColor = TPixel::Transparent;
+                }
+              } else
+                inkColor = inks[i];
+
+              if (s.m_transparencyCheck) t = t / 2;
+
+              colorUp =
+                  blend(inkColor, paintColor, t, TPixelCM32::getMaxTone());
+              break;
+            }
+            }
+
+          if (colorUp.m == 255)
+            *dnPix = colorUp;
+          else if (colorUp.m != 0)
+            *dnPix = quickOverPix(*dnPix, colorUp);
+        }
       }
     }
-  }
+  });
   dn->unlock();
   up->unlock();
 }
@@ -3564,80 +3613,80 @@ void doQuickPutCmapped(const TRaster32P &dn, const TRasterCM32P &up,
   dn->lock();
   up->lock();
   TPixelCM32 *upBasePix = up->pixels();
-  TPixel32 *dnRow       = dn->pixels(yMin + kMinY);
 
   //  (xL, yL) sono le coordinate (inizializzate per il round)
   //  in versione "TLonghizzata" del pixel corrente di up
 
-  //  inizializza yL
-  int yL = yL0 + (kMinY - 1) * deltaYL;
-
   //  scorre le scanline di boundingBoxD
-  for (int kY = kMinY; kY <= kMaxY; kY++, dnRow += dnWrap) {
-    //  inizializza xL
-    int xL = xL0 + (kMinX - 1) * deltaXL;
-    yL += deltaYL;
-
-    //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e' approssimato
-    //  con (xI, yI)
-    int yI = yL >> PADN;  //  round
-
-    TPixel32 *dnPix    = dnRow + xMin + kMinX;
-    TPixel32 *dnEndPix = dnRow + xMin + kMaxX + 1;
-
-    //  scorre i pixel sulla (yMin + kY)-esima scanline di dn
-    for (; dnPix < dnEndPix; ++dnPix) {
-      xL += deltaXL;
-      //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e'
-      //  approssimato con (xI, yI)
-      int xI = xL >> PADN;  //	round
-
-      assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
-             (yI <= up->getLy() - 1));
-
-      TPixelCM32 *upPix = upBasePix + (yI * upWrap + xI);
-      int t             = upPix->getTone();
-      int p             = upPix->getPaint();
-      assert(0 <= t && t < 256);
-      assert(0 <= p && p < (int)paints.size());
-
-      if (t == 0xff && p == 0)
-        continue;
-      else {
-        int i = upPix->getInk();
-        assert(0 <= i && i < (int)inks.size());
-        TPixel32 colorUp;
-        if (inksOnly) switch (t) {
-          case 0:
-            colorUp = inks[i];
-            break;
-          case 255:
-            colorUp = TPixel::Transparent;
-            break;
-          default:
-            colorUp = antialias(inks[i], 255 - t);
-            break;
-          }
-        else
-          switch (t) {
-          case 0:
-            colorUp = inks[i];
-            break;
-          case 255:
-            colorUp = paints[p];
-            break;
-          default:
-            colorUp = blend(inks[i], paints[p], t, TPixelCM32::getMaxTone());
-            break;
-          }
-
-        if (colorUp.m == 255)
-          *dnPix = colorUp;
-        else if (colorUp.m != 0)
-          *dnPix = quickOverPix(*dnPix, colorUp);
+  putInBands(kMinY, kMaxY, kMaxX - kMinX + 1, [&](int kY0, int kY1) {
+    TPixel32 *dnRow = dn->pixels(yMin + kY0);
+    int yL          = yL0 + (kY0 - 1) * deltaYL;
+    for (int kY = kY0; kY <= kY1; kY++, dnRow += dnWrap) {
+      //  inizializza xL
+      int xL = xL0 + (kMinX - 1) * deltaXL;
+      yL += deltaYL;
+
+      //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e' approssimato
+      //  con (xI, yI)
+      int yI = yL >> PADN;  //  round
+
+      TPixel32 *dnPix    = dnRow + xMin + kMinX;
+      TPixel32 *dnEndPix = dnRow + xMin + kMaxX + 1;
+
+      //  scorre i pixel sulla (yMin + kY)-esima scanline di dn
+      for (; dnPix < dnEndPix; ++dnPix) {
+        xL += deltaXL;
+        //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e'
+        //  approssimato con (xI, yI)
+        int xI = xL >> PADN;  //	round
+
+        assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
+               (yI <= up->getLy() - 1));
+
+        TPixelCM32 *upPix = upBasePix + (yI * upWrap + xI);
+        int t             = upPix->getTone();
+        int p             = upPix->getPaint();
+        assert(0 <= t && t < 256);
+        assert(0 <= p && p < (int)paints.size());
+
+        if (t == 0xff && p == 0)
+          continue;
+        else {
+          int i = upPix->getInk();
+          assert(0 <= i && i < (int)inks.size());
+          TPixel32 colorUp;
+          if (inksOnly) switch (t) {
+            case 0:
+              colorUp = inks[i];
+              break;
+            case 255:
+              colorUp = TPixel::Transparent;
+              break;
+            default:
+              colorUp = antialias(inks[i], 255 - t);
+              break;
+            }
+          else
+            switch (t) {
+            case 0:
+              colorUp = inks[i];
+              break;
+            case 255:
+              colorUp = paints[p];
+              break;
+            default:
+              colorUp = blend(inks[i], paints[p], t, TPixelCM32::getMaxTone());
+              break;
+            }
+
+          if (colorUp.m == 255)
+            *dnPix = colorUp;
+          else if (colorUp.m != 0)
+            *dnPix = quickOverPix(*dnPix, colorUp);
+        }
       }
     }
-  }
+  });
   dn->unlock();
   up->unlock();
 }
@@ -3695,86 +3744,88 @@ void doQuickResampleColorFilter(const TRaster32P &dn, const TRasterCM32P &up,
   dn->lock();
   up->lock();
 
-  TPixel32 *dnRow       = dn->pixels(yMin);
   TPixelCM32 *upBasePix = up->pixels();
 
-  for (int y = yMin; y <= yMax; y++, dnRow += dnWrap) {
-    TPointD a = invAff * TPointD(xMin, y);
-    int xL0   = tround((a.x + 0.5) * (1 << PADN));
-    int yL0   = tround((a.y + 0.5) * (1 << PADN));
-    int kMinX = 0, kMaxX = xMax - xMin;  //  clipping su dn
-    int kMinY = 0, kMaxY = xMax - xMin;  //  clipping su dn
-    if (deltaXL == 0) {
-      if ((xL0 < 0) || (lxPred < xL0)) continue;
-    } else if (deltaXL > 0) {
-      if (lxPred < xL0) continue;
-
-      kMaxX              = (lxPred - xL0) / deltaXL;          //  floor
-      if (xL0 < 0) kMinX = ((-xL0) + deltaXL - 1) / deltaXL;  //  ceil
-    } else                                                    //  (deltaXL < 0)
-    {
-      if (xL0 < 0) continue;
-      kMaxX = xL0 / (-deltaXL);  //  floor
-      if (lxPred < xL0)
-        kMinX = (xL0 - lxPred - deltaXL - 1) / (-deltaXL);  //  ceil
-    }
-    if (deltaYL == 0) {
-      if ((yL0 < 0) || (lyPred < yL0)) continue;
-    } else if (deltaYL > 0) {
-      if (lyPred < yL0) continue;
-
-      kMaxY              = (lyPred - yL0) / deltaYL;          //  floor
-      if (yL0 < 0) kMinY = ((-yL0) + deltaYL - 1) / deltaYL;  //  ceil
-    } else                                                    //  (deltaYL < 0)
-    {
-      if (yL0 < 0) continue;
-
-      kMaxY = yL0 / (-deltaYL);  //  floor
-      if (lyPred < yL0)
-        kMinY = (yL0 - lyPred - deltaYL - 1) / (-deltaYL);  //  ceil
-    }
-    int kMin           = std::max({kMinX, kMinY, (int)0});
-    int kMax           = std::min({kMaxX, kMaxY, xMax - xMin});
-    TPixel32 *dnPix    = dnRow + xMin + kMin;
-    TPixel32 *dnEndPix = dnRow + xMin + kMax + 1;
-    int xL             = xL0 + (kMin - 1) * deltaXL;  //  inizializza xL
-    int yL             = yL0 + (kMin - 1) * deltaYL;  //  inizializza yL
-    for (; dnPix < dnEndPix; ++dnPix) {
-      xL += deltaXL;
-      yL += deltaYL;
-      int xI = xL >> PADN;  //  round
-      int yI = yL >> PADN;  //  round
-
-      assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
-             (yI <= up->getLy() - 1));
-
-      TPixelCM32 *upPix = upBasePix + (yI * upWrap + xI);
-      int t             = upPix->getTone();
-      int p             = upPix->getPaint();
-      int i             = upPix->getInk();
-      TPixel32 colorUp;
-      switch (t) {
-      case 0:
-        colorUp = inks[i];
-        break;
-      case 255:
-        colorUp = paints[p];
-        break;
-      default:
-        colorUp = blend(inks[i], paints[p], t, TPixelCM32::getMaxTone());
-        break;
+  putInBands(yMin, yMax, xMax - xMin + 1, [&](int y0, int y1) {
+    TPixel32 *dnRow = dn->pixels(y0);
+    for (int y = y0; y <= y1; y++, dnRow += dnWrap) {
+      TPointD a = invAff * TPointD(xMin, y);
+      int xL0   = tround((a.x + 0.5) * (1 << PADN));
+      int yL0   = tround((a.y + 0.5) * (1 << PADN));
+      int kMinX = 0, kMaxX = xMax - xMin;  //  clipping su dn
+      int kMinY = 0, kMaxY = xMax - xMin;  //  clipping su dn
+      if (deltaXL == 0) {
+        if ((xL0 < 0) || (lxPred < xL0)) continue;
+      } else if (deltaXL > 0) {
+        if (lxPred < xL0) continue;
+
+        kMaxX              = (lxPred - xL0) / deltaXL;          //  floor
+        if (xL0 < 0) kMinX = ((-xL0) + deltaXL - 1) / deltaXL;  //  ceil
+      } else  //  (deltaXL < 0)
+      {
+        if (xL0 < 0) continue;
+        kMaxX = xL0 / (-deltaXL);  //  floor
+        if (lxPred < xL0)
+          kMinX = (xL0 - lxPred - deltaXL - 1) / (-deltaXL);  //  ceil
       }
-
-      if (colorMask == TRop::MChan)
-        dnPix->r = dnPix->g = dnPix->b = colorUp.m;
-      else {
-        dnPix->r = ((colorMask & TRop::RChan) ? colorUp.r : 0);
-        dnPix->g = ((colorMask & TRop::GChan) ? colorUp.g : 0);
-        dnPix->b = ((colorMask & TRop::BChan) ? colorUp.b : 0);
+      if (deltaYL == 0) {
+        if ((yL0 < 0) || (lyPred < yL0)) continue;
+      } else if (deltaYL > 0) {
+        if (lyPred < yL0) continue;
+
+        kMaxY              = (lyPred - yL0) / deltaYL;          //  floor
+        if (yL0 < 0) kMinY = ((-yL0) + deltaYL - 1) / deltaYL;  //  ceil
+      } else  //  (deltaYL < 0)
+      {
+        if (yL0 < 0) continue;
+
+        kMaxY = yL0 / (-deltaYL);  //  floor
+        if (lyPred < yL0)
+          kMinY = (yL0 - lyPred - deltaYL - 1) / (-deltaYL);  //  ceil
+      }
+      int kMin           = std::max({kMinX, kMinY, (int)0});
+      int kMax           = std::min({kMaxX, kMaxY, xMax - xMin});
+      TPixel32 *dnPix    = dnRow + xMin + kMin;
+      TPixel32 *dnEndPix = dnRow + xMin + kMax + 1;
+      int xL             = xL0 + (kMin - 1) * deltaXL;  //  inizializza xL
+      int yL             = yL0 + (kMin - 1) * deltaYL;  //  inizializza yL
+      for (; dnPix < dnEndPix; ++dnPix) {
+        xL += deltaXL;
+        yL += deltaYL;
+        int xI = xL >> PADN;  //  round
+        int yI = yL >> PADN;  //  round
+
+        assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
+               (yI <= up->getLy() - 1));
+
+        TPixelCM32 *upPix = upBasePix + (yI * upWrap + xI);
+        int t             = upPix->getTone();
+        int p             = upPix->getPaint();
+        int i             = upPix->getInk();
+        TPixel32 colorUp;
+        switch (t) {
+        case 0:
+          colorUp = inks[i];
+          break;
+        case 255:
+          colorUp = paints[p];
+          break;
+        default:
+          colorUp = blend(inks[i], paints[p], t, TPixelCM32::getMaxTone());
+          break;
+        }
+
+        if (colorMask == TRop::MChan)
+          dnPix->r = dnPix->g = dnPix->b = colorUp.m;
+        else {
+          dnPix->r = ((colorMask & TRop::RChan) ? colorUp.r : 0);
+          dnPix->g = ((colorMask & TRop::GChan) ? colorUp.g : 0);
+          dnPix->b = ((colorMask & TRop::BChan) ? colorUp.b : 0);
+        }
+        dnPix->m = 255;
       }
-      dnPix->m = 255;
     }
-  }
+  });
   dn->unlock();
   up->unlock();
 }
@@ -4349,131 +4400,133 @@ void doQuickResampleNoFilter(const TRasterPT<PIX> &dn, const TRasterPT<PIX> &up,
   dn->lock();
   up->lock();
 
-  PIX *dnRow     = dn->pixels(yMin);
   PIX *upBasePix = up->pixels();
 
   //  scorre le scanline di boundingBoxD
-  for (int y = yMin; y <= yMax; y++, dnRow += dnWrap) {
-    //  (1)  equazione k-parametrica della y-esima scanline di boundingBoxD:
-    //         (xMin, y) + k*(1, 0),
-    //           k = 0, ..., (xMax - xMin)
-
-    //  (2)  equazione k-parametrica dell'immagine mediante invAff di (1):
-    //         invAff*(xMin, y) + k*(deltaXD, deltaYD),
-    //           k = kMin, ..., kMax
-    //           con 0 <= kMin <= kMax <= (xMax - xMin)
-
-    //  calcola kMin, kMax per la scanline corrente intersecando
-    //  la (2) con i lati di up
-
-    //  il segmento [a, b] di up e' la controimmagine mediante aff della
-    //  porzione di scanline  [ (xMin, y), (xMax, y) ] di dn
-
-    //  TPointD b = invAff*TPointD(xMax, y);
-    TPointD a = invAff * TPointD(xMin, y);
-
-    //  (xL0, yL0) sono le coordinate di a (inizializzate per il round)
-    //  in versione "TLonghizzata"
-    //  0 <= xL0 + k*deltaXL < up->getLx()*(1<<PADN),
-    //  0 <= kMinX <= kMin <= k <= kMax <= kMaxX <= (xMax - xMin)
-
-    //  0 <= yL0 + k*deltaYL < up->getLy()*(1<<PADN),
-    //  0 <= kMinY <= kMin <= k <= kMax <= kMaxY <= (xMax - xMin)
-
-    //  xL0 inizializzato per il round
-    int xL0 = tround((a.x + 0.5) * (1 << PADN));
-
-    //  yL0 inizializzato per il round
-    int yL0 = tround((a.y + 0.5) * (1 << PADN));
-
-    //  calcola kMinX, kMaxX, kMinY, kMaxY
-    int kMinX = 0, kMaxX = xMax - xMin;  //  clipping su dn
-    int kMinY = 0, kMaxY = xMax - xMin;  //  clipping su dn
-    //  0 <= xL0 + k*deltaXL < up->getLx()*(1<<PADN)
-    //               <=>
-    //  0 <= xL0 + k*eltaXL <= lxPred
-
-    //  0 <= yL0 + k*deltaYL < up->getLy()*(1<<PADN)
-    //               <=>
-    //  0 <= yL0 + k*deltaYL <= lyPred
-
-    //  calcola kMinX, kMaxX
-    if (deltaXL == 0) {
-      //  [a, b] verticale esterno ad up+(bordo destro/basso)
-      if ((xL0 < 0) || (lxPred < xL0)) continue;
-      //  altrimenti usa solo
-      //  kMinY, kMaxY ((deltaXL != 0) || (deltaYL != 0))
-    } else if (deltaXL > 0) {
-      //  [a, b] esterno ad up+(bordo destro/basso)
-      if (lxPred < xL0) continue;
-
-      kMaxX = (lxPred - xL0) / deltaXL;  //  floor
-      if (xL0 < 0) {
-        kMinX = ((-xL0) + deltaXL - 1) / deltaXL;  //  ceil
+  putInBands(yMin, yMax, xMax - xMin + 1, [&](int y0, int y1) {
+    PIX *dnRow = dn->pixels(y0);
+    for (int y = y0; y <= y1; y++, dnRow += dnWrap) {
+      //  (1)  equazione k-parametrica della y-esima scanline di boundingBoxD:
+      //         (xMin, y) + k*(1, 0),
+      //           k = 0, ..., (xMax - xMin)
+
+      //  (2)  equazione k-parametrica dell'immagine mediante invAff di (1):
+      //         invAff*(xMin, y) + k*(deltaXD, deltaYD),
+      //           k = kMin, ..., kMax
+      //           con 0 <= kMin <= kMax <= (xMax - xMin)
+
+      //  calcola kMin, kMax per la scanline corrente intersecando
+      //  la (2) con i lati di up
+
+      //  il segmento [a, b] di up e' la controimmagine mediante aff della
+      //  porzione di scanline  [ (xMin, y), (xMax, y) ] di dn
+
+      //  TPointD b = invAff*TPointD(xMax, y);
+      TPointD a = invAff * TPointD(xMin, y);
+
+      //  (xL0, yL0) sono le coordinate di a (inizializzate per il round)
+      //  in versione "TLonghizzata"
+      //  0 <= xL0 + k*deltaXL < up->getLx()*(1<<PADN),
+      //  0 <= kMinX <= kMin <= k <= kMax <= kMaxX <= (xMax - xMin)
+
+      //  0 <= yL0 + k*deltaYL < up->getLy()*(1<<PADN),
+      //  0 <= kMinY <= kMin <= k <= kMax <= kMaxY <= (xMax - xMin)
+
+      //  xL0 inizializzato per il round
+      int xL0 = tround((a.x + 0.5) * (1 << PADN));
+
+      //  yL0 inizializzato per il round
+      int yL0 = tround((a.y + 0.5) * (1 << PADN));
+
+      //  calcola kMinX, kMaxX, kMinY, kMaxY
+      int kMinX = 0, kMaxX = xMax - xMin;  //  clipping su dn
+      int kMinY = 0, kMaxY = xMax - xMin;  //  clipping su dn
+      //  0 <= xL0 + k*deltaXL < up->getLx()*(1<<PADN)
+      //               <=>
+      //  0 <= xL0 + k*eltaXL <= lxPred
+
+      //  0 <= yL0 + k*deltaYL < up->getLy()*(1<<PADN)
+      //               <=>
+      //  0 <= yL0 + k*deltaYL <= lyPred
+
+      //  calcola kMinX, kMaxX
+      if (deltaXL == 0) {
+        //  [a, b] verticale esterno ad up+(bordo destro/basso)
+        if ((xL0 < 0) || (lxPred < xL0)) continue;
+        //  altrimenti usa solo
+        //  kMinY, kMaxY ((deltaXL != 0) || (deltaYL != 0))
+      } else if (deltaXL > 0) {
+        //  [a, b] esterno ad up+(bordo destro/basso)
+        if (lxPred < xL0) continue;
+
+        kMaxX = (lxPred - xL0) / deltaXL;  //  floor
+        if (xL0 < 0) {
+          kMinX = ((-xL0) + deltaXL - 1) / deltaXL;  //  ceil
+        }
+      } else  //  (deltaXL < 0)
+      {
+        // [a, b] esterno ad up+(bordo destro/basso)
+        if (xL0 < 0) continue;
+
+        kMaxX = xL0 / (-deltaXL);  //  floor
+        if (lxPred < xL0) {
+          kMinX = (xL0 - lxPred - deltaXL - 1) / (-deltaXL);  //  ceil
+        }
       }
-    } else  //  (deltaXL < 0)
-    {
-      // [a, b] esterno ad up+(bordo destro/basso)
-      if (xL0 < 0) continue;
-
-      kMaxX = xL0 / (-deltaXL);  //  floor
-      if (lxPred < xL0) {
-        kMinX = (xL0 - lxPred - deltaXL - 1) / (-deltaXL);  //  ceil
-      }
-    }
 
-    //  calcola kMinY, kMaxY
-    if (deltaYL == 0) {
-      //  [a, b] orizzontale esterno ad up+(bordo destro/basso)
-      if ((yL0 < 0) || (lyPred < yL0)) continue;
-      //  altrimenti usa solo
-      //  kMinX, kMaxX ((deltaXL != 0) || (deltaYL != 0))
-    } else if (deltaYL > 0) {
-      //  [a, b] esterno ad up+(bordo destro/basso)
-      if (lyPred < yL0) continue;
-
-      kMaxY = (lyPred - yL0) / deltaYL;  //  floor
-      if (yL0 < 0) {
-        kMinY = ((-yL0) + deltaYL - 1) / deltaYL;  //  ceil
+      //  calcola kMinY, kMaxY
+      if (deltaYL == 0) {
+        //  [a, b] orizzontale esterno ad up+(bordo destro/basso)
+        if ((yL0 < 0) || (lyPred < yL0)) continue;
+        //  altrimenti usa solo
+        //  kMinX, kMaxX ((deltaXL != 0) || (deltaYL != 0))
+      } else if (deltaYL > 0) {
+        //  [a, b] esterno ad up+(bordo destro/basso)
+        if (lyPred < yL0) continue;
+
+        kMaxY = (lyPred - yL0) / deltaYL;  //  floor
+        if (yL0 < 0) {
+          kMinY = ((-yL0) + deltaYL - 1) / deltaYL;  //  ceil
+        }
+      } else  //  (deltaYL < 0)
+      {
+        //  [a, b] esterno ad up+(bordo destro/basso)
+        if (yL0 < 0) continue;
+
+        kMaxY = yL0 / (-deltaYL);  //  floor
+        if (lyPred < yL0) {
+          kMinY = (yL0 - lyPred - deltaYL - 1) / (-deltaYL);  //  ceil
+        }
       }
-    } else  //  (deltaYL < 0)
-    {
-      //  [a, b] esterno ad up+(bordo destro/basso)
-      if (yL0 < 0) continue;
-
-      kMaxY = yL0 / (-deltaYL);  //  floor
-      if (lyPred < yL0) {
-        kMinY = (yL0 - lyPred - deltaYL - 1) / (-deltaYL);  //  ceil
-      }
-    }
 
-    //  calcola kMin, kMax effettuando anche il clippind su dn
-    int kMin = std::max({kMinX, kMinY, (int)0});
-    int kMax = std::min({kMaxX, kMaxY, xMax - xMin});
+      //  calcola kMin, kMax effettuando anche il clippind su dn
+      int kMin = std::max({kMinX, kMinY, (int)0});
+      int kMax = std::min({kMaxX, kMaxY, xMax - xMin});
 
-    PIX *dnPix    = dnRow + xMin + kMin;
-    PIX *dnEndPix = dnRow + xMin + kMax + 1;
+      PIX *dnPix    = dnRow + xMin + kMin;
+      PIX *dnEndPix = dnRow + xMin + kMax + 1;
 
-    //  (xL, yL) sono le coordinate (inizializzate per il round)
-    //  in versione "TLonghizzata" del pixel corrente di up
-    int xL = xL0 + (kMin - 1) * deltaXL;  //  inizializza xL
-    int yL = yL0 + (kMin - 1) * deltaYL;  //  inizializza yL
+      //  (xL, yL) sono le coordinate (inizializzate per il round)
+      //  in versione "TLonghizzata" del pixel corrente di up
+      int xL = xL0 + (kMin - 1) * deltaXL;  //  inizializza xL
+      int yL = yL0 + (kMin - 1) * deltaYL;  //  inizializza yL
 
-    //  scorre i pixel sulla y-esima scanline di boundingBoxD
-    for (; dnPix < dnEndPix; ++dnPix) {
-      xL += deltaXL;
-      yL += deltaYL;
-      //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e'
-      //  approssimato con (xI, yI)
-      int xI = xL >> PADN;  //  round
-      int yI = yL >> PADN;  //  round
+      //  scorre i pixel sulla y-esima scanline di boundingBoxD
+      for (; dnPix < dnEndPix; ++dnPix) {
+        xL += deltaXL;
+        yL += deltaYL;
+        //  il punto di up TPointD(xL/(1<<PADN), yL/(1<<PADN)) e'
+        //  approssimato con (xI, yI)
+        int xI = xL >> PADN;  //  round
+        int yI = yL >> PADN;  //  round
 
-      assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
-             (yI <= up->getLy() - 1));
+        assert((0 <= xI) && (xI <= up->getLx() - 1) && (0 <= yI) &&
+               (yI <= up->getLy() - 1));
 
-      *dnPix = *(upBasePix + (yI * upWrap + xI));
+        *dnPix = *(upBasePix + (yI * upWrap + xI));
+      }
     }
-  }
+  });
   dn->unlock();
   up->unlock();
 }
@@ -13,6 +13,7 @@
 #include "timage_io.h"
 #include "trasterimage.h"
 #include "tsimplecolorstyles.h"
+#include "tthread.h"
 
 //#include "tlevel.h"
 //#include "ttoonzimage.h"
@@ -60,6 +61,118 @@ bool renderRas32(const TTile &tileOut, const TTile &tileIn,
 const TPixel32 c_transparencyCheckPaint = TPixel32(80, 80, 80, 255);
 const TPixel32 c_transparencyCheckInk   = TPixel32::Black;
 
+namespace {
+
+/*! Converts rows [y0, y1) of \b rasIn using the premultiplied per-style
+    colors \b inks and \b paints. Runs of identical cm32 pixels (which make up
+    most of a toonz raster) reuse the previous result.
+*/
+void convertRows(const TRaster32P &rasOut, const TRasterCM32P &rasIn, int y0,
+                 int y1, const TPixel32 *inks, const TPixel32 *paints) {
+  const int maxTone = TPixelCM32::getMaxTone();
+  int rasLx         = rasOut->getLx();
+
+  for (int y = y0; y < y1; ++y) {
+    TPixel32 *pix32      = rasOut->pixels(y);
+    TPixelCM32 *pixIn    = rasIn->pixels(y);
+    TPixelCM32 *endPixIn = pixIn + rasLx;
+
+    TUINT32 lastValue = ~pixIn->getValue();
+    TPixel32 lastPix;
+
+    for (; pixIn < endPixIn; ++pixIn, ++pix32) {
+      if (pixIn->getValue() == lastValue) {
+        *pix32 = lastPix;
+        continue;
+      }
+      lastValue = pixIn->getValue();
+
+      int t = pixIn->getTone();
+      if (t == maxTone)
+        lastPix = paints[pixIn->getPaint()];
+      else if (t == 0)
+        lastPix = inks[pixIn->getInk()];
+      else
+        lastPix = blend(inks[pixIn->getInk()], paints[pixIn->getPaint()], t,
+                        maxTone);
+      *pix32 = lastPix;
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+#ifdef USE_SSE2
+
+//! SSE2 version of convertRows(); anti-aliased pixels are rounded.
+void convertRowsSse2(const TRaster32P &rasOut, const TRasterCM32P &rasIn,
+                     int y0, int y1, const TPixel32 *inks2,
+                     const TPixel32 *paints2, const TPixelFloat *inks,
+                     const TPixelFloat *paints) {
+  __m128i zeros     = _mm_setzero_si128();
+  float maxTone     = (float)TPixelCM32::getMaxTone();
+  __m128 den_packed = _mm_load1_ps(&maxTone);
+  int rasLx         = rasOut->getLx();
+
+  for (int y = y0; y < y1; ++y) {
+    TPixel32 *pix32      = rasOut->pixels(y);
+    TPixelCM32 *pixIn    = rasIn->pixels(y);
+    TPixelCM32 *endPixIn = pixIn + rasLx;
+
+    TUINT32 lastValue = ~pixIn->getValue();
+    TPixel32 lastPix;
+
+    for (; pixIn < endPixIn; ++pixIn, ++pix32) {
+      if (pixIn->getValue() == lastValue) {
+        *pix32 = lastPix;
+        continue;
+      }
+      lastValue = pixIn->getValue();
+
+      int tt = pixIn->getTone();
+      int p  = pixIn->getPaint();
+      int i  = pixIn->getInk();
+      switch (tt) {
+      case 255:
+        lastPix = paints2[p];
+        break;
+      case 0:
+        lastPix = inks2[i];
+        break;
+      default: {
+        float t         = (float)tt;
+        __m128 a_packed = _mm_load_ps((float *)&(inks[i]));
+        __m128 b_packed = _mm_load_ps((float *)&(paints[p]));
+
+        __m128 num_packed  = _mm_load1_ps(&t);
+        __m128 diff_packed = _mm_sub_ps(den_packed, num_packed);
+
+        // calcola in modo vettoriale out = ((den-num)*a + num*b)/den
+        __m128 outPix_packed = _mm_mul_ps(diff_packed, a_packed);
+        __m128 tmpPix_packed = _mm_mul_ps(num_packed, b_packed);
+
+        outPix_packed = _mm_add_ps(outPix_packed, tmpPix_packed);
+        outPix_packed = _mm_div_ps(outPix_packed, den_packed);
+
+        // converte i canali da float a char
+        __m128i outPix_packed_i = _mm_cvtps_epi32(outPix_packed);
+        outPix_packed_i         = _mm_packs_epi32(outPix_packed_i, zeros);
+        outPix_packed_i         = _mm_packus_epi16(outPix_packed_i, zeros);
+
+        *(DWORD *)(&lastPix) = _mm_cvtsi128_si32(outPix_packed_i);
+      }
+      }
+      *pix32 = lastPix;
+    }
+  }
+}
+
+#endif
+
+}  // namespace
+
+//-----------------------------------------------------------------------------
+
 void TRop::convert(const TRaster32P &rasOut, const TRasterCM32P &rasIn,
                    const TPaletteP palette, bool transparencyCheck) {
   int count = palette->getStyleCount();
@@ -73,139 +186,46 @@ void TRop::convert(const TRaster32P &rasOut, const TRasterCM32P &rasIn,
   int rasLx = rasOut->getLx();
   int rasLy = rasOut->getLy();
 
+  // the style colors are resolved once per call, not per pixel
+  std::vector<TPixel32> paints(count2, TPixel32(255, 0, 0));
+  std::vector<TPixel32> inks(count2, TPixel32(255, 0, 0));
+  if (transparencyCheck) {
+    for (int i = 0; i < count; i++) {
+      paints[i] = c_transparencyCheckPaint;
+      inks[i]   = c_transparencyCheckInk;
+    }
+    paints[0] = TPixel32::Transparent;
+  } else
+    for (int i = 0; i < count; i++)
+      paints[i] = inks[i] =
+          ::premultiply(palette->getStyle(i)->getAverageColor());
+
   rasOut->lock();
   rasIn->lock();
 #ifdef USE_SSE2
   if (TSystem::getCPUExtensions() & TSystem::CpuSupportsSse2) {
-    __m128i zeros = _mm_setzero_si128();
-    TPixelFloat *paints =
+    TPixelFloat *paintsF =
         (TPixelFloat *)_aligned_malloc(count2 * sizeof(TPixelFloat), 16);
-    TPixelFloat *inks =
+    TPixelFloat *inksF =
         (TPixelFloat *)_aligned_malloc(count2 * sizeof(TPixelFloat), 16);
-
-    std::vector<TPixel32> paints2(count2);
-    std::vector<TPixel32> inks2(count2);
-    if (transparencyCheck) {
-      for (int i = 0; i < palette->getStyleCount(); i++) {
-        paints2[i] = c_transparencyCheckPaint;
-        inks2[i]   = c_transparencyCheckInk;
-        paints[i]  = TPixelFloat(paints2[i]);
-        inks[i]    = TPixelFloat(inks2[i]);
-      }
-      paints2[0] = TPixel32::Transparent;
-      paints[0]  = TPixelFloat(TPixel32::Transparent);
-    }
-    /*
-else if (true)
-{
-            for(int i=0;i<palette->getStyleCount();i++)
-{
-paints2[i] = c_transparencyCheckPaint;
-                    inks2[i]   = c_transparencyCheckInk;
-paints[i]  = TPixelFloat(paints2[i]);
-                    inks[i]    = TPixelFloat(inks2[i]);
-            paints2[i] = TPixel32::Transparent;
-            paints[i] = TPixelFloat(TPixel32::Transparent);
-}
-            paints2[0] = TPixel32::Transparent;
-            paints[0] = TPixelFloat(TPixel32::Transparent);
-}
-*/
-    else
-      for (int i = 0; i < palette->getStyleCount(); i++) {
-        TPixel32 color = ::premultiply(palette->getStyle(i)->getAverageColor());
-        paints[i] = inks[i] = TPixelFloat(color);
-        paints2[i] = inks2[i] = color;
-      }
-
-    float maxTone     = (float)TPixelCM32::getMaxTone();
-    __m128 den_packed = _mm_load1_ps(&maxTone);
-
-    for (int y = 0; y < rasLy; ++y) {
-      TPixel32 *pix32   = rasOut->pixels(y);
-      TPixelCM32 *pixIn = rasIn->pixels(y);
-
-      TPixelCM32 *endPixIn = pixIn + rasLx;
-
-      while (pixIn < endPixIn) {
-        int tt = pixIn->getTone();
-        int p  = pixIn->getPaint();
-        int i  = pixIn->getInk();
-        switch (tt) {
-        case 255:
-          *pix32++ = paints2[p];
-          break;
-        case 0:
-          *pix32++ = inks2[i];
-          break;
-        default: {
-          float t         = (float)tt;
-          __m128 a_packed = _mm_load_ps((float *)&(inks[i]));
-          __m128 b_packed = _mm_load_ps((float *)&(paints[p]));
-
-          __m128 num_packed  = _mm_load1_ps(&t);
-          __m128 diff_packed = _mm_sub_ps(den_packed, num_packed);
-
-          // calcola in modo vettoriale out = ((den-num)*a + num*b)/den
-          __m128 outPix_packed = _mm_mul_ps(diff_packed, a_packed);
-          __m128 tmpPix_packed = _mm_mul_ps(num_packed, b_packed);
-
-          outPix_packed = _mm_add_ps(outPix_packed, tmpPix_packed);
-          outPix_packed = _mm_div_ps(outPix_packed, den_packed);
-
-          // converte i canali da float a char
-          __m128i outPix_packed_i = _mm_cvtps_epi32(outPix_packed);
-          outPix_packed_i         = _mm_packs_epi32(outPix_packed_i, zeros);
-          outPix_packed_i         = _mm_packus_epi16(outPix_packed_i, zeros);
-
-          *(DWORD *)(pix32) = _mm_cvtsi128_si32(outPix_packed_i);
-          ++pix32;
-        }
-        }
-        ++pixIn;
-      }
+    for (int i = 0; i < count2; i++) {
+      paintsF[i] = TPixelFloat(paints[i]);
+      inksF[i]   = TPixelFloat(inks[i]);
     }
 
-    _aligned_free(paints);
-    _aligned_free(inks);
+    TThread::runInBands(rasLx, rasLy, [&](int y0, int y1) {
+      convertRowsSse2(rasOut, rasIn, y0, y1, &inks[0], &paints[0], inksF,
+                      paintsF);
+    });
 
+    _aligned_free(paintsF);
+    _aligned_free(inksF);
   } else  // SSE2 not supported
 #endif    // _WIN32
   {
-
-    std::vector<TPixel32> paints(count2, TPixel32(255, 0, 0));
-    std::vector<TPixel32> inks(count2, TPixel32(255, 0, 0));
-    if (transparencyCheck) {
-      for (int i = 0; i < palette->getStyleCount(); i++) {
-        paints[i] = c_transparencyCheckPaint;
-        inks[i]   = c_transparencyCheckInk;
-      }
-      paints[0] = TPixel32::Transparent;
-    } else
-      for (int i  = 0; i < palette->getStyleCount(); i++)
-        paints[i] = inks[i] =
-            ::premultiply(palette->getStyle(i)->getAverageColor());
-
-    for (int y = 0; y < rasLy; ++y) {
-      TPixel32 *pix32      = rasOut->pixels(y);
-      TPixelCM32 *pixIn    = rasIn->pixels(y);
-      TPixelCM32 *endPixIn = pixIn + rasLx;
-
-      while (pixIn < endPixIn) {
-        int t = pixIn->getTone();
-        int p = pixIn->getPaint();
-        int i = pixIn->getInk();
-
-        if (t == TPixelCM32::getMaxTone())
-          *pix32++ = paints[p];
-        else if (t == 0)
-          *pix32++ = inks[i];
-        else
-          *pix32++ = blend(inks[i], paints[p], t, TPixelCM32::getMaxTone());
-
-        ++pixIn;
-      }
-    }
+    TThread::runInBands(rasLx, rasLy, [&](int y0, int y1) {
+      convertRows(rasOut, rasIn, y0, y1, &inks[0], &paints[0]);
+    });
   }
   rasOut->unlock();
   rasIn->unlock();
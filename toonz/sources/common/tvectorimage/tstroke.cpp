@@ -532,6 +532,11 @@ struct computeSpeed_ {
   double operator()(double par) { return norm(ref_->getSpeed(par)); }
 };
 
+//---------------------------------------------------------------------------
+
+//! Number of parameter steps per chunk in the stroke's length table
+const int c_lengthTableSteps = 8;
+
 //---------------------------------------------------------------------------
 }  // end of unnamed namespace
 
@@ -569,6 +574,11 @@ struct TStroke::Imp {
   //! This vector contains length computed for  each control point of stroke.
   DoubleArray m_partialLengthArray;
 
+  //! For each chunk, the lengths (from the chunk start) at c_lengthTableSteps
+  //! + 1 evenly spaced parameters. Built together with m_partialLengthArray,
+  //! it narrows the search of the parameter at a given length.
+  DoubleArray m_chunkLengthTable;
+
   //! This vector contains parameter computed for each control point of stroke.
   DoubleArray m_parameterValueAtControlPoint;
 
@@ -791,6 +801,7 @@ void TStroke::Imp::swapGeometry(Imp &other) throw() {
   std::swap(m_areDisabledComputeOfCaches, other.m_areDisabledComputeOfCaches);
   std::swap(m_bBox, other.m_bBox);
   std::swap(m_partialLengthArray, other.m_partialLengthArray);
+  std::swap(m_chunkLengthTable, other.m_chunkLengthTable);
   std::swap(m_parameterValueAtControlPoint,
             other.m_parameterValueAtControlPoint);
   std::swap(m_centerLineArray, other.m_centerLineArray);
@@ -822,6 +833,9 @@ void TStroke::Imp::computeCacheVector() {
 
       m_partialLengthArray[0] = 0.0;
 
+      m_chunkLengthTable.resize(getChunkCount() * (c_lengthTableSteps + 1));
+      DoubleIt lengthTableIt = m_chunkLengthTable.begin();
+
       double length = 0.0;
       int j         = 0;
       const TThickQuadratic *tq;
@@ -835,6 +849,10 @@ void TStroke::Imp::computeCacheVector() {
         m_partialLengthArray[j++] = length;
         m_partialLengthArray[j++] = length + lengthEvaluator.getLengthAt(0.5);
         length += lengthEvaluator.getLengthAt(1.0);
+
+        for (int k = 0; k <= c_lengthTableSteps; ++k)
+          *lengthTableIt++ =
+              lengthEvaluator.getLengthAt(k / (double)c_lengthTableSteps);
       }
 
       m_partialLengthArray[j++] = length;
@@ -952,11 +970,25 @@ bool TStroke::Imp::retrieveChunkAndItsParamameterAtLength(double s, int &chunk,
       return false;
     }
 
-    // fisso un offset per l'algoritmo di bisezione
+    // offset of s from the chunk start, for the root finder
     double offset = (first == m_partialLengthArray.begin())
                         ? s
                         : s - m_partialLengthArray[chunk * 2];
 
+    // narrow the search to the length table step containing offset
+    double t0 = 0.0, t1 = 1.0;
+
+    int tableOffset = chunk * (c_lengthTableSteps + 1);
+    if (tableOffset + c_lengthTableSteps < (int)m_chunkLengthTable.size()) {
+      DoubleIt lengths = m_chunkLengthTable.begin() + tableOffset;
+      int k = std::upper_bound(lengths + 1, lengths + c_lengthTableSteps,
+                               offset) -
+              (lengths + 1);
+
+      t0 = k / (double)c_lengthTableSteps;
+      t1 = (k + 1) / (double)c_lengthTableSteps;
+    }
+
     // cerco il parametro minimo a meno di una tolleranza epsilon
 
     const double tol = TConsts::epsilon * 0.1;
@@ -965,7 +997,7 @@ bool TStroke::Imp::retrieveChunkAndItsParamameterAtLength(double s, int &chunk,
     computeOffset_ op(getChunk(chunk), offset);
     computeSpeed_ op2(getChunk(chunk));
 
-    if (!findZero_Newton(0.0, 1.0, op, op2, tol, tol, 100, t, err))
+    if (!findZero_Newton(t0, t1, op, op2, tol, tol, 100, t, err))
       t = -1;  // if can not find a good value set parameter to error value
 
     // se l'algoritmo di ricerca ha fallito fissa il valore ad uno dei due
@@ -1242,6 +1274,7 @@ TStroke::TStroke(const TStroke &other)
   copy(other.m_imp->m_partialLengthArray.begin(),
        other.m_imp->m_partialLengthArray.end(),
        back_inserter<DoubleArray>(m_imp->m_partialLengthArray));
+  m_imp->m_chunkLengthTable = other.m_imp->m_chunkLengthTable;
   copy(other.m_imp->m_parameterValueAtControlPoint.begin(),
        other.m_imp->m_parameterValueAtControlPoint.end(),
        back_inserter<DoubleArray>(m_imp->m_parameterValueAtControlPoint));
@@ -1883,6 +1916,13 @@ TRectD TStroke::getCenterlineBBox() const {
 
 //-----------------------------------------------------------------------------
 
+void TStroke::computeCaches() const {
+  m_imp->computeCacheVector();
+  getBBox();
+}
+
+//-----------------------------------------------------------------------------
+
 void TStroke::disableComputeOfCaches() {
   m_imp->m_areDisabledComputeOfCaches = true;
 }
@@ -0,0 +1,434 @@
+// TnzCore includes
+#include "tvectorimage.h"
+#include "tvectorrenderdata.h"
+#include "tstroke.h"
+#include "tregion.h"
+#include "tpalette.h"
+#include "tcolorfunctions.h"
+#include "tsimplecolorstyles.h"
+#include "tstrokeoutline.h"
+#include "tpixelutils.h"
+#include "tthreadmessage.h"
+#include "tthread.h"
+#include "drawutil.h"
+
+// STD includes
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <typeinfo>
+
+#include "tvectorrasterizer.h"
+
+//********************************************************************************
+//    Local namespace  stuff
+//********************************************************************************
+
+namespace {
+
+//  coverage below which a pixel is left untouched (it would round to 0 anyway)
+const float c_minCoverage = 1.0f / 512.0f;
+
+//------------------------------------------------------------------------------
+
+bool isOThick(const TStroke *s) {
+  for (int i = 0; i < s->getControlPointCount(); i++)
+    if (s->getControlPoint(i).thick != 0) return false;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+//! Returns whether the style is a plain TSolidColorStyle, the only kind the
+//! rasterizer knows how to fill. Derived styles (colorfx fills, cleanup
+//! styles) have their own drawing code and are left to the GL path.
+bool isSolidStyle(const TPalette *palette, int styleId) {
+  TColorStyle *style = palette->getStyle(styleId);
+  if (!style || typeid(*style) != typeid(TSolidColorStyle)) return false;
+
+  TSolidColorStyle *solid = static_cast<TSolidColorStyle *>(style);
+  return !solid->getRegionOutlineModifier();
+}
+
+//------------------------------------------------------------------------------
+
+bool isSupportedRegion(const TPalette *palette, const TRegion *r) {
+  if (r->getStyle() && !isSolidStyle(palette, r->getStyle())) return false;
+
+  for (UINT i = 0; i < r->getSubregionCount(); i++)
+    if (!isSupportedRegion(palette, r->getSubregion(i))) return false;
+
+  return true;
+}
+
+//==============================================================================
+
+//! A single color fill, made of closed polygons in raster coordinates. Fill
+//! polygons run counterclockwise and holes clockwise, so that the coverage of
+//! a pixel is the (clamped) sum of the signed areas covering it. Overlapping
+//! fill polygons, like the quads of a stroke outline, then simply merge.
+struct Shape {
+  std::vector<TPointD> m_points;
+  std::vector<int> m_sizes;  //!< Points count of each polygon.
+  TRectD m_bbox;
+  TPixel32 m_color;  //!< Premultiplied.
+
+  Shape(const TPixel32 &color) : m_color(premultiply(color)) {}
+
+  void addPolygon(const TPointD *points, int count, bool hole) {
+    double area = 0.0;
+    for (int i = 0, j = count - 1; i < count; j = i++)
+      area += cross(points[j], points[i]);
+    if (area == 0.0) return;
+
+    if ((area < 0.0) != hole)
+      m_points.insert(m_points.end(), std::reverse_iterator<const TPointD *>(
+                                          points + count),
+                      std::reverse_iterator<const TPointD *>(points));
+    else
+      m_points.insert(m_points.end(), points, points + count);
+    m_sizes.push_back(count);
+
+    if (m_sizes.size() == 1) m_bbox = TRectD(points[0], points[0]);
+    for (int i = 0; i < count; ++i) {
+      const TPointD &p = points[i];
+      m_bbox.x0 = std::min(m_bbox.x0, p.x);
+      m_bbox.y0 = std::min(m_bbox.y0, p.y);
+      m_bbox.x1 = std::max(m_bbox.x1, p.x);
+      m_bbox.y1 = std::max(m_bbox.y1, p.y);
+    }
+  }
+};
+
+//==============================================================================
+
+/*!
+  Coverage accumulator for a rectangular window of the output.
+
+  Every boundary segment deposits, in each cell it crosses, the signed area
+  it sweeps up to the cell's right side, plus the remaining height in the
+  cell that follows. A running sum along each row then yields the exact
+  analytic coverage of every pixel, with no supersampling.
+*/
+class CoverageBuffer {
+  std::vector<float> m_cells;
+  int m_lx, m_ly, m_wrap;
+
+public:
+  CoverageBuffer() : m_lx(0), m_ly(0), m_wrap(0) {}
+
+  void reset(int lx, int ly) {
+    m_lx = lx, m_ly = ly, m_wrap = lx + 2;
+    m_cells.assign(m_wrap * ly, 0.0f);
+  }
+
+  //! Adds a segment in window coordinates. Parts lying left of the window
+  //! are projected on its left side, where they still count for the cells
+  //! on their right; parts right of the window are dropped.
+  void addSegment(const TPointD &p0, const TPointD &p1) {
+    double bounds[2] = {0.0, (double)m_lx}, t[2];
+    int count = 0;
+    for (int i = 0; i < 2; ++i)
+      if ((p0.x - bounds[i]) * (p1.x - bounds[i]) < 0.0)
+        t[count++] = (bounds[i] - p0.x) / (p1.x - p0.x);
+    if (count == 2 && t[0] > t[1]) std::swap(t[0], t[1]);
+
+    TPointD a = p0;
+    for (int i = 0; i < count; ++i) {
+      TPointD b = p0 + t[i] * (p1 - p0);
+      addLine(a, b);
+      a = b;
+    }
+    addLine(a, p1);
+  }
+
+  void blend(const TRaster32P &ras, const TPoint &pos,
+             const TPixel32 &color) const {
+    // Same as GL's blending in tglDraw(): premultiplied 'over', with the
+    // source scaled by coverage
+    for (int y = 0; y < m_ly; ++y) {
+      const float *cell = &m_cells[y * m_wrap];
+      TPixel32 *pix     = ras->pixels(pos.y + y) + pos.x;
+
+      float acc = 0.0f;
+      for (int x = 0; x < m_lx; ++x, ++pix) {
+        acc += cell[x];
+        if (acc < c_minCoverage) continue;
+
+        if (acc >= 1.0f && color.m == 255) {
+          *pix = color;
+          continue;
+        }
+
+        double cov = std::min(acc, 1.0f), k = 1.0 - cov * color.m / 255.0;
+        pix->r = (UCHAR)(color.r * cov + pix->r * k + 0.5);
+        pix->g = (UCHAR)(color.g * cov + pix->g * k + 0.5);
+        pix->b = (UCHAR)(color.b * cov + pix->b * k + 0.5);
+        pix->m = (UCHAR)(color.m * cov + pix->m * k + 0.5);
+      }
+    }
+  }
+
+private:
+  void addLine(TPointD p0, TPointD p1) {
+    p0.x = tcrop(p0.x, 0.0, (double)m_lx);
+    p1.x = tcrop(p1.x, 0.0, (double)m_lx);
+    if (p0.y == p1.y) return;
+
+    // Counterclockwise polygons must accumulate positive coverage: their
+    // upward edges are on the right
+    float dir = -1.0f;
+    if (p0.y > p1.y) std::swap(p0, p1), dir = 1.0f;
+    if (p1.y <= 0.0 || p0.y >= m_ly) return;
+
+    double dxdy = (p1.x - p0.x) / (p1.y - p0.y);
+    double y0 = std::max(p0.y, 0.0), y1 = std::min(p1.y, (double)m_ly);
+    double x  = p0.x + (y0 - p0.y) * dxdy;
+
+    for (int y = (int)y0; y < y1; ++y) {
+      double dy    = std::min(y + 1.0, y1) - std::max((double)y, y0);
+      double xNext = tcrop(x + dxdy * dy, 0.0, (double)m_lx);
+      double d     = dir * dy;
+      float *row   = &m_cells[y * m_wrap];
+
+      double xa = std::min(x, xNext), xb = std::max(x, xNext);
+      int xaFloor = (int)xa, xbCeil = (int)std::ceil(xb);
+
+      if (xbCeil <= xaFloor + 1) {
+        // The segment stays in a single cell
+        double xm = 0.5 * (x + xNext) - xaFloor;
+        row[xaFloor] += (float)(d * (1.0 - xm));
+        row[xaFloor + 1] += (float)(d * xm);
+      } else {
+        double s   = 1.0 / (xb - xa);
+        double xaf = xa - xaFloor, xbf = xb - xbCeil + 1.0;
+        double a0 = 0.5 * s * (1.0 - xaf) * (1.0 - xaf);
+        double am = 0.5 * s * xbf * xbf;
+
+        row[xaFloor] += (float)(d * a0);
+        if (xbCeil == xaFloor + 2)
+          row[xaFloor + 1] += (float)(d * (1.0 - a0 - am));
+        else {
+          double a1 = s * (1.5 - xaf);
+          row[xaFloor + 1] += (float)(d * (a1 - a0));
+          for (int xi = xaFloor + 2; xi < xbCeil - 1; ++xi)
+            row[xi] += (float)(d * s);
+          double a2 = a1 + (xbCeil - xaFloor - 3) * s;
+          row[xbCeil - 1] += (float)(d * (1.0 - a2 - am));
+        }
+        row[xbCeil] += (float)(d * am);
+      }
+
+      x = xNext;
+    }
+  }
+};
+
+//==============================================================================
+
+//! Collects the shapes of an image in drawing order, following doDraw() in
+//! tglregions.cpp.
+class ShapeBuilder {
+  const TVectorRenderData &m_rd;
+  const TPalette *m_palette;
+  TRectD m_bounds;
+  double m_pixelSize;
+
+public:
+  std::vector<Shape> m_shapes;
+
+public:
+  ShapeBuilder(const TVectorRenderData &rd, const TPalette *palette,
+               const TRectD &bounds)
+      : m_rd(rd), m_palette(palette), m_bounds(bounds) {
+    double det  = fabs(rd.m_aff.det());
+    m_pixelSize = (det > 0.0) ? sqrt(1.0 / det) : 1.0;
+  }
+
+  void addStroke(const TStroke *s) {
+    TPixel32 color;
+    if (isOThick(s) || !getColor(s->getStyle(), color)) return;
+    if (!(m_rd.m_aff * s->getBBox()).overlaps(m_bounds)) return;
+
+    TStrokeOutline outline;
+    TOutlineUtil::makeOutline(*s, outline, TOutlineUtil::OutlineParameter());
+
+    // The outline is a quad strip: fill each quad on its own
+    const std::vector<TOutlinePoint> &v = outline.getArray();
+    Shape shape(color);
+    for (int i = 0; i + 3 < (int)v.size(); i += 2) {
+      TPointD quad[4] = {m_rd.m_aff * convert(v[i]),
+                         m_rd.m_aff * convert(v[i + 1]),
+                         m_rd.m_aff * convert(v[i + 3]),
+                         m_rd.m_aff * convert(v[i + 2])};
+      shape.addPolygon(quad, 4, false);
+    }
+    addShape(shape);
+  }
+
+  void addRegion(const TRegion *r) {
+    TPixel32 color;
+    if (r->getStyle() && getColor(r->getStyle(), color) &&
+        (m_rd.m_aff * r->getBBox()).overlaps(m_bounds)) {
+      Shape shape(color);
+      addBoundary(shape, r, false);
+      for (UINT i = 0; i < r->getSubregionCount(); i++)
+        addBoundary(shape, r->getSubregion(i), true);
+      addShape(shape);
+    }
+
+    for (UINT i = 0; i < r->getSubregionCount(); i++)
+      addRegion(r->getSubregion(i));
+  }
+
+private:
+  bool getColor(int styleId, TPixel32 &color) const {
+    TColorStyle *style = m_palette->getStyle(styleId);
+    if (!style || !style->isEnabled()) return false;
+
+    color = style->getMainColor();
+    if (m_rd.m_cf) color = (*m_rd.m_cf)(color);
+    return color.m != 0;
+  }
+
+  void addBoundary(Shape &shape, const TRegion *r, bool hole) {
+    std::vector<TPointD> polyline;
+    for (UINT i = 0; i < r->getEdgeCount(); i++) {
+      const TEdge &edge = *r->getEdge(i);
+      if (edge.m_index >= 0 && edge.m_s)
+        stroke2polyline(polyline, *edge.m_s, m_pixelSize, edge.m_w0,
+                        edge.m_w1);
+    }
+    if (polyline.size() < 3) return;
+
+    for (TPointD &p : polyline) p = m_rd.m_aff * p;
+    shape.addPolygon(&polyline[0], (int)polyline.size(), hole);
+  }
+
+  void addShape(Shape &shape) {
+    if (shape.m_sizes.empty() || !shape.m_bbox.overlaps(m_bounds)) return;
+
+    // Keep the box in int range, coverage outside the bounds is not drawn
+    shape.m_bbox *= m_bounds;
+    m_shapes.push_back(std::move(shape));
+  }
+};
+
+//------------------------------------------------------------------------------
+
+//! Fills the shapes on the ras scanlines [y0, y1], in order.
+void drawRows(const TRaster32P &ras, const std::vector<Shape> &shapes, int y0,
+              int y1) {
+  TRect band(0, y0, ras->getLx() - 1, y1);
+  CoverageBuffer buffer;
+
+  for (const Shape &shape : shapes) {
+    const TRectD &b = shape.m_bbox;
+    TRect box       = TRect(tfloor(b.x0), tfloor(b.y0), tceil(b.x1) - 1,
+                      tceil(b.y1) - 1) *
+                band;
+    if (box.isEmpty()) continue;
+
+    buffer.reset(box.getLx(), box.getLy());
+
+    TPointD origin(box.x0, box.y0);
+    const TPointD *points = &shape.m_points[0];
+    for (int count : shape.m_sizes) {
+      for (int i = 0, j = count - 1; i < count; j = i++)
+        buffer.addSegment(points[j] - origin, points[i] - origin);
+      points += count;
+    }
+
+    buffer.blend(ras, box.getP00(), shape.m_color);
+  }
+}
+
+}  // namespace
+
+//********************************************************************************
+//    TVectorRasterizer  implementation
+//********************************************************************************
+
+bool TVectorRasterizer::isSupported(const TVectorImage *vim,
+                                    const TVectorRenderData &rd) {
+  if (!vim) return false;
+
+  // Check modes and guided drawing highlights are drawn by tglDraw() only
+  if (rd.m_tcheckEnabled || rd.m_inkCheckEnabled || rd.m_ink1CheckEnabled ||
+      rd.m_paintCheckEnabled || rd.m_showGuidedDrawing || rd.m_is3dView ||
+      rd.m_show0ThickStrokes)
+    return false;
+
+  // Groups entered in the editor are drawn faded
+  if (!rd.m_isIcon && vim->isInsideGroup() > 0) return false;
+
+  const TPalette *palette = rd.m_palette ? rd.m_palette : vim->getPalette();
+  if (!palette) return false;
+
+  QMutexLocker sl(vim->getMutex());
+
+  for (UINT i = 0; i < vim->getStrokeCount(); i++) {
+    const TStroke *s = vim->getStroke(i);
+    if (!isSolidStyle(palette, s->getStyle())) return false;
+
+    // Centerline strokes are drawn as GL lines
+    if (s->isCenterLine() && !isOThick(s)) return false;
+  }
+
+  if (rd.m_drawRegions)
+    for (UINT i = 0; i < vim->getRegionCount(); i++)
+      if (!isSupportedRegion(palette, vim->getRegion(i))) return false;
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+
+void TVectorRasterizer::draw(const TRaster32P &ras, const TVectorImage *vim,
+                             const TVectorRenderData &rd) {
+  assert(isSupported(vim, rd));
+
+  const TPalette *palette = rd.m_palette ? rd.m_palette : vim->getPalette();
+  if (!ras || !vim || !palette) return;
+
+  TRectD bounds(0, 0, ras->getLx(), ras->getLy());
+  if (rd.m_clippingRect != TRect())
+    bounds *= TRectD(rd.m_clippingRect.x0, rd.m_clippingRect.y0,
+                     rd.m_clippingRect.x1 + 1, rd.m_clippingRect.y1 + 1);
+  if (bounds.isEmpty()) return;
+
+  ShapeBuilder builder(rd, palette, bounds);
+  {
+    QMutexLocker sl(vim->getMutex());
+
+    // Each group draws its regions first, then its strokes
+    UINT strokeIndex = 0, strokeCount = vim->getStrokeCount();
+    while (strokeIndex < strokeCount) {
+      UINT currStrokeIndex = strokeIndex;
+
+      if (rd.m_drawRegions)
+        for (UINT i = 0; i < vim->getRegionCount(); i++)
+          if (vim->sameGroupStrokeAndRegion(currStrokeIndex, i))
+            builder.addRegion(vim->getRegion(i));
+
+      while (strokeIndex < strokeCount &&
+             vim->sameGroup(strokeIndex, currStrokeIndex))
+        builder.addStroke(vim->getStroke(strokeIndex++));
+    }
+  }
+
+  const std::vector<Shape> &shapes = builder.m_shapes;
+  if (shapes.empty()) return;
+
+  int y0 = std::max(tfloor(bounds.y0), 0),
+      y1 = std::min(tceil(bounds.y1), ras->getLy()) - 1;
+  int lx = ras->getLx(), ly = y1 - y0 + 1;
+  if (ly <= 0) return;
+
+  // Bands are disjoint, and each one draws all the shapes in order
+  ras->lock();
+  TThread::runInBands(lx, ly, [&](int bandY0, int bandY1) {
+    drawRows(ras, shapes, y0 + bandY0, y0 + bandY1 - 1);
+  });
+  ras->unlock();
+}
@@ -13,6 +13,14 @@
 #include "../compatibility/tfile_io.h"
 #include "tenv.h"
 
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QMutex>
+
+#include <unordered_map>
+#include <algorithm>
+
 /*=====================================================================*/
 
 #if defined(MACOSX)
@@ -146,18 +154,30 @@ MyOfstream &MyOfstream::operator<<(const std::string &s) {
 
 /*=====================================================================*/
 
-class MyIfstream  // The input is done without stl; it was crashing in release
-                  // version loading textures!!
-{
+// The input is read from a memory mapping of the whole file: values are
+// decoded straight from memory and readTag() hands out pointers into the
+// mapping, so that loading a frame only touches the bytes of its own tags.
+// If the file cannot be mapped, its content is read in a single block.
+
+class MyIfstream {
 private:
   bool m_isIrixEndian;
-  FILE *m_fp;
+  QFile m_file;
+  const UCHAR *m_data;
+  std::vector<UCHAR> m_fileData;  // Used only when the mapping fails
+  TUINT32 m_size, m_pos;
+
+  const UCHAR *advance(TUINT32 length) {
+    if (length > m_size - std::min(m_pos, m_size))
+      throw TException("corrupted pli file: unexpected end of file");
+    const UCHAR *data = m_data + m_pos;
+    m_pos += length;
+    return data;
+  }
 
 public:
-  MyIfstream() : m_isIrixEndian(false) { m_fp = 0; }
-  ~MyIfstream() {
-    if (m_fp) fclose(m_fp);
-  }
+  MyIfstream() : m_isIrixEndian(false), m_data(0), m_size(0), m_pos(0) {}
+  ~MyIfstream() { close(); }
   void setEndianess(bool isIrixEndian) { m_isIrixEndian = isIrixEndian; }
   MyIfstream &operator>>(TUINT32 &un);
   MyIfstream &operator>>(string &un);
@@ -165,35 +185,57 @@ public:
   MyIfstream &operator>>(UCHAR &un);
   MyIfstream &operator>>(char &un);
   void open(const TFilePath &filename);
-  void close() {
-    if (m_fp) fclose(m_fp);
-    m_fp = 0;
-  }
-  TUINT32 tellg() { return (TUINT32)ftell(m_fp); }
+  void close();
+  TUINT32 tellg() const { return m_pos; }
   // void seekg(TUINT32 pos, ios_base::seek_dir type);
   void seekg(TUINT32 pos, int type);
   void read(char *m_buf, int length) {
-    fread((void *)m_buf, sizeof(char), length, m_fp);
+    memcpy(m_buf, advance(length), length);
+  }
+  //! Returns the next \b length bytes of the file, without copying them.
+  const UCHAR *data(TUINT32 length) { return advance(length); }
+
+  TUINT32 size() const { return m_size; }
+  QDateTime lastModified() const {
+    return QFileInfo(m_file).lastModified();
   }
 };
 
 /*=====================================================================*/
 
 void MyIfstream::open(const TFilePath &filename) {
-  try {
-    m_fp = fopen(filename, "rb");
-  } catch (TException &) {
+  close();
+
+  m_file.setFileName(filename.getQString());
+  if (!m_file.open(QIODevice::ReadOnly))
     throw TImageException(filename, "File not found");
+
+  m_size = (TUINT32)m_file.size();
+  m_data = m_file.map(0, m_size);
+  if (!m_data && m_size) {
+    m_fileData.resize(m_size);
+    if (m_file.read((char *)&m_fileData[0], m_size) != (qint64)m_size)
+      throw TImageException(filename, "Error on reading file");
+    m_data = &m_fileData[0];
   }
 }
 
 /*=====================================================================*/
 
+void MyIfstream::close() {
+  m_file.close();  // Unmaps the file, too
+  std::vector<UCHAR>().swap(m_fileData);
+  m_data = 0;
+  m_size = m_pos = 0;
+}
+
+/*=====================================================================*/
+
 void MyIfstream::seekg(TUINT32 pos, int type) {
   if (type == ios_base::beg)
-    fseek(m_fp, pos, SEEK_SET);
+    m_pos = pos;
   else if (type == ios_base::cur)
-    fseek(m_fp, pos, SEEK_CUR);
+    m_pos += pos;
   else
     assert(false);
 }
@@ -201,27 +243,21 @@ void MyIfstream::seekg(TUINT32 pos, int type) {
 /*=====================================================================*/
 
 inline MyIfstream &MyIfstream::operator>>(UCHAR &un) {
-  int ret = fread((void *)&un, sizeof(UCHAR), 1, m_fp);
-  if (ret < 1) throw TException("corrupted pli file: unexpected end of file");
-  // read((char *)&un, sizeof(UCHAR));
+  un = *advance(sizeof(UCHAR));
   return *this;
 }
 
 /*=====================================================================*/
 
 inline MyIfstream &MyIfstream::operator>>(char &un) {
-  int ret = fread((void *)&un, sizeof(char), 1, m_fp);
-  if (ret < 1) throw TException("corrupted pli file: unexpected end of file");
-  // read((char *)&un, sizeof(char));
+  un = (char)*advance(sizeof(char));
   return *this;
 }
 
 /*=====================================================================*/
 
 inline MyIfstream &MyIfstream::operator>>(USHORT &un) {
-  int ret = fread((void *)&un, sizeof(USHORT), 1, m_fp);
-  if (ret < 1) throw TException("corrupted pli file: unexpected end of file");
-  //  read((char *)&un, sizeof(USHORT));
+  memcpy(&un, advance(sizeof(USHORT)), sizeof(USHORT));
 
   if (m_isIrixEndian) un = ((un & 0xff00) >> 8) | ((un & 0x00ff) << 8);
   return *this;
@@ -230,9 +266,7 @@ inline MyIfstream &MyIfstream::operator>>(USHORT &un) {
 /*=====================================================================*/
 
 inline MyIfstream &MyIfstream::operator>>(TUINT32 &un) {
-  int ret = fread((void *)&un, sizeof(TUINT32), 1, m_fp);
-  if (ret < 1) throw TException("corrupted pli file: unexpected end of file");
-  // read((char *)&un, sizeof(TUINT32));
+  memcpy(&un, advance(sizeof(TUINT32)), sizeof(TUINT32));
 
   if (m_isIrixEndian)
     un = ((un & 0xff000000) >> 24) | ((un & 0x00ff0000) >> 8) |
@@ -243,15 +277,10 @@ inline MyIfstream &MyIfstream::operator>>(TUINT32 &un) {
 /*=====================================================================*/
 
 inline MyIfstream &MyIfstream::operator>>(string &un) {
-  string s = "";
   USHORT length;
   (*this) >> length;
-  for (UINT i = 0; i < length; i++) {
-    UCHAR ch;
-    (*this) >> ch;
-    s.append(1, ch);
-  }
-  un = s;
+  const UCHAR *data = advance(length);
+  un.assign((const char *)data, length);
 
   return *this;
 }
@@ -310,6 +339,60 @@ public:
   }
 };
 
+/*=====================================================================*/
+
+namespace {
+
+// Frame index of a pli file, i.e. what loadInfo() finds scanning all the
+// tags. It is kept for the whole session, so that reopening a level (which
+// happens every time one of its frames has to be loaded again) only reads
+// the header and the tags holding the styles, palette and history.
+struct PliIndex {
+  TUINT32 m_fileSize;
+  QDateTime m_lastModified;
+  std::map<TFrameId, int> m_frameOffsInFile;
+  // Offsets of the tags read by loadInfo(), each with the dynamic data
+  // size in effect at that point of the file
+  std::vector<std::pair<TUINT32, UCHAR>> m_infoTags;
+};
+
+class PliIndexCache {
+  QMutex m_mutex;
+  std::map<TFilePath, PliIndex> m_indices;
+
+public:
+  static PliIndexCache *instance() {
+    static PliIndexCache theInstance;
+    return &theInstance;
+  }
+
+  bool get(const TFilePath &fp, TUINT32 fileSize,
+           const QDateTime &lastModified, PliIndex &index) {
+    QMutexLocker locker(&m_mutex);
+    std::map<TFilePath, PliIndex>::iterator it = m_indices.find(fp);
+    if (it == m_indices.end()) return false;
+    if (it->second.m_fileSize != fileSize ||
+        it->second.m_lastModified != lastModified) {
+      m_indices.erase(it);
+      return false;
+    }
+    index = it->second;
+    return true;
+  }
+
+  void set(const TFilePath &fp, const PliIndex &index) {
+    QMutexLocker locker(&m_mutex);
+    m_indices[fp] = index;
+  }
+
+  void remove(const TFilePath &fp) {
+    QMutexLocker locker(&m_mutex);
+    m_indices.erase(fp);
+  }
+};
+
+}  // namespace
+
 /*=====================================================================*/
 class TContentHistory;
 
@@ -326,11 +409,11 @@ public:
   TFilePath m_filePath;
   UCHAR m_currDinamicTypeBytesNum;
   TUINT32 m_tagLength;
-  TUINT32 m_bufLength;
-  std::unique_ptr<UCHAR[]> m_buf;
+  const UCHAR *m_buf;  // Body of the last read tag, inside m_iChan's data
   TAffine m_affine;
   int m_precisionScale;
   std::map<TFrameId, int> m_frameOffsInFile;
+  std::unordered_map<TUINT32, PliTag *> m_tagsByOffset;
 
   PliTag *readTextTag();
   PliTag *readPaletteTag();
@@ -380,9 +463,12 @@ public:
   inline void setDinamicTypeBytesNum(int minval, int maxval);
 
   PliTag *findTagFromOffset(UINT tagOffs);
+  void clearTags();
   UINT findOffsetFromTag(PliTag *tag);
   TagElem *findTag(PliTag *tag);
   USHORT readTagHeader();
+  void readInfoTag(TUINT32 pos, bool &readPlt, TPalette *&palette,
+                   TContentHistory *&history);
 
 public:
   enum errorType {
@@ -490,7 +576,7 @@ ParsedPliImp::ParsedPliImp()
     , m_currTag(NULL)
     , m_iChan()
     , m_oChan(0)
-    , m_bufLength(0)
+    , m_buf(0)
     , m_affine()
     , m_precisionScale(REGION_COMPUTING_PRECISION)
     , m_creator("") {}
@@ -511,7 +597,7 @@ ParsedPliImp::ParsedPliImp(UCHAR majorVersionNumber, UCHAR minorVersionNumber,
     , m_currTag(NULL)
     , m_iChan()
     , m_oChan(0)
-    , m_bufLength(0)
+    , m_buf(0)
     , m_affine(TScale(1.0 / pow(10.0, precision)))
     , m_precisionScale(REGION_COMPUTING_PRECISION)
     , m_creator("") {}
@@ -529,7 +615,7 @@ ParsedPliImp::ParsedPliImp(const TFilePath &filename, bool readInfo)
     , m_currTag(NULL)
     , m_iChan()
     , m_oChan(0)
-    , m_bufLength(0)
+    , m_buf(0)
     , m_precisionScale(REGION_COMPUTING_PRECISION)
     , m_creator("") {
   TUINT32 magic;
@@ -539,6 +625,8 @@ ParsedPliImp::ParsedPliImp(const TFilePath &filename, bool readInfo)
 
   // cerr<<m_filePath<<endl;
 
+  m_filePath = filename;
+
   //#ifdef _WIN32
   m_iChan.open(filename);
 
@@ -606,10 +694,12 @@ ParsedPliImp::ParsedPliImp(const TFilePath &filename, bool readInfo)
         m_lastTag->m_next = tagElem;
         m_lastTag         = m_lastTag->m_next;
       }
+      m_tagsByOffset[tagElem->m_offset] = tagElem->m_tag;
     }
 
     for (tagElem = m_firstTag; tagElem; tagElem = tagElem->m_next)
       tagElem->m_offset = 0;
+    m_tagsByOffset.clear();
 
     m_iChan.close();
   }
@@ -658,6 +748,18 @@ void ParsedPliImp::loadInfo(bool readPlt, TPalette *&palette,
 
   m_currDinamicTypeBytesNum = 2;
 
+  PliIndex index;
+  if (PliIndexCache::instance()->get(m_filePath, m_iChan.size(),
+                                     m_iChan.lastModified(), index)) {
+    m_frameOffsInFile = index.m_frameOffsInFile;
+    for (UINT i = 0; i < index.m_infoTags.size(); i++) {
+      m_currDinamicTypeBytesNum = index.m_infoTags[i].second;
+      readInfoTag(index.m_infoTags[i].first, readPlt, palette, history);
+    }
+    assert(m_frameOffsInFile.size() == m_framesNumber);
+    return;
+  }
+
   // m_frameOffsInFile = new int[m_framesNumber];
   // for (int i=0; i<m_framesNumber; i++)
   //  m_frameOffsInFile[i] = -1;
@@ -678,33 +780,20 @@ void ParsedPliImp::loadInfo(bool readPlt, TPalette *&palette,
 
       // m_iChan.seekg(m_tagLength, ios::cur);
       m_iChan.seekg(m_tagLength - 2, ios::cur);
-    } else if (type == PliTag::STYLE_NGOBJ) {
-      m_iChan.seekg(pos, ios::beg);
-      TagElem *tagElem = readTag();
-      addTag(*tagElem);
-      tagElem->m_tag = 0;
-      delete tagElem;
-    } else if (type == PliTag::TEXT) {
-      m_iChan.seekg(pos, ios::beg);
-      TagElem *tagElem = readTag();
-      TextTag *textTag = (TextTag *)tagElem->m_tag;
-      history          = new TContentHistory(true);
-      history->deserialize(QString::fromStdString(textTag->m_text));
-      delete tagElem;
-    }
-
-    else if (type == PliTag::GROUP_GOBJ && readPlt)  // la paletta!!!
-    {
-      m_iChan.seekg(pos, ios::beg);
-      TagElem *tagElem   = readTag();
-      GroupTag *grouptag = (GroupTag *)tagElem->m_tag;
-      if (grouptag->m_type == (UCHAR)GroupTag::PALETTE) {
-        readPlt = false;
-        palette = readPalette((GroupTag *)tagElem->m_tag, m_majorVersionNumber,
-                              m_minorVersionNumber);
+    } else if (type == PliTag::STYLE_NGOBJ || type == PliTag::TEXT) {
+      index.m_infoTags.push_back(
+          std::make_pair(pos, m_currDinamicTypeBytesNum));
+      readInfoTag(pos, readPlt, palette, history);
+    } else if (type == PliTag::GROUP_GOBJ) {
+      // only the palette group is needed: stroke groups belong to frames
+      UCHAR groupType;
+      m_iChan >> groupType;
+      if (groupType == (UCHAR)GroupTag::PALETTE) {
+        index.m_infoTags.push_back(
+            std::make_pair(pos, m_currDinamicTypeBytesNum));
+        readInfoTag(pos, readPlt, palette, history);
       } else
-        assert(grouptag->m_type == (UCHAR)GroupTag::STROKE);
-      delete tagElem;
+        m_iChan.seekg(m_tagLength - 1, ios::cur);
     } else {
       m_iChan.seekg(m_tagLength, ios::cur);
       switch (type) {
@@ -724,6 +813,11 @@ void ParsedPliImp::loadInfo(bool readPlt, TPalette *&palette,
     pos = m_iChan.tellg();
   }
 
+  index.m_fileSize        = m_iChan.size();
+  index.m_lastModified    = m_iChan.lastModified();
+  index.m_frameOffsInFile = m_frameOffsInFile;
+  PliIndexCache::instance()->set(m_filePath, index);
+
   assert(m_frameOffsInFile.size() == m_framesNumber);
   // palette = new TPalette();
   // for (int i=0; i<256; i++)
@@ -732,6 +826,36 @@ void ParsedPliImp::loadInfo(bool readPlt, TPalette *&palette,
 
 /*=====================================================================*/
 
+void ParsedPliImp::readInfoTag(TUINT32 pos, bool &readPlt, TPalette *&palette,
+                               TContentHistory *&history) {
+  m_iChan.seekg(pos, ios::beg);
+  USHORT type = readTagHeader();
+  if (type == PliTag::GROUP_GOBJ && !readPlt) {
+    m_iChan.seekg(m_tagLength, ios::cur);
+    return;
+  }
+
+  m_iChan.seekg(pos, ios::beg);
+  TagElem *tagElem = readTag();
+  if (type == PliTag::STYLE_NGOBJ) {
+    addTag(*tagElem);
+    tagElem->m_tag = 0;
+  } else if (type == PliTag::TEXT) {
+    TextTag *textTag = (TextTag *)tagElem->m_tag;
+    history          = new TContentHistory(true);
+    history->deserialize(QString::fromStdString(textTag->m_text));
+  } else if (type == PliTag::GROUP_GOBJ)  // la paletta!!!
+  {
+    GroupTag *grouptag = (GroupTag *)tagElem->m_tag;
+    assert(grouptag->m_type == (UCHAR)GroupTag::PALETTE);
+    readPlt = false;
+    palette = readPalette(grouptag, m_majorVersionNumber, m_minorVersionNumber);
+  }
+  delete tagElem;
+}
+
+/*=====================================================================*/
+
 USHORT ParsedPliImp::readTagHeader() {
   UCHAR ucharTagType, tagLengthId;
   USHORT tagType;
@@ -787,13 +911,8 @@ USHORT ParsedPliImp::readTagHeader() {
 ImageTag *ParsedPliImp::loadFrame(const TFrameId &frameNumber) {
   m_currDinamicTypeBytesNum = 2;
 
-  TagElem *tagElem = m_firstTag;
-  while (tagElem) {
-    TagElem *auxTag = tagElem;
-    tagElem         = tagElem->m_next;
-    delete auxTag;
-  }
-  m_firstTag = 0;
+  clearTags();
+  TagElem *tagElem;
 
   // PliTag *tag;
   USHORT type = PliTag::IMAGE_BEGIN_GOBJ;
@@ -839,6 +958,7 @@ ImageTag *ParsedPliImp::loadFrame(const TFrameId &frameNumber) {
       m_lastTag->m_next = tagElem;
       m_lastTag         = m_lastTag->m_next;
     }
+    m_tagsByOffset[tagElem->m_offset] = tagElem->m_tag;
     if (tagElem->m_tag->m_type == PliTag::IMAGE_GOBJ) {
       assert(((ImageTag *)(tagElem->m_tag))->m_numFrame == frameId);
       return (ImageTag *)tagElem->m_tag;
@@ -893,15 +1013,8 @@ TagElem *ParsedPliImp::readTag() {
     assert(false);
   }
 
-  if (m_bufLength < m_tagLength) {
-    m_bufLength = m_tagLength;
-    m_buf.reset(new UCHAR[m_bufLength]);
-  }
-
-  if (m_tagLength) {
-    m_iChan.read((char *)m_buf.get(), (int)m_tagLength);
-    CHECK_FOR_READ_ERROR(m_filePath);
-  }
+  m_buf = m_iChan.data(m_tagLength);
+  CHECK_FOR_READ_ERROR(m_filePath);
 
   PliTag *newTag = NULL;
 
@@ -975,9 +1088,22 @@ TagElem *ParsedPliImp::readTag() {
 /*=====================================================================*/
 
 PliTag *ParsedPliImp::findTagFromOffset(UINT tagOffs) {
-  for (TagElem *elem = m_firstTag; elem; elem = elem->m_next)
-    if (elem->m_offset == tagOffs) return elem->m_tag;
-  return NULL;
+  std::unordered_map<TUINT32, PliTag *>::const_iterator it =
+      m_tagsByOffset.find(tagOffs);
+  return (it == m_tagsByOffset.end()) ? NULL : it->second;
+}
+
+/*=====================================================================*/
+
+void ParsedPliImp::clearTags() {
+  TagElem *tag = m_firstTag;
+  while (tag) {
+    TagElem *auxTag = tag;
+    tag             = tag->m_next;
+    delete auxTag;
+  }
+  m_firstTag = m_lastTag = m_currTag = 0;
+  m_tagsByOffset.clear();
 }
 /*=====================================================================*/
 
@@ -1086,7 +1212,7 @@ inline bool ParsedPliImp::readDinamicData(TINT32 &val, TUINT32 &bufOffs) {
 PliTag *ParsedPliImp::readTextTag() {
   if (m_tagLength == 0) return new TextTag("");
 
-  return new TextTag(string((char *)m_buf.get(), m_tagLength));
+  return new TextTag(string((char *)m_buf, m_tagLength));
 }
 
 /*=====================================================================*/
@@ -1457,7 +1583,7 @@ UINT ParsedPliImp::readRasterData(TRaster32P &r, TUINT32 &bufOffs) {
   r.create((int)lx, (int)ly);
   UINT size = lx * ly * 4;
   r->lock();
-  memcpy(r->getRawData(), m_buf.get() + bufOffs, size);
+  memcpy(r->getRawData(), m_buf + bufOffs, size);
   r->unlock();
   bufOffs += size;
   return size + 2 + 2;
@@ -1593,7 +1719,7 @@ PliTag *ParsedPliImp::readBitmapTag() {
 
   r.create(lx, ly);
   r->lock();
-  memcpy(r->getRawData(), m_buf.get() + bufOffs, lx * ly * 4);
+  memcpy(r->getRawData(), m_buf + bufOffs, lx * ly * 4);
   r->unlock();
   BitmapTag *tag = new BitmapTag(r);
 
@@ -1759,6 +1885,8 @@ bool ParsedPliImp::addTag(PliTag *tagPtr, bool addFront) {
 bool ParsedPliImp::addTag(const TagElem &elem, bool addFront) {
   TagElem *_tag = new TagElem(elem);
 
+  if (_tag->m_offset) m_tagsByOffset[_tag->m_offset] = _tag->m_tag;
+
   if (!m_firstTag) {
     m_firstTag = m_lastTag = _tag;
   } else if (addFront) {
@@ -2525,6 +2653,8 @@ TUINT32 ParsedPliImp::writeBitmapTag(BitmapTag *tag) {
 /*=====================================================================*/
 
 bool ParsedPliImp::writePli(const TFilePath &filename) {
+  PliIndexCache::instance()->remove(filename);
+
   MyOfstream os(filename);
   if (!os || os.fail()) return false;
   m_oChan = &os;
@@ -2657,14 +2787,7 @@ double ParsedPli::getThickRatio() const { return imp->m_thickRatio; }
 
 /*=====================================================================*/
 
-ParsedPliImp::~ParsedPliImp() {
-  TagElem *tag = m_firstTag;
-  while (tag) {
-    TagElem *auxTag = tag;
-    tag             = tag->m_next;
-    delete auxTag;
-  }
-}
+ParsedPliImp::~ParsedPliImp() { clearTags(); }
 
 /*=====================================================================*/
 /*=====================================================================*/
@@ -28,6 +28,11 @@ TNZ_LITTLE_ENDIAN undefined !!
     const int CURRENT_VERSION = 14;
 const int CREATOR_LENGTH      = 40;
 
+// New levels are compressed with LZ4 instead of LZO when set. The codec is
+// recorded in the header, so both kinds can be read; older versions of the
+// software can read only LZO levels, though.
+TEnv::IntVar TlvCompressionLz4("TlvCompressionLz4", 0);
+
 namespace {
 
 char *reverse(char *buffer, int size) {
@@ -148,7 +153,7 @@ bool readHeaderAndOffsets(FILE *chan, TzlOffsetMap &frameOffsTable,
                           TzlOffsetMap &iconOffsTable, TDimension &res,
                           int &version, QString &creator, TINT32 *_frameCount,
                           TINT32 *_offsetTablePos, TINT32 *_iconOffsetTablePos,
-                          TLevelP level) {
+                          TLevelP level, bool *_isLz4 = 0) {
   TINT32 hdrSize;
   TINT32 lx = 0, ly = 0, frameCount = 0;
   char codec[4];
@@ -276,9 +281,21 @@ bool readHeaderAndOffsets(FILE *chan, TzlOffsetMap &frameOffsTable,
   if (_iconOffsetTablePos) *_iconOffsetTablePos = iconOffsetTablePos;
 
   if (_frameCount) *_frameCount = frameCount;
+  if (_isLz4) *_isLz4           = (memcmp(codec, "LZ4 ", 4) == 0);
 
   return true;
 }
+
+bool decompressFrame(const UCHAR *buff, TINT32 buffSize, TRasterP &ras,
+                     bool safeMode, bool isLz4) {
+  if (isLz4) {
+    TRasterCodecLz4 codec("LZ4", false);
+    return codec.decompress(buff, buffSize, ras, safeMode);
+  } else {
+    TRasterCodecLZO codec("LZO", false);
+    return codec.decompress(buff, buffSize, ras, safeMode);
+  }
+}
 }
 
 static bool adjustIconAspectRatio(TDimension &outDimension,
@@ -501,11 +518,13 @@ TLevelWriterTzl::TLevelWriterTzl(const TFilePath &path, TPropertyGroup *info)
     , m_iconSize(TDimension(80, 60))
     , m_userIconSize(TDimension(80, 60))
     , m_adjustRatio(false)
-    , m_codec(new TRasterCodecLZO("LZO", true))
+    , m_codec(0)
+    , m_lz4Codec(0)
     , m_overwritePaletteFlag(true) {
   m_path        = path;
   m_palettePath = path.withNoFrame().withType("tpl");
   TFileStatus fs(path);
+  bool isLz4  = (TlvCompressionLz4 != 0);
   m_magic     = "TLV14B1a";  // actual version
   erasedFrame = false;
   // version TLV10B1a: first version
@@ -524,7 +543,8 @@ TLevelWriterTzl::TLevelWriterTzl(const TFilePath &path, TPropertyGroup *info)
     /*--- TLVファイルのヘッダが正しく読めなかった場合 ---*/
     if (!readHeaderAndOffsets(m_chan, m_frameOffsTable, m_iconOffsTable, m_res,
                               m_version, m_creator, &m_frameCount,
-                              &m_offsetTablePos, &m_iconOffsetTablePos, 0)) {
+                              &m_offsetTablePos, &m_iconOffsetTablePos, 0,
+                              &isLz4)) {
       throw TSystemException(path, "can't readHeaderAndOffsets.");
     } else {
       if (m_version >= 12) buildFreeChunksTable();
@@ -536,6 +556,11 @@ TLevelWriterTzl::TLevelWriterTzl(const TFilePath &path, TPropertyGroup *info)
         m_frameCountPos = 8 + 3 * sizeof(TINT32);
     }
   }
+  // frames are compressed with the codec of the existing file, if any
+  if (isLz4)
+    m_lz4Codec = new TRasterCodecLz4("LZ4", true);
+  else
+    m_codec = new TRasterCodecLZO("LZO", true);
   if (!m_exists) {
     TFilePath parentDir = path.getParentDir();
     if (!TFileStatus(parentDir).doesExist()) {
@@ -560,6 +585,7 @@ TLevelWriterTzl::~TLevelWriterTzl() {
     assert(m_version == CURRENT_VERSION);
   }
   delete m_codec;
+  delete m_lz4Codec;
 
   TINT32 offsetMapPos     = 0;
   TINT32 iconOffsetMapPos = 0;
@@ -646,7 +672,7 @@ TImageWriterP TLevelWriterTzl::getFrameWriter(TFrameId fid) {
 
 void TLevelWriterTzl::writeHeader(const TDimension &size) {
   m_headerWritten   = true;
-  const char *codec = "LZO ";
+  const char *codec = m_lz4Codec ? "LZ4 " : "LZO ";
   int codecLen      = strlen(codec);
   TINT32 hdrSize    = 3 * sizeof(TINT32) + codecLen;
   TINT32 lx = size.lx, ly = size.ly, intval = 1;
@@ -921,7 +947,9 @@ void TLevelWriterTzl::saveImage(const TImageP &img, const TFrameId &_fid,
     }
   }
 
-  TRasterGR8P rCompressed = m_codec->compress(cmras, 1, buffSize);
+  TRasterGR8P rCompressed = m_lz4Codec
+                                ? m_lz4Codec->compress(cmras, 1, buffSize)
+                                : m_codec->compress(cmras, 1, buffSize);
   if (rCompressed == TRasterGR8P()) {
     static bool firstTime = true;
     if (firstTime) {
@@ -945,7 +973,7 @@ void TLevelWriterTzl::saveImage(const TImageP &img, const TFrameId &_fid,
   Header *header = (Header *)buff;
 
   TRasterP ras;
-  m_codec->decompress(buff, buffSize, ras);
+  decompressFrame(buff, buffSize, ras, false, m_lz4Codec != 0);
   delete[] buff;
   assert((TRasterCM32P)ras);
   assert(ras->getLx() == header->m_lx);
@@ -962,7 +990,8 @@ void TLevelWriterTzl::saveImage(const TImageP &img, const TFrameId &_fid,
     ras->unlock();
   }
 
-  rCompressed = m_codec->compress(ras, 1, buffSize);
+  rCompressed = m_lz4Codec ? m_lz4Codec->compress(ras, 1, buffSize)
+                          : m_codec->compress(ras, 1, buffSize);
 
   header = (Header *)buff;
 
@@ -1443,13 +1472,14 @@ TLevelReaderTzl::TLevelReaderTzl(const TFilePath &path)
     , m_frameOffsTable()
     , m_iconOffsTable()
     , m_level()
-    , m_readPalette(true) {
+    , m_readPalette(true)
+    , m_isLz4(false) {
   m_chan = fopen(path, "rb");
 
   if (!m_chan) return;
 
   if (!readHeaderAndOffsets(m_chan, m_frameOffsTable, m_iconOffsTable, m_res,
-                            m_version, m_creator, 0, 0, 0, m_level))
+                            m_version, m_creator, 0, 0, 0, m_level, &m_isLz4))
     return;
 
   TFilePath historyFp = path.withNoFrame().withType("hst");
@@ -1618,9 +1648,9 @@ m_lrp->m_frameIndex = m_frameIndex;*/
   header->m_rasType = (Header::RasType)swapTINT32(header->m_rasType);
 #endif
 
-  TRasterCodecLZO codec("LZO", false);
   TRasterP ras;
-  if (!codec.decompress(imgBuff, actualBuffSize, ras, m_safeMode))
+  if (!decompressFrame(imgBuff, actualBuffSize, ras, m_safeMode,
+                       m_lrp->m_isLz4))
     return TImageP();
   assert((TRasterCM32P)ras);
   assert(ras->getLx() == header->m_lx);
@@ -1738,9 +1768,9 @@ m_lrp->m_frameIndex = m_frameIndex;*/
   header->m_rasType = (Header::RasType)swapTINT32(header->m_rasType);
 #endif
 
-  TRasterCodecLZO codec("LZO", false);
   TRasterP ras;
-  if (!codec.decompress(imgBuff, actualBuffSize, ras, m_safeMode))
+  if (!decompressFrame(imgBuff, actualBuffSize, ras, m_safeMode,
+                       m_lrp->m_isLz4))
     return TImageP();
   assert((TRasterCM32P)ras);
   assert(ras->getLx() == header->m_lx);
@@ -1853,9 +1883,9 @@ TImageP TImageReaderTzl::load13() {
     header->m_ly      = swapTINT32(header->m_ly);
     header->m_rasType = (Header::RasType)swapTINT32(header->m_rasType);
 #endif
-    TRasterCodecLZO codec("LZO", false);
     TRasterP ras;
-    if (!codec.decompress(imgBuff, actualBuffSize, ras, m_safeMode))
+    if (!decompressFrame(imgBuff, actualBuffSize, ras, m_safeMode,
+                         m_lrp->m_isLz4))
       return TImageP();
     assert((TRasterCM32P)ras);
     delete[] imgBuff;
@@ -1938,9 +1968,9 @@ TImageP TImageReaderTzl::load13() {
   header->m_rasType = (Header::RasType)swapTINT32(header->m_rasType);
 #endif
 
-  TRasterCodecLZO codec("LZO", false);
   TRasterP ras;
-  if (!codec.decompress(imgBuff, actualBuffSize, ras, m_safeMode))
+  if (!decompressFrame(imgBuff, actualBuffSize, ras, m_safeMode,
+                       m_lrp->m_isLz4))
     return TImageP();
   assert((TRasterCM32P)ras);
   assert(ras->getLx() == header->m_lx);
@@ -2099,9 +2129,9 @@ TImageP TImageReaderTzl::load14() {
     header->m_rasType = (Header::RasType)swapTINT32(header->m_rasType);
 #endif
 
-    TRasterCodecLZO codec("LZO", false);
     TRasterP ras;
-    if (!codec.decompress(imgBuff, actualBuffSize, ras, m_safeMode))
+    if (!decompressFrame(imgBuff, actualBuffSize, ras, m_safeMode,
+                         m_lrp->m_isLz4))
       return TImageP();
     assert((TRasterCM32P)ras);
     raux->unlock();
@@ -2205,9 +2235,9 @@ TImageP TImageReaderTzl::load14() {
   header->m_rasType = (Header::RasType)swapTINT32(header->m_rasType);
 #endif
 
-  TRasterCodecLZO codec("LZO", false);
   TRasterP ras;
-  if (!codec.decompress(imgBuff, actualBuffSize, ras, m_safeMode))
+  if (!decompressFrame(imgBuff, actualBuffSize, ras, m_safeMode,
+                       m_lrp->m_isLz4))
     return TImageP();
   assert((TRasterCM32P)ras);
   assert(ras->getLx() == header->m_lx);
@@ -29,6 +29,7 @@ private:
 
 typedef std::map<TFrameId, TzlChunk> TzlOffsetMap;
 class TRasterCodecLZO;
+class TRasterCodecLz4;
 
 class TLevelWriterTzl final : public TLevelWriter {
   // bool m_paletteWritten;
@@ -57,6 +58,7 @@ class TLevelWriterTzl final : public TLevelWriter {
   TDimension m_currentIconSize;  // If file exists this is the current IconSize
                                  // in the file
   TRasterCodecLZO *m_codec;
+  TRasterCodecLz4 *m_lz4Codec;  // Replaces m_codec in LZ4 levels
 
   bool m_overwritePaletteFlag;
 
@@ -174,6 +176,7 @@ private:
   int m_version;
   QString m_creator;
   bool m_readPalette;
+  bool m_isLz4;  // Frames are compressed with LZ4 rather than LZO
 
 public:
   static TLevelReader *create(const TFilePath &f) {
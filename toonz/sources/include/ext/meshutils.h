@@ -3,6 +3,9 @@
 #ifndef MESHUTILS_H
 #define MESHUTILS_H
 
+// TnzCore includes
+#include "traster.h"
+
 #undef DVAPI
 #undef DVVAR
 #ifdef TNZEXT_EXPORTS
@@ -128,4 +131,32 @@ DVAPI void tglDraw(
         &deformerDatas  //!< Data structure of a deformation of the input image.
     );
 
+//---------------------------------------------------------------------------
+
+/*!
+  \brief    Draws a texturized mesh image over a raster, without OpenGL.
+
+  \details  This is the software counterpart of the above tglDraw(), meant
+            for hosts with no usable OpenGL implementation. Faces are drawn
+            in the same order, with analytic antialiasing on the mesh border
+            and bilinear texture sampling. Minified faces sample a box
+            filtered mipmap of the texture. Large rasters are split in row
+            bands drawn by separate threads.
+
+  \remark   Unlike tglDraw(), the input texture is expected \a premultiplied.
+            The drawn image is premultiplied too.
+*/
+
+DVAPI void tDraw(
+    const TRaster32P &ras,    //!< Output raster.
+    const TMeshImage &image,  //!< Mesh image to be drawn.
+    const TRaster32P &texture,  //!< Premultiplied texture.
+    const TAffine &meshToTexAffine,  //!< Transform from mesh to texture
+                                     //!< pixel coordinates.
+    const TAffine &meshToRasAffine,  //!< Transform from deformed mesh to
+                                     //!< output pixel coordinates.
+    const PlasticDeformerDataGroup
+        &deformerDatas  //!< Data structure of a deformation of the input image.
+    );
+
 #endif  // MESHUTILS_H
@@ -62,6 +62,13 @@ public:
   virtual TLevelP loadInfo();
   virtual QString getCreator() { return ""; }
 
+  /*!
+    Drops the listing of \b folder that loadInfo() shares among the image
+    sequences it contains. Listings are refreshed anyway when the folder's
+    modification time changes; this is meant for file system watchers.
+  */
+  static void invalidateFolderIndex(const TFilePath &folder);
+
   virtual void doReadPalette(bool) {}
   virtual void enableRandomAccessRead(bool) {}
   virtual TImageReaderP getFrameReader(TFrameId);
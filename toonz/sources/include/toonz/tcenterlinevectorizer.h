@@ -42,8 +42,12 @@ class DVAPI VectorizerCore final : public QObject {
 
   bool m_isCanceled;
 
+  //! The core running the batch this one is part of, if any
+  VectorizerCore *m_batchOwner;
+
 public:
-  VectorizerCore() : m_currPartial(0), m_isCanceled(false) {}
+  VectorizerCore()
+      : m_currPartial(0), m_isCanceled(false), m_batchOwner(0) {}
   ~VectorizerCore() {}
 
   /*!Calls the appropriate technique to convert \b image to vectors depending on
@@ -55,8 +59,21 @@ Returns the \b TVectorImageP converted image.*/
   TVectorImageP vectorize(const TImageP &image,
                           const VectorizerConfiguration &c, TPalette *palette);
 
+  /*!Vectorizes \b images (each one with the corresponding entry of \b
+configurations) on the shared thread pool (see TThread::runInRanges()),
+storing the converted images in \b results in the same order. imageDone() is
+emitted, from the converting thread, as each image is completed.
+Outline vectorization of full-color images adds styles to \b palette: in that
+case images are processed one at a time.*/
+  void vectorize(
+      const std::vector<TImageP> &images,
+      const std::vector<const VectorizerConfiguration *> &configurations,
+      TPalette *palette, std::vector<TVectorImageP> &results);
+
   //! Returns true if vectorization was aborted at user's request
-  bool isCanceled() { return m_isCanceled; }
+  bool isCanceled() {
+    return m_isCanceled || (m_batchOwner && m_batchOwner->m_isCanceled);
+  }
 
   //!\b (\b Internal \b use \b only) Sets the maximum number of partial
   //! notifications.
@@ -111,6 +128,9 @@ signals:
   //! Partial progress \b par1 of overall \b par2 is notified.
   void partialDone(int, int);
 
+  //! Image \b par1 of a batch vectorize() call has been converted.
+  void imageDone(int);
+
 protected slots:
 
   //! Receives a user cancel signal and attempts an early exit from
@@ -21,6 +21,10 @@
 // Qt includes
 #include <QStack>
 
+// STD includes
+#include <memory>
+#include <vector>
+
 #undef DVAPI
 #undef DVVAR
 #ifdef TOONZLIB_EXPORTS
@@ -356,6 +360,20 @@ with the frame.
   TAffine getPlacement(double t);
   TAffine getParentPlacement(double t) const;
 
+  /*!
+Precomputes the placements of the specified objects for the frames in
+[\b r0, \b r1], so that getPlacement() reads them back from a table with
+no lazy data update. Objects must be sorted so that parents come first.
+Frames are split among threads; objects driven by expressions, files or
+hooks are evaluated sequentially, and inverse kinematics chains are not
+cached at all. Tables are dropped by invalidate() and dropPlacements().
+*/
+  static void cachePlacements(const std::vector<TStageObject *> &objects,
+                              int r0, int r1);
+
+  //! Drops the placements precomputed for this object and its descendants.
+  void dropPlacements();
+
   /*!
 Returns the object's depth at specified frame.
 \sa Methods getGlobalNoScaleZ() and getNoScaleZ().
@@ -439,7 +457,7 @@ Doesn't delete \e this.
   void attachChildrenToParent(const TStageObjectId &parentId);
 
   //! Resets the area position setting internal time of the object and of all
-  //! his children to -1.
+  //! his children to -1, and drops their precomputed placements.
   void invalidate();
 
   /*!
@@ -504,6 +522,13 @@ private:
     LazyData();
   };
 
+  // Placements precomputed by cachePlacements()
+
+  struct PlacementTable {
+    int m_r0;
+    std::vector<TAffine> m_placements;
+  };
+
 private:
   tcg::invalidable<LazyData> m_lazyData;
 
@@ -517,6 +542,9 @@ private:
   TAffine m_localPlacement;
   TAffine m_absPlacement;
 
+  std::shared_ptr<const PlacementTable>
+      m_placementTable;  //!< Accessed with std::atomic_load/store only
+
   TStageObjectSpline *m_spline;
   Status m_status;
 
@@ -556,7 +584,10 @@ private:
 
   TPointD getHandlePos(std::string handle, int row) const;
   TAffine computeLocalPlacement(double frame);
+  TAffine localPlacement(double frame) const;
   TStageObject *findRoot(double frame) const;
+  bool isIkDriven() const;
+  bool hasPlainPlacement() const;
   TStageObject *getPinnedDescendant(int frame);
 
 private:
@@ -568,6 +599,7 @@ private:
   void update(LazyData &ld) const;
 
   void invalidate(LazyData &ld) const;
+  void invalidateTime() { invalidate(m_lazyData(tcg::direct_access)); }
   void updateKeyframes(LazyData &ld) const;
 
   void onChange(const class TParamChange &c) override;
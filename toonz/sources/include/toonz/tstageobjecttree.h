@@ -182,6 +182,15 @@ Returns the numbers of the objects in the tree.
 
   void invalidateAll();
 
+  /*!
+          Precomputes the placements of all the objects in the tree for the
+     frames in [\b \e r0, \b \e r1], to be read concurrently by a render.
+          \sa TStageObject::cachePlacements() and dropPlacements().
+  */
+  void cachePlacements(int r0, int r1);
+  //! Drops the placements precomputed by cachePlacements().
+  void dropPlacements();
+
   /*!
           Sets the handle manager to be \b \e hm.
           An Handle Manager is an object that implements a method to retrieve
@@ -53,6 +53,8 @@ public:
   TTileSet(const TDimension &dim) : m_srcImageSize(dim) {}
   virtual ~TTileSet();
 
+  //! Returns the memory actually taken by the tiles, in bytes: compressed
+  //! tiles count for their compressed size.
   int getMemorySize() const;
 
   void add(Tile *tile);
@@ -69,6 +71,10 @@ public:
   TDimension getSrcImageSize() const { return m_srcImageSize; }
 
   virtual TTileSet *clone() const = 0;
+
+protected:
+  //! Compresses the tiles in the image cache, in a background thread.
+  void compressTiles() const;
 };
 
 //********************************************************************************
@@ -105,6 +111,11 @@ public:
   // Nota: clona il raster!
   void add(const TRasterP &ras, TRect rect) override;
 
+  //! Used once the tiles' source raster has been modified: shrinks each tile
+  //! to the pixels that differ from \b ras, removes the unchanged tiles and
+  //! compresses the others in background.
+  void shrinkToChanges(const TRasterCM32P &ras);
+
   const Tile *getTile(int index) const;
   Tile *editTile(int index) const;
 
@@ -145,6 +156,9 @@ public:
   // Nota: clona il raster!
   void add(const TRasterP &ras, TRect rect) override;
 
+  //! See TTileSetCM32::shrinkToChanges().
+  void shrinkToChanges(const TRasterP &ras);
+
   const Tile *getTile(int index) const;
   Tile *editTile(int index) const;
 
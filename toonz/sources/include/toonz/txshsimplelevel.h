@@ -272,6 +272,14 @@ Editable range is contained in \b m_editableRange.
   void load() override;
   void load(const std::vector<TFrameId> &fIds);
 
+  //! Returns the decoded paths of the level files whose infos load() reads.
+  std::vector<TFilePath> getInfoPaths() const;
+  //! Opens the level file at \a path and reads its level info ahead of
+  //! load(), which takes it over. Can run concurrently on different paths.
+  static void prefetchInfo(const TFilePath &path);
+  //! Drops the prefetched infos that were not taken over by load().
+  static void releasePrefetchedInfos();
+
   //! Saves the level to disk, with the same path deduction from load()
   void save() override;
 
@@ -152,8 +152,13 @@ public slots:
   void onException(TThread::RunnableP iconRenderer);
   void onTerminated(TThread::RunnableP iconRenderer);
 
+private slots:
+
+  void closeRequestBatch();
+
 private:
   TThread::Executor m_executor;
+  TThread::Executor m_fileExecutor;  //!< Renders file icons in parallel.
   QThreadStorage<TOfflineGL *> m_contexts;
   TDimension m_iconSize;
 
@@ -162,8 +167,22 @@ private:
 
   Settings m_settings;
 
+  int m_requestBatch;       //!< Index of the current batch of requests.
+  bool m_requestBatchOpen;  //!< Whether m_requestBatch was started in the
+                            //! current event loop cycle.
+
+  //! Requests waiting for m_executor and m_fileExecutor, keyed by the
+  //! opposite of their batch index: the latest batches come first.
+  std::multimap<int, TThread::RunnableP> m_pendingRequests;
+  std::multimap<int, TThread::RunnableP> m_pendingFileRequests;
+  int m_submittedRequests;      //!< Requests passed to m_executor.
+  int m_submittedFileRequests;  //!< Requests passed to m_fileExecutor.
+
 private:
-  void addTask(const std::string &id, TThread::RunnableP iconRenderer);
+  void addTask(const std::string &id, TThread::RunnableP iconRenderer,
+               bool noGL = false);
+  void submitRequests();
+  void onRequestDone(TThread::RunnableP iconRenderer);
 };
 
 //**********************************************************************************
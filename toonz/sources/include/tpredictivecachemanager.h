@@ -30,6 +30,13 @@
 The TPredictiveCacheManager is the TFxCacheManagerDelegate used to cache
 intermediate
 render results due to predictive analysis of the scene schematic.
+
+Since the predictive analysis spans all the frames of a render instance, node
+results whose alias is identical across frames (held cells, static backgrounds,
+non-animated fx branches) are computed once and reused by every frame that
+requires them. Retention of such results is bounded by the available physical
+memory: when shared results would exceed it, those saving the least
+computations per retained byte are dropped and recomputed on demand.
 */
 
 class DVAPI TPredictiveCacheManager final : public TFxCacheManagerDelegate {
@@ -38,6 +45,25 @@ class DVAPI TPredictiveCacheManager final : public TFxCacheManagerDelegate {
   class Imp;
   std::unique_ptr<Imp> m_imp;
 
+public:
+  //! Statistics about the node results shared by the render instance.
+  struct SharingStats {
+    int m_requestedEvaluations;  //!< Node evaluations requested by all frames
+    int m_sharedResults;         //!< Distinct results retained for reuse
+    int m_crossFrameResults;     //!< Shared results reused by several frames
+    int m_droppedResults;        //!< Shared results dropped due to memory
+    int m_savedEvaluations;      //!< Node evaluations avoided through reuse
+    TINT64 m_retainedMemory;     //!< Estimated retained memory, in KB
+
+    SharingStats()
+        : m_requestedEvaluations(0)
+        , m_sharedResults(0)
+        , m_crossFrameResults(0)
+        , m_droppedResults(0)
+        , m_savedEvaluations(0)
+        , m_retainedMemory(0) {}
+  };
+
 public:
   TPredictiveCacheManager();
   ~TPredictiveCacheManager();
@@ -50,6 +76,9 @@ public:
   void setMaxTileSize(int maxTileSize);
   void setBPP(int bpp);
 
+  //! Returns the sharing statistics gathered at the end of the test run.
+  const SharingStats &getSharingStats() const;
+
   void getResource(TCacheResourceP &resource, const std::string &alias,
                    const TFxP &fx, double frame, const TRenderSettings &rs,
                    ResourceDeclaration *resData) override;
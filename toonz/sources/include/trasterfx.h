@@ -11,6 +11,9 @@
 #include "trasterfxrenderdata.h"
 #include <QOffscreenSurface>
 
+// STD includes
+#include <map>
+
 #undef DVAPI
 #undef DVVAR
 #ifdef TFX_EXPORTS
@@ -288,6 +291,23 @@ public:
 
   virtual bool isPlugin() const { return false; };
 
+  //! Time spent in doCompute() by all fxs of a same type.
+  struct ComputeTiming {
+    int m_calls;        //!< Number of doCompute() invocations
+    double m_selfTime;  //!< Total time (ms), excluding nested input computes
+
+    ComputeTiming() : m_calls(0), m_selfTime(0.0) {}
+  };
+
+  //! Enables the collection of per-fx type compute timings, from all render
+  //! threads. It is disabled by default, since it requires some locking.
+  static void enableComputeTimings(bool on);
+  static bool areComputeTimingsEnabled();
+
+  //! Returns the timings collected so far, keyed by fx type.
+  static std::map<std::string, ComputeTiming> getComputeTimings();
+  static void clearComputeTimings();
+
 private:
   friend class FxResourceBuilder;
 };
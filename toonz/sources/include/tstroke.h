@@ -262,6 +262,10 @@ Return parameter for a control point
   //! Return the stroke leght at passed control point
   double getLengthAtControlPoint(int) const;
 
+  //! Computes the length caches and the bbox, which are otherwise built on
+  //! demand by const methods. Call it before sharing the stroke among threads.
+  void computeCaches() const;
+
   //! Freeze parameter of a stroke in last valid status
   void disableComputeOfCaches();
 
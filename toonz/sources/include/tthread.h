@@ -7,6 +7,8 @@
 
 #include <QThread>
 
+#include <functional>
+
 #undef DVAPI
 #undef DVVAR
 #ifdef TNZCORE_EXPORTS
@@ -30,6 +32,33 @@ void DVAPI shutdown();
 
 //------------------------------------------------------------------------------
 
+//! Calls bandFunc(y0, y1) on disjoint bands [y0, y1) covering rows [0, ly)
+//! of an image lx pixels wide, and returns once every band is done.
+/*!
+  Images smaller than 256 x 256 pixels are processed in the calling thread.
+  Larger ones are split in up to QThread::idealThreadCount() bands, which are
+  shared between the calling thread and a process-wide thread pool of that
+  same size - so concurrent or nested calls (e.g. from several render threads)
+  never start more helper threads than there are cores. The calling thread
+  keeps taking bands while the pool is busy, so a call always completes.
+
+  bandFunc must only write to the rows it is passed.
+*/
+void DVAPI runInBands(int lx, int ly,
+                      const std::function<void(int, int)> &bandFunc);
+
+//! Calls rangeFunc(i0, i1) on rangesCount disjoint ranges [i0, i1) covering
+//! [0, count), and returns once every range is done.
+/*!
+  Ranges are taken in order by the calling thread and by the thread pool of
+  runInBands(), as soon as either is free. So for items of uneven cost, more
+  ranges than threads balance the load better.
+*/
+void DVAPI runInRanges(int count, int rangesCount,
+                       const std::function<void(int, int)> &rangeFunc);
+
+//------------------------------------------------------------------------------
+
 // Forward declarations
 class ExecutorId;  // Private
 class Runnable;
@@ -0,0 +1,56 @@
+#pragma once
+
+#ifndef TVECTORRASTERIZER_H
+#define TVECTORRASTERIZER_H
+
+// TnzCore includes
+#include "traster.h"
+
+#undef DVAPI
+#undef DVVAR
+#ifdef TVRENDER_EXPORTS
+#define DVAPI DV_EXPORT_API
+#define DVVAR DV_EXPORT_VAR
+#else
+#define DVAPI DV_IMPORT_API
+#define DVVAR DV_IMPORT_VAR
+#endif
+
+//========================================================================
+
+//    Forward declarations
+
+class TVectorImage;
+class TVectorRenderData;
+
+//========================================================================
+
+/*!
+  \brief    Software rasterizer for vector images.
+
+  \details  Draws vector images with a scanline coverage accumulator and
+            analytic antialiasing, without any GL context. Stroke outlines
+            and region boundaries are the same ones the GL path feeds to
+            the tessellator, so the output matches tglDraw() up to
+            antialiasing differences.
+
+            Only solid color styles are supported; callers are expected to
+            check isSupported() and fall back to TOfflineGL otherwise.
+            Both functions are reentrant, so different images (or the same
+            image on different rasters) can be drawn concurrently.
+*/
+
+namespace TVectorRasterizer {
+
+//! Returns whether the specified image can be drawn by draw() with the
+//! passed render data.
+DVAPI bool isSupported(const TVectorImage *vim, const TVectorRenderData &rd);
+
+//! Draws the image over \b ras, blending premultiplied colors the same way
+//! the GL path does. Rows are split among threads on large rasters.
+DVAPI void draw(const TRaster32P &ras, const TVectorImage *vim,
+                const TVectorRenderData &rd);
+
+}  // namespace TVectorRasterizer
+
+#endif  // TVECTORRASTERIZER_H
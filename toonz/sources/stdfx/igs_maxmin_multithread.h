@@ -3,6 +3,7 @@
 #ifndef igs_maxmin_multithread_h
 #define igs_maxmin_multithread_h
 
+#include <thread> /* std::thread::hardware_concurrency() */
 #include "igs_ifx_common.h" /* igs::image::rgba */
 #include "igs_resource_multithread.h"
 #include "igs_maxmin_slrender.h"
@@ -47,11 +48,13 @@ public:
     this->ref_      = ref;
     this->ref_mode_ = ref_mode;
 
-    this->y_begin_        = y_begin;
-    this->y_end_          = y_end;
-    this->lens_offsets_p_ = lens_offsets_p;
-    this->lens_sizes_p_   = lens_sizes_p;
-    this->lens_ratio_p_   = lens_ratio_p;
+    this->y_begin_ = y_begin;
+    this->y_end_   = y_end;
+    /* 半径が変化するときlensはthread内でreshapeされるので、
+    thread毎に複製して持つ */
+    this->lens_offsets_ = *lens_offsets_p;
+    this->lens_sizes_   = *lens_sizes_p;
+    this->lens_ratio_   = *lens_ratio_p;
 
     this->radius_             = radius;
     this->smooth_outer_range_ = smooth_outer_range;
@@ -63,7 +66,7 @@ public:
     this->add_blend_sw_       = add_blend_sw;
 
     igs::maxmin::slrender::resize(
-        static_cast<int>(this->lens_offsets_p_->size()), this->width_,
+        static_cast<int>(this->lens_offsets_.size()), this->width_,
         (ref != 0 || 4 <= channels) ? true : false, this->pixe_tracks_,
         this->alpha_ref_, this->result_);
   }
@@ -117,6 +120,9 @@ public:
   void clear(void) {
     igs::maxmin::slrender::clear(this->pixe_tracks_, this->alpha_ref_,
                                  this->result_);
+    this->lens_ratio_.clear();
+    this->lens_sizes_.clear();
+    this->lens_offsets_.clear();
   }
 
 private:
@@ -132,9 +138,9 @@ private:
   int y_begin_;
   int y_end_;
 
-  std::vector<int> *lens_offsets_p_;
-  std::vector<int> *lens_sizes_p_;
-  std::vector<std::vector<double>> *lens_ratio_p_;
+  std::vector<int> lens_offsets_;
+  std::vector<int> lens_sizes_;
+  std::vector<std::vector<double>> lens_ratio_;
 
   double radius_;
   double smooth_outer_range_;
@@ -172,8 +178,8 @@ private:
     }
     igs::maxmin::slrender::render(
         this->radius_, this->smooth_outer_range_, this->polygon_number_,
-        this->roll_degree_, this->min_sw_, *(this->lens_offsets_p_),
-        *(this->lens_sizes_p_), *(this->lens_ratio_p_), this->pixe_tracks_,
+        this->roll_degree_, this->min_sw_, this->lens_offsets_,
+        this->lens_sizes_, this->lens_ratio_, this->pixe_tracks_,
         this->alpha_ref_, this->result_);
 
     igs::maxmin::getput::put(this->result_, this->height_, this->width_,
@@ -231,7 +237,10 @@ public:
         this->lens_offsets_, this->lens_sizes_, this->lens_ratio_);
     /*-------スレッド毎の処理指定-----------------------*/
     int thread_num = number_of_thread;
-    /* ゼロ以下の場合強制変更。そもそもGUIでエラーにすべき */
+    /* ゼロ以下の場合はCPU数に合わせて自動で決める */
+    if (thread_num < 1) {
+      thread_num = static_cast<int>(std::thread::hardware_concurrency());
+    }
     if (thread_num < 1) {
       thread_num = 1;
     }
@@ -257,7 +266,7 @@ public:
 
           ,
           min_sw, alpha_rendering_sw, add_blend_sw);
-      yy = y_end;
+      yy = y_end + 1;
     }
     /*------スレッド毎のスレッド指定------*/
     for (int ii = 0; ii < thread_num; ++ii) {
@@ -100,6 +100,206 @@ void set_begin_ptr_(const std::vector<std::vector<double>> &tracks,
                            : 0;
   }
 }
+/*
+        lensの各scanlineのうち、比率(ratio)が1.0で連続する区間(core)は、
+        区間内の最大(最小)値だけで結果が決まる
+        (src + (x - src) * 1.0 はxについて単調なため)。
+        そこでcoreはvan Herk/Gil-Werman法の移動窓で1 pixelあたりO(1)で求め、
+        残りの縁(ring)だけをpixel毎に辿る。
+        半径の2乗に比例していた計算量が半径に比例するまで下がる。
+*/
+class lens_core_ {
+public:
+  lens_core_(const std::vector<int> &lens_sizes,
+             const std::vector<std::vector<double>> &lens_ratio)
+      : begin(lens_sizes.size(), 0), end(lens_sizes.size(), 0) {
+    for (unsigned yy = 0; yy < lens_sizes.size(); ++yy) {
+      const int sz = lens_sizes.at(yy);
+      if (sz <= 0) {
+        continue;
+      }
+      const std::vector<double> &ratio = lens_ratio.at(yy);
+      int b = 0;
+      while (b < sz && ratio.at(b) != 1.0) {
+        ++b;
+      }
+      int e = b;
+      while (e < sz && ratio.at(e) == 1.0) {
+        ++e;
+      }
+      /* 短すぎる区間は移動窓にする意味がないのでringとして扱う */
+      if (e - b < 3) {
+        continue;
+      }
+      this->begin.at(yy) = b;
+      this->end.at(yy)   = e;
+    }
+  }
+  std::vector<int> begin; /* core区間の開始(lens scanline内の位置) */
+  std::vector<int> end;   /* core区間の終了(含まない) */
+};
+/* 長さ(size + window - 1)の配列(src)に対して、
+        window幅の移動窓の最大(min_swなら最小)値をdstにsize個求める */
+void sliding_maxmin_(const double *src, const int size, const int window,
+                     const bool min_sw, std::vector<double> &prefix,
+                     std::vector<double> &suffix, double *dst) {
+  const int len = size + window - 1;
+  prefix.resize(len);
+  suffix.resize(len);
+  double *pp = &prefix.at(0);
+  double *ss = &suffix.at(0);
+  if (min_sw) {
+    for (int bb = 0; bb < len; bb += window) {
+      const int ee = (bb + window < len) ? bb + window : len;
+      pp[bb]       = src[bb];
+      for (int xx = bb + 1; xx < ee; ++xx) {
+        pp[xx] = (src[xx] < pp[xx - 1]) ? src[xx] : pp[xx - 1];
+      }
+      ss[ee - 1] = src[ee - 1];
+      for (int xx = ee - 2; bb <= xx; --xx) {
+        ss[xx] = (src[xx] < ss[xx + 1]) ? src[xx] : ss[xx + 1];
+      }
+    }
+    for (int xx = 0; xx < size; ++xx) {
+      const double a = ss[xx], b = pp[xx + window - 1];
+      dst[xx]        = (a < b) ? a : b;
+    }
+    return;
+  }
+  for (int bb = 0; bb < len; bb += window) {
+    const int ee = (bb + window < len) ? bb + window : len;
+    pp[bb]       = src[bb];
+    for (int xx = bb + 1; xx < ee; ++xx) {
+      pp[xx] = (pp[xx - 1] < src[xx]) ? src[xx] : pp[xx - 1];
+    }
+    ss[ee - 1] = src[ee - 1];
+    for (int xx = ee - 2; bb <= xx; --xx) {
+      ss[xx] = (ss[xx + 1] < src[xx]) ? src[xx] : ss[xx + 1];
+    }
+  }
+  for (int xx = 0; xx < size; ++xx) {
+    const double a = ss[xx], b = pp[xx + window - 1];
+    dst[xx]        = (a < b) ? b : a;
+  }
+}
+/* result[x_begin...x_end-1]を同じlensで処理する */
+void render_run_(const int x_begin, const int x_end, const bool min_sw,
+                 const std::vector<int> &lens_offsets,
+                 const std::vector<int> &lens_sizes,
+                 const std::vector<std::vector<double>> &lens_ratio,
+                 const std::vector<std::vector<double>> &tracks,
+                 std::vector<double> &result) {
+  const int size = x_end - x_begin;
+  if (size <= 0) {
+    return;
+  }
+
+  /* 短い区間、小さなlensはpixel毎に全体を辿る */
+  if (size < static_cast<int>(lens_offsets.size()) * 2 ||
+      lens_offsets.size() < 5) {
+    std::vector<const double *> begin_ptr(lens_offsets.size());
+    set_begin_ptr_(tracks, lens_offsets, x_begin, begin_ptr);
+    for (int xx = x_begin; xx < x_end; ++xx) {
+      result.at(xx) =
+          maxmin_(result.at(xx), min_sw, begin_ptr, lens_sizes, lens_ratio);
+      for (unsigned ii = 0; ii < begin_ptr.size(); ++ii) {
+        if (begin_ptr.at(ii) != 0) {
+          ++begin_ptr.at(ii);
+        }
+      }
+    }
+    return;
+  }
+
+  const lens_core_ core(lens_sizes, lens_ratio);
+
+  /* 判断用の値(min_swなら反転値)の初期値は元値 */
+  std::vector<double> val(size);
+  for (int xx = 0; xx < size; ++xx) {
+    val.at(xx) = min_sw ? 1.0 - result.at(x_begin + xx) : result.at(
+                                                               x_begin + xx);
+  }
+
+  /* core : 移動窓の最大(最小)値を元値と比べる */
+  std::vector<double> window_val(size), prefix, suffix;
+  for (unsigned yy = 0; yy < lens_offsets.size(); ++yy) {
+    const int window = core.end.at(yy) - core.begin.at(yy);
+    if (lens_offsets.at(yy) < 0 || window <= 0) {
+      continue;
+    }
+    sliding_maxmin_(&tracks.at(yy).at(x_begin + lens_offsets.at(yy) +
+                                      core.begin.at(yy)),
+                    size, window, min_sw, prefix, suffix, &window_val.at(0));
+    if (min_sw) {
+      for (int xx = 0; xx < size; ++xx) {
+        const double rev_src = 1.0 - result.at(x_begin + xx);
+        const double crnt    = 1.0 - window_val.at(xx);
+        if (rev_src < crnt) {
+          const double vv = rev_src + (crnt - rev_src);
+          if (val.at(xx) < vv) {
+            val.at(xx) = vv;
+          }
+        }
+      }
+    } else {
+      for (int xx = 0; xx < size; ++xx) {
+        const double src  = result.at(x_begin + xx);
+        const double crnt = window_val.at(xx);
+        if (src < crnt) {
+          const double vv = src + (crnt - src);
+          if (val.at(xx) < vv) {
+            val.at(xx) = vv;
+          }
+        }
+      }
+    }
+  }
+
+  /* ring : core以外をpixel毎に辿る */
+  for (unsigned yy = 0; yy < lens_offsets.size(); ++yy) {
+    const int sz = lens_sizes.at(yy);
+    if (lens_offsets.at(yy) < 0 || sz <= 0) {
+      continue;
+    }
+    const double *rptr = &lens_ratio.at(yy).at(0);
+    for (int xx = 0; xx < size; ++xx) {
+      const double *xptr =
+          &tracks.at(yy).at(x_begin + xx + lens_offsets.at(yy));
+      const double src = result.at(x_begin + xx);
+      double v         = val.at(xx);
+      for (int ii = 0; ii < sz; ++ii) {
+        if (core.begin.at(yy) <= ii && ii < core.end.at(yy)) {
+          ii = core.end.at(yy) - 1;
+          continue;
+        }
+        if (min_sw) {
+          const double rev_src = 1.0 - src;
+          double crnt          = 1.0 - xptr[ii];
+          if (crnt <= rev_src) {
+            continue;
+          }
+          crnt = rev_src + (crnt - rev_src) * rptr[ii];
+          if (v < crnt) {
+            v = crnt;
+          }
+        } else {
+          if (xptr[ii] <= src) {
+            continue;
+          }
+          const double crnt = src + (xptr[ii] - src) * rptr[ii];
+          if (v < crnt) {
+            v = crnt;
+          }
+        }
+      }
+      val.at(xx) = v;
+    }
+  }
+
+  for (int xx = 0; xx < size; ++xx) {
+    result.at(x_begin + xx) = min_sw ? 1.0 - val.at(xx) : val.at(xx);
+  }
+}
 }
 /* --- tracksをレンダリングする --------------------------------------*/
 void igs::maxmin::slrender::render(
@@ -120,59 +320,41 @@ void igs::maxmin::slrender::render(
     ,
     std::vector<double> &result /* 計算結果 */
     ) {
-  /* 初期位置 */
-  std::vector<const double *> begin_ptr(lens_offsets.size());
-  set_begin_ptr_(tracks, lens_offsets, 0, begin_ptr);
-
-  /* 効果半径に変化がある場合 */
+  /* 効果半径に変化がある場合、同じ半径が続く区間毎に処理する */
   if (0 < alpha_ref.size()) {
-    double before_radius = 0.0;
-    for (unsigned xx = 0; xx < result.size(); ++xx) {
-      /* 次の処理の半径 */
-      const double radius2 = alpha_ref.at(xx) * radius;
-
-      /* ゼロ以上なら処理する */
-      if (0.0 < alpha_ref.at(xx)) {
-        /* 前のPixelと違う大きさならreshapeする */
-        if (radius2 != before_radius) {
-          igs::maxmin::reshape_lens_matrix(
-              radius2, igs::maxmin::outer_radius_from_radius(
-                           radius2, smooth_outer_range),
-              igs::maxmin::diameter_from_outer_radius(radius +
-                                                      smooth_outer_range),
-              polygon_number, roll_degree, lens_offsets, lens_sizes,
-              lens_ratio);
-          set_begin_ptr_(tracks, lens_offsets, xx, begin_ptr);
-        }
-        /* 各ピクセルの処理 */
-        result.at(xx) =
-            maxmin_(result.at(xx), min_sw, begin_ptr, lens_sizes, lens_ratio);
-      } /* alpha_refがゼロなら変化なし */
-
-      /* 次の位置へ移動 */
-      for (unsigned ii = 0; ii < begin_ptr.size(); ++ii) {
-        if (begin_ptr.at(ii) != 0) {
-          ++begin_ptr.at(ii);
-        }
+    double shaped_radius = -1.0;
+    const int width      = static_cast<int>(result.size());
+    for (int xx = 0; xx < width;) {
+      /* ゼロなら変化なし */
+      if (alpha_ref.at(xx) <= 0.0) {
+        ++xx;
+        continue;
+      }
+      int x_end = xx + 1;
+      while (x_end < width && alpha_ref.at(x_end) == alpha_ref.at(xx)) {
+        ++x_end;
       }
-      if (radius2 != before_radius) {
-        before_radius = radius2;
+
+      /* 前の区間と違う大きさならreshapeする */
+      const double radius2 = alpha_ref.at(xx) * radius;
+      if (radius2 != shaped_radius) {
+        igs::maxmin::reshape_lens_matrix(
+            radius2,
+            igs::maxmin::outer_radius_from_radius(radius2, smooth_outer_range),
+            igs::maxmin::diameter_from_outer_radius(radius +
+                                                    smooth_outer_range),
+            polygon_number, roll_degree, lens_offsets, lens_sizes, lens_ratio);
+        shaped_radius = radius2;
       }
+
+      render_run_(xx, x_end, min_sw, lens_offsets, lens_sizes, lens_ratio,
+                  tracks, result);
+      xx = x_end;
     }
   }
   /* 効果半径が変わらない場合 */
   else {
-    for (unsigned xx = 0; xx < result.size(); ++xx) {
-      /* 各ピクセルの処理 */
-      result.at(xx) =
-          maxmin_(result.at(xx), min_sw, begin_ptr, lens_sizes, lens_ratio);
-
-      /* 次の位置へ移動 */
-      for (unsigned ii = 0; ii < begin_ptr.size(); ++ii) {
-        if (begin_ptr.at(ii) != 0) {
-          ++begin_ptr.at(ii);
-        }
-      }
-    }
+    render_run_(0, static_cast<int>(result.size()), min_sw, lens_offsets,
+                lens_sizes, lens_ratio, tracks, result);
   }
 }
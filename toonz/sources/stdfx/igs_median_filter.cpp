@@ -1,9 +1,11 @@
 #include <cmath>
 #include <vector>
-#include <algorithm>  // std::sort()
+#include <algorithm>  // std::nth_element()
+#include <thread>     /* std::thread::hardware_concurrency() */
 #include <stdexcept>  /* std::domain_error(-) */
 #include <limits>     /* std::numeric_limits */
 #include "igs_ifx_common.h"
+#include "igs_resource_multithread.h"
 
 namespace igs {
 namespace median_filter {
@@ -161,8 +163,6 @@ T median_filter_(igs::median_filter::pixrender &pixr, const T *image,
         pixr, image, hh, ww, ch, xx + pixr.xp.at(ii), yy + pixr.yp.at(ii), zz));
   }
 
-  std::sort(pixr.around.begin(), pixr.around.end());
-
   /*	中央値(median)計算は、厳密な定義(wikipediaより)によると
                   奇数(odd)のときは中央値
                   偶数(even)のときは中央の二つの値の平均
@@ -171,8 +171,89 @@ T median_filter_(igs::median_filter::pixrender &pixr, const T *image,
           偶数の場合も奇数の計算をそのまま流用する。
           よって偶数の場合は中央の二つの値の大きいほうとなる。
           2009-03-24
+          全体をsortする必要はなく、中央の位置だけ決まればよい
   */
-  return static_cast<T>(pixr.around.at(pixr.around.size() / 2));
+  std::vector<int>::iterator median_it =
+      pixr.around.begin() + pixr.around.size() / 2;
+  std::nth_element(pixr.around.begin(), median_it, pixr.around.end());
+  return static_cast<T>(*median_it);
+}
+/* 1 scanline分のmedianを求める */
+template <class T>
+void median_filter_sl_(igs::median_filter::pixrender &pixr, const T *image,
+                       const int hh, const int ww, const int ch, const int yy,
+                       const int zz, std::vector<T> &medians) {
+  for (int xx = 0; xx < ww; ++xx) {
+    medians.at(xx) = median_filter_(pixr, image, hh, ww, ch, xx, yy, zz);
+  }
+}
+/*
+        8bitの場合はヒストグラムを横に移動させながら更新する(Huang法)。
+        1 pixel移動する毎に、円の各行の左端を抜き右端を足すだけなので、
+        計算量は半径の2乗でなく半径に比例する。
+        結果はsortした場合と同じ値になる。
+*/
+template <>
+void median_filter_sl_(igs::median_filter::pixrender &pixr,
+                       const unsigned char *image, const int hh, const int ww,
+                       const int ch, const int yy, const int zz,
+                       std::vector<unsigned char> &medians) {
+  const int size = static_cast<int>(pixr.xp.size());
+  if (size <= 0) {
+    return;
+  }
+
+  /* 円の各行の半幅(円は左右対称で、各行は連続している) */
+  int y_min = 0, y_max = 0;
+  for (int ii = 0; ii < size; ++ii) {
+    y_min = (std::min)(y_min, pixr.yp.at(ii));
+    y_max = (std::max)(y_max, pixr.yp.at(ii));
+  }
+  std::vector<int> half_width(y_max - y_min + 1, -1);
+  for (int ii = 0; ii < size; ++ii) {
+    int &hw = half_width.at(pixr.yp.at(ii) - y_min);
+    hw      = (std::max)(hw, pixr.xp.at(ii));
+  }
+
+  int histogram[256] = {0};
+  for (int ii = 0; ii < size; ++ii) {
+    ++histogram[getter_(pixr, image, hh, ww, ch, pixr.xp.at(ii),
+                        yy + pixr.yp.at(ii), zz)];
+  }
+
+  /* sortしたときsize/2番目にくる値(median)と、それ未満の個数(lower) */
+  const int target = size / 2;
+  int median = 0, lower = 0;
+  while (lower + histogram[median] <= target) {
+    lower += histogram[median++];
+  }
+
+  for (int xx = 0;;) {
+    medians.at(xx) = static_cast<unsigned char>(median);
+    if (ww <= ++xx) {
+      break;
+    }
+
+    for (int dy = y_min; dy <= y_max; ++dy) {
+      const int hw = half_width.at(dy - y_min);
+      if (hw < 0) {
+        continue;
+      }
+      const int out_val =
+          getter_(pixr, image, hh, ww, ch, xx - 1 - hw, yy + dy, zz);
+      const int in_val = getter_(pixr, image, hh, ww, ch, xx + hw, yy + dy, zz);
+      --histogram[out_val];
+      ++histogram[in_val];
+      lower += (in_val < median) - (out_val < median);
+    }
+
+    while (target < lower) {
+      lower -= histogram[--median];
+    }
+    while (lower + histogram[median] <= target) {
+      lower += histogram[median++];
+    }
+  }
 }
 }
 //------------------------------------------------------------
@@ -182,66 +263,120 @@ double refchk_(const int src, const int tgt, const double refv) {
                      : (src - tgt + 0.999999) * (1.0 - refv) + tgt;
 }
 template <class IT, class RT>
-void convert_each_to_all_channels_template_(
-    const IT *in, IT *out, const int hh, const int ww, const int ch
-
-    ,
-    const RT *ref /* 求める画像(out)と同じ高さ、幅、チャンネル数 */
-    ,
-    const int ref_mode  // R,G,B,A,luminance
+class median_thread_ final : public igs::resource::thread_execute_interface {
+public:
+  median_thread_(const IT *in, IT *out, const int hh, const int ww,
+                 const int ch, const RT *ref, const int ref_mode,
+                 const int zz /* 0...ch-1 or ch(each channel) */,
+                 const double radius,
+                 const igs::median_filter::out_of_image type,
+                 const int y_begin, const int y_end)
+      : in_(in)
+      , out_(out)
+      , hh_(hh)
+      , ww_(ww)
+      , ch_(ch)
+      , ref_(ref)
+      , ref_mode_(ref_mode)
+      , zz_(zz)
+      , y_begin_(y_begin)
+      , y_end_(y_end)
+      , pixr_(radius, type) {}
+  void run(void) override {
+    std::vector<IT> medians(this->ww_);
+    const int r_max = (std::numeric_limits<RT>::max)();
+    for (int yy = this->y_begin_; yy < this->y_end_; ++yy) {
+      const IT *in_pix = this->in_ + this->ww_ * this->ch_ * yy;
+      IT *out_pix      = this->out_ + this->ww_ * this->ch_ * yy;
+      const RT *ref =
+          (this->ref_ != 0) ? this->ref_ + this->ww_ * this->ch_ * yy : 0;
 
-    ,
-    const int zz, const double radius,
-    const igs::median_filter::out_of_image type) {
-  igs::median_filter::pixrender pixr(radius, type);
-  const IT *in_pix = in;
-  IT *out_pix      = out;
-  const int r_max  = std::numeric_limits<RT>::max();
-  for (int yy = 0; yy < hh; ++yy) {
-    for (int xx = 0; xx < ww; ++xx, in_pix += ch, out_pix += ch) {
-      double refv = 1.0;
-      if (ref != 0) {
-        refv *= igs::color::ref_value(ref, ch, r_max, ref_mode);
-        ref += ch;
+      /* 1 channelで判断して全channelに入れる */
+      if ((0 <= this->zz_) && (this->zz_ < this->ch_)) {
+        median_filter_sl_(this->pixr_, this->in_, this->hh_, this->ww_,
+                          this->ch_, yy, this->zz_, medians);
+        for (int xx = 0; xx < this->ww_;
+             ++xx, in_pix += this->ch_, out_pix += this->ch_) {
+          double refv = 1.0;
+          if (ref != 0) {
+            refv *= igs::color::ref_value(ref, this->ch_, r_max,
+                                          this->ref_mode_);
+            ref += this->ch_;
+          }
+          const IT v2 = static_cast<IT>(
+              refchk_(in_pix[this->zz_], medians.at(xx), refv));
+          for (int zz = 0; zz < this->ch_; ++zz) {
+            out_pix[zz] = v2;
+          }
+        }
+        continue;
       }
-      const IT v1 = median_filter_(pixr, in, hh, ww, ch, xx, yy, zz);
-      const IT v2 = static_cast<IT>(refchk_(in_pix[zz], v1, refv));
-      for (int zz = 0; zz < ch; ++zz) {
-        out_pix[zz] = v2;
+
+      /* channel毎に処理 */
+      for (int zz = 0; zz < this->ch_; ++zz) {
+        median_filter_sl_(this->pixr_, this->in_, this->hh_, this->ww_,
+                          this->ch_, yy, zz, medians);
+        const RT *rr = ref;
+        for (int xx = 0; xx < this->ww_; ++xx) {
+          double refv = 1.0;
+          if (rr != 0) {
+            refv *=
+                igs::color::ref_value(rr, this->ch_, r_max, this->ref_mode_);
+            rr += this->ch_;
+          }
+          out_pix[xx * this->ch_ + zz] = static_cast<IT>(
+              refchk_(in_pix[xx * this->ch_ + zz], medians.at(xx), refv));
+        }
       }
     }
   }
-  pixr.clear();
-}
+
+private:
+  const IT *in_;
+  IT *out_;
+  const int hh_, ww_, ch_;
+  const RT *ref_;
+  const int ref_mode_;
+  const int zz_;
+  const int y_begin_, y_end_;
+  igs::median_filter::pixrender pixr_; /* thread毎の作業領域 */
+};
 template <class IT, class RT>
-void convert_each_to_each_channel_template_(
-    const IT *in, IT *out, const int hh, const int ww, const int ch
+void convert_template_(const IT *in, IT *out, const int hh, const int ww,
+                       const int ch
 
-    ,
-    const RT *ref /* 求める画像(out)と同じ高さ、幅、チャンネル数 */
-    ,
-    const int ref_mode  // R,G,B,A,luminance
+                       ,
+                       const RT *ref /* 求める画像(out)と同じ高さ、幅、ch数 */
+                       ,
+                       const int ref_mode  // R,G,B,A,luminance
 
-    ,
-    const double radius, const igs::median_filter::out_of_image type) {
-  igs::median_filter::pixrender pixr(radius, type);
-  const IT *in_pix = in;
-  IT *out_pix      = out;
-  const int r_max  = std::numeric_limits<RT>::max();
-  for (int yy = 0; yy < hh; ++yy) {
-    for (int xx = 0; xx < ww; ++xx, in_pix += ch, out_pix += ch) {
-      double refv = 1.0;
-      if (ref != 0) {
-        refv *= igs::color::ref_value(ref, ch, r_max, ref_mode);
-        ref += ch;
-      }
-      for (int zz = 0; zz < ch; ++zz) {
-        const IT v1 = median_filter_(pixr, in, hh, ww, ch, xx, yy, zz);
-        out_pix[zz] = static_cast<IT>(refchk_(in_pix[zz], v1, refv));
-      }
-    }
+                       ,
+                       const int zz /* 0...ch-1 or ch(each channel) */,
+                       const double radius,
+                       const igs::median_filter::out_of_image type) {
+  /* scanlineの帯に分けてCPU数分のthreadで処理する */
+  int thread_num = static_cast<int>(std::thread::hardware_concurrency());
+  if (thread_num < 1) {
+    thread_num = 1;
+  }
+  if (hh < thread_num) {
+    thread_num = (hh < 1) ? 1 : hh;
+  }
+
+  std::vector<median_thread_<IT, RT>> threads;
+  threads.reserve(thread_num);
+  for (int ii = 0; ii < thread_num; ++ii) {
+    threads.push_back(median_thread_<IT, RT>(
+        in, out, hh, ww, ch, ref, ref_mode, zz, radius, type,
+        hh * ii / thread_num, hh * (ii + 1) / thread_num));
   }
-  pixr.clear();
+
+  igs::resource::multithread mthread;
+  for (int ii = 0; ii < thread_num; ++ii) {
+    mthread.add(&threads.at(ii));
+  }
+  mthread.run();
+  mthread.clear();
 }
 }
 //------------------------------------------------------------
@@ -324,61 +459,30 @@ void igs::median_filter::convert(
     break; /* 必要か?????? */
   }
 
-  /* 処理 */
+  /* 処理 (z2が0...channels-1以外ならchannel毎に処理) */
   if ((std::numeric_limits<unsigned char>::digits == bits) &&
       ((std::numeric_limits<unsigned char>::digits == ref_bits) ||
        (0 == ref_bits))) {
-    if ((0 <= z2) && (z2 < channels)) {
-      convert_each_to_all_channels_template_(in_image, out_image, height, width,
-                                             channels, ref, ref_mode, z2,
-                                             radius, type);
-    } else {
-      convert_each_to_each_channel_template_(in_image, out_image, height, width,
-                                             channels, ref, ref_mode, radius,
-                                             type);
-    }
+    convert_template_(in_image, out_image, height, width, channels, ref,
+                      ref_mode, z2, radius, type);
   } else if ((std::numeric_limits<unsigned short>::digits == bits) &&
              ((std::numeric_limits<unsigned char>::digits == ref_bits) ||
               (0 == ref_bits))) {
-    if ((0 <= z2) && (z2 < channels)) {
-      convert_each_to_all_channels_template_(
-          reinterpret_cast<const unsigned short *>(in_image),
-          reinterpret_cast<unsigned short *>(out_image), height, width,
-          channels, ref, ref_mode, z2, radius, type);
-    } else {
-      convert_each_to_each_channel_template_(
-          reinterpret_cast<const unsigned short *>(in_image),
-          reinterpret_cast<unsigned short *>(out_image), height, width,
-          channels, ref, ref_mode, radius, type);
-    }
+    convert_template_(reinterpret_cast<const unsigned short *>(in_image),
+                      reinterpret_cast<unsigned short *>(out_image), height,
+                      width, channels, ref, ref_mode, z2, radius, type);
   } else if ((std::numeric_limits<unsigned short>::digits == bits) &&
              (std::numeric_limits<unsigned short>::digits == ref_bits)) {
-    if ((0 <= z2) && (z2 < channels)) {
-      convert_each_to_all_channels_template_(
-          reinterpret_cast<const unsigned short *>(in_image),
-          reinterpret_cast<unsigned short *>(out_image), height, width,
-          channels, reinterpret_cast<const unsigned short *>(ref), ref_mode, z2,
-          radius, type);
-    } else {
-      convert_each_to_each_channel_template_(
-          reinterpret_cast<const unsigned short *>(in_image),
-          reinterpret_cast<unsigned short *>(out_image), height, width,
-          channels, reinterpret_cast<const unsigned short *>(ref), ref_mode,
-          radius, type);
-    }
+    convert_template_(reinterpret_cast<const unsigned short *>(in_image),
+                      reinterpret_cast<unsigned short *>(out_image), height,
+                      width, channels,
+                      reinterpret_cast<const unsigned short *>(ref), ref_mode,
+                      z2, radius, type);
   } else if ((std::numeric_limits<unsigned char>::digits == bits) &&
              (std::numeric_limits<unsigned short>::digits == ref_bits)) {
-    if ((0 <= z2) && (z2 < channels)) {
-      convert_each_to_all_channels_template_(
-          in_image, out_image, height, width, channels,
-          reinterpret_cast<const unsigned short *>(ref), ref_mode, z2, radius,
-          type);
-    } else {
-      convert_each_to_each_channel_template_(
-          in_image, out_image, height, width, channels,
-          reinterpret_cast<const unsigned short *>(ref), ref_mode, radius,
-          type);
-    }
+    convert_template_(in_image, out_image, height, width, channels,
+                      reinterpret_cast<const unsigned short *>(ref), ref_mode,
+                      z2, radius, type);
   } else {
     throw std::domain_error("Bad bits,Not uchar/ushort");
   }
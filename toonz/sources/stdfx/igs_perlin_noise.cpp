@@ -1,24 +1,25 @@
 #include <cmath>  // pow()
-#include "iwa_noise1234.h"
+#include <vector>
+#include "noiseengine.h"
 
 namespace {
-double perlin_noise_3d_(const double x, const double y, const double z,
-                        const int octaves_start  // 0<=
-                        ,
-                        const int octaves_end  // 0<=
-                        ,
-                        const double persistence  // Not 0
-                        // 1/4 or 1/2 or 1/sqrt(3) or 1/sqrt(2) or 1 or ...
-                        ) {
-  double total = 0;
-  Noise1234 pn;
-  for (int ii = octaves_start; ii <= octaves_end; ++ii) {
-    const double frequency = pow(2.0, ii);  // 1,2,4,8...
-    const double amplitude = pow(persistence, ii);
-    total += pn.noise(x * frequency, y * frequency, z * frequency) * amplitude;
+/* octaveごとの周波数と振幅。画素ごとにpow()しないよう前もって計算しておく */
+struct octaves_ {
+  std::vector<double> frequencies;  // 1,2,4,8...
+  std::vector<double> amplitudes;
+  octaves_(const int octaves_start  // 0<=
+           ,
+           const int octaves_end  // 0<=
+           ,
+           const double persistence  // Not 0
+           // 1/4 or 1/2 or 1/sqrt(3) or 1/sqrt(2) or 1 or ...
+           ) {
+    for (int ii = octaves_start; ii <= octaves_end; ++ii) {
+      this->frequencies.push_back(pow(2.0, ii));
+      this->amplitudes.push_back(pow(persistence, ii));
+    }
   }
-  return total;
-}
+};
 double perlin_noise_minmax_(const int octaves_start  // 0<=
                             ,
                             const int octaves_end  // 0<=
@@ -38,6 +39,7 @@ double perlin_noise_minmax_(const int octaves_start  // 0<=
 #include <limits>           // std::numeric_limits
 #include "igs_ifx_common.h" /* igs::image::rgba */
 #include "igs_perlin_noise.h"
+#include "tthread.h"
 namespace {
 template <class T>
 void change_(T *image_array, const int height  // pixel
@@ -79,24 +81,33 @@ void change_(T *image_array, const int height  // pixel
   const double maxi =
       perlin_noise_minmax_(octaves_start, octaves_end, persistence);
 
+  const octaves_ octaves(octaves_start, octaves_end, persistence);
+
   using namespace igs::image::rgba;
-  T *image_crnt = image_array;
-  for (int yy = 0; yy < height; ++yy) {
-    for (int xx = 0; xx < width; ++xx, image_crnt += channels) {
-      const T val = static_cast<T>(
-          perlin_noise_3d_(xx * a11 + yy * a12 + a13, xx * a21 + yy * a22 + a23,
-                           zz, octaves_start, octaves_end, persistence) /
-              maxi * max_mul +
-          max_off);
-      for (int zz = 0; zz < channels; ++zz) {
-        if (!alpha_rendering_sw && (alp == zz)) {
-          image_crnt[zz] = static_cast<T>(max_div);
-        } else {
-          image_crnt[zz] = val;
+  /* scanlineの帯に分けて並列処理する */
+  TThread::runInBands(width, height, [&](const int y0, const int y1) {
+    std::vector<double> xs(width), ys(width), noises(width);
+    T *image_crnt = image_array + y0 * width * channels;
+    for (int yy = y0; yy < y1; ++yy) {
+      /* 行全体のノイズをoctaveごとにまとめて計算する */
+      for (int xx = 0; xx < width; ++xx) {
+        xs[xx] = xx * a11 + yy * a12 + a13;
+        ys[xx] = xx * a21 + yy * a22 + a23;
+      }
+      NoiseEngine::noise1234Octaves(&noises[0], &xs[0], &ys[0], width, zz,
+                                    octaves.frequencies, octaves.amplitudes);
+      for (int xx = 0; xx < width; ++xx, image_crnt += channels) {
+        const T val = static_cast<T>(noises[xx] / maxi * max_mul + max_off);
+        for (int zz = 0; zz < channels; ++zz) {
+          if (!alpha_rendering_sw && (alp == zz)) {
+            image_crnt[zz] = static_cast<T>(max_div);
+          } else {
+            image_crnt[zz] = val;
+          }
         }
       }
     }
-  }
+  });
 }
 }
 // #include "igs_geometry2d.h"
@@ -6,6 +6,9 @@
 #include "trop.h"
 #include "trasterfx.h"
 #include "stdfx.h"
+#include "tthread.h"
+
+#include <vector>
 
 namespace ino {
 /* 一時バッファとの変換機能 */
@@ -37,6 +40,64 @@ inline int pixel_bits(const TRasterP ras) {
 // inline double pixel_per_mm(void) { return 640. / 12. / 25.4; }
 inline double pixel_per_mm(void) { return 1.; }
 // inline double pixel_per_inch(void) { return 640. / 12.; }
+
+/* blend fx共通の合成処理
+  up_rasをdn_ras_outに重ねる。blend_funcはigs::color::over()等と同じ引数で、
+  channel値を0...1のdoubleで受け取る。
+  - 8bitsのchannel値は表引きで0...1に変換する(除算と同じ値になる)
+  - upが透明な画素は結果がdownのままなので飛ばす。cross_dissolveのように
+    upが透明でも合成するものはtransparent_up_keeps_dn_swをfalseにする
+  - 大きな画像はscanlineの帯に分けて並列処理する
+*/
+template <class T, class Q, class BlendFunc>
+void blend_ras(TRasterPT<T> dn_ras_out, const TRasterPT<T> &up_ras,
+               const double up_opacity, const bool clipping_mask_sw,
+               const BlendFunc &blend_func,
+               const bool transparent_up_keeps_dn_sw = true) {
+  const double maxi = static_cast<double>(T::maxChannelValue);  // 255or65535
+
+  assert(dn_ras_out->getSize() == up_ras->getSize());
+
+  double unit_table[256];
+  const bool table_sw = (T::maxChannelValue == 255);
+  if (table_sw) {
+    for (int ii = 0; ii < 256; ++ii) {
+      unit_table[ii] = static_cast<double>(ii) / maxi;
+    }
+  }
+  auto to_unit = [&](const Q val) {
+    return table_sw ? unit_table[val] : static_cast<double>(val) / maxi;
+  };
+
+  auto blend_rows = [&](const int y0, const int y1) {
+    for (int yy = y0; yy < y1; ++yy) {
+      T *out_pix             = dn_ras_out->pixels(yy);
+      const T *const out_end = out_pix + dn_ras_out->getLx();
+      const T *up_pix        = up_ras->pixels(yy);
+      for (; out_pix < out_end; ++out_pix, ++up_pix) {
+        if (up_pix->m == 0 && (transparent_up_keeps_dn_sw || out_pix->m == 0)) {
+          continue;
+        }
+        double upr = to_unit(up_pix->r);
+        double upg = to_unit(up_pix->g);
+        double upb = to_unit(up_pix->b);
+        double upa = to_unit(up_pix->m);
+        double dnr = to_unit(out_pix->r);
+        double dng = to_unit(out_pix->g);
+        double dnb = to_unit(out_pix->b);
+        double dna = to_unit(out_pix->m);
+        blend_func(dnr, dng, dnb, dna, upr, upg, upb, upa,
+                   clipping_mask_sw ? up_opacity * dna : up_opacity);
+        out_pix->r = static_cast<Q>(dnr * (maxi + 0.999999));
+        out_pix->g = static_cast<Q>(dng * (maxi + 0.999999));
+        out_pix->b = static_cast<Q>(dnb * (maxi + 0.999999));
+        out_pix->m = static_cast<Q>(dna * (maxi + 0.999999));
+      }
+    }
+  };
+
+  TThread::runInBands(dn_ras_out->getLx(), dn_ras_out->getLy(), blend_rows);
+}
 }
 
 class TBlendForeBackRasterFx : public TRasterFx {
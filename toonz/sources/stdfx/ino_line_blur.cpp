@@ -79,6 +79,14 @@ IGS_LINE_BLUR_EXPORT void convert(
 
 #include <iostream>
 #include <stdexcept>
+#include <algorithm>
+#include <vector>
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+
+#include "tthread.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -1596,6 +1604,17 @@ private:
   pixel_point_node *_clpa_link[5];
   calculator_geometry _cl_cal_geom;
 
+  /* get_near_point()の高速化用、
+     延長した線の点を先頭から一定数ずつまとめたbbox */
+  struct point_block {
+    pixel_point_node *clp_first;
+    int32_t i32_pos, i32_count;
+    double d_x_min, d_x_max, d_y_min, d_y_max;
+  };
+  std::vector<point_block> _point_blocks;
+  double _get_block_length2(const point_block &block, double d_xp,
+                            double d_yp);
+
   int _expand_line_from_one(pixel_point_root *clp_pp_root,
                             int32_t i32_body_point_count,
                             pixel_point_node *clp_one,
@@ -1812,33 +1831,100 @@ int pixel_line_node::expand_line(pixel_point_root *clp_pixel_point_root) {
 
 #include "igs_line_blur.h"  // "pixel_line_node.h"
 
+/* 点のまとまりのbboxまでの距離の2乗
+        (まとまりの中の点までの距離の2乗以下になる) */
+double pixel_line_node::_get_block_length2(const point_block &block,
+                                           double d_xp, double d_yp) {
+  double d_dx = 0.0, d_dy = 0.0;
+  if (d_xp < block.d_x_min) {
+    d_dx = block.d_x_min - d_xp;
+  } else if (block.d_x_max < d_xp) {
+    d_dx = d_xp - block.d_x_max;
+  }
+  if (d_yp < block.d_y_min) {
+    d_dy = block.d_y_min - d_yp;
+  } else if (block.d_y_max < d_yp) {
+    d_dy = d_yp - block.d_y_max;
+  }
+  return d_dx * d_dx + d_dy * d_dy;
+}
+
+/* 一番近い点を探す
+        点のまとまりのbboxまでの距離で、一番近い点を含みえないまとまりは飛ばす
+        (全点を見た場合と同じ点(距離が同じなら先の点)を返す) */
 void pixel_line_node::get_near_point(double d_xp, double d_yp,
                                      int32_t *i32p_pos,
                                      pixel_point_node **clpp_point,
                                      double *dp_length) {
   pixel_point_node *clp_loop;
-  int32_t ii;
-  double d_length;
+  int32_t ii, jj, i32_nearest_block;
+  double d_length, d_length2, d_length2_min, d_limit;
 
   assert(NULL != this->get_clp_link_one_expand());
 
+  /* bboxが一番近いまとまり */
+  i32_nearest_block = -1;
+  d_length2_min     = 0.0;
+  for (jj = 0; jj < (int32_t)this->_point_blocks.size(); ++jj) {
+    d_length2 = this->_get_block_length2(this->_point_blocks[jj], d_xp, d_yp);
+    if ((i32_nearest_block < 0) || (d_length2 < d_length2_min)) {
+      i32_nearest_block = jj;
+      d_length2_min     = d_length2;
+    }
+  }
+
+  /* 一番近そうなまとまりの中の最近点までの距離を上限とする */
+  d_limit = 1000.0;
+  if (0 <= i32_nearest_block) {
+    const point_block &block = this->_point_blocks[i32_nearest_block];
+    clp_loop                 = block.clp_first;
+    for (ii = 0; ii < block.i32_count;
+         ++ii, clp_loop = clp_loop->get_clp_next_point()) {
+      d_length = sqrt((clp_loop->get_d_xp_tgt() - d_xp) *
+                          (clp_loop->get_d_xp_tgt() - d_xp) +
+                      (clp_loop->get_d_yp_tgt() - d_yp) *
+                          (clp_loop->get_d_yp_tgt() - d_yp));
+      if (d_length < d_limit) {
+        d_limit = d_length;
+      }
+    }
+  }
+
   /* 各ポイントを探索 */
-  *dp_length = 1000.0;
-  clp_loop   = this->get_clp_link_one_expand();
-  for (ii = 0; NULL != clp_loop;
-       ++ii, clp_loop = clp_loop->get_clp_next_point()) {
-    /* 偽の場合、たぶん無限ループ */
-    assert(ii < this->_i32_point_count);
+  *dp_length    = 1000.0;
+  d_length2_min = 1000.0 * 1000.0;
+  for (jj = 0; jj < (int32_t)this->_point_blocks.size(); ++jj) {
+    const point_block &block = this->_point_blocks[jj];
+
+    /* 上限より遠いまとまりには一番近い点はない */
+    if (d_limit < sqrt(this->_get_block_length2(block, d_xp, d_yp))) {
+      continue;
+    }
+
+    clp_loop = block.clp_first;
+    for (ii = block.i32_pos; ii < block.i32_pos + block.i32_count;
+         ++ii, clp_loop = clp_loop->get_clp_next_point()) {
+      /* 偽の場合、たぶん無限ループ */
+      assert(ii < this->_i32_point_count);
 
-    /* 距離 */
-    d_length = sqrt(
-        (clp_loop->get_d_xp_tgt() - d_xp) * (clp_loop->get_d_xp_tgt() - d_xp) +
-        (clp_loop->get_d_yp_tgt() - d_yp) * (clp_loop->get_d_yp_tgt() - d_yp));
-    /* 近いものならセットする */
-    if (d_length < (*dp_length)) {
-      *i32p_pos   = ii;
-      *clpp_point = clp_loop;
-      *dp_length  = d_length;
+      /* 距離の2乗 */
+      d_length2 = (clp_loop->get_d_xp_tgt() - d_xp) *
+                      (clp_loop->get_d_xp_tgt() - d_xp) +
+                  (clp_loop->get_d_yp_tgt() - d_yp) *
+                      (clp_loop->get_d_yp_tgt() - d_yp);
+      /* 2乗で遠いものはsqrt()しても近くならないので飛ばす */
+      if (d_length2_min <= d_length2) {
+        continue;
+      }
+      /* 距離 */
+      d_length = sqrt(d_length2);
+      /* 近いものならセットする */
+      if (d_length < (*dp_length)) {
+        *i32p_pos     = ii;
+        *clpp_point   = clp_loop;
+        *dp_length    = d_length;
+        d_length2_min = d_length2;
+      }
     }
   }
 }
@@ -2302,6 +2388,38 @@ void pixel_line_node::set_bbox(void) {
       }
     }
   }
+
+  /* 延長した線の点を16個ずつまとめたbbox(get_near_point()用) */
+  this->_point_blocks.clear();
+  clp_point = this->get_clp_link_one_expand();
+  for (ii        = 0; NULL != clp_point;
+       clp_point = clp_point->get_clp_next_point(), ++ii) {
+    assert(ii < this->_i32_point_count);
+
+    if (0 == (ii % 16)) {
+      point_block block;
+      block.clp_first = clp_point;
+      block.i32_pos   = ii;
+      block.i32_count = 0;
+      block.d_x_min = block.d_x_max = clp_point->get_d_xp_tgt();
+      block.d_y_min = block.d_y_max = clp_point->get_d_yp_tgt();
+      this->_point_blocks.push_back(block);
+    }
+    point_block &block = this->_point_blocks.back();
+    ++block.i32_count;
+    if (clp_point->get_d_xp_tgt() < block.d_x_min) {
+      block.d_x_min = clp_point->get_d_xp_tgt();
+    }
+    if (block.d_x_max < clp_point->get_d_xp_tgt()) {
+      block.d_x_max = clp_point->get_d_xp_tgt();
+    }
+    if (clp_point->get_d_yp_tgt() < block.d_y_min) {
+      block.d_y_min = clp_point->get_d_yp_tgt();
+    }
+    if (block.d_y_max < clp_point->get_d_yp_tgt()) {
+      block.d_y_max = clp_point->get_d_yp_tgt();
+    }
+  }
 }
 
 #include <assert.h> /* assert() */
@@ -2776,6 +2894,12 @@ public:
 
     this->_i32_smooth_retry   = 100;
     this->_i_same_way_exec_sw = true;
+
+    this->_d_grid_x_min     = 0.0;
+    this->_d_grid_y_min     = 0.0;
+    this->_d_grid_cell_size = 1.0;
+    this->_i32_grid_w       = 0;
+    this->_i32_grid_h       = 0;
   }
   ~pixel_line_root(void) { this->mem_free(); }
   void set_i_mv_sw(bool sw) { this->_i_mv_sw = sw; }
@@ -2799,6 +2923,12 @@ public:
   void exec09_same_way_expand(pixel_select_same_way_root *clp_select);
   void exec10_smooth_expand(void);
   void exec11_set_bbox(void);
+  void exec12_set_grid(double d_effect_area_radius);
+
+  /* 位置(d_xp,d_yp)に影響しうるラインのリスト(リスト順)
+     exec12_set_grid()前はNULLを返す */
+  const std::vector<pixel_line_node *> *get_grid_lines(double d_xp,
+                                                       double d_yp);
 
   int save_not_include(pixel_point_root *clp_pixel_point_root,
                        const char *cp_fname);
@@ -2822,6 +2952,12 @@ private:
   int32_t _i32_smooth_retry;
   bool _i_same_way_exec_sw;
 
+  /* 近傍ライン検索用の格子 */
+  double _d_grid_x_min, _d_grid_y_min, _d_grid_cell_size;
+  int32_t _i32_grid_w, _i32_grid_h;
+  std::vector<std::vector<pixel_line_node *>> _grid;
+  const std::vector<pixel_line_node *> _grid_empty;
+
   calculator_geometry _cl_cal_geom;
 
   pixel_line_node *_append(pixel_line_node *clp_previous);
@@ -3428,6 +3564,7 @@ void pixel_line_root::exec09_same_way_expand(
   }
 }
 
+#include <math.h>   /* floor() */
 #include <assert.h> /* assert() */
 
 #include "igs_line_blur.h"  // "pri.h" "pixel_line_root.h"
@@ -3472,6 +3609,126 @@ void pixel_line_root::exec11_set_bbox(void) {
                        this->_d_bbox_x_max, this->_d_bbox_y_max);
   }
 }
+
+/* 各ラインのbboxを影響半径分広げて格子に登録する
+        pixel_select_curve_blur_root::exec()で
+        全ラインを見るかわりに、その位置の升目のラインだけを見るため
+        升目の中のラインはリストの順番のまま(選択結果を変えないため)
+        exec11_set_bbox()の後に呼ぶこと
+*/
+void pixel_line_root::exec12_set_grid(double d_effect_area_radius) {
+  pixel_line_node *clp_line;
+  int32_t ii, xx, yy, x1, x2, y1, y2;
+  double d_x_min, d_x_max, d_y_min, d_y_max;
+
+  if (this->_i_mv_sw) {
+    pri_funct_msg_ttvr("pixel_line_root::exec12_set_grid()");
+  }
+
+  this->_grid.clear();
+  this->_i32_grid_w = 0;
+  this->_i32_grid_h = 0;
+
+  if (NULL == this->get_clp_first()) {
+    return;
+  }
+
+  /* 全ラインを含む範囲(影響半径分広げる) */
+  d_x_min = d_x_max = d_y_min = d_y_max = 0.0;
+  for (clp_line = (pixel_line_node *)this->get_clp_first(), ii = 0;
+       NULL != clp_line;
+       clp_line = (pixel_line_node *)clp_line->get_clp_next(), ++ii) {
+    assert(ii < this->get_i32_count());
+    if ((0 == ii) || (clp_line->get_d_bbox_x_min() < d_x_min)) {
+      d_x_min = clp_line->get_d_bbox_x_min();
+    }
+    if ((0 == ii) || (d_x_max < clp_line->get_d_bbox_x_max())) {
+      d_x_max = clp_line->get_d_bbox_x_max();
+    }
+    if ((0 == ii) || (clp_line->get_d_bbox_y_min() < d_y_min)) {
+      d_y_min = clp_line->get_d_bbox_y_min();
+    }
+    if ((0 == ii) || (d_y_max < clp_line->get_d_bbox_y_max())) {
+      d_y_max = clp_line->get_d_bbox_y_max();
+    }
+  }
+  d_x_min -= d_effect_area_radius;
+  d_x_max += d_effect_area_radius;
+  d_y_min -= d_effect_area_radius;
+  d_y_max += d_effect_area_radius;
+
+  /* 升目の大きさは影響半径ほど、ただし升目数は100万個ほどまで */
+  this->_d_grid_cell_size = (d_effect_area_radius < 4.0) ? 4.0
+                                                         : d_effect_area_radius;
+  while (1000000.0 < ((d_x_max - d_x_min) / this->_d_grid_cell_size + 1.0) *
+                         ((d_y_max - d_y_min) / this->_d_grid_cell_size + 1.0)) {
+    this->_d_grid_cell_size *= 2.0;
+  }
+  this->_d_grid_x_min = d_x_min;
+  this->_d_grid_y_min = d_y_min;
+  this->_i32_grid_w =
+      (int32_t)floor((d_x_max - d_x_min) / this->_d_grid_cell_size) + 1;
+  this->_i32_grid_h =
+      (int32_t)floor((d_y_max - d_y_min) / this->_d_grid_cell_size) + 1;
+  this->_grid.resize(this->_i32_grid_w * this->_i32_grid_h);
+
+  /* 各ラインを重なる升目に登録 */
+  for (clp_line = (pixel_line_node *)this->get_clp_first(); NULL != clp_line;
+       clp_line = (pixel_line_node *)clp_line->get_clp_next()) {
+    x1 = (int32_t)floor(
+        (clp_line->get_d_bbox_x_min() - d_effect_area_radius - d_x_min) /
+        this->_d_grid_cell_size);
+    x2 = (int32_t)floor(
+        (clp_line->get_d_bbox_x_max() + d_effect_area_radius - d_x_min) /
+        this->_d_grid_cell_size);
+    y1 = (int32_t)floor(
+        (clp_line->get_d_bbox_y_min() - d_effect_area_radius - d_y_min) /
+        this->_d_grid_cell_size);
+    y2 = (int32_t)floor(
+        (clp_line->get_d_bbox_y_max() + d_effect_area_radius - d_y_min) /
+        this->_d_grid_cell_size);
+    if (x1 < 0) {
+      x1 = 0;
+    }
+    if (y1 < 0) {
+      y1 = 0;
+    }
+    if (this->_i32_grid_w <= x2) {
+      x2 = this->_i32_grid_w - 1;
+    }
+    if (this->_i32_grid_h <= y2) {
+      y2 = this->_i32_grid_h - 1;
+    }
+    for (yy = y1; yy <= y2; ++yy) {
+      for (xx = x1; xx <= x2; ++xx) {
+        this->_grid[yy * this->_i32_grid_w + xx].push_back(clp_line);
+      }
+    }
+  }
+
+  if (this->_i_pv_sw) {
+    pri_funct_msg_ttvr(" set grid %d x %d cells : cell size %g",
+                       this->_i32_grid_w, this->_i32_grid_h,
+                       this->_d_grid_cell_size);
+  }
+}
+
+const std::vector<pixel_line_node *> *pixel_line_root::get_grid_lines(
+    double d_xp, double d_yp) {
+  int32_t xx, yy;
+
+  if (this->_grid.empty()) {
+    return NULL;
+  }
+
+  xx = (int32_t)floor((d_xp - this->_d_grid_x_min) / this->_d_grid_cell_size);
+  yy = (int32_t)floor((d_yp - this->_d_grid_y_min) / this->_d_grid_cell_size);
+  if ((xx < 0) || (this->_i32_grid_w <= xx) || (yy < 0) ||
+      (this->_i32_grid_h <= yy)) {
+    return &(this->_grid_empty);
+  }
+  return &(this->_grid[yy * this->_i32_grid_w + xx]);
+}
 #include <assert.h> /* assert() */
 
 #include "igs_line_blur.h"  // "pri.h" "pixel_line_root.h"
@@ -3513,6 +3770,11 @@ void pixel_line_root::mem_free(void) {
       pri_funct_msg_ttvr("free line node %d", ii);
     }
   }
+
+  /* 格子はラインを指しているので一緒に捨てる */
+  this->_grid.clear();
+  this->_i32_grid_w = 0;
+  this->_i32_grid_h = 0;
 }
 
 #include "igs_line_blur.h"  // "pri.h" "pixel_line_root.h"
@@ -4141,6 +4403,12 @@ int pixel_select_curve_blur_root::_sort_append(
   /* 情報をコピー */
   clp_prev->copy(clp_src);
 
+  /* get_line()で使うのは先頭から_i32_count_max個だけなので、
+     それより後ろに押し出されたものは捨てる */
+  while (this->_i32_count_max < this->get_i32_count()) {
+    this->_remove((pixel_select_curve_blur_node *)this->get_clp_last());
+  }
+
   return OK;
 }
 
@@ -4153,11 +4421,12 @@ void pixel_select_curve_blur_root::exec(double d_xp, double d_yp,
                                         int32_t i32_blur_count,
                                         double d_effect_area_radius) {
   pixel_line_node *clp_line;
-  int32_t ii, i32_pos;
+  int32_t ii, i32_pos, i32_line_count;
   bool i_reverse_sw;
   pixel_point_node *clp_near_point, *clp_start_point;
   double d_length, d_radius, d_radius_1st;
   pixel_select_curve_blur_node cl_select;
+  const std::vector<pixel_line_node *> *clp_grid_lines;
 
   /* 選択リストをクリア */
   this->mem_free();
@@ -4176,13 +4445,23 @@ void pixel_select_curve_blur_root::exec(double d_xp, double d_yp,
 
   d_radius_1st = NOT_USE_PARAMETER_VAL;
 
-  /* 全ライン */
-  ii = 0;
-  for (clp_line = (pixel_line_node *)clp_pixel_line_root->get_clp_first();
-       NULL != clp_line;
-       clp_line = (pixel_line_node *)clp_line->get_clp_next(), ++ii) {
-    /* 無限ループ? */
-    assert(ii < clp_pixel_line_root->get_i32_count());
+  /* 格子があればその升目のラインだけ、なければ全ライン
+     (どちらもリストの順番、最初の線分の方向で選択結果が変わるため) */
+  clp_grid_lines = clp_pixel_line_root->get_grid_lines(d_xp, d_yp);
+  i32_line_count = (NULL != clp_grid_lines)
+                       ? (int32_t)clp_grid_lines->size()
+                       : clp_pixel_line_root->get_i32_count();
+  clp_line = NULL;
+  for (ii = 0; ii < i32_line_count; ++ii) {
+    if (NULL != clp_grid_lines) {
+      clp_line = (*clp_grid_lines)[ii];
+    } else if (0 == ii) {
+      clp_line = (pixel_line_node *)clp_pixel_line_root->get_clp_first();
+    } else {
+      clp_line = (pixel_line_node *)clp_line->get_clp_next();
+    }
+    /* リストが壊れている? */
+    assert(NULL != clp_line);
     /* 選択してない? */
     assert(NULL != clp_line->get_clp_link_middle());
     assert(NULL != clp_line->get_clp_link_one());
@@ -5691,6 +5970,65 @@ int igs_line_blur_brush_curve_blur_subpixel_(
   return OK;
 }
 
+/* 画像をscanlineの帯に分け、帯ごとに線ぼかしする
+        ブラシと選択リストは同時に動く帯毎、ラインリストと入力画像は共有(読むだけ)
+        出力は帯の中のピクセルだけに書く */
+class brush_curve_blur_thread_ {
+public:
+  brush_curve_blur_thread_(
+      brush_curve_blur &cl_brush_curve_blur,
+      pixel_select_curve_blur_root &cl_pixel_select_curve_blur_root,
+      pixel_line_root &cl_pixel_line_root, const void *in, const int height,
+      const int width, const int channels, const int bits, void *out,
+      const int y_begin, const int y_end, const bool cv_sw)
+      : brush_(cl_brush_curve_blur)
+      , select_(cl_pixel_select_curve_blur_root)
+      , line_root_(cl_pixel_line_root)
+      , in_(in)
+      , height_(height)
+      , width_(width)
+      , channels_(channels)
+      , bits_(bits)
+      , out_(out)
+      , y_begin_(y_begin)
+      , y_end_(y_end)
+      , cv_sw_(cv_sw) {}
+  void run(void) {
+    for (int yy = this->y_begin_; yy < this->y_end_; ++yy) {
+      /* カウントダウン表示中 */
+      if (this->cv_sw_) {
+        pri_funct_cv_run(yy - this->y_begin_);
+      }
+
+      for (int xx = 0; xx < this->width_; ++xx) {
+        if (OK == igs_line_blur_brush_curve_blur_subpixel_(
+                      this->brush_, this->select_, this->line_root_, this->in_,
+                      this->height_, this->width_, this->channels_,
+                      this->bits_, xx, yy)) {
+          /* ピクセル値を計算 */
+          this->brush_.set_pixel_value();
+
+          /* 結果をピクセルへ置く
+  (取ったものと別の画像におくこと) */
+          igs_line_blur_brush_curve_point_put_image_(
+              this->brush_, xx, yy, this->height_, this->width_,
+              this->channels_, this->bits_, this->out_);
+        }
+      }
+    }
+  }
+
+private:
+  brush_curve_blur &brush_;
+  pixel_select_curve_blur_root &select_;
+  pixel_line_root &line_root_;
+  const void *in_;
+  const int height_, width_, channels_, bits_;
+  void *out_;
+  const int y_begin_, y_end_;
+  const bool cv_sw_;
+};
+
 int igs_line_blur_brush_curve_blur_all_(
     bool mv_sw, bool pv_sw, bool cv_sw, brush_curve_blur &cl_brush_curve_blur,
     pixel_select_curve_blur_root &cl_pixel_select_curve_blur_root,
@@ -5720,51 +6058,94 @@ int igs_line_blur_brush_curve_blur_all_(
               << cl_brush_curve_blur.get_d_effect_area_radius() << std::endl;
   }
 
+  /* 帯はTThread::runInBands()の共有thread poolで処理する
+     同時に動く帯はQThread::idealThreadCount()個までなので、
+     その数だけブラシと選択リストを用意し、帯ごとに空いているものを使う */
+  const int thread_num = std::max(1, QThread::idealThreadCount());
+
+  /* 2番目以後のブラシと選択リスト(設定は1番目と同じ) */
+  std::vector<brush_curve_blur> brushes(thread_num - 1);
+  std::vector<pixel_select_curve_blur_root> selects(thread_num - 1);
+  for (int ii = 0; ii < thread_num - 1; ++ii) {
+    brushes.at(ii).set_i32_count(cl_brush_curve_blur.get_i32_count());
+    brushes.at(ii).set_i32_subpixel_divide(
+        cl_brush_curve_blur.get_i32_subpixel_divide());
+    brushes.at(ii).set_d_effect_area_radius(
+        cl_brush_curve_blur.get_d_effect_area_radius());
+    brushes.at(ii).set_d_power(cl_brush_curve_blur.get_d_power());
+    selects.at(ii).set_i32_count_max(
+        cl_pixel_select_curve_blur_root.get_i32_count_max());
+    selects.at(ii).set_d_length_max(
+        cl_pixel_select_curve_blur_root.get_d_length_max());
+  }
+
   /* ブラシメモリの確保 */
   if (OK != cl_brush_curve_blur.mem_alloc()) {
     throw std::domain_error(
         "Error : cl_brush_curve_blur.mem_alloc() returns NG");
   }
+  for (int ii = 0; ii < thread_num - 1; ++ii) {
+    if (OK != brushes.at(ii).mem_alloc()) {
+      throw std::domain_error(
+          "Error : cl_brush_curve_blur.mem_alloc() returns NG");
+    }
+  }
 
   /* ブラシの線ぼかし変化比率の設定 */
   cl_brush_curve_blur.init_ratio_array();
+  for (int ii = 0; ii < thread_num - 1; ++ii) {
+    brushes.at(ii).init_ratio_array();
+  }
+
+  /* 近くの線分を探すための格子を作る */
+  cl_pixel_line_root.exec12_set_grid(
+      cl_brush_curve_blur.get_d_effect_area_radius());
 
   /* 画像をinからoutへコピーしておく */
   (void)memcpy(out, in, height * width * channels * ((16 == bits) ? 2 : 1));
-  /* カウントダウン表示始め */
-  if (cv_sw) {
-    pri_funct_cv_start(height);
+  /* 空いているブラシと選択リストの番号 */
+  std::vector<int> free_brushes;
+  for (int ii = thread_num - 1; 0 <= ii; --ii) {
+    free_brushes.push_back(ii);
   }
+  QMutex free_brushes_mutex;
 
-  for (int yy = 0; yy < height; ++yy) {
-    /* カウントダウン表示中 */
-    if (cv_sw) {
-      pri_funct_cv_run(yy);
+  TThread::runInBands(width, height, [&](const int y_begin, const int y_end) {
+    int ii;
+    {
+      QMutexLocker locker(&free_brushes_mutex);
+      ii = free_brushes.back();
+      free_brushes.pop_back();
     }
 
-    for (int xx = 0; xx < width; ++xx) {
-      if (OK == igs_line_blur_brush_curve_blur_subpixel_(
-                    cl_brush_curve_blur, cl_pixel_select_curve_blur_root,
-                    cl_pixel_line_root, in, height, width, channels, bits, xx,
-                    yy)) {
-        /* ピクセル値を計算 */
-        cl_brush_curve_blur.set_pixel_value();
+    /* カウントダウン表示(最初の帯で表示) */
+    const bool cv_band_sw = cv_sw && (0 == y_begin);
+    if (cv_band_sw) {
+      pri_funct_cv_start(y_end - y_begin);
+    }
 
-        /* 結果をピクセルへ置く
-(取ったものと別の画像におくこと) */
-        igs_line_blur_brush_curve_point_put_image_(
-            cl_brush_curve_blur, xx, yy, height, width, channels, bits, out);
-      }
+    brush_curve_blur_thread_(
+        (0 == ii) ? cl_brush_curve_blur : brushes.at(ii - 1),
+        (0 == ii) ? cl_pixel_select_curve_blur_root : selects.at(ii - 1),
+        cl_pixel_line_root, in, height, width, channels, bits, out, y_begin,
+        y_end, cv_band_sw)
+        .run();
+
+    if (cv_band_sw) {
+      pri_funct_cv_end();
     }
-  }
 
-  /* カウントダウン表示終了 */
-  if (cv_sw) {
-    pri_funct_cv_end();
-  }
+    {
+      QMutexLocker locker(&free_brushes_mutex);
+      free_brushes.push_back(ii);
+    }
+  });
 
   /* ブラシメモリの開放 */
   cl_brush_curve_blur.mem_free();
+  for (int ii = 0; ii < thread_num - 1; ++ii) {
+    brushes.at(ii).mem_free();
+  }
 
   return OK;
 }
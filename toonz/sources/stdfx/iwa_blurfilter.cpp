@@ -0,0 +1,71 @@
+/*------------------------------------
+ Iwa_DirectionalBlurFx と Iwa_MotionBlurCompFx で共有する
+ フィルタのキャッシュと畳み込み処理
+//------------------------------------*/
+
+#include "iwa_blurfilter.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <list>
+
+namespace {
+
+/*- キャッシュするフィルタの合計サイズの上限 -*/
+const size_t c_filterCacheBytes = 64 << 20;
+
+struct FilterCacheEntry {
+  std::string m_fxType;
+  BlurFilterUtils::FilterKey m_key;
+  BlurFilterUtils::Filter m_filter;
+};
+
+/*- 新しく使ったものが先頭 -*/
+QMutex FilterCacheMutex;
+std::list<FilterCacheEntry> FilterCache;
+size_t FilterCacheBytes = 0;
+
+size_t filterBytes(const BlurFilterUtils::Filter &filter) {
+  return filter->size() * sizeof(float);
+}
+
+}  // namespace
+
+//------------------------------------
+
+BlurFilterUtils::Filter BlurFilterUtils::findFilter(const std::string &fxType,
+                                                    const FilterKey &key) {
+  QMutexLocker locker(&FilterCacheMutex);
+
+  for (auto it = FilterCache.begin(); it != FilterCache.end(); ++it) {
+    if (it->m_fxType == fxType && it->m_key == key) {
+      FilterCache.splice(FilterCache.begin(), FilterCache, it);
+      return it->m_filter;
+    }
+  }
+  return Filter();
+}
+
+//------------------------------------
+
+void BlurFilterUtils::storeFilter(const std::string &fxType,
+                                  const FilterKey &key, const Filter &filter) {
+  size_t bytes = filterBytes(filter);
+  if (bytes > c_filterCacheBytes) return;
+
+  QMutexLocker locker(&FilterCacheMutex);
+
+  /*- 他のスレッドが同じフィルタを先に作っていたら何もしない -*/
+  for (const FilterCacheEntry &entry : FilterCache)
+    if (entry.m_fxType == fxType && entry.m_key == key) return;
+
+  while (FilterCacheBytes + bytes > c_filterCacheBytes) {
+    FilterCacheBytes -= filterBytes(FilterCache.back().m_filter);
+    FilterCache.pop_back();
+  }
+
+  FilterCacheEntry entry = {fxType, key, filter};
+  FilterCache.push_front(entry);
+  FilterCacheBytes += bytes;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+/*------------------------------------
+ Iwa_DirectionalBlurFx と Iwa_MotionBlurCompFx で共有する
+ フィルタのキャッシュと畳み込み処理
+//------------------------------------*/
+
+#ifndef IWA_BLUR_FILTER_H
+#define IWA_BLUR_FILTER_H
+
+#include "tgeometry.h"
+#include "tthread.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace BlurFilterUtils {
+
+typedef std::shared_ptr<const std::vector<float>> Filter;
+
+/*- フィルタを作ったパラメータ。値をそのまま並べて比較する -*/
+typedef std::vector<double> FilterKey;
+
+/*- キャッシュされたフィルタを返す。無ければ空のポインタ -*/
+Filter findFilter(const std::string &fxType, const FilterKey &key);
+
+/*- フィルタをキャッシュする。古いものから捨てる -*/
+void storeFilter(const std::string &fxType, const FilterKey &key,
+                 const Filter &filter);
+
+/*- フィルタ値が０でない要素 -*/
+struct Tap {
+  int filx, fily;
+  int offset; /*- 出力ピクセルから見たサンプルピクセルのインデックス差 -*/
+  float value;
+};
+
+/*- フィルタ値が０でない要素を、フィルタ全体を走査するのと同じ順に並べる。
+    フィルタはサンプル点の画像を収集するように用いるため、
+    上下左右反転してサンプルする -*/
+inline std::vector<Tap> makeTaps(const float *filter_p,
+                                 const TDimensionI &filterDim, int marginLeft,
+                                 int marginBottom, int lx) {
+  std::vector<Tap> taps;
+  for (int fily = -marginBottom; fily < filterDim.ly - marginBottom; fily++) {
+    for (int filx = -marginLeft; filx < filterDim.lx - marginLeft;
+         filx++, filter_p++) {
+      if ((*filter_p) == 0.0f) continue;
+      Tap tap = {filx, fily, -fily * lx - filx, *filter_p};
+      taps.push_back(tap);
+    }
+  }
+  return taps;
+}
+
+/*- 露光値などをフィルタリングしてぼかす。outDimの範囲をループする。
+    積算の順番は元のフィルタ全体のループと同じなので、結果も変わらない -*/
+template <typename FLOAT4>
+void applyFilter(const FLOAT4 *in_p, FLOAT4 *out_p, int lx,
+                 const std::vector<Tap> &taps, int marginRight, int marginTop,
+                 const TDimensionI &outDim) {
+  TThread::runInBands(outDim.lx, outDim.ly, [&](int y0, int y1) {
+    for (int y = y0; y < y1; y++) {
+      int outIndex = (y + marginTop) * lx + marginRight;
+      for (int x = 0; x < outDim.lx; x++, outIndex++) {
+        FLOAT4 value = {0.0f, 0.0f, 0.0f, 0.0f};
+        for (const Tap &tap : taps) {
+          const FLOAT4 &sample = in_p[outIndex + tap.offset];
+          /*- サンプルピクセルが透明ならcontinue -*/
+          if (sample.w == 0.0f) continue;
+          value.x += sample.x * tap.value;
+          value.y += sample.y * tap.value;
+          value.z += sample.z * tap.value;
+          value.w += sample.w * tap.value;
+        }
+        out_p[outIndex] = value;
+      }
+    }
+  });
+}
+
+}  // namespace BlurFilterUtils
+
+#endif
@@ -4,6 +4,7 @@
 //------------------------------------*/
 
 #include "iwa_directionalblurfx.h"
+#include "iwa_blurfilter.h"
 
 #include "tparamuiconcept.h"
 
@@ -241,10 +242,6 @@ void Iwa_DirectionalBlurFx::doCompute_CPU(
   out_ras->lock();
   float4 *out = (float4 *)out_ras->getRawData();
 
-  TRasterGR8P filter_ras(sizeof(float) * filterDim.lx, filterDim.ly);
-  filter_ras->lock();
-  float *filter = (float *)filter_ras->getRawData();
-
   /*- ソース画像を０〜１に正規化してホストメモリに読み込む -*/
   TRaster32P ras32 = (TRaster32P)enlarge_tile.getRaster();
   TRaster64P ras64 = (TRaster64P)enlarge_tile.getRaster();
@@ -253,125 +250,92 @@ void Iwa_DirectionalBlurFx::doCompute_CPU(
   else if (ras64)
     setSourceRaster<TRaster64P, TPixel64>(ras64, in, enlargedDimIn);
 
-  /*- フィルタ作る -*/
-  makeDirectionalBlurFilter_CPU(filter, blur, bidirectional, marginLeft,
-                                marginRight, marginTop, marginBottom,
-                                filterDim);
+  /*- フィルタ作る。同じパラメータのフィルタはキャッシュから使い回す -*/
+  BlurFilterUtils::FilterKey filterKey = {
+      blur.x,
+      blur.y,
+      (double)bidirectional,
+      (double)m_filterType->getValue(),
+      (double)marginLeft,
+      (double)marginRight,
+      (double)marginTop,
+      (double)marginBottom};
+  BlurFilterUtils::Filter filter =
+      BlurFilterUtils::findFilter(getFxType(), filterKey);
+  if (!filter) {
+    std::shared_ptr<std::vector<float>> newFilter(
+        new std::vector<float>(filterDim.lx * filterDim.ly));
+    makeDirectionalBlurFilter_CPU(newFilter->data(), blur, bidirectional,
+                                  marginLeft, marginRight, marginTop,
+                                  marginBottom, filterDim);
+    filter = newFilter;
+    BlurFilterUtils::storeFilter(getFxType(), filterKey, filter);
+  }
+
+  /*- フィルタ値が０でない要素だけを使う -*/
+  std::vector<BlurFilterUtils::Tap> taps = BlurFilterUtils::makeTaps(
+      filter->data(), filterDim, marginLeft, marginBottom, enlargedDimIn.lx);
 
   if (reference_host) /*- 参照画像がある場合 -*/
   {
-    float4 *out_p = out + marginTop * enlargedDimIn.lx;
-    float *ref_p  = reference_host + marginTop * enlargedDimIn.lx;
-    /*- フィルタリング -*/
-    for (int y = marginTop; y < dimOut.ly + marginTop; y++) {
-      out_p += marginRight;
-      ref_p += marginRight;
-      for (int x = marginRight; x < dimOut.lx + marginRight;
-           x++, out_p++, ref_p++) {
-        /*- 参照画像が黒ならソースをそのまま返す -*/
-        if ((*ref_p) == 0.0f) {
-          (*out_p) = in[y * enlargedDimIn.lx + x];
-          continue;
-        }
+    /*- フィルタリング。行の帯ごとに並列処理する -*/
+    TThread::runInBands(dimOut.lx, dimOut.ly, [&](int y0, int y1) {
+      for (int y = y0 + marginTop; y < y1 + marginTop; y++) {
+        int index = y * enlargedDimIn.lx + marginRight;
+        for (int x = marginRight; x < dimOut.lx + marginRight; x++, index++) {
+          float ref = reference_host[index];
+          /*- 参照画像が黒ならソースをそのまま返す -*/
+          if (ref == 0.0f) {
+            out[index] = in[index];
+            continue;
+          }
 
-        /*- 値を積算する入れ物を用意 -*/
-        float4 value = {0.0f, 0.0f, 0.0f, 0.0f};
-
-        float *filter_p = filter;
-
-        if ((*ref_p) == 1.0f) {
-          /*- フィルタのサイズでループ
-             ただし、フィルタはサンプル点の画像を収集するように
-                  用いるため、上下左右反転してサンプルする -*/
-          for (int fily = -marginBottom; fily < filterDim.ly - marginBottom;
-               fily++) {
-            /*- サンプル座標 と インデックス の このスキャンラインのうしろ -*/
-            int2 samplePos  = {x + marginLeft, y - fily};
-            int sampleIndex = samplePos.y * enlargedDimIn.lx + samplePos.x;
-
-            for (int filx = -marginLeft; filx < filterDim.lx - marginLeft;
-                 filx++, filter_p++, sampleIndex--) {
-              /*- フィルター値が０またはサンプルピクセルが透明ならcontinue -*/
-              if ((*filter_p) == 0.0f || in[sampleIndex].w == 0.0f) continue;
+          /*- 値を積算する入れ物を用意 -*/
+          float4 value = {0.0f, 0.0f, 0.0f, 0.0f};
+
+          if (ref == 1.0f) {
+            for (const BlurFilterUtils::Tap &tap : taps) {
+              const float4 &sample = in[index + tap.offset];
+              /*- サンプルピクセルが透明ならcontinue -*/
+              if (sample.w == 0.0f) continue;
               /*- サンプル点の値にフィルタ値を掛けて積算する -*/
-              value.x += in[sampleIndex].x * (*filter_p);
-              value.y += in[sampleIndex].y * (*filter_p);
-              value.z += in[sampleIndex].z * (*filter_p);
-              value.w += in[sampleIndex].w * (*filter_p);
+              value.x += sample.x * tap.value;
+              value.y += sample.y * tap.value;
+              value.z += sample.z * tap.value;
+              value.w += sample.w * tap.value;
             }
-          }
-        } else {
-          for (int fily = -marginBottom; fily < filterDim.ly - marginBottom;
-               fily++) {
-            for (int filx = -marginLeft; filx < filterDim.lx - marginLeft;
-                 filx++, filter_p++) {
-              /*- フィルター値が０ならcontinue -*/
-              if ((*filter_p) == 0.0f) continue;
+          } else {
+            for (const BlurFilterUtils::Tap &tap : taps) {
               /*- サンプル座標 -*/
-              int2 samplePos = {tround((float)x - (float)filx * (*ref_p)),
-                                tround((float)y - (float)fily * (*ref_p))};
+              int2 samplePos  = {tround((float)x - (float)tap.filx * ref),
+                                tround((float)y - (float)tap.fily * ref)};
               int sampleIndex = samplePos.y * enlargedDimIn.lx + samplePos.x;
+              const float4 &sample = in[sampleIndex];
 
               /*- サンプルピクセルが透明ならcontinue -*/
-              if (in[sampleIndex].w == 0.0f) continue;
+              if (sample.w == 0.0f) continue;
 
               /*- サンプル点の値にフィルタ値を掛けて積算する -*/
-              value.x += in[sampleIndex].x * (*filter_p);
-              value.y += in[sampleIndex].y * (*filter_p);
-              value.z += in[sampleIndex].z * (*filter_p);
-              value.w += in[sampleIndex].w * (*filter_p);
+              value.x += sample.x * tap.value;
+              value.y += sample.y * tap.value;
+              value.z += sample.z * tap.value;
+              value.w += sample.w * tap.value;
             }
           }
-        }
 
-        /*- 値を格納 -*/
-        (*out_p) = value;
+          /*- 値を格納 -*/
+          out[index] = value;
+        }
       }
-      out_p += marginLeft;
-      ref_p += marginLeft;
-    }
-
+    });
   } else /*- 参照画像が無い場合 -*/
   {
-    float4 *out_p = out + marginTop * enlargedDimIn.lx;
-    /*- フィルタリング -*/
-    for (int y = marginTop; y < dimOut.ly + marginTop; y++) {
-      out_p += marginRight;
-      for (int x = marginRight; x < dimOut.lx + marginRight; x++, out_p++) {
-        /*- 値を積算する入れ物を用意 -*/
-        float4 value = {0.0f, 0.0f, 0.0f, 0.0f};
-        /*- フィルタのサイズでループ
-           ただし、フィルタはサンプル点の画像を収集するように
-                用いるため、上下左右反転してサンプルする -*/
-        int filterIndex = 0;
-        for (int fily = -marginBottom; fily < filterDim.ly - marginBottom;
-             fily++) {
-          /*- サンプル座標 と インデックス の このスキャンラインのうしろ -*/
-          int2 samplePos  = {x + marginLeft, y - fily};
-          int sampleIndex = samplePos.y * enlargedDimIn.lx + samplePos.x;
-
-          for (int filx = -marginLeft; filx < filterDim.lx - marginLeft;
-               filx++, filterIndex++, sampleIndex--) {
-            /*- フィルター値が０またはサンプルピクセルが透明ならcontinue -*/
-            if (filter[filterIndex] == 0.0f || in[sampleIndex].w == 0.0f)
-              continue;
-            /*- サンプル点の値にフィルタ値を掛けて積算する -*/
-            value.x += in[sampleIndex].x * filter[filterIndex];
-            value.y += in[sampleIndex].y * filter[filterIndex];
-            value.z += in[sampleIndex].z * filter[filterIndex];
-            value.w += in[sampleIndex].w * filter[filterIndex];
-          }
-        }
-
-        /*- 値を格納 -*/
-        (*out_p) = value;
-      }
-      out_p += marginLeft;
-    }
+    /*- フィルタリング。行の帯ごとに並列処理する -*/
+    BlurFilterUtils::applyFilter(in, out, enlargedDimIn.lx, taps, marginRight,
+                                 marginTop, dimOut);
   }
 
   in_ras->unlock();
-  filter_ras->unlock();
 
   /*- ラスタのクリア -*/
   tile.getRaster()->clear();
@@ -5,6 +5,7 @@ Available to composite exposure value with background.
 //------------------------------------*/
 
 #include "iwa_motionblurfx.h"
+#include "iwa_blurfilter.h"
 #include "tfxattributes.h"
 
 #include "toonz/tstageobject.h"
@@ -376,37 +377,39 @@ void Iwa_MotionBlurCompFx::makeZanzoFilter_CPU(
 void Iwa_MotionBlurCompFx::convertRGBtoExposure_CPU(
     float4 *in_tile_p, TDimensionI &dim, float hardness,
     bool sourceIsPremultiplied) {
-  float4 *cur_tile_p = in_tile_p;
-  for (int i = 0; i < dim.lx * dim.ly; i++, cur_tile_p++) {
-    /* if alpha is 0, return */
-    if (cur_tile_p->w == 0.0f) {
-      cur_tile_p->x = 0.0f;
-      cur_tile_p->y = 0.0f;
-      cur_tile_p->z = 0.0f;
-      continue;
-    }
+  TThread::runInBands(dim.lx, dim.ly, [&](int y0, int y1) {
+    float4 *cur_tile_p = in_tile_p + y0 * dim.lx;
+    for (int i = y0 * dim.lx; i < y1 * dim.lx; i++, cur_tile_p++) {
+      /* if alpha is 0, return */
+      if (cur_tile_p->w == 0.0f) {
+        cur_tile_p->x = 0.0f;
+        cur_tile_p->y = 0.0f;
+        cur_tile_p->z = 0.0f;
+        continue;
+      }
 
-    /* Unpremultiply on sources that are premultiplied, such as regular Level.
-     * It is not done for 'digital overlay' (image with alpha mask added by
-     * using Photoshop, as known as 'DigiBook' in Japanese animation industry)
-     * etc. */
-    if (sourceIsPremultiplied) {
-      /* unpremultiply */
-      cur_tile_p->x /= cur_tile_p->w;
-      cur_tile_p->y /= cur_tile_p->w;
-      cur_tile_p->z /= cur_tile_p->w;
-    }
+      /* Unpremultiply on sources that are premultiplied, such as regular Level.
+       * It is not done for 'digital overlay' (image with alpha mask added by
+       * using Photoshop, as known as 'DigiBook' in Japanese animation industry)
+       * etc. */
+      if (sourceIsPremultiplied) {
+        /* unpremultiply */
+        cur_tile_p->x /= cur_tile_p->w;
+        cur_tile_p->y /= cur_tile_p->w;
+        cur_tile_p->z /= cur_tile_p->w;
+      }
 
-    /* convert RGB to Exposure */
-    cur_tile_p->x = powf(10, (cur_tile_p->x - 0.5f) * hardness);
-    cur_tile_p->y = powf(10, (cur_tile_p->y - 0.5f) * hardness);
-    cur_tile_p->z = powf(10, (cur_tile_p->z - 0.5f) * hardness);
+      /* convert RGB to Exposure */
+      cur_tile_p->x = powf(10, (cur_tile_p->x - 0.5f) * hardness);
+      cur_tile_p->y = powf(10, (cur_tile_p->y - 0.5f) * hardness);
+      cur_tile_p->z = powf(10, (cur_tile_p->z - 0.5f) * hardness);
 
-    /* Then multiply with the alpha channel */
-    cur_tile_p->x *= cur_tile_p->w;
-    cur_tile_p->y *= cur_tile_p->w;
-    cur_tile_p->z *= cur_tile_p->w;
-  }
+      /* Then multiply with the alpha channel */
+      cur_tile_p->x *= cur_tile_p->w;
+      cur_tile_p->y *= cur_tile_p->w;
+      cur_tile_p->z *= cur_tile_p->w;
+    }
+  });
 }
 
 /*------------------------------------------------------------
@@ -416,46 +419,14 @@ void Iwa_MotionBlurCompFx::convertRGBtoExposure_CPU(
 
 void Iwa_MotionBlurCompFx::applyBlurFilter_CPU(
     float4 *in_tile_p, float4 *out_tile_p, TDimensionI &enlargedDim,
-    float *filter_p, TDimensionI &filterDim, int marginLeft, int marginBottom,
-    int marginRight, int marginTop, TDimensionI &outDim) {
-  for (int i = 0; i < outDim.lx * outDim.ly; i++) {
-    /* in_tile_dev and out_tile_dev contain data with dimensions lx * ly.
-     * So, convert i to coordinates for output. */
-    int2 outPos  = {i % outDim.lx + marginRight, i / outDim.lx + marginTop};
-    int outIndex = outPos.y * enlargedDim.lx + outPos.x;
-    /* put the result in out_tile_dev [outIndex] */
-
-    /* Prepare a container to accumulate values ​​- */
-    float4 value = {0.0f, 0.0f, 0.0f, 0.0f};
-
-    /* Loop by filter size.
-     * Note that the filter is used to 'collect' pixels at sample points
-     * so flip the filter vertically and horizontally and sample it */
-    int filterIndex = 0;
-    for (int fily = -marginBottom; fily < filterDim.ly - marginBottom; fily++) {
-      /* Sample coordinates and index of the end of this scan line */
-      int2 samplePos  = {outPos.x + marginLeft, outPos.y - fily};
-      int sampleIndex = samplePos.y * enlargedDim.lx + samplePos.x;
-
-      for (int filx = -marginLeft; filx < filterDim.lx - marginLeft;
-           filx++, filterIndex++, sampleIndex--) {
-        /* If the filter value is 0 or the sample pixel is transparent, continue
-         */
-        if (filter_p[filterIndex] == 0.0f || in_tile_p[sampleIndex].w == 0.0f)
-          continue;
-        /* multiply the sample point value by the filter value and integrate */
-        value.x += in_tile_p[sampleIndex].x * filter_p[filterIndex];
-        value.y += in_tile_p[sampleIndex].y * filter_p[filterIndex];
-        value.z += in_tile_p[sampleIndex].z * filter_p[filterIndex];
-        value.w += in_tile_p[sampleIndex].w * filter_p[filterIndex];
-      }
-    }
-
-    out_tile_p[outIndex].x = value.x;
-    out_tile_p[outIndex].y = value.y;
-    out_tile_p[outIndex].z = value.z;
-    out_tile_p[outIndex].w = value.w;
-  }
+    const float *filter_p, TDimensionI &filterDim, int marginLeft,
+    int marginBottom, int marginRight, int marginTop, TDimensionI &outDim) {
+  /* Only the non-zero filter values are visited, in the same order as a loop
+   * on the whole filter. Rows are split in bands among threads. */
+  std::vector<BlurFilterUtils::Tap> taps = BlurFilterUtils::makeTaps(
+      filter_p, filterDim, marginLeft, marginBottom, enlargedDim.lx);
+  BlurFilterUtils::applyFilter(in_tile_p, out_tile_p, enlargedDim.lx, taps,
+                               marginRight, marginTop, outDim);
 }
 
 /*------------------------------------------------------------
@@ -467,42 +438,44 @@ void Iwa_MotionBlurCompFx::applyBlurFilter_CPU(
 void Iwa_MotionBlurCompFx::convertExposureToRGB_CPU(float4 *out_tile_p,
                                                     TDimensionI &dim,
                                                     float hardness) {
-  float4 *cur_tile_p = out_tile_p;
-  for (int i = 0; i < dim.lx * dim.ly; i++, cur_tile_p++) {
-    /* if alpha is 0 return */
-    if (cur_tile_p->w == 0.0f) {
-      cur_tile_p->x = 0.0f;
-      cur_tile_p->y = 0.0f;
-      cur_tile_p->z = 0.0f;
-      continue;
-    }
+  TThread::runInBands(dim.lx, dim.ly, [&](int y0, int y1) {
+    float4 *cur_tile_p = out_tile_p + y0 * dim.lx;
+    for (int i = y0 * dim.lx; i < y1 * dim.lx; i++, cur_tile_p++) {
+      /* if alpha is 0 return */
+      if (cur_tile_p->w == 0.0f) {
+        cur_tile_p->x = 0.0f;
+        cur_tile_p->y = 0.0f;
+        cur_tile_p->z = 0.0f;
+        continue;
+      }
 
-    // unpremultiply
-    cur_tile_p->x /= cur_tile_p->w;
-    cur_tile_p->y /= cur_tile_p->w;
-    cur_tile_p->z /= cur_tile_p->w;
-
-    /* Convert Exposure to RGB value */
-    cur_tile_p->x = log10f(cur_tile_p->x) / hardness + 0.5f;
-    cur_tile_p->y = log10f(cur_tile_p->y) / hardness + 0.5f;
-    cur_tile_p->z = log10f(cur_tile_p->z) / hardness + 0.5f;
-
-    // multiply
-    cur_tile_p->x *= cur_tile_p->w;
-    cur_tile_p->y *= cur_tile_p->w;
-    cur_tile_p->z *= cur_tile_p->w;
-
-    /* Clamp */
-    cur_tile_p->x = (cur_tile_p->x > 1.0f)
-                        ? 1.0f
-                        : ((cur_tile_p->x < 0.0f) ? 0.0f : cur_tile_p->x);
-    cur_tile_p->y = (cur_tile_p->y > 1.0f)
-                        ? 1.0f
-                        : ((cur_tile_p->y < 0.0f) ? 0.0f : cur_tile_p->y);
-    cur_tile_p->z = (cur_tile_p->z > 1.0f)
-                        ? 1.0f
-                        : ((cur_tile_p->z < 0.0f) ? 0.0f : cur_tile_p->z);
-  }
+      // unpremultiply
+      cur_tile_p->x /= cur_tile_p->w;
+      cur_tile_p->y /= cur_tile_p->w;
+      cur_tile_p->z /= cur_tile_p->w;
+
+      /* Convert Exposure to RGB value */
+      cur_tile_p->x = log10f(cur_tile_p->x) / hardness + 0.5f;
+      cur_tile_p->y = log10f(cur_tile_p->y) / hardness + 0.5f;
+      cur_tile_p->z = log10f(cur_tile_p->z) / hardness + 0.5f;
+
+      // multiply
+      cur_tile_p->x *= cur_tile_p->w;
+      cur_tile_p->y *= cur_tile_p->w;
+      cur_tile_p->z *= cur_tile_p->w;
+
+      /* Clamp */
+      cur_tile_p->x = (cur_tile_p->x > 1.0f)
+                          ? 1.0f
+                          : ((cur_tile_p->x < 0.0f) ? 0.0f : cur_tile_p->x);
+      cur_tile_p->y = (cur_tile_p->y > 1.0f)
+                          ? 1.0f
+                          : ((cur_tile_p->y < 0.0f) ? 0.0f : cur_tile_p->y);
+      cur_tile_p->z = (cur_tile_p->z > 1.0f)
+                          ? 1.0f
+                          : ((cur_tile_p->z < 0.0f) ? 0.0f : cur_tile_p->z);
+    }
+  });
 }
 
 /*------------------------------------------------------------
@@ -776,8 +749,6 @@ void Iwa_MotionBlurCompFx::doCompute_CPU(
   /* Processing memory */
   float4 *in_tile_p;  /* With margin */
   float4 *out_tile_p; /* With margin */
-  /* Filter */
-  float *filter_p;
 
   /* Memory allocation */
   TRasterGR8P in_tile_ras(sizeof(float4) * enlargedDimIn.lx, enlargedDimIn.ly);
@@ -786,9 +757,6 @@ void Iwa_MotionBlurCompFx::doCompute_CPU(
   TRasterGR8P out_tile_ras(sizeof(float4) * enlargedDimIn.lx, enlargedDimIn.ly);
   out_tile_ras->lock();
   out_tile_p = (float4 *)out_tile_ras->getRawData();
-  TRasterGR8P filter_ras(sizeof(float) * filterDim.lx, filterDim.ly);
-  filter_ras->lock();
-  filter_p = (float *)filter_ras->getRawData();
 
   bool sourceIsPremultiplied;
   /* normalize the source image to 0 - 1 and read it into memory */
@@ -803,19 +771,45 @@ void Iwa_MotionBlurCompFx::doCompute_CPU(
         ras64, in_tile_p, enlargedDimIn,
         (PremultiTypes)m_premultiType->getValue());
 
-  /* When afterimage mode is off */
-  if (!m_zanzoMode->getValue()) {
-    /* Create and normalize filters */
-    makeMotionBlurFilter_CPU(filter_p, filterDim, marginLeft, marginBottom,
-                             pointsTable, pointAmount, startValue, startCurve,
-                             endValue, endCurve);
+  /* Filters are cached, keyed by everything they are made from. The z
+   * of the last point is left undefined, and is not used anyway. */
+  bool zanzoMode                       = m_zanzoMode->getValue();
+  BlurFilterUtils::FilterKey filterKey = {(double)zanzoMode,
+                                          startValue,
+                                          startCurve,
+                                          endValue,
+                                          endCurve,
+                                          (double)marginLeft,
+                                          (double)marginBottom,
+                                          (double)filterDim.lx,
+                                          (double)filterDim.ly};
+  for (int p = 0; p < pointAmount; p++) {
+    filterKey.push_back(pointsTable[p].x);
+    filterKey.push_back(pointsTable[p].y);
+    if (p < pointAmount - 1) filterKey.push_back(pointsTable[p].z);
+    filterKey.push_back(pointsTable[p].w);
   }
-  /* When afterimage mode is ON */
-  else {
-    /* Create / normalize the afterimage filter */
-    makeZanzoFilter_CPU(filter_p, filterDim, marginLeft, marginBottom,
-                        pointsTable, pointAmount, startValue, startCurve,
-                        endValue, endCurve);
+  BlurFilterUtils::Filter filter =
+      BlurFilterUtils::findFilter(getFxType(), filterKey);
+  if (!filter) {
+    std::shared_ptr<std::vector<float>> newFilter(
+        new std::vector<float>(filterDim.lx * filterDim.ly));
+    /* When afterimage mode is off */
+    if (!zanzoMode) {
+      /* Create and normalize filters */
+      makeMotionBlurFilter_CPU(newFilter->data(), filterDim, marginLeft,
+                               marginBottom, pointsTable, pointAmount,
+                               startValue, startCurve, endValue, endCurve);
+    }
+    /* When afterimage mode is ON */
+    else {
+      /* Create / normalize the afterimage filter */
+      makeZanzoFilter_CPU(newFilter->data(), filterDim, marginLeft,
+                          marginBottom, pointsTable, pointAmount, startValue,
+                          startCurve, endValue, endCurve);
+    }
+    filter = newFilter;
+    BlurFilterUtils::storeFilter(getFxType(), filterKey, filter);
   }
 
   delete[] pointsTable;
@@ -828,11 +822,11 @@ void Iwa_MotionBlurCompFx::doCompute_CPU(
                            sourceIsPremultiplied);
 
   /* Filter and blur exposure value */
-  applyBlurFilter_CPU(in_tile_p, out_tile_p, enlargedDimIn, filter_p, filterDim,
-                      marginLeft, marginBottom, marginRight, marginTop, dimOut);
+  applyBlurFilter_CPU(in_tile_p, out_tile_p, enlargedDimIn, filter->data(),
+                      filterDim, marginLeft, marginBottom, marginRight,
+                      marginTop, dimOut);
   /* Memory release */
   in_tile_ras->unlock();
-  filter_ras->unlock();
 
   /* If there is a background, do Exposure multiplication */
   if (m_background.isConnected()) {
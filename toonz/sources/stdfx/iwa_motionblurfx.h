@@ -89,7 +89,7 @@ protected:
 
   /*- 露光値をフィルタリングしてぼかす -*/
   void applyBlurFilter_CPU(float4 *in_tile_p, float4 *out_tile_p,
-                           TDimensionI &dim, float *filter_p,
+                           TDimensionI &dim, const float *filter_p,
                            TDimensionI &filterDim, int marginLeft,
                            int marginBottom, int marginRight, int marginTop,
                            TDimensionI &outDim);
@@ -11,6 +11,7 @@ PerlinNoise/SimplexNoiseパターンを生成、透視投影する
 #include "iwa_fresnel.h"
 #include "iwa_simplexnoise.h"
 #include "iwa_noise1234.h"
+#include "tthread.h"
 
 #include <vector>
 
@@ -318,78 +319,81 @@ void Iwa_PNPerspectiveFx::calcPerinNoise_CPU(float4 *out_host,
                                              TDimensionI &dimOut, PN_Params &p,
                                              bool doResample) {
   int reso = (doResample) ? 10 : 1;
-  /* 結果を収めるイテレータ */
-  float4 *out_p = out_host;
-  /* 各ピクセルについて */
-  for (int yy = 0; yy < p.drawLevel; yy++) {
-    for (int xx = 0; xx < dimOut.lx; xx++, out_p++) {
-      float val_sum = 0.0f;
-      int count     = 0;
-      /* 各リサンプル点について */
-      for (int tt = 0; tt < reso; tt++) {
-        for (int ss = 0; ss < reso; ss++) {
-          float2 tmpPixPos = {
-              (float)xx - 0.5f + ((float)ss + 0.5f) / (float)reso,
-              (float)yy - 0.5f + ((float)tt + 0.5f) / (float)reso};
-          float2 screenPos = {
-              tmpPixPos.x * p.a11 + tmpPixPos.y * p.a12 + p.a13,
-              tmpPixPos.x * p.a21 + tmpPixPos.y * p.a22 + p.a23};
-          /* ② Perlin Noise 平面上の座標を計算する */
-          float2 noisePos;
-          noisePos.x = -(p.eyeLevel.y + p.fy_2) * (screenPos.x - p.eyeLevel.x) /
-                           (screenPos.y - p.eyeLevel.y) +
-                       p.eyeLevel.x;
-          noisePos.y =
-              (p.fy_2 + screenPos.y) * p.A / (p.eyeLevel.y - screenPos.y);
-          float tmpVal           = 0.5f;
-          float currentSize      = p.size;
-          float2 currentOffset   = p.offset;
-          float currentIntensity = 1.0f;
-          // float2* basis_p = basis;
-
-          float currentEvolution = p.time;
+  /* 各ピクセルについて。行の帯ごとに並列処理する */
+  TThread::runInBands(dimOut.lx, p.drawLevel, [&](int y0, int y1) {
+    for (int yy = y0; yy < y1; yy++) {
+      /* 結果を収めるイテレータ */
+      float4 *out_p = out_host + yy * dimOut.lx;
+      for (int xx = 0; xx < dimOut.lx; xx++, out_p++) {
+        float val_sum = 0.0f;
+        int count     = 0;
+        /* 各リサンプル点について */
+        for (int tt = 0; tt < reso; tt++) {
+          for (int ss = 0; ss < reso; ss++) {
+            float2 tmpPixPos = {
+                (float)xx - 0.5f + ((float)ss + 0.5f) / (float)reso,
+                (float)yy - 0.5f + ((float)tt + 0.5f) / (float)reso};
+            float2 screenPos = {
+                tmpPixPos.x * p.a11 + tmpPixPos.y * p.a12 + p.a13,
+                tmpPixPos.x * p.a21 + tmpPixPos.y * p.a22 + p.a23};
+            /* ② Perlin Noise 平面上の座標を計算する */
+            float2 noisePos;
+            noisePos.x = -(p.eyeLevel.y + p.fy_2) *
+                             (screenPos.x - p.eyeLevel.x) /
+                             (screenPos.y - p.eyeLevel.y) +
+                         p.eyeLevel.x;
+            noisePos.y =
+                (p.fy_2 + screenPos.y) * p.A / (p.eyeLevel.y - screenPos.y);
+            float tmpVal           = 0.5f;
+            float currentSize      = p.size;
+            float2 currentOffset   = p.offset;
+            float currentIntensity = 1.0f;
+            // float2* basis_p = basis;
+
+            float currentEvolution = p.time;
+
+            /* ノイズを各世代足しこむ */
+            for (int o = 0; o < p.octaves; o++) {
+              float2 currentNoisePos = {
+                  (noisePos.x - currentOffset.x) / currentSize,
+                  (noisePos.y - currentOffset.y) / currentSize};
 
-          /* ノイズを各世代足しこむ */
-          for (int o = 0; o < p.octaves; o++) {
-            float2 currentNoisePos = {
-                (noisePos.x - currentOffset.x) / currentSize,
-                (noisePos.y - currentOffset.y) / currentSize};
+              if (p.noiseType == 0) {
+                tmpVal += currentIntensity *
+                          Noise1234::noise(currentNoisePos.x, currentNoisePos.y,
+                                           currentEvolution) /
+                          p.int_sum;
+              } else {
+                tmpVal +=
+                    currentIntensity *
+                    SimplexNoise::noise(currentNoisePos.x, currentNoisePos.y,
+                                        currentEvolution) /
+                    p.int_sum;
+              }
 
-            if (p.noiseType == 0) {
-              tmpVal += currentIntensity *
-                        Noise1234::noise(currentNoisePos.x, currentNoisePos.y,
-                                         currentEvolution) /
-                        p.int_sum;
-            } else {
-              tmpVal +=
-                  currentIntensity *
-                  SimplexNoise::noise(currentNoisePos.x, currentNoisePos.y,
-                                      currentEvolution) /
-                  p.int_sum;
+              currentSize *= p.p_size;
+              currentOffset.x *= p.p_offset;
+              currentOffset.y *= p.p_offset;
+              currentIntensity *= p.p_intensity;
+              currentEvolution *= p.p_evolution;
             }
-
-            currentSize *= p.p_size;
-            currentOffset.x *= p.p_offset;
-            currentOffset.y *= p.p_offset;
-            currentIntensity *= p.p_intensity;
-            currentEvolution *= p.p_evolution;
+            val_sum += tmpVal;
+            count += 1;
           }
-          val_sum += tmpVal;
-          count += 1;
         }
-      }
 
-      float val = val_sum / (float)count;
+        float val = val_sum / (float)count;
 
-      /* クランプ */
-      val = (val < 0.0f) ? 0.0f : ((val > 1.0f) ? 1.0f : val);
+        /* クランプ */
+        val = (val < 0.0f) ? 0.0f : ((val > 1.0f) ? 1.0f : val);
 
-      (*out_p).x = val;
-      (*out_p).y = val;
-      (*out_p).z = val;
-      (*out_p).w = (p.alp_rend_sw) ? val : 1.0f;
+        (*out_p).x = val;
+        (*out_p).y = val;
+        (*out_p).z = val;
+        (*out_p).w = (p.alp_rend_sw) ? val : 1.0f;
+      }
     }
-  }
+  });
 }
 
 /*------------------------------------------------------------
@@ -398,193 +402,199 @@ void Iwa_PNPerspectiveFx::calcPerinNoise_CPU(float4 *out_host,
 void Iwa_PNPerspectiveFx::calcPNNormal_CPU(float4 *out_host,
                                            TDimensionI &dimOut, PN_Params &p,
                                            bool isSubWave) {
-  /* 結果を収めるイテレータ */
-  float4 *out_p = out_host;
-  /* 各ピクセルについて */
-  for (int yy = 0; yy < p.drawLevel; yy++) {
-    for (int xx = 0; xx < dimOut.lx; xx++, out_p++) {
-      float2 screenPos = {(float)xx * p.a11 + (float)yy * p.a12 + p.a13,
-                          (float)xx * p.a21 + (float)yy * p.a22 + p.a23};
-
-      /*  ② Perlin Noise 平面上の座標を計算する */
-      float2 noisePos;
-
-      noisePos.x = -(p.eyeLevel.y + p.fy_2) * (screenPos.x - p.eyeLevel.x) /
-                       (screenPos.y - p.eyeLevel.y) +
-                   p.eyeLevel.x;
-
-      noisePos.y = (p.fy_2 + screenPos.y) * p.A / (p.eyeLevel.y - screenPos.y);
-
-      float gradient[2]; /* 0 : よこ差分、1 : たて差分 */
-
-      float delta = 0.001f;
-
-      /* 横、縦差分それぞれについて */
-      for (int yokoTate = 0; yokoTate < 2; yokoTate++) {
-        /* 勾配の初期化 */
-        gradient[yokoTate] = 0.0f;
-
-        /* サンプリング位置のオフセットを求める */
-        float2 kinbouNoisePos[2] = {
-            float2{noisePos.x - ((yokoTate == 0) ? delta : 0.0f),
-                   noisePos.y - ((yokoTate == 0) ? 0.0f : delta)},
-            float2{noisePos.x + ((yokoTate == 0) ? delta : 0.0f),
-                   noisePos.y + ((yokoTate == 0) ? 0.0f : delta)}};
-        float currentSize      = p.size;
-        float2 currentOffset   = p.offset;
-        float currentIntensity = 1.0f;
-        // float2* basis_p = basis;
-        float currentEvolution = (isSubWave) ? p.time + 100.0f : p.time;
-        /* 各世代について */
-        for (int o = 0; o < p.octaves; o++, currentSize *= p.p_size,
-                 currentOffset.x *= p.p_offset, currentOffset.y *= p.p_offset,
-                 currentIntensity *= p.p_intensity) {
-          /* プラス方向、マイナス方向それぞれオフセットしたノイズ座標を求める */
-          float2 currentOffsetNoisePos[2];
-          for (int mp = 0; mp < 2; mp++)
-            currentOffsetNoisePos[mp] =
-                float2{(kinbouNoisePos[mp].x - currentOffset.x) / currentSize,
-                       (kinbouNoisePos[mp].y - currentOffset.y) / currentSize};
-
-          /* ノイズの差分を積算していく */
-          float noiseDiff;
-          // Perlin Noise
-          if (p.noiseType == 0) {
-            noiseDiff =
-                Noise1234::noise(currentOffsetNoisePos[1].x,
-                                 currentOffsetNoisePos[1].y, currentEvolution) -
-                Noise1234::noise(currentOffsetNoisePos[0].x,
-                                 currentOffsetNoisePos[0].y, currentEvolution);
-          } else {
-            /* インデックスをチェック */
-            /* まず、前後 */
-            CellIds kinbouIds[2] = {
-                SimplexNoise::getCellIds(currentOffsetNoisePos[0].x,
-                                         currentOffsetNoisePos[0].y,
-                                         currentEvolution),
-                SimplexNoise::getCellIds(currentOffsetNoisePos[1].x,
-                                         currentOffsetNoisePos[1].y,
-                                         currentEvolution)};
-            /* 同じセルに入っていたら、普通に差分を計算 */
-            if (kinbouIds[0] == kinbouIds[1]) {
-              noiseDiff = SimplexNoise::noise(currentOffsetNoisePos[1].x,
-                                              currentOffsetNoisePos[1].y,
-                                              currentEvolution) -
-                          SimplexNoise::noise(currentOffsetNoisePos[0].x,
-                                              currentOffsetNoisePos[0].y,
-                                              currentEvolution);
-            }
-            /* 違うセルの場合、中心位置を用いる */
-            else {
-              float2 currentCenterNoisePos = {
-                  (noisePos.x - currentOffset.x) / currentSize,
-                  (noisePos.y - currentOffset.y) / currentSize};
-              CellIds centerIds = SimplexNoise::getCellIds(
-                  currentCenterNoisePos.x, currentCenterNoisePos.y,
-                  currentEvolution);
-              if (kinbouIds[0] == centerIds) {
-                noiseDiff = SimplexNoise::noise(currentCenterNoisePos.x,
-                                                currentCenterNoisePos.y,
-                                                currentEvolution) -
-                            SimplexNoise::noise(currentOffsetNoisePos[0].x,
-                                                currentOffsetNoisePos[0].y,
-                                                currentEvolution);
-              } else  // if(kinbouIds[1] == centerIds)
-              {
+  /* 各ピクセルについて。行の帯ごとに並列処理する */
+  TThread::runInBands(dimOut.lx, p.drawLevel, [&](int y0, int y1) {
+    for (int yy = y0; yy < y1; yy++) {
+      /* 結果を収めるイテレータ */
+      float4 *out_p = out_host + yy * dimOut.lx;
+      for (int xx = 0; xx < dimOut.lx; xx++, out_p++) {
+        float2 screenPos = {(float)xx * p.a11 + (float)yy * p.a12 + p.a13,
+                            (float)xx * p.a21 + (float)yy * p.a22 + p.a23};
+
+        /*  ② Perlin Noise 平面上の座標を計算する */
+        float2 noisePos;
+
+        noisePos.x = -(p.eyeLevel.y + p.fy_2) * (screenPos.x - p.eyeLevel.x) /
+                         (screenPos.y - p.eyeLevel.y) +
+                     p.eyeLevel.x;
+
+        noisePos.y =
+            (p.fy_2 + screenPos.y) * p.A / (p.eyeLevel.y - screenPos.y);
+
+        float gradient[2]; /* 0 : よこ差分、1 : たて差分 */
+
+        float delta = 0.001f;
+
+        /* 横、縦差分それぞれについて */
+        for (int yokoTate = 0; yokoTate < 2; yokoTate++) {
+          /* 勾配の初期化 */
+          gradient[yokoTate] = 0.0f;
+
+          /* サンプリング位置のオフセットを求める */
+          float2 kinbouNoisePos[2] = {
+              float2{noisePos.x - ((yokoTate == 0) ? delta : 0.0f),
+                     noisePos.y - ((yokoTate == 0) ? 0.0f : delta)},
+              float2{noisePos.x + ((yokoTate == 0) ? delta : 0.0f),
+                     noisePos.y + ((yokoTate == 0) ? 0.0f : delta)}};
+          float currentSize      = p.size;
+          float2 currentOffset   = p.offset;
+          float currentIntensity = 1.0f;
+          // float2* basis_p = basis;
+          float currentEvolution = (isSubWave) ? p.time + 100.0f : p.time;
+          /* 各世代について */
+          for (int o = 0; o < p.octaves; o++, currentSize *= p.p_size,
+                   currentOffset.x *= p.p_offset, currentOffset.y *= p.p_offset,
+                   currentIntensity *= p.p_intensity) {
+            /* プラス方向、マイナス方向それぞれオフセットしたノイズ座標を求める */
+            float2 currentOffsetNoisePos[2];
+            for (int mp = 0; mp < 2; mp++)
+              currentOffsetNoisePos[mp] = float2{
+                  (kinbouNoisePos[mp].x - currentOffset.x) / currentSize,
+                  (kinbouNoisePos[mp].y - currentOffset.y) / currentSize};
+
+            /* ノイズの差分を積算していく */
+            float noiseDiff;
+            // Perlin Noise
+            if (p.noiseType == 0) {
+              noiseDiff = Noise1234::noise(currentOffsetNoisePos[1].x,
+                                           currentOffsetNoisePos[1].y,
+                                           currentEvolution) -
+                          Noise1234::noise(currentOffsetNoisePos[0].x,
+                                           currentOffsetNoisePos[0].y,
+                                           currentEvolution);
+            } else {
+              /* インデックスをチェック */
+              /* まず、前後 */
+              CellIds kinbouIds[2] = {
+                  SimplexNoise::getCellIds(currentOffsetNoisePos[0].x,
+                                           currentOffsetNoisePos[0].y,
+                                           currentEvolution),
+                  SimplexNoise::getCellIds(currentOffsetNoisePos[1].x,
+                                           currentOffsetNoisePos[1].y,
+                                           currentEvolution)};
+              /* 同じセルに入っていたら、普通に差分を計算 */
+              if (kinbouIds[0] == kinbouIds[1]) {
                 noiseDiff = SimplexNoise::noise(currentOffsetNoisePos[1].x,
                                                 currentOffsetNoisePos[1].y,
                                                 currentEvolution) -
-                            SimplexNoise::noise(currentCenterNoisePos.x,
-                                                currentCenterNoisePos.y,
+                            SimplexNoise::noise(currentOffsetNoisePos[0].x,
+                                                currentOffsetNoisePos[0].y,
                                                 currentEvolution);
               }
-              /* 片端→中心の変位を使っているので、片端→片端に合わせて変位を2倍する
-               */
-              noiseDiff *= 2.0f;
+              /* 違うセルの場合、中心位置を用いる */
+              else {
+                float2 currentCenterNoisePos = {
+                    (noisePos.x - currentOffset.x) / currentSize,
+                    (noisePos.y - currentOffset.y) / currentSize};
+                CellIds centerIds = SimplexNoise::getCellIds(
+                    currentCenterNoisePos.x, currentCenterNoisePos.y,
+                    currentEvolution);
+                if (kinbouIds[0] == centerIds) {
+                  noiseDiff = SimplexNoise::noise(currentCenterNoisePos.x,
+                                                  currentCenterNoisePos.y,
+                                                  currentEvolution) -
+                              SimplexNoise::noise(currentOffsetNoisePos[0].x,
+                                                  currentOffsetNoisePos[0].y,
+                                                  currentEvolution);
+                } else  // if(kinbouIds[1] == centerIds)
+                {
+                  noiseDiff = SimplexNoise::noise(currentOffsetNoisePos[1].x,
+                                                  currentOffsetNoisePos[1].y,
+                                                  currentEvolution) -
+                              SimplexNoise::noise(currentCenterNoisePos.x,
+                                                  currentCenterNoisePos.y,
+                                                  currentEvolution);
+                }
+                /* 片端→中心の変位を使っているので、片端→片端に合わせて変位を2倍する
+                 */
+                noiseDiff *= 2.0f;
+              }
             }
-          }
-          /* 差分に強度を乗算して足しこむ */
-          gradient[yokoTate] += currentIntensity * noiseDiff / p.int_sum;
+            /* 差分に強度を乗算して足しこむ */
+            gradient[yokoTate] += currentIntensity * noiseDiff / p.int_sum;
 
-          currentEvolution *= p.p_evolution;
+            currentEvolution *= p.p_evolution;
+          }
         }
-      }
 
-      /* X方向、Y方向の近傍ベクトルを計算する */
-      float3 vec_x  = {delta * 2, 0.0f, gradient[0] * p.waveHeight};
-      float3 vec_y  = {0.0f, delta * 2, gradient[1] * p.waveHeight};
-      float3 normal = normalize(cross(vec_x, vec_y));
-
-      /* カメラから平面へのベクトル */
-      float3 cam_vec = {noisePos.x - p.cam_pos.x, noisePos.y - p.cam_pos.y,
-                        -p.cam_pos.z};
-      cam_vec = normalize(cam_vec);
-      /* WarpHVの参照画像モード */
-      if (p.renderMode == 2 || p.renderMode == 4) {
-        /* 平面からの反射ベクトル */
-        float alpha        = dot(normal, cam_vec);
-        float3 reflect_cam = {
-            2.0f * alpha * normal.x - cam_vec.x,
-            2.0f * alpha * normal.y - cam_vec.y,
-            2.0f * alpha * normal.z - cam_vec.z}; /* これの長さは１ */
-        /* 完全に水平な面で反射した場合の反射ベクトル */
-        float3 reflect_cam_mirror = {cam_vec.x, cam_vec.y, -cam_vec.z};
-        /* 角度のずれを格納する */
-        /*  -PI/2 ～ PI/2 */
-        float angle_h = atanf(reflect_cam.x / reflect_cam.y) -
-                        atanf(reflect_cam_mirror.x / reflect_cam_mirror.y);
-        float angle_v = atanf(reflect_cam.z / reflect_cam.y) -
-                        atanf(reflect_cam_mirror.z / reflect_cam_mirror.y);
-
-        /* 30°を最大とする */
-        angle_h = 0.5f + angle_h / 0.5236f;
-        angle_v = 0.5f - angle_v / 0.5236f;
-
-        /* クランプ */
-        angle_h = (angle_h < 0.0f) ? 0.0f : ((angle_h > 1.0f) ? 1.0f : angle_h);
-        angle_v = (angle_v < 0.0f) ? 0.0f : ((angle_v > 1.0f) ? 1.0f : angle_v);
-
-        if (p.renderMode == 2) {
-          (*out_p).x = angle_h;
-          (*out_p).y = angle_v;
-          (*out_p).z = 0.0f;
-          (*out_p).w = 1.0f;
-        } else  //  p.renderMode == 4
-        {
-          if (!isSubWave) {
+        /* X方向、Y方向の近傍ベクトルを計算する */
+        float3 vec_x  = {delta * 2, 0.0f, gradient[0] * p.waveHeight};
+        float3 vec_y  = {0.0f, delta * 2, gradient[1] * p.waveHeight};
+        float3 normal = normalize(cross(vec_x, vec_y));
+
+        /* カメラから平面へのベクトル */
+        float3 cam_vec = {noisePos.x - p.cam_pos.x, noisePos.y - p.cam_pos.y,
+                          -p.cam_pos.z};
+        cam_vec = normalize(cam_vec);
+        /* WarpHVの参照画像モード */
+        if (p.renderMode == 2 || p.renderMode == 4) {
+          /* 平面からの反射ベクトル */
+          float alpha        = dot(normal, cam_vec);
+          float3 reflect_cam = {
+              2.0f * alpha * normal.x - cam_vec.x,
+              2.0f * alpha * normal.y - cam_vec.y,
+              2.0f * alpha * normal.z - cam_vec.z}; /* これの長さは１ */
+          /* 完全に水平な面で反射した場合の反射ベクトル */
+          float3 reflect_cam_mirror = {cam_vec.x, cam_vec.y, -cam_vec.z};
+          /* 角度のずれを格納する */
+          /*  -PI/2 ～ PI/2 */
+          float angle_h = atanf(reflect_cam.x / reflect_cam.y) -
+                          atanf(reflect_cam_mirror.x / reflect_cam_mirror.y);
+          float angle_v = atanf(reflect_cam.z / reflect_cam.y) -
+                          atanf(reflect_cam_mirror.z / reflect_cam_mirror.y);
+
+          /* 30°を最大とする */
+          angle_h = 0.5f + angle_h / 0.5236f;
+          angle_v = 0.5f - angle_v / 0.5236f;
+
+          /* クランプ */
+          angle_h =
+              (angle_h < 0.0f) ? 0.0f : ((angle_h > 1.0f) ? 1.0f : angle_h);
+          angle_v =
+              (angle_v < 0.0f) ? 0.0f : ((angle_v > 1.0f) ? 1.0f : angle_v);
+
+          if (p.renderMode == 2) {
+            (*out_p).x = angle_h;
             (*out_p).y = angle_v;
             (*out_p).z = 0.0f;
             (*out_p).w = 1.0f;
-          } else
-            (*out_p).x = angle_v;
+          } else  //  p.renderMode == 4
+          {
+            if (!isSubWave) {
+              (*out_p).y = angle_v;
+              (*out_p).z = 0.0f;
+              (*out_p).w = 1.0f;
+            } else
+              (*out_p).x = angle_v;
+          }
+        }
+        /* フレネル反射モード */
+        else if (p.renderMode == 3) {
+          cam_vec.x *= -1;
+          cam_vec.y *= -1;
+          cam_vec.z *= -1;
+          float diffuse_angle = acosf(dot(normal, cam_vec)) * 180.0f / 3.14159f;
+          float ref           = 0.0f;
+          if (diffuse_angle >= 0.0f && diffuse_angle < 90.0f) {
+            int index   = (int)diffuse_angle;
+            float ratio = diffuse_angle - (float)index;
+            float fresnel_ref =
+                fresnel[index] * (1.0f - ratio) + fresnel[index + 1] * ratio;
+            ref = (fresnel_ref - p.base_fresnel_ref) /
+                  (1.0f - p.base_fresnel_ref);
+          } else if (diffuse_angle >= 90.0f)
+            ref = 1.0f;
+
+          /* クランプ */
+          ref        = (ref < 0.0f) ? 0.0f : ((ref > 1.0f) ? 1.0f : ref);
+          (*out_p).x = ref;
+          (*out_p).y = ref;
+          (*out_p).z = ref;
+          (*out_p).w = (p.alp_rend_sw) ? ref : 1.0f;
         }
-      }
-      /* フレネル反射モード */
-      else if (p.renderMode == 3) {
-        cam_vec.x *= -1;
-        cam_vec.y *= -1;
-        cam_vec.z *= -1;
-        float diffuse_angle = acosf(dot(normal, cam_vec)) * 180.0f / 3.14159f;
-        float ref           = 0.0f;
-        if (diffuse_angle >= 0.0f && diffuse_angle < 90.0f) {
-          int index   = (int)diffuse_angle;
-          float ratio = diffuse_angle - (float)index;
-          float fresnel_ref =
-              fresnel[index] * (1.0f - ratio) + fresnel[index + 1] * ratio;
-          ref =
-              (fresnel_ref - p.base_fresnel_ref) / (1.0f - p.base_fresnel_ref);
-        } else if (diffuse_angle >= 90.0f)
-          ref = 1.0f;
-
-        /* クランプ */
-        ref        = (ref < 0.0f) ? 0.0f : ((ref > 1.0f) ? 1.0f : ref);
-        (*out_p).x = ref;
-        (*out_p).y = ref;
-        (*out_p).z = ref;
-        (*out_p).w = (p.alp_rend_sw) ? ref : 1.0f;
       }
     }
-  }
+  });
 }
 
 //------------------------------------------------------------
@@ -122,8 +122,8 @@ static short permMod12[512] = {
 //----------------------------------------
 double SimplexNoise::noise(double xin, double yin) {
   // Skewing and unskewing factors for 2 dimensions
-  static const double F2 = 0.5 * (sqrt(3.0) - 1.0);
-  static const double G2 = (3.0 - sqrt(3.0)) / 6.0;
+  const double F2 = 0.5 * (sqrt(3.0) - 1.0);
+  const double G2 = (3.0 - sqrt(3.0)) / 6.0;
 
   double n0, n1, n2;  // Noise contributions from the three corners
   // Skew the input space to determine which simplex cell we're in
@@ -199,8 +199,8 @@ double SimplexNoise::noise(double xin, double yin) {
 //----------------------------------------
 double SimplexNoise::noise(double xin, double yin, double zin) {
   // Skewing and unskewing factors for 3 dimensions
-  static const double F3 = 1.0 / 3.0;
-  static const double G3 = 1.0 / 6.0;
+  const double F3 = 1.0 / 3.0;
+  const double G3 = 1.0 / 6.0;
 
   double n0, n1, n2, n3;  // Noise contributions from the four corners
   // Skew the input space to determine which simplex cell we're in
@@ -337,8 +337,8 @@ double SimplexNoise::noise(double xin, double yin, double zin) {
 //----------------------------------------
 double SimplexNoise::noise(double x, double y, double z, double w) {
   // Skewing and unskewing factors for 4 dimensions
-  static const double F4 = (sqrt(5.0) - 1.0) / 4.0;
-  static const double G4 = (5.0 - sqrt(5.0)) / 20.0;
+  const double F4 = (sqrt(5.0) - 1.0) / 4.0;
+  const double G4 = (5.0 - sqrt(5.0)) / 20.0;
 
   // The skewing and unskewing factors are hairy again for the 4D case
   double n0, n1, n2, n3, n4;  // Noise contributions from the five corners
@@ -11,22 +11,27 @@ Inherits Iwa_SpectrumFx.
 #include "iwa_xyz.h"
 
 #include "trop.h"
+#include "tthread.h"
 
 #include <QList>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QPoint>
 #include <QSize>
 #include <QRect>
 
+#include <algorithm>
+#include <vector>
+
 namespace {
 const float PI = 3.14159265f;
 
 #define INF 1e20 /* less than FLT_MAX */
 
-/* dt of 1d function using squared distance */
-static float* dt(float* f, int n, float a = 1.0f) {
-  float* d = new float[n];
-  int* v   = new int[n];
-  float* z = new float[n + 1];
+/* dt of 1d function using squared distance.
+   v and z are work buffers of n and n + 1 elements. */
+static void dt(const float* f, float* d, int* v, float* z, int n,
+               float a = 1.0f) {
   /* index of rightmost parabola in lower envelope */
   int k = 0;
   /* locations of parabolas in lower envelope */
@@ -55,10 +60,41 @@ static float* dt(float* f, int n, float a = 1.0f) {
     while (z[k + 1] < q) k++;
     d[q] = a * (q - v[k]) * (q - v[k]) + f[v[k]];
   }
+}
+
+/* row and column bands each get their own work buffers */
+struct DtBuffers {
+  std::vector<float> f, d, z;
+  std::vector<int> v;
+  DtBuffers(int n) : f(n), d(n), z(n + 1), v(n) {}
+  void run(int n, float a) {
+    dt(f.data(), d.data(), v.data(), z.data(), n, a);
+  }
+};
+
+/* nonzero span [begin, end) of each row of the blur filter */
+struct FilterSpan {
+  int begin, end;
+};
+
+/* The noise phase differences, drawn from srand(0) / rand() and kept for
+   the following renders. Drawing them under the lock keeps concurrent
+   renders from interleaving their rand() calls. */
+QMutex noise_phases_mutex;
+std::vector<float> noise_phases;
+
+void get_noise_phases(std::vector<float>& phases, int count) {
+  QMutexLocker locker(&noise_phases_mutex);
+
+  if ((int)noise_phases.size() < count) {
+    noise_phases.resize(count);
+    srand(0);
+    /* Set the phase differences (0-2) */
+    for (int i = 0; i < count; i++)
+      noise_phases[i] = (float)rand() / (float)RAND_MAX * 2.0f * PI;
+  }
 
-  delete[] v;
-  delete[] z;
-  return d;
+  phases.assign(noise_phases.begin(), noise_phases.begin() + count);
 }
 }
 
@@ -284,22 +320,24 @@ void Iwa_SoapBubbleFx::doCompute(TTile& tile, double frame,
 template <typename RASTER, typename PIXEL>
 void Iwa_SoapBubbleFx::convertToBrightness(const RASTER srcRas, float* dst,
                                            float* alpha, TDimensionI dim) {
-  float* dst_p   = dst;
-  float* alpha_p = alpha;
-  for (int j = 0; j < dim.ly; j++) {
-    PIXEL* pix = srcRas->pixels(j);
-    for (int i = 0; i < dim.lx; i++, dst_p++, pix++) {
-      float r = (float)pix->r / (float)PIXEL::maxChannelValue;
-      float g = (float)pix->g / (float)PIXEL::maxChannelValue;
-      float b = (float)pix->b / (float)PIXEL::maxChannelValue;
-      /* brightness */
-      *dst_p = 0.298912f * r + 0.586611f * g + 0.114478f * b;
-      if (alpha) {
-        *alpha_p = (float)pix->m / (float)PIXEL::maxChannelValue;
-        alpha_p++;
+  TThread::runInBands(dim.lx, dim.ly, [&](int y0, int y1) {
+    float* dst_p   = dst + y0 * dim.lx;
+    float* alpha_p = (alpha) ? alpha + y0 * dim.lx : nullptr;
+    for (int j = y0; j < y1; j++) {
+      PIXEL* pix = srcRas->pixels(j);
+      for (int i = 0; i < dim.lx; i++, dst_p++, pix++) {
+        float r = (float)pix->r / (float)PIXEL::maxChannelValue;
+        float g = (float)pix->g / (float)PIXEL::maxChannelValue;
+        float b = (float)pix->b / (float)PIXEL::maxChannelValue;
+        /* brightness */
+        *dst_p = 0.298912f * r + 0.586611f * g + 0.114478f * b;
+        if (alpha) {
+          *alpha_p = (float)pix->m / (float)PIXEL::maxChannelValue;
+          alpha_p++;
+        }
       }
     }
-  }
+  });
 }
 
 //------------------------------------
@@ -308,100 +346,106 @@ template <typename RASTER, typename PIXEL>
 void Iwa_SoapBubbleFx::convertToRaster(const RASTER ras, float* thickness_map_p,
                                        float* depth_map_p, float* alpha_map_p,
                                        TDimensionI dim, float3* bubbleColor_p) {
-  int renderMode     = m_renderMode->getValue();
-  float* depth_p     = depth_map_p;
-  float* thickness_p = thickness_map_p;
-  float* alpha_p     = alpha_map_p;
-  for (int j = 0; j < dim.ly; j++) {
-    PIXEL* pix = ras->pixels(j);
-    for (int i = 0; i < dim.lx;
-         i++, depth_p++, thickness_p++, alpha_p++, pix++) {
-      float alpha = (*alpha_p);
-      if (!m_fit_thickness->getValue())
-        alpha *= (float)pix->m / (float)PIXEL::maxChannelValue;
-      if (alpha == 0.0f) { /* no change for the transparent pixels */
-        pix->m = (typename PIXEL::Channel)0;
-        continue;
-      }
+  int renderMode    = m_renderMode->getValue();
+  bool fitThickness = m_fit_thickness->getValue();
+  TThread::runInBands(dim.lx, dim.ly, [&](int y0, int y1) {
+    float* depth_p     = depth_map_p + y0 * dim.lx;
+    float* thickness_p = thickness_map_p + y0 * dim.lx;
+    float* alpha_p     = alpha_map_p + y0 * dim.lx;
+    for (int j = y0; j < y1; j++) {
+      PIXEL* pix = ras->pixels(j);
+      for (int i = 0; i < dim.lx;
+           i++, depth_p++, thickness_p++, alpha_p++, pix++) {
+        float alpha = (*alpha_p);
+        if (!fitThickness)
+          alpha *= (float)pix->m / (float)PIXEL::maxChannelValue;
+        if (alpha == 0.0f) { /* no change for the transparent pixels */
+          pix->m = (typename PIXEL::Channel)0;
+          continue;
+        }
 
-      // thickness and depth render mode
-      if (renderMode != RENDER_MODE_BUBBLE) {
+        // thickness and depth render mode
+        if (renderMode != RENDER_MODE_BUBBLE) {
+          float val = alpha * (float)PIXEL::maxChannelValue + 0.5f;
+          pix->m =
+              (typename PIXEL::Channel)((val > (float)PIXEL::maxChannelValue)
+                                            ? (float)PIXEL::maxChannelValue
+                                            : val);
+          float mapVal = (renderMode == RENDER_MODE_THICKNESS) ? (*thickness_p)
+                                                               : (*depth_p);
+          val = alpha * mapVal * (float)PIXEL::maxChannelValue + 0.5f;
+          typename PIXEL::Channel chanVal =
+              (typename PIXEL::Channel)((val > (float)PIXEL::maxChannelValue)
+                                            ? (float)PIXEL::maxChannelValue
+                                            : val);
+          pix->r = chanVal;
+          pix->g = chanVal;
+          pix->b = chanVal;
+          continue;
+        }
+
+        float coordinate[2];
+        coordinate[0] = 256.0f * std::min(1.0f, *depth_p);
+        coordinate[1] = 256.0f * std::min(1.0f, *thickness_p);
+
+        int neighbors[2][2];
+
+        /* interpolate sampling */
+        if (coordinate[0] <= 0.5f)
+          neighbors[0][0] = 0;
+        else
+          neighbors[0][0] = (int)std::floor(coordinate[0] - 0.5f);
+        if (coordinate[0] >= 255.5f)
+          neighbors[0][1] = 255;
+        else
+          neighbors[0][1] = (int)std::floor(coordinate[0] + 0.5f);
+        if (coordinate[1] <= 0.5f)
+          neighbors[1][0] = 0;
+        else
+          neighbors[1][0] = (int)std::floor(coordinate[1] - 0.5f);
+        if (coordinate[1] >= 255.5f)
+          neighbors[1][1] = 255;
+        else
+          neighbors[1][1] = (int)std::floor(coordinate[1] + 0.5f);
+
+        float interp_ratio[2];
+        interp_ratio[0] =
+            coordinate[0] - 0.5f - std::floor(coordinate[0] - 0.5f);
+        interp_ratio[1] =
+            coordinate[1] - 0.5f - std::floor(coordinate[1] - 0.5f);
+
+        float3 nColors[4] = {
+            bubbleColor_p[neighbors[0][0] * 256 + neighbors[1][0]],
+            bubbleColor_p[neighbors[0][1] * 256 + neighbors[1][0]],
+            bubbleColor_p[neighbors[0][0] * 256 + neighbors[1][1]],
+            bubbleColor_p[neighbors[0][1] * 256 + neighbors[1][1]]};
+
+        float3 color =
+            nColors[0] * (1.0f - interp_ratio[0]) * (1.0f - interp_ratio[1]) +
+            nColors[1] * interp_ratio[0] * (1.0f - interp_ratio[1]) +
+            nColors[2] * (1.0f - interp_ratio[0]) * interp_ratio[1] +
+            nColors[3] * interp_ratio[0] * interp_ratio[1];
+
+        /* clamp */
         float val = alpha * (float)PIXEL::maxChannelValue + 0.5f;
         pix->m = (typename PIXEL::Channel)((val > (float)PIXEL::maxChannelValue)
                                                ? (float)PIXEL::maxChannelValue
                                                : val);
-        float mapVal =
-            (renderMode == RENDER_MODE_THICKNESS) ? (*thickness_p) : (*depth_p);
-        val = alpha * mapVal * (float)PIXEL::maxChannelValue + 0.5f;
-        typename PIXEL::Channel chanVal =
-            (typename PIXEL::Channel)((val > (float)PIXEL::maxChannelValue)
-                                          ? (float)PIXEL::maxChannelValue
-                                          : val);
-        pix->r = chanVal;
-        pix->g = chanVal;
-        pix->b = chanVal;
-        continue;
+        val    = alpha * color.x * (float)PIXEL::maxChannelValue + 0.5f;
+        pix->r = (typename PIXEL::Channel)((val > (float)PIXEL::maxChannelValue)
+                                               ? (float)PIXEL::maxChannelValue
+                                               : val);
+        val    = alpha * color.y * (float)PIXEL::maxChannelValue + 0.5f;
+        pix->g = (typename PIXEL::Channel)((val > (float)PIXEL::maxChannelValue)
+                                               ? (float)PIXEL::maxChannelValue
+                                               : val);
+        val    = alpha * color.z * (float)PIXEL::maxChannelValue + 0.5f;
+        pix->b = (typename PIXEL::Channel)((val > (float)PIXEL::maxChannelValue)
+                                               ? (float)PIXEL::maxChannelValue
+                                               : val);
       }
-
-      float coordinate[2];
-      coordinate[0] = 256.0f * std::min(1.0f, *depth_p);
-      coordinate[1] = 256.0f * std::min(1.0f, *thickness_p);
-
-      int neighbors[2][2];
-
-      /* interpolate sampling */
-      if (coordinate[0] <= 0.5f)
-        neighbors[0][0] = 0;
-      else
-        neighbors[0][0] = (int)std::floor(coordinate[0] - 0.5f);
-      if (coordinate[0] >= 255.5f)
-        neighbors[0][1] = 255;
-      else
-        neighbors[0][1] = (int)std::floor(coordinate[0] + 0.5f);
-      if (coordinate[1] <= 0.5f)
-        neighbors[1][0] = 0;
-      else
-        neighbors[1][0] = (int)std::floor(coordinate[1] - 0.5f);
-      if (coordinate[1] >= 255.5f)
-        neighbors[1][1] = 255;
-      else
-        neighbors[1][1] = (int)std::floor(coordinate[1] + 0.5f);
-
-      float interp_ratio[2];
-      interp_ratio[0] = coordinate[0] - 0.5f - std::floor(coordinate[0] - 0.5f);
-      interp_ratio[1] = coordinate[1] - 0.5f - std::floor(coordinate[1] - 0.5f);
-
-      float3 nColors[4] = {
-          bubbleColor_p[neighbors[0][0] * 256 + neighbors[1][0]],
-          bubbleColor_p[neighbors[0][1] * 256 + neighbors[1][0]],
-          bubbleColor_p[neighbors[0][0] * 256 + neighbors[1][1]],
-          bubbleColor_p[neighbors[0][1] * 256 + neighbors[1][1]]};
-
-      float3 color =
-          nColors[0] * (1.0f - interp_ratio[0]) * (1.0f - interp_ratio[1]) +
-          nColors[1] * interp_ratio[0] * (1.0f - interp_ratio[1]) +
-          nColors[2] * (1.0f - interp_ratio[0]) * interp_ratio[1] +
-          nColors[3] * interp_ratio[0] * interp_ratio[1];
-
-      /* clamp */
-      float val = alpha * (float)PIXEL::maxChannelValue + 0.5f;
-      pix->m = (typename PIXEL::Channel)((val > (float)PIXEL::maxChannelValue)
-                                             ? (float)PIXEL::maxChannelValue
-                                             : val);
-      val    = alpha * color.x * (float)PIXEL::maxChannelValue + 0.5f;
-      pix->r = (typename PIXEL::Channel)((val > (float)PIXEL::maxChannelValue)
-                                             ? (float)PIXEL::maxChannelValue
-                                             : val);
-      val    = alpha * color.y * (float)PIXEL::maxChannelValue + 0.5f;
-      pix->g = (typename PIXEL::Channel)((val > (float)PIXEL::maxChannelValue)
-                                             ? (float)PIXEL::maxChannelValue
-                                             : val);
-      val    = alpha * color.z * (float)PIXEL::maxChannelValue + 0.5f;
-      pix->b = (typename PIXEL::Channel)((val > (float)PIXEL::maxChannelValue)
-                                             ? (float)PIXEL::maxChannelValue
-                                             : val);
     }
-  }
+  });
 }
 
 //------------------------------------
@@ -449,17 +493,19 @@ void Iwa_SoapBubbleFx::processShape(double frame, TTile& shape_tile,
 
   /* if blur radius is 0, set the distance image to the depth image as-is */
   if (blur_radius == 0.0f) {
-    float power      = (float)m_blur_power->getValue(frame);
-    float* tmp_depth = depth_map_p;
-    float* tmp_dist  = distance_p;
-    USHORT* rid_p    = regionIds_p;
-    for (int i = 0; i < dim.lx * dim.ly;
-         i++, tmp_depth++, tmp_dist++, rid_p++) {
-      if (*rid_p == 0)
-        *tmp_depth = 0.0f;
-      else
-        *tmp_depth = 1.0f - std::pow(*tmp_dist, power);
-    }
+    float power = (float)m_blur_power->getValue(frame);
+    TThread::runInBands(dim.lx, dim.ly, [&](int y0, int y1) {
+      float* tmp_depth = depth_map_p + y0 * dim.lx;
+      float* tmp_dist  = distance_p + y0 * dim.lx;
+      USHORT* rid_p    = regionIds_p + y0 * dim.lx;
+      for (int i = y0 * dim.lx; i < y1 * dim.lx;
+           i++, tmp_depth++, tmp_dist++, rid_p++) {
+        if (*rid_p == 0)
+          *tmp_depth = 0.0f;
+        else
+          *tmp_depth = 1.0f - std::pow(*tmp_dist, power);
+      }
+    });
     distance_ras->unlock();
     return;
   }
@@ -494,17 +540,19 @@ int Iwa_SoapBubbleFx::do_binarize(TRaster32P srcRas, USHORT* dst_p, float thres,
                                   TDimensionI dim) {
   TPixel32::Channel channelThres =
       (TPixel32::Channel)(thres * (float)TPixel32::maxChannelValue);
-  USHORT* tmp_p   = dst_p;
-  float* tmp_dist = distance_p;
-  float* alpha_p  = alpha_map_p;
-  for (int j = 0; j < dim.ly; j++) {
-    TPixel32* pix = srcRas->pixels(j);
-    for (int i = 0; i < dim.lx; i++, pix++, tmp_p++, tmp_dist++, alpha_p++) {
-      (*tmp_p)    = (pix->m > channelThres) ? 1 : 0;
-      (*tmp_dist) = (*tmp_p == 1) ? INF : 0.0f;
-      *alpha_p    = (float)pix->m / (float)TPixel32::maxChannelValue;
+  TThread::runInBands(dim.lx, dim.ly, [&](int y0, int y1) {
+    USHORT* tmp_p   = dst_p + y0 * dim.lx;
+    float* tmp_dist = distance_p + y0 * dim.lx;
+    float* alpha_p  = alpha_map_p + y0 * dim.lx;
+    for (int j = y0; j < y1; j++) {
+      TPixel32* pix = srcRas->pixels(j);
+      for (int i = 0; i < dim.lx; i++, pix++, tmp_p++, tmp_dist++, alpha_p++) {
+        (*tmp_p)    = (pix->m > channelThres) ? 1 : 0;
+        (*tmp_dist) = (*tmp_p == 1) ? INF : 0.0f;
+        *alpha_p    = (float)pix->m / (float)TPixel32::maxChannelValue;
+      }
     }
-  }
+  });
 
   // label regions when multi bubble option is on
   if (!m_multi_source->getValue()) {
@@ -531,7 +579,7 @@ int Iwa_SoapBubbleFx::do_binarize(TRaster32P srcRas, USHORT* dst_p, float thres,
 
   QList<int> lut;
   for (int i      = 0; i < 65536; i++) lut.append(i);
-  tmp_p           = dst_p;
+  USHORT* tmp_p   = dst_p;
   int regionCount = 0;
   for (int j = 0; j < dim.ly; j++) {
     for (int i = 0; i < dim.lx; i++, tmp_p++) {
@@ -648,32 +696,52 @@ void Iwa_SoapBubbleFx::do_applyFilter(float* depth_map_p, TDimensionI dim,
                                       const TRenderSettings& settings) {
   float power = (float)m_blur_power->getValue(frame);
 
-  memset(depth_map_p, 0, sizeof(float) * dim.lx * dim.ly);
-
+  /* The filter is a cone inside a circle, thus not separable. Instead, only
+     the nonzero span of each filter row is scanned. Zeros are skipped in the
+     same order as before, so the sums are unchanged. */
   int fil_margin = (blur_filter_size - 1) / 2;
-  float* dst_p   = depth_map_p;
-  USHORT* bin_p  = binarized_p;
-  for (int j = 0; j < dim.ly; j++) {
-    for (int i = 0; i < dim.lx; i++, dst_p++, bin_p++) {
-      if (*bin_p == 0) continue;
+  std::vector<FilterSpan> spans(blur_filter_size);
+  for (int fy = 0; fy < blur_filter_size; fy++) {
+    float* fil_p = blur_filter_p + fy * blur_filter_size;
+    int begin    = 0;
+    int end      = blur_filter_size;
+    while (begin < end && fil_p[begin] == 0.0f) begin++;
+    while (end > begin && fil_p[end - 1] == 0.0f) end--;
+    FilterSpan span = {begin, end};
+    spans[fy]       = span;
+  }
+
+  TThread::runInBands(dim.lx, dim.ly, [&](int y0, int y1) {
+    float* dst_p  = depth_map_p + y0 * dim.lx;
+    USHORT* bin_p = binarized_p + y0 * dim.lx;
+    for (int j = y0; j < y1; j++) {
+      if (settings.m_isCanceled && *settings.m_isCanceled) return;
 
-      float* fil_p = blur_filter_p;
-      for (int fy = j - fil_margin; fy <= j + fil_margin; fy++) {
-        if (fy < 0 || fy >= dim.ly) {
-          fil_p += blur_filter_size;
+      for (int i = 0; i < dim.lx; i++, dst_p++, bin_p++) {
+        if (*bin_p == 0) {
+          *dst_p = 0.0f;
           continue;
         }
-        for (int fx = i - fil_margin; fx <= i + fil_margin; fx++, fil_p++) {
-          if (fx < 0 || fx >= dim.lx) continue;
 
-          *dst_p += *fil_p * distance_p[fy * dim.lx + fx];
+        float sum = 0.0f;
+        for (int fy = std::max(0, fil_margin - j);
+             fy < std::min(blur_filter_size, dim.ly - j + fil_margin); fy++) {
+          const FilterSpan& span = spans[fy];
+          /* clip the span to the image */
+          int begin = std::max(span.begin, fil_margin - i);
+          int end   = std::min(span.end, dim.lx - i + fil_margin);
+          if (begin >= end) continue;
+          const float* fil_p = blur_filter_p + fy * blur_filter_size + begin;
+          const float* dist_p =
+              distance_p + (j - fil_margin + fy) * dim.lx + i - fil_margin;
+          for (int fx = begin; fx < end; fx++, fil_p++)
+            sum += *fil_p * dist_p[fx];
         }
+        /* power the value */
+        *dst_p = 1.0f - std::pow(sum, power);
       }
-      /* power the value */
-      *dst_p = 1.0f - std::pow(*dst_p, power);
     }
-    if (settings.m_isCanceled && *settings.m_isCanceled) return;
-  }
+  });
 }
 
 //------------------------------------
@@ -713,14 +781,9 @@ void Iwa_SoapBubbleFx::processNoise(float* thickness_map_p, float* depth_map_p,
     whole_noise_amount += amount;
   }
 
-  float* noise_phases = new float[whole_noise_amount];
-  float* ph_p         = noise_phases;
-
-  srand(0);
-  /* Set the phase differences (0-2) */
-  for (int i = 0; i < whole_noise_amount; i++, ph_p++) {
-    *ph_p = (float)rand() / (float)RAND_MAX * 2.0f * PI;
-  }
+  std::vector<float> noise_phases;
+  get_noise_phases(noise_phases, whole_noise_amount);
+  const float* ph_p = noise_phases.data();
 
   /* make noise base */
   /* compute composite ratio of each layer */
@@ -734,10 +797,11 @@ void Iwa_SoapBubbleFx::processNoise(float* thickness_map_p, float* depth_map_p,
   /* normalize */
   for (int i = 0; i < noise_sub_depth; i++) comp_ratios[i] /= ratio_sum;
 
-  float* noise_base = new float[whole_noise_amount];
+  TRasterGR8P noise_base_ras(sizeof(float) * whole_noise_amount, 1);
+  noise_base_ras->lock();
+  float* noise_base = (float*)noise_base_ras->getRawData();
 
   float* nb_p = noise_base;
-  ph_p        = noise_phases;
 
   /* for each sub-noise layer */
   for (int layer = 0; layer < noise_sub_depth; layer++) {
@@ -746,7 +810,6 @@ void Iwa_SoapBubbleFx::processNoise(float* thickness_map_p, float* depth_map_p,
       *nb_p = comp_ratios[layer] * (cosf(tmp_evolution + *ph_p) / 2.0f + 0.5f);
     }
   }
-  delete[] noise_phases;
 
   TRasterGR8P norm_angle_ras(sizeof(float) * dim.lx * dim.ly, 1);
   norm_angle_ras->lock();
@@ -762,7 +825,7 @@ void Iwa_SoapBubbleFx::processNoise(float* thickness_map_p, float* depth_map_p,
                  noise_base_resolution, noise_sub_depth, noise_base);
 
   norm_angle_ras->unlock();
-  delete[] noise_base;
+  noise_base_ras->unlock();
 
   /* composite with perlin noise */
   add_noise(thickness_map_p, depth_map_p, dim, noise_map_p,
@@ -786,33 +849,34 @@ void Iwa_SoapBubbleFx::calc_norm_angle(float* norm_angle_p, float* depth_map_p,
 
   int sampleDistance =
       std::max(1, m_normal_sample_distance->getValue() / shrink);
-  float* dst_p = norm_angle_p;
 
-  for (int j = 0; j < dim.ly; j++) {
-    int sample_y[2]                  = {j - sampleDistance, j + sampleDistance};
-    if (sample_y[0] < 0) sample_y[0] = 0;
-    if (sample_y[1] >= dim.ly) sample_y[1] = dim.ly - 1;
-
-    for (int i = 0; i < dim.lx; i++, norm_angle_p++) {
-      int sample_x[2] = {i - sampleDistance, i + sampleDistance};
-      if (sample_x[1] >= dim.lx) sample_x[1] = dim.lx - 1;
-      if (sample_x[0] < 0) sample_x[0]       = 0;
-
-      float gradient[2];
-      gradient[0] =
-          (locals.data(sample_x[0], j) - locals.data(sample_x[1], j)) /
-          (float)(sample_x[0] - sample_x[1]);
-      gradient[1] =
-          (locals.data(i, sample_y[0]) - locals.data(i, sample_y[1])) /
-          (float)(sample_y[0] - sample_y[1]);
-
-      if (gradient[0] == 0.0f && gradient[1] == 0.0f)
-        *norm_angle_p = 0.0f;
-      else /* normalize value range to 0-1 */
-        *norm_angle_p =
-            0.5f + std::atan2(gradient[0], gradient[1]) / (2.0f * PI);
+  TThread::runInBands(dim.lx, dim.ly, [&](int y0, int y1) {
+    float* dst_p = norm_angle_p + y0 * dim.lx;
+    for (int j = y0; j < y1; j++) {
+      int sample_y[2] = {j - sampleDistance, j + sampleDistance};
+      if (sample_y[0] < 0) sample_y[0] = 0;
+      if (sample_y[1] >= dim.ly) sample_y[1] = dim.ly - 1;
+
+      for (int i = 0; i < dim.lx; i++, dst_p++) {
+        int sample_x[2] = {i - sampleDistance, i + sampleDistance};
+        if (sample_x[1] >= dim.lx) sample_x[1] = dim.lx - 1;
+        if (sample_x[0] < 0) sample_x[0]       = 0;
+
+        float gradient[2];
+        gradient[0] =
+            (locals.data(sample_x[0], j) - locals.data(sample_x[1], j)) /
+            (float)(sample_x[0] - sample_x[1]);
+        gradient[1] =
+            (locals.data(i, sample_y[0]) - locals.data(i, sample_y[1])) /
+            (float)(sample_y[0] - sample_y[1]);
+
+        if (gradient[0] == 0.0f && gradient[1] == 0.0f)
+          *dst_p = 0.0f;
+        else /* normalize value range to 0-1 */
+          *dst_p = 0.5f + std::atan2(gradient[0], gradient[1]) / (2.0f * PI);
+      }
     }
-  }
+  });
 }
 
 //------------------------------------
@@ -822,52 +886,54 @@ void Iwa_SoapBubbleFx::make_noise_map(float* noise_map_p, float* depth_map_p,
                                       const QList<int>& noise_amount,
                                       const QList<QSize>& noise_base_resolution,
                                       int noise_sub_depth, float* noise_base) {
-  float* dst_p   = noise_map_p;
-  float* depth_p = depth_map_p;
-  float* norm_p  = norm_angle_p;
-
-  for (int j = 0; j < dim.ly; j++) {
-    for (int i = 0; i < dim.lx; i++, dst_p++, depth_p++, norm_p++) {
-      /* Obtain coordinate */
-      /* circumferential direction */
-      float tmp_s = (*norm_p);
-      /* distal direction */
-      float tmp_t = std::min(1.0f, *depth_p);
-
-      /* accumulate noise values */
-      *dst_p                  = 0.0f;
-      float* noise_layer_base = noise_base;
-      for (int layer = 0; layer < noise_sub_depth; layer++) {
-        /* obtain pseudo polar coords */
-        QSize reso = noise_base_resolution.at(layer);
-        float polar_s =
-            tmp_s * (float)(reso.width()); /* because it is circumferential */
-        float polar_t = tmp_t * (float)(reso.height() - 1);
-
-        /* first, compute circumferential position and ratio */
-        int neighbor_s[2];
-        neighbor_s[0] = (int)std::floor(polar_s);
-        neighbor_s[1] = neighbor_s[0] + 1;
-        if (neighbor_s[0] == reso.width()) neighbor_s[0] = 0;
-        if (neighbor_s[1] >= reso.width()) neighbor_s[1] = 0;
-        float ratio_s = polar_s - std::floor(polar_s);
-
-        /* second, compute distal position and ratio */
-        int neighbor_t[2];
-        neighbor_t[0] = (int)std::floor(polar_t);
-        neighbor_t[1] = neighbor_t[0] + 1;
-        if (neighbor_t[1] == reso.height()) neighbor_t[1] -= 1;
-        float ratio_t = polar_t - std::floor(polar_t);
-
-        *dst_p += noise_interp(neighbor_s[0], neighbor_s[1], neighbor_t[0],
-                               neighbor_t[1], ratio_s, ratio_t,
-                               noise_layer_base, reso.width());
-
-        /* offset noise pointer */
-        noise_layer_base += noise_amount[layer];
+  TThread::runInBands(dim.lx, dim.ly, [&](int y0, int y1) {
+    float* dst_p   = noise_map_p + y0 * dim.lx;
+    float* depth_p = depth_map_p + y0 * dim.lx;
+    float* norm_p  = norm_angle_p + y0 * dim.lx;
+
+    for (int j = y0; j < y1; j++) {
+      for (int i = 0; i < dim.lx; i++, dst_p++, depth_p++, norm_p++) {
+        /* Obtain coordinate */
+        /* circumferential direction */
+        float tmp_s = (*norm_p);
+        /* distal direction */
+        float tmp_t = std::min(1.0f, *depth_p);
+
+        /* accumulate noise values */
+        *dst_p                  = 0.0f;
+        float* noise_layer_base = noise_base;
+        for (int layer = 0; layer < noise_sub_depth; layer++) {
+          /* obtain pseudo polar coords */
+          QSize reso = noise_base_resolution.at(layer);
+          float polar_s =
+              tmp_s * (float)(reso.width()); /* because it is circumferential */
+          float polar_t = tmp_t * (float)(reso.height() - 1);
+
+          /* first, compute circumferential position and ratio */
+          int neighbor_s[2];
+          neighbor_s[0] = (int)std::floor(polar_s);
+          neighbor_s[1] = neighbor_s[0] + 1;
+          if (neighbor_s[0] == reso.width()) neighbor_s[0] = 0;
+          if (neighbor_s[1] >= reso.width()) neighbor_s[1] = 0;
+          float ratio_s = polar_s - std::floor(polar_s);
+
+          /* second, compute distal position and ratio */
+          int neighbor_t[2];
+          neighbor_t[0] = (int)std::floor(polar_t);
+          neighbor_t[1] = neighbor_t[0] + 1;
+          if (neighbor_t[1] == reso.height()) neighbor_t[1] -= 1;
+          float ratio_t = polar_t - std::floor(polar_t);
+
+          *dst_p += noise_interp(neighbor_s[0], neighbor_s[1], neighbor_t[0],
+                                 neighbor_t[1], ratio_s, ratio_t,
+                                 noise_layer_base, reso.width());
+
+          /* offset noise pointer */
+          noise_layer_base += noise_amount[layer];
+        }
       }
     }
-  }
+  });
 }
 
 //------------------------------------
@@ -898,19 +964,21 @@ void Iwa_SoapBubbleFx::add_noise(float* thickness_map_p, float* depth_map_p,
                                  float noise_depth_mix_ratio) {
   float one_minus_thickness_ratio = 1.0f - noise_thickness_mix_ratio;
   float one_minus_depth_ratio     = 1.0f - noise_depth_mix_ratio;
-  float* tmp_thickness            = thickness_map_p;
-  float* tmp_depth                = depth_map_p;
-  float* tmp_noise                = noise_map_p;
-
-  for (int j = 0; j < dim.ly; j++) {
-    for (int i = 0; i < dim.lx;
-         i++, tmp_thickness++, tmp_depth++, tmp_noise++) {
-      *tmp_thickness = *tmp_noise * noise_thickness_mix_ratio +
-                       *tmp_thickness * one_minus_thickness_ratio;
-      *tmp_depth = *tmp_noise * noise_depth_mix_ratio +
-                   *tmp_depth * one_minus_depth_ratio;
+  TThread::runInBands(dim.lx, dim.ly, [&](int y0, int y1) {
+    float* tmp_thickness = thickness_map_p + y0 * dim.lx;
+    float* tmp_depth     = depth_map_p + y0 * dim.lx;
+    float* tmp_noise     = noise_map_p + y0 * dim.lx;
+
+    for (int j = y0; j < y1; j++) {
+      for (int i = 0; i < dim.lx;
+           i++, tmp_thickness++, tmp_depth++, tmp_noise++) {
+        *tmp_thickness = *tmp_noise * noise_thickness_mix_ratio +
+                         *tmp_thickness * one_minus_thickness_ratio;
+        *tmp_depth = *tmp_noise * noise_depth_mix_ratio +
+                     *tmp_depth * one_minus_depth_ratio;
+      }
     }
-  }
+  });
 }
 //------------------------------------
 
@@ -919,51 +987,51 @@ void Iwa_SoapBubbleFx::do_distance_transform(float* dst_p, USHORT* binarized_p,
                                              double frame) {
   float ar = (float)m_shape_aspect_ratio->getValue(frame);
 
-  float* f = new float[std::max(dim.lx, dim.ly)];
-
-  QList<float> max_val;
-  for (int r = 0; r <= regionCount; r++) max_val.append(0.0f);
-
-  float* tmp_dst = dst_p;
   /* transform along rows */
-  for (int j = 0; j < dim.ly; j++) {
-    for (int i = 0; i < dim.lx; i++, tmp_dst++) {
-      f[i] = *tmp_dst;
-    }
-
-    tmp_dst -= dim.lx;
-
-    float* d = dt(f, dim.lx);
-    for (int i = 0; i < dim.lx; i++, tmp_dst++) {
-      *tmp_dst = d[i];
-    }
-    delete[] d;
-  }
-  /* transform along columns */
-  for (int i = 0; i < dim.lx; i++) {
-    for (int j = 0; j < dim.ly; j++) {
-      f[j] = dst_p[j * dim.lx + i];
+  TThread::runInBands(dim.lx, dim.ly, [&](int y0, int y1) {
+    DtBuffers buf(dim.lx);
+    for (int j = y0; j < y1; j++) {
+      float* row_p = dst_p + j * dim.lx;
+      std::copy(row_p, row_p + dim.lx, buf.f.begin());
+      buf.run(dim.lx, 1.0f);
+      std::copy(buf.d.begin(), buf.d.end(), row_p);
     }
-    float* d =
-        dt(f, dim.ly,
-           ar); /* ar : taking account of the aspect ratio of the shape */
-    for (int j = 0; j < dim.ly; j++) {
-      dst_p[j * dim.lx + i] = d[j];
-      int regionId          = binarized_p[j * dim.lx + i];
-      if (d[j] > max_val[regionId]) max_val[regionId] = d[j];
+  });
+
+  std::vector<float> max_val(regionCount + 1, 0.0f);
+  QMutex max_val_mutex;
+
+  /* transform along columns. columns are split into bands in the same way */
+  TThread::runInBands(dim.ly, dim.lx, [&](int x0, int x1) {
+    DtBuffers buf(dim.ly);
+    std::vector<float> band_max_val(regionCount + 1, 0.0f);
+    for (int i = x0; i < x1; i++) {
+      for (int j = 0; j < dim.ly; j++) buf.f[j] = dst_p[j * dim.lx + i];
+      /* ar : taking account of the aspect ratio of the shape */
+      buf.run(dim.ly, ar);
+      for (int j = 0; j < dim.ly; j++) {
+        float d               = buf.d[j];
+        dst_p[j * dim.lx + i] = d;
+        int regionId          = binarized_p[j * dim.lx + i];
+        if (d > band_max_val[regionId]) band_max_val[regionId] = d;
+      }
     }
-    delete[] d;
-  }
+    QMutexLocker locker(&max_val_mutex);
+    for (int r = 0; r <= regionCount; r++)
+      max_val[r] = std::max(max_val[r], band_max_val[r]);
+  });
 
-  tmp_dst = dst_p;
   for (int r = 0; r <= regionCount; r++) max_val[r] = std::sqrt(max_val[r]);
 
   /* square root and normalize */
-  USHORT* region_p = binarized_p;
-  for (int i = 0; i < dim.lx * dim.ly; i++, tmp_dst++, region_p++) {
-    if (max_val[*region_p] > 0)
-      *tmp_dst = std::sqrt(*tmp_dst) / max_val[*region_p];
-  }
+  TThread::runInBands(dim.lx, dim.ly, [&](int y0, int y1) {
+    float* tmp_dst   = dst_p + y0 * dim.lx;
+    USHORT* region_p = binarized_p + y0 * dim.lx;
+    for (int i = y0 * dim.lx; i < y1 * dim.lx; i++, tmp_dst++, region_p++) {
+      if (max_val[*region_p] > 0)
+        *tmp_dst = std::sqrt(*tmp_dst) / max_val[*region_p];
+    }
+  });
 }
 //------------------------------------
 
@@ -983,12 +1051,14 @@ bool Iwa_SoapBubbleFx::checkCancelAndReleaseRaster(
 void Iwa_SoapBubbleFx::applyDistanceToAlpha(float* distance_p,
                                             float* alpha_map_p, TDimensionI dim,
                                             float center_opacity) {
-  float da   = 1.0f - center_opacity;
-  float* d_p = distance_p;
-  float* a_p = alpha_map_p;
-  for (int i = 0; i < dim.lx * dim.ly; i++, d_p++, a_p++) {
-    (*a_p) *= 1.0f - (*d_p) * da;
-  }
+  float da = 1.0f - center_opacity;
+  TThread::runInBands(dim.lx, dim.ly, [&](int y0, int y1) {
+    float* d_p = distance_p + y0 * dim.lx;
+    float* a_p = alpha_map_p + y0 * dim.lx;
+    for (int i = y0 * dim.lx; i < y1 * dim.lx; i++, d_p++, a_p++) {
+      (*a_p) *= 1.0f - (*d_p) * da;
+    }
+  });
 }
 
 //------------------------------------
@@ -0,0 +1,121 @@
+#include "noiseengine.h"
+#include "iwa_noise1234.h"
+
+#include "trandom.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <list>
+#include <map>
+
+//-------------------------------------------------------------------
+
+namespace {
+
+//! Memory budget for the fields kept by the cache below.
+const size_t c_fieldCacheBytes = 128 << 20;
+
+QMutex RandomTablesMutex;
+std::map<unsigned int, std::shared_ptr<const std::vector<float>>>
+    RandomTables;
+
+struct FieldCacheEntry {
+  NoiseEngine::FieldKey m_key;
+  std::shared_ptr<const std::vector<double>> m_field;
+};
+
+//! The latest fields, most recent first.
+QMutex FieldCacheMutex;
+std::list<FieldCacheEntry> FieldCache;
+size_t FieldCacheBytes = 0;
+
+std::shared_ptr<const std::vector<double>> findField(
+    const NoiseEngine::FieldKey &key, int count) {
+  QMutexLocker sl(&FieldCacheMutex);
+
+  for (auto it = FieldCache.begin(); it != FieldCache.end(); ++it) {
+    if (it->m_key == key && (int)it->m_field->size() == count) {
+      FieldCache.splice(FieldCache.begin(), FieldCache, it);
+      return it->m_field;
+    }
+  }
+
+  return std::shared_ptr<const std::vector<double>>();
+}
+
+void storeField(const NoiseEngine::FieldKey &key,
+                const std::shared_ptr<const std::vector<double>> &field) {
+  size_t bytes = field->size() * sizeof(double);
+  if (bytes > c_fieldCacheBytes) return;
+
+  QMutexLocker sl(&FieldCacheMutex);
+
+  // Another thread may have computed the same field meanwhile
+  for (const FieldCacheEntry &entry : FieldCache)
+    if (entry.m_key == key && entry.m_field->size() == field->size()) return;
+
+  while (FieldCacheBytes + bytes > c_fieldCacheBytes) {
+    FieldCacheBytes -= FieldCache.back().m_field->size() * sizeof(double);
+    FieldCache.pop_back();
+  }
+
+  FieldCacheEntry entry = {key, field};
+  FieldCache.push_front(entry);
+  FieldCacheBytes += bytes;
+}
+
+}  // namespace
+
+//-------------------------------------------------------------------
+
+std::shared_ptr<const std::vector<float>> NoiseEngine::randomTable(
+    unsigned int seed, int count) {
+  QMutexLocker sl(&RandomTablesMutex);
+
+  std::shared_ptr<const std::vector<float>> &table = RandomTables[seed];
+  if (!table || (int)table->size() < count) {
+    std::shared_ptr<std::vector<float>> newTable(new std::vector<float>(count));
+
+    TRandom random(seed);
+    for (int i = 0; i < count; ++i) (*newTable)[i] = random.getFloat();
+
+    table = newTable;
+  }
+
+  return table;
+}
+
+//-------------------------------------------------------------------
+
+void NoiseEngine::noise1234Octaves(double *out, const double *x,
+                                   const double *y, int count, double z,
+                                   const std::vector<double> &frequencies,
+                                   const std::vector<double> &amplitudes) {
+  for (int i = 0; i < count; ++i) out[i] = 0.0;
+
+  for (unsigned int o = 0; o < frequencies.size(); ++o) {
+    const double frequency = frequencies[o];
+    const double amplitude = amplitudes[o];
+    const double zf        = z * frequency;
+    for (int i = 0; i < count; ++i)
+      out[i] +=
+          Noise1234::noise(x[i] * frequency, y[i] * frequency, zf) * amplitude;
+  }
+}
+
+//-------------------------------------------------------------------
+
+std::shared_ptr<const std::vector<double>> NoiseEngine::field(
+    const FieldKey &key, int count,
+    const std::function<void(double *)> &compute) {
+  std::shared_ptr<const std::vector<double>> cached = findField(key, count);
+  if (cached) return cached;
+
+  // Computed out of the locks, since it typically splits among threads
+  std::shared_ptr<std::vector<double>> newField(new std::vector<double>(count));
+  if (count > 0) compute(&(*newField)[0]);
+
+  storeField(key, newField);
+  return newField;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#ifndef NOISEENGINE_H
+#define NOISEENGINE_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+//=============================================================================
+
+//! Shared building blocks of the procedural noise fxs.
+/*!
+  \li Random tables are drawn from TRandom with an explicit seed, so a noise
+      pattern never depends on the global rand() state or on the platform.
+  \li Octave sums are evaluated over whole rows of points at once, one octave
+      after the other, which keeps the per point arithmetic in tight loops
+      the compiler can vectorize. Each point still sums its octaves in the
+      same order, so results are the same as the per point evaluation.
+  \li Noise fields (a value per pixel of a tile) are cached by everything
+      they depend on - seed, scale, evolution, tile placement - so renders
+      that only change what the noise is applied to skip the evaluation.
+*/
+
+namespace NoiseEngine {
+
+//! Returns at least \b count values uniformly distributed in [0, 1), the
+//! first ones drawn from TRandom(seed). Tables are shared: the same seed
+//! always returns the same sequence, and longer requests extend it.
+std::shared_ptr<const std::vector<float>> randomTable(unsigned int seed,
+                                                      int count);
+
+//! Stores in out[i] the sum of the Noise1234 octaves at (x[i], y[i], z), for
+//! count points: each octave scales the point by its frequency, and weighs
+//! the noise by its amplitude.
+void noise1234Octaves(double *out, const double *x, const double *y,
+                      int count, double z,
+                      const std::vector<double> &frequencies,
+                      const std::vector<double> &amplitudes);
+
+//! Everything a noise field depends on. Keys begin with the id of the field's
+//! generator, so that fields of different generators never mix.
+typedef std::vector<double> FieldKey;
+
+enum FieldId { PERLIN_NOISE_FIELD };
+
+//! Returns the \b count values of the noise field identified by \b key.
+//! Fields missing from the cache are computed by \b compute, which is passed
+//! the array to fill.
+std::shared_ptr<const std::vector<double>> field(
+    const FieldKey &key, int count,
+    const std::function<void(double *)> &compute);
+
+}  // namespace NoiseEngine
+
+#endif
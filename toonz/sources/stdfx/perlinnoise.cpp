@@ -4,10 +4,26 @@
 //#include "tfxparam.h"
 #include "perlinnoise.h"
 
+#include "noiseengine.h"
+#include "tthread.h"
+
 // using std::cout;
 // using std::endl;
 //-------------------------------------------------------------------
 
+namespace {
+
+// il pixel size va animato da 1 (escluso)
+// a 0.1 (consigliato) fino ad un min di 0.001
+const double c_pixelSize = 0.05;
+
+// Seed of the random lattice shared by all PerlinNoise instances
+const unsigned int c_latticeSeed = 1;
+
+}  // namespace
+
+//-------------------------------------------------------------------
+
 double PerlinNoise::LinearNoise(double x, double y, double t) {
   int ix, iy, it, ix1, iy1, it1;
   double dx, dy, dt, val1, val2, val3, val4, val5, val6;
@@ -47,156 +63,136 @@ double PerlinNoise::LinearNoise(double x, double y, double t) {
   return (val5 + dt * (val6 - val5));
 }
 
-double PerlinNoise::Turbolence(double u, double v, double k, double grain) {
-  u += Offset;
-  v += Offset;
-  Pixel_size = 0.05;
-  double t = 0.0, scale = 1.0, tscale = 0;
-
-  u /= grain;
-  v /= grain;
-  k /= 10;
-  while (scale > Pixel_size) {
-    tscale += scale;
-    t += LinearNoise(u / scale, v / scale, k / scale) * scale;
-    scale /= 2.0;
+void PerlinNoise::Octaves(double *out, const double *u, const double *v,
+                          int count, double k, double grain) {
+  std::vector<double> us(count), vs(count);
+  for (int i = 0; i < count; ++i) {
+    us[i]  = (u[i] + Offset) / grain;
+    vs[i]  = (v[i] + Offset) / grain;
+    out[i] = 0.0;
   }
-  return t / tscale;
-}
-
-double PerlinNoise::Turbolence(double u, double v, double k, double grain,
-                               double min, double max) {
-  u += Offset;
-  v += Offset;
-  Pixel_size = 0.05;
-  double t = 0.0, scale = 1.0, tscale = 0;
-
-  u /= grain;
-  v /= grain;
   k /= 10;
-  while (scale > Pixel_size) {
-    tscale += scale;
-    t += LinearNoise(u / scale, v / scale, k / scale) * scale;
-    scale /= 2.0;
-  }
-  t = t / tscale;
-  if (t < min)
-    t = 0;
-  else {
-    if (t > max)
-      t = 1;
-    else
-      t = (t - min) / ((max - min));
-  }
-  return t;
-}
-
-double PerlinNoise::Marble(double u, double v, double k, double grain) {
-  u += Offset;
-  v += Offset;
-  Pixel_size = 0.05;
-  double t = 0.0, scale = 1.0, tscale = 0;
 
-  u /= grain;
-  v /= grain;
-  k /= 10;
-  while (scale > Pixel_size) {
-    tscale += scale;
-    t += LinearNoise(u / scale, v / scale, k / scale) * scale;
+  // Octave by octave over the whole row. Every point sums its octaves in
+  // the same order as a per point loop would.
+  double scale = 1.0;
+  while (scale > c_pixelSize) {
+    double ks = k / scale;
+    for (int i = 0; i < count; ++i)
+      out[i] += LinearNoise(us[i] / scale, vs[i] / scale, ks) * scale;
     scale /= 2.0;
   }
-  t = 10 * t;
-  return (t - (int)t);
 }
 
-double PerlinNoise::Marble(double u, double v, double k, double grain,
-                           double min, double max) {
-  u += Offset;
-  v += Offset;
-  Pixel_size = 0.05;
-  double t = 0.0, scale = 1.0, tscale = 0;
+void PerlinNoise::Turbolence(double *out, const double *u, const double *v,
+                             int count, double k, double grain, double min,
+                             double max) {
+  Octaves(out, u, v, count, k, grain);
 
-  u /= grain;
-  v /= grain;
-  k /= 10;
-  while (scale > Pixel_size) {
+  double tscale = 0, scale = 1.0;
+  while (scale > c_pixelSize) {
     tscale += scale;
-    t += LinearNoise(u / scale, v / scale, k / scale) * scale;
     scale /= 2.0;
   }
-  t = 10 * t;
-  t = (t - (int)t);
-  if (t < min)
-    t = 0;
-  else {
-    if (t > max)
-      t = 1;
-    else
-      t = (t - min) / ((max - min));
+
+  for (int i = 0; i < count; ++i) {
+    double t = out[i] / tscale;
+    if (t < min)
+      t = 0;
+    else {
+      if (t > max)
+        t = 1;
+      else
+        t = (t - min) / ((max - min));
+    }
+    out[i] = t;
   }
-  return t;
 }
 
-PerlinNoise::PerlinNoise() : Noise(new float[Size * Size * TimeSize]) {
-  TRandom random(1);
-  for (int i = 0; i < Size; i++) {
-    for (int j = 0; j < Size; j++) {
-      for (int k = 0; k < TimeSize; k++) {
-        float tmp = random.getFloat();
-        // cout << "tmp = " << tmp << "HM = "<< HowMany<< endl;
-        Noise[k + TimeSize * j + TimeSize * Size * i] = tmp;
-      }
+void PerlinNoise::Marble(double *out, const double *u, const double *v,
+                         int count, double k, double grain, double min,
+                         double max) {
+  Octaves(out, u, v, count, k, grain);
+
+  for (int i = 0; i < count; ++i) {
+    double t = 10 * out[i];
+    t        = (t - (int)t);
+    if (t < min)
+      t = 0;
+    else {
+      if (t > max)
+        t = 1;
+      else
+        t = (t - min) / ((max - min));
     }
+    out[i] = t;
   }
+}
 
-  // cout << "HowMany = " << HowMany <<endl;
+PerlinNoise::PerlinNoise()
+    : m_table(
+          NoiseEngine::randomTable(c_latticeSeed, Size * Size * TimeSize)) {
+  // The lattice is indexed [x][y][t], in the order it is drawn
+  Noise = &(*m_table)[0];
 }
 
 int PerlinNoise::Size     = 60;
 int PerlinNoise::TimeSize = 20;
 int PerlinNoise::Offset   = 1000000;
-double PerlinNoise::Pixel_size =
-    0.01;  // il pixel size va animato da 1 (escluso)
-// a 0.1 (consigliato) fino ad un min di 0.001
+
+std::shared_ptr<const std::vector<double>> perlinNoiseField(
+    int type, const TPointD &tilepos, int lx, int ly, double scale,
+    const TPointD &offset, double evolution, double size, double min,
+    double max) {
+  NoiseEngine::FieldKey key = {
+      NoiseEngine::PERLIN_NOISE_FIELD, c_latticeSeed, (double)type,
+      tilepos.x, tilepos.y, (double)lx, (double)ly, scale, offset.x,
+      offset.y, evolution, size, min, max};
+
+  return NoiseEngine::field(key, lx * ly, [&](double *field) {
+    TAffine aff = TScale(1 / scale);
+    PerlinNoise Noise;
+    TThread::runInBands(lx, ly, [&](int y0, int y1) {
+      std::vector<double> u(lx), v(lx);
+      for (int j = y0; j < y1; j++) {
+        TPointD pos = tilepos;
+        pos.y += j;
+        for (int i = 0; i < lx; i++) {
+          TPointD posAff = aff * pos;
+          u[i]           = posAff.x + offset.x;
+          v[i]           = posAff.y + offset.y;
+          pos.x += 1.0;
+        }
+
+        double *out = field + j * lx;
+        if (type == PNOISE_CLOUDS)
+          Noise.Turbolence(out, &u[0], &v[0], lx, evolution, size, min, max);
+        else
+          Noise.Marble(out, &u[0], &v[0], lx, evolution, size, min, max);
+      }
+    });
+  });
+}
 
 namespace {
 template <typename PIXEL>
 void doCloudsT(const TRasterPT<PIXEL> &ras, const TSpectrumT<PIXEL> &spectrum,
                TPointD &tilepos, double evolution, double size, double min,
                double max, int type, double scale) {
-  int j;
-  TAffine aff = TScale(1 / scale);
-  PerlinNoise Noise;
+  int lx = ras->getLx();
+  std::shared_ptr<const std::vector<double>> field =
+      perlinNoiseField(type, tilepos, lx, ras->getLy(), scale, TPointD(),
+                       evolution, size, min, max);
+
   ras->lock();
-  if (type == PNOISE_CLOUDS) {
-    for (j = 0; j < ras->getLy(); j++) {
-      TPointD pos = tilepos;
-      pos.y += j;
-      PIXEL *pix    = ras->pixels(j);
-      PIXEL *endPix = pix + ras->getLx();
-      while (pix < endPix) {
-        TPointD posAff = aff * pos;
-        double pnoise =
-            Noise.Turbolence(posAff.x, posAff.y, evolution, size, min, max);
-        pos.x += 1.0;
-        *pix++ = spectrum.getPremultipliedValue(pnoise);
-      }
-    }
-  } else {
-    for (j = 0; j < ras->getLy(); j++) {
-      TPointD pos = tilepos;
-      pos.y += j;
-      PIXEL *pix    = ras->pixels(j);
-      PIXEL *endPix = pix + ras->getLx();
-      while (pix < endPix) {
-        TPointD posAff = aff * pos;
-        double pnoise =
-            Noise.Marble(posAff.x, posAff.y, evolution, size, min, max);
-        pos.x += 1.0;
-        *pix++ = spectrum.getPremultipliedValue(pnoise);
-      }
+  TThread::runInBands(lx, ras->getLy(), [&](int y0, int y1) {
+    for (int j = y0; j < y1; j++) {
+      const double *pnoise = &(*field)[j * lx];
+      PIXEL *pix           = ras->pixels(j);
+      PIXEL *endPix        = pix + lx;
+      while (pix < endPix) *pix++ = spectrum.getPremultipliedValue(*pnoise++);
     }
-  }
+  });
   ras->unlock();
 }
 }
@@ -3,30 +3,47 @@
 #ifndef PERLINNOISE_H
 #define PERLINOISE_H
 
-#include <memory>
-
 #include "tfxparam.h"
 #include "tspectrumparam.h"
 
+#include <memory>
+#include <vector>
+
 enum { PNOISE_CLOUDS, PNOISE_WOODS };
 
+//! Value noise on a fixed random lattice. The lattice is always seeded the
+//! same way, so it is shared among all instances (see NoiseEngine); these
+//! are cheap to construct, and safe to use from concurrent threads.
+/*!
+  Points are evaluated a row at a time: \b out[i] receives the noise at
+  (\b u[i], \b v[i]) for the \b count points passed.
+*/
 class PerlinNoise {
   static int Size;
   static int TimeSize;
   static int Offset;
-  static double Pixel_size;
-  std::unique_ptr<float[]> Noise;
+  std::shared_ptr<const std::vector<float>> m_table;
+  const float *Noise;
   double LinearNoise(double x, double y, double t);
+  void Octaves(double *out, const double *u, const double *v, int count,
+               double k, double grain);
 
 public:
   PerlinNoise();
-  double Turbolence(double u, double v, double k, double grain);
-  double Turbolence(double u, double v, double k, double grain, double min,
-                    double max);
-  double Marble(double u, double v, double k, double grain);
-  double Marble(double u, double v, double k, double grain, double min,
-                double max);
+  void Turbolence(double *out, const double *u, const double *v, int count,
+                  double k, double grain, double min, double max);
+  void Marble(double *out, const double *u, const double *v, int count,
+              double k, double grain, double min, double max);
 };
+
+//! Returns the noise of the lx x ly pixels starting at \b tilepos, scaled
+//! by 1 / \b scale and shifted by \b offset, as PNOISE_CLOUDS turbolence or
+//! PNOISE_WOODS marble. Fields are kept in the NoiseEngine cache.
+std::shared_ptr<const std::vector<double>> perlinNoiseField(
+    int type, const TPointD &tilepos, int lx, int ly, double scale,
+    const TPointD &offset, double evolution, double size, double min,
+    double max);
+
 /*---------------------------------------------------------------------------*/
 void doClouds(const TRasterP &ras, const TSpectrumParamP colors, TPointD pos,
               double evolution, double size, double min, double max, int type,
@@ -6,6 +6,7 @@
 #include "stdfx.h"
 #include "trasterfx.h"
 #include "tparamuiconcept.h"
+#include "tthread.h"
 
 //==================================================================
 
@@ -92,75 +93,77 @@ void doPerlinNoise(const TRasterPT<PIXEL> &rasOut,
                    double evolution, double size, double min, double max,
                    double offsetx, double offsety, int type, int brad,
                    int matte, double scale) {
-  PerlinNoise Noise;
+  int lx = rasOut->getLx(), ly = rasOut->getLy();
+  TPointD offset(offsetx, offsety);
+
+  // Woods displace along x and y with two marble fields
+  std::shared_ptr<const std::vector<double>> field =
+      perlinNoiseField(type, tilepos, lx, ly, scale, offset, evolution, size,
+                       min, max);
+  std::shared_ptr<const std::vector<double>> fieldY;
+  if (type != PNOISE_CLOUDS)
+    fieldY = perlinNoiseField(type, tilepos, lx, ly, scale, offset,
+                              evolution + 100, size, min, max);
+
   rasOut->lock();
 
-  TAffine aff = TScale(1 / scale);
-
-  if (type == PNOISE_CLOUDS)
-
-    for (int j = 0; j < rasOut->getLy(); ++j) {
-      PIXEL *pixout    = rasOut->pixels(j);
-      PIXEL *endPixOut = pixout + rasOut->getLx();
-      PIXEL *pix       = rasIn->pixels(j + brad) + brad;
-      TPointD pos      = tilepos;
-      pos.y += j;
-      while (pixout < endPixOut) {
-        TPointD posAff = aff * pos;
-        double pnoise = Noise.Turbolence(posAff.x + offsetx, posAff.y + offsety,
-                                         evolution, size, min, max);
-        int sval     = (int)(brad * (pnoise - 0.5));
-        int pixshift = sval + rasIn->getWrap() * (sval);
-        pos.x += 1.0;
-
-        if (matte) {
-          pixout->r = (CHANNEL_TYPE)((pix + pixshift)->r * pnoise);
-          pixout->g = (CHANNEL_TYPE)((pix + pixshift)->g * pnoise);
-          pixout->b = (CHANNEL_TYPE)((pix + pixshift)->b * pnoise);
-          pixout->m = (CHANNEL_TYPE)((pix + pixshift)->m * pnoise);
-        } else {
-          pixout->r = (CHANNEL_TYPE)((pix + pixshift)->r);
-          pixout->g = (CHANNEL_TYPE)((pix + pixshift)->g);
-          pixout->b = (CHANNEL_TYPE)((pix + pixshift)->b);
-          pixout->m = (CHANNEL_TYPE)((pix + pixshift)->m);
+  TThread::runInBands(lx, ly, [&](int y0, int y1) {
+    if (type == PNOISE_CLOUDS)
+      for (int j = y0; j < y1; ++j) {
+        PIXEL *pixout       = rasOut->pixels(j);
+        PIXEL *endPixOut    = pixout + lx;
+        PIXEL *pix          = rasIn->pixels(j + brad) + brad;
+        const double *noise = &(*field)[j * lx];
+        while (pixout < endPixOut) {
+          double pnoise = *noise++;
+          int sval      = (int)(brad * (pnoise - 0.5));
+          int pixshift  = sval + rasIn->getWrap() * (sval);
+
+          if (matte) {
+            pixout->r = (CHANNEL_TYPE)((pix + pixshift)->r * pnoise);
+            pixout->g = (CHANNEL_TYPE)((pix + pixshift)->g * pnoise);
+            pixout->b = (CHANNEL_TYPE)((pix + pixshift)->b * pnoise);
+            pixout->m = (CHANNEL_TYPE)((pix + pixshift)->m * pnoise);
+          } else {
+            pixout->r = (CHANNEL_TYPE)((pix + pixshift)->r);
+            pixout->g = (CHANNEL_TYPE)((pix + pixshift)->g);
+            pixout->b = (CHANNEL_TYPE)((pix + pixshift)->b);
+            pixout->m = (CHANNEL_TYPE)((pix + pixshift)->m);
+          }
+          pix++;
+          pixout++;
         }
-        pix++;
-        pixout++;
       }
-    }
-  else
-    for (int j = 0; j < rasOut->getLy(); ++j) {
-      PIXEL *pixout    = rasOut->pixels(j);
-      PIXEL *endPixOut = pixout + rasOut->getLx();
-      PIXEL *pix       = rasIn->pixels(j + brad) + brad;
-      TPointD pos      = tilepos;
-      pos.y += j;
-      while (pixout < endPixOut) {
-        TPointD posAff = aff * pos;
-        double pnoisex = Noise.Marble(posAff.x + offsetx, posAff.y + offsety,
-                                      evolution, size, min, max);
-        double pnoisey = Noise.Marble(posAff.x + offsetx, posAff.y + offsety,
-                                      evolution + 100, size, min, max);
-        int svalx    = (int)(brad * (pnoisex - 0.5));
-        int svaly    = (int)(brad * (pnoisey - 0.5));
-        int pixshift = svalx + rasIn->getWrap() * (svaly);
-        pos.x += 1.0;
-
-        if (matte) {
-          pixout->r = (CHANNEL_TYPE)((pix + pixshift)->r * pnoisex);
-          pixout->g = (CHANNEL_TYPE)((pix + pixshift)->g * pnoisex);
-          pixout->b = (CHANNEL_TYPE)((pix + pixshift)->b * pnoisex);
-          pixout->m = (CHANNEL_TYPE)((pix + pixshift)->m * pnoisex);
-        } else {
-          pixout->r = (CHANNEL_TYPE)((pix + pixshift)->r);
-          pixout->g = (CHANNEL_TYPE)((pix + pixshift)->g);
-          pixout->b = (CHANNEL_TYPE)((pix + pixshift)->b);
-          pixout->m = (CHANNEL_TYPE)((pix + pixshift)->m);
+    else
+      for (int j = y0; j < y1; ++j) {
+        PIXEL *pixout        = rasOut->pixels(j);
+        PIXEL *endPixOut     = pixout + lx;
+        PIXEL *pix           = rasIn->pixels(j + brad) + brad;
+        const double *noiseX = &(*field)[j * lx];
+        const double *noiseY = &(*fieldY)[j * lx];
+        while (pixout < endPixOut) {
+          double pnoisex = *noiseX++;
+          double pnoisey = *noiseY++;
+          int svalx      = (int)(brad * (pnoisex - 0.5));
+          int svaly      = (int)(brad * (pnoisey - 0.5));
+          int pixshift   = svalx + rasIn->getWrap() * (svaly);
+
+          if (matte) {
+            pixout->r = (CHANNEL_TYPE)((pix + pixshift)->r * pnoisex);
+            pixout->g = (CHANNEL_TYPE)((pix + pixshift)->g * pnoisex);
+            pixout->b = (CHANNEL_TYPE)((pix + pixshift)->b * pnoisex);
+            pixout->m = (CHANNEL_TYPE)((pix + pixshift)->m * pnoisex);
+          } else {
+            pixout->r = (CHANNEL_TYPE)((pix + pixshift)->r);
+            pixout->g = (CHANNEL_TYPE)((pix + pixshift)->g);
+            pixout->b = (CHANNEL_TYPE)((pix + pixshift)->b);
+            pixout->m = (CHANNEL_TYPE)((pix + pixshift)->m);
+          }
+          pix++;
+          pixout++;
         }
-        pix++;
-        pixout++;
       }
-    }
+  });
   rasOut->unlock();
 }
 
@@ -1,9 +1,18 @@
 
 
 #include "warp.h"
+#include "tthread.h"
 #include "toonz/tdistort.h"
 #include "timage_io.h"  //For debug use only
 
+// Qt includes
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <cstring>
+#include <list>
+#include <memory>
+
 //-------------------------------------------------------------------
 
 namespace {
@@ -26,6 +35,100 @@ inline double convert<TPixel64>(const TPixel64 &pixel) {
 
 /*-----------------------------------------------------------------*/
 
+namespace {
+
+//! Memory budget for lattices kept by the cache below.
+const size_t c_latticeCacheBytes = 128 << 20;
+
+//! Everything but the warper's content a lattice depends on.
+struct LatticeKey {
+  TPointD m_warperPos;
+  int m_shrink;
+  double m_warperScale;
+  double m_intensity;
+  bool m_sharpen;
+
+  bool operator==(const LatticeKey &other) const {
+    return m_warperPos == other.m_warperPos && m_shrink == other.m_shrink &&
+           m_warperScale == other.m_warperScale &&
+           m_intensity == other.m_intensity && m_sharpen == other.m_sharpen;
+  }
+};
+
+struct LatticeCacheEntry {
+  LatticeKey m_key;
+  TRasterP m_warper;  // Copy of the warper, before blurring
+  std::shared_ptr<const Lattice> m_lattice;
+  size_t m_bytes;
+};
+
+//! Lattices of the latest warps, most recent first. Warpers generated from
+//! unanimated params (the same tile of the next frame, typically) hit this
+//! and skip both the blur and the lattice build.
+QMutex LatticeCacheMutex;
+std::list<LatticeCacheEntry> LatticeCache;
+size_t LatticeCacheBytes = 0;
+
+bool sameContent(const TRasterP &ras1, const TRasterP &ras2) {
+  if (ras1->getSize() != ras2->getSize() ||
+      ras1->getPixelSize() != ras2->getPixelSize())
+    return false;
+
+  int rowBytes = ras1->getLx() * ras1->getPixelSize();
+  bool same    = true;
+
+  ras1->lock();
+  ras2->lock();
+  for (int y = 0; same && y < ras1->getLy(); ++y)
+    same = (memcmp(ras1->getRawData(0, y), ras2->getRawData(0, y),
+                   rowBytes) == 0);
+  ras2->unlock();
+  ras1->unlock();
+
+  return same;
+}
+
+std::shared_ptr<const Lattice> findLattice(const LatticeKey &key,
+                                           const TRasterP &warper) {
+  QMutexLocker sl(&LatticeCacheMutex);
+
+  for (auto it = LatticeCache.begin(); it != LatticeCache.end(); ++it) {
+    if (it->m_key == key && sameContent(it->m_warper, warper)) {
+      LatticeCache.splice(LatticeCache.begin(), LatticeCache, it);
+      return it->m_lattice;
+    }
+  }
+
+  return std::shared_ptr<const Lattice>();
+}
+
+void storeLattice(const LatticeKey &key, const TRasterP &warperCopy,
+                  const std::shared_ptr<const Lattice> &lattice) {
+  size_t bytes = lattice->m_warps.size() * sizeof(TPointD) +
+                 warperCopy->getLx() * warperCopy->getLy() *
+                     warperCopy->getPixelSize();
+  if (bytes > c_latticeCacheBytes) return;
+
+  QMutexLocker sl(&LatticeCacheMutex);
+
+  // Another thread may have built the same lattice meanwhile
+  for (const LatticeCacheEntry &entry : LatticeCache)
+    if (entry.m_key == key && sameContent(entry.m_warper, warperCopy)) return;
+
+  while (LatticeCacheBytes + bytes > c_latticeCacheBytes) {
+    LatticeCacheBytes -= LatticeCache.back().m_bytes;
+    LatticeCache.pop_back();
+  }
+
+  LatticeCacheEntry entry = {key, warperCopy, lattice, bytes};
+  LatticeCache.push_front(entry);
+  LatticeCacheBytes += bytes;
+}
+
+}  // namespace
+
+/*-----------------------------------------------------------------*/
+
 template <typename T>
 class Warper final : public TDistorter {
 public:
@@ -39,7 +142,7 @@ public:
   double m_warperScale;
   double m_intensity;
   bool m_sharpen;
-  Lattice m_lattice;
+  std::shared_ptr<const Lattice> m_lattice;
 
   Warper(TPointD rinPos, TPointD warperPos, const TRasterPT<T> &rin,
          const TRasterPT<T> &warper, TRasterPT<T> &rout,
@@ -62,85 +165,81 @@ public:
   TPointD map(const TPointD &p) const override;
   int invMap(const TPointD &p, TPointD *invs) const override;
   int maxInvCount() const override { return 1; }
+
+private:
+  void buildLattice(Lattice &lattice);
 };
 
 /*---------------------------------------------------------------------------*/
 
 template <typename T>
 void Warper<T>::createLattice() {
-  int ori_lx, ori_ly, i, j, lx, ly, incr;
-  double fac;
+  LatticeKey key = {m_warperPos, m_shrink, m_warperScale, m_intensity,
+                    m_sharpen};
 
-  ori_lx = m_shrink * (m_warper->getLx() - 1) + 1;
-  ori_ly = m_shrink * (m_warper->getLy() - 1) + 1;
+  m_lattice = findLattice(key, m_warper);
+  if (m_lattice) return;
 
-  lx = m_lattice.m_width = ori_lx;
-  ly = m_lattice.m_height = ori_ly;
+  // The warper may be blurred in place while building the lattice
+  TRasterP warperCopy(m_warper->clone());
 
-  TRasterPT<T> aux = m_warper;
+  std::shared_ptr<Lattice> lattice(new Lattice);
+  buildLattice(*lattice);
+  m_lattice = lattice;
 
-  if (!m_sharpen) TRop::blur(aux, aux, 6.0, 0, 0);
+  storeLattice(key, warperCopy, m_lattice);
+}
 
-  m_lattice.coords = new LPoint[lx * ly];
+//---------------------------------------------------------------------------
 
-  LPoint *coord = m_lattice.coords;
+template <typename T>
+void Warper<T>::buildLattice(Lattice &lattice) {
+  int i, j, lx, ly;
+  double fac;
 
-  for (j = 0; j < ly; ++j) {
-    if (j >= ly - 1) j = ori_ly - 1;
-    coord->s.y = (coord + lx - 1)->s.y = 0;
-    coord->d.y = (coord + lx - 1)->d.y = j;
+  lx = lattice.m_width  = m_shrink * (m_warper->getLx() - 1) + 1;
+  ly = lattice.m_height = m_shrink * (m_warper->getLy() - 1) + 1;
 
-    (coord + lx - 1)->s.x = 0;
-    (coord + lx - 1)->d.x = ori_lx - 1;
-    coord += lx;
-  }
+  TRasterPT<T> aux = m_warper;
 
-  coord = m_lattice.coords;
-  incr  = (ly - 1) * lx;
+  if (!m_sharpen) TRop::blur(aux, aux, 6.0, 0, 0);
 
-  for (i = 0; i < lx; ++i) {
-    if (i >= (lx - 1)) i = ori_lx - 1;
-    coord->s.x = (coord + incr)->s.x = 0;
-    coord->d.x = (coord + incr)->d.x = i;
-    (coord + incr)->s.y              = 0;
-    (coord + incr)->d.y              = ori_ly - 1;
-    coord++;
-  }
+  // Original lattice points, scaled according to the m_scale parameter
+  lattice.m_xs.resize(lx);
+  for (i = 0; i < lx; ++i) lattice.m_xs[i] = m_warperPos.x + m_warperScale * i;
+
+  lattice.m_ys.resize(ly);
+  for (j = 0; j < ly; ++j) lattice.m_ys[j] = m_warperPos.y + m_warperScale * j;
+
+  // Warps are null on the lattice border
+  lattice.m_warps.assign(lx * ly, TPointD());
 
   fac = m_intensity * (TPixel32::maxChannelValue / (double)T::maxChannelValue);
   aux->lock();
   T *buffer = (T *)aux->getRawData();
   T *pixIn;
+  TPointD *warp;
   int auxWrap = aux->getWrap();
 
   for (j = 1; j < ly - 1; j++) {
     pixIn = buffer + j * auxWrap;
-    coord = &(m_lattice.coords[j * lx]);
+    warp  = &lattice.m_warps[j * lx];
 
     for (i = 1; i < lx - 1; i++) {
       ++pixIn;
-      ++coord;
-      coord->d.x = i;
-      coord->d.y = j;
+      ++warp;
 
       // FOR A FUTURE RELEASE: We should not make the diffs below between +1 and
       // -1, BUT 0 and -1!!
 
-      coord->s.x = fac * (convert(*(pixIn + 1)) - convert(*(pixIn - 1)));
-      coord->s.y =
-          fac * (convert(*(pixIn + auxWrap)) - convert(*(pixIn - auxWrap)));
+      warp->x = m_warperScale *
+                (fac * (convert(*(pixIn + 1)) - convert(*(pixIn - 1))));
+      warp->y = m_warperScale * (fac * (convert(*(pixIn + auxWrap)) -
+                                        convert(*(pixIn - auxWrap))));
     }
   }
 
   aux->unlock();
-
-  // Finally, we scale the lattice according to the m_scale parameter.
-  coord  = m_lattice.coords;
-  int wh = m_lattice.m_width * m_lattice.m_height;
-  for (i = 0; i < wh; ++i, ++coord) {
-    coord->d = m_warperPos + m_warperScale * coord->d;
-    coord->s = m_warperScale * coord->s;
-  }
 }
 
 //---------------------------------------------------------------------------
@@ -153,8 +252,19 @@ void Warper<T>::shepardWarp() {
   m_rout->lock();
 
   TRasterP rasIn(m_rin);
-  TRasterP rasOut(m_rout);
-  distort(rasOut, rasIn, *this, -convert(m_rinPos), TRop::Bilinear);
+  TPoint rinPos(-convert(m_rinPos));
+
+  // Output rows are distorted independently, so they are split in bands
+  // among threads. Inverses are taken at the very same points in any case.
+  int lx = m_rout->getLx(), ly = m_rout->getLy();
+
+  auto distortRows = [&](int y0, int y1) {
+    if (y0 >= y1) return;
+    TRasterP rasOut(m_rout->extract(0, y0, lx - 1, y1 - 1));
+    distort(rasOut, rasIn, *this, rinPos + TPoint(0, y0), TRop::Bilinear);
+  };
+
+  TThread::runInBands(lx, ly, distortRows);
 
   m_rout->unlock();
   m_rin->unlock();
@@ -174,6 +284,10 @@ int Warper<T>::invMap(const TPointD &p, TPointD *invs) const {
   // Make a Shepard interpolant of grid points
   const double maxDist = 2 * m_warperScale;
 
+  const Lattice &lattice = *m_lattice;
+  const double *xs       = lattice.m_xs.data();
+  const double *ys       = lattice.m_ys.data();
+
   TPointD pos(p + m_rinPos);
 
   // First, bisect for the interesting maxDist-from-p region
@@ -183,20 +297,20 @@ int Warper<T>::invMap(const TPointD &p, TPointD *invs) const {
   double xEnd   = pos.x + maxDist;
   double yEnd   = pos.y + maxDist;
 
-  int a = 0, b = m_lattice.m_width;
+  int a = 0, b = lattice.m_width;
   while (a + 1 < b) {
     i = (a + b) / 2;
-    if (m_lattice.coords[i].d.x < xStart)
+    if (xs[i] < xStart)
       a = i;
     else
       b = i;
   }
   i = a;
 
-  a = 0, b = m_lattice.m_height;
+  a = 0, b = lattice.m_height;
   while (a + 1 < b) {
     j = (a + b) / 2;
-    if (m_lattice.coords[j * m_lattice.m_width].d.y < yStart)
+    if (ys[j] < yStart)
       a = j;
     else
       b = j;
@@ -208,30 +322,30 @@ int Warper<T>::invMap(const TPointD &p, TPointD *invs) const {
   double w, wsum = 0;
   double xDistSq, yDistSq;
   double distSq, maxDistSq = sq(maxDist);
-  TPointD result;
+  double resultX = 0, resultY = 0;
 
-  for (v = j; v < m_lattice.m_height; ++v) {
-    int vidx = v * m_lattice.m_width;
-    if (m_lattice.coords[vidx].d.y > yEnd) break;
+  for (v = j; v < lattice.m_height; ++v) {
+    if (ys[v] > yEnd) break;
 
-    yDistSq = sq(pos.y - m_lattice.coords[vidx].d.y);
+    yDistSq = sq(pos.y - ys[v]);
 
-    LPoint *coord = &m_lattice.coords[vidx + i];
-    for (u = i; u < m_lattice.m_width; ++u, ++coord) {
-      xDistSq = sq(pos.x - m_lattice.coords[u].d.x);
-      if (m_lattice.coords[u].d.x > xEnd) break;
+    const TPointD *warp = &lattice.m_warps[v * lattice.m_width + i];
+    for (u = i; u < lattice.m_width; ++u, ++warp) {
+      if (xs[u] > xEnd) break;
+      xDistSq = sq(pos.x - xs[u]);
 
       distSq = xDistSq + yDistSq;
       if (distSq > maxDistSq) continue;
 
       w = maxDist - sqrt(distSq);
       wsum += w;
-      result += w * coord->s;
+      resultX += w * warp->x;
+      resultY += w * warp->y;
     }
   }
 
   if (wsum)
-    invs[0] = p + TPointD(result.x / wsum, result.y / wsum);
+    invs[0] = p + TPointD(resultX / wsum, resultY / wsum);
   else
     invs[0] = p;
 
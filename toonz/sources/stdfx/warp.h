@@ -7,6 +7,8 @@
 #include "trop.h"
 #include "trasterfx.h"
 
+#include <vector>
+
 //-----------------------------------------------------------------------
 
 struct WarpParams {
@@ -16,20 +18,16 @@ struct WarpParams {
   bool m_sharpen;
 };
 
-struct LPoint {
-  TPointD s;  // Warped lattice point
-  TPointD d;  // Original lattice point
-};
-
 struct Lattice {
-  int m_width;     // Number of lattice columns
-  int m_height;    // Number of lattice rows
-  LPoint *coords;  // Grid vertex coordinates
-
-  Lattice() : coords(0) {}
-  ~Lattice() {
-    if (coords) delete[] coords;
-  }
+  int m_width;   // Number of lattice columns
+  int m_height;  // Number of lattice rows
+
+  // Original lattice points lie on a regular grid, so only the coordinates
+  // of its columns and rows are stored
+  std::vector<double> m_xs, m_ys;
+  std::vector<TPointD> m_warps;  // Warp of each grid vertex, row-major
+
+  Lattice() : m_width(0), m_height(0) {}
 };
 
 namespace  // Ugly...
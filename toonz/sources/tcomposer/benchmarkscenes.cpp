@@ -0,0 +1,848 @@
+#include "benchmarkscenes.h"
+
+// TnzLib includes
+#include "toonz/toonzscene.h"
+#include "toonz/tproject.h"
+#include "toonz/sceneproperties.h"
+#include "toonz/tcamera.h"
+#include "toonz/levelset.h"
+#include "toonz/levelproperties.h"
+#include "toonz/txsheet.h"
+#include "toonz/txshcell.h"
+#include "toonz/txshsimplelevel.h"
+#include "toonz/txshleveltypes.h"
+#include "toonz/txshzeraryfxcolumn.h"
+#include "toonz/tcolumnfx.h"
+#include "toonz/tcolumnfxset.h"
+#include "toonz/fxdag.h"
+#include "toonz/tstageobject.h"
+#include "toonz/tstageobjectid.h"
+#include "toonz/tstageobjecttree.h"
+#include "toonz/tstageobjectspline.h"
+#include "toonz/stage.h"
+#include "toutputproperties.h"
+
+// TnzExt includes
+#include "ext/meshbuilder.h"
+#include "ext/meshutils.h"
+#include "ext/plasticskeleton.h"
+#include "ext/plasticskeletondeformation.h"
+
+// TnzBase includes
+#include "tfxutil.h"
+#include "tdoubleparam.h"
+#include "tnotanimatableparam.h"
+#include "tparamcontainer.h"
+
+// TnzCore includes
+#include "tsystem.h"
+#include "tconvert.h"
+#include "trandom.h"
+#include "tpalette.h"
+#include "tcolorstyles.h"
+#include "tstroke.h"
+#include "drawutil.h"
+#include "tvectorimage.h"
+#include "ttoonzimage.h"
+#include "trasterimage.h"
+#include "tmeshimage.h"
+#include "tproperty.h"
+
+// STD includes
+#include <memory>
+
+//***********************************************************************************
+//    Local namespace
+//***********************************************************************************
+
+namespace {
+
+const TDimension c_cameraRes(1920, 1080);
+const double c_dpi = 120.0;  // Camera res / camera size in inches
+
+const int c_frameCount = 24;
+
+// Camera half extents, in stage units (the vector images' reference)
+const double c_stageHalfWidth  = 0.5 * Stage::inch * c_cameraRes.lx / c_dpi;
+const double c_stageHalfHeight = 0.5 * Stage::inch * c_cameraRes.ly / c_dpi;
+
+//-----------------------------------------------------------------------------
+
+inline double random(TRandom &rnd, double min, double max) {
+  return min + (max - min) * rnd.getDouble();
+}
+
+//-----------------------------------------------------------------------------
+
+inline TPixel32 randomColor(TRandom &rnd) {
+  return TPixel32(rnd.getInt(0, 256), rnd.getInt(0, 256), rnd.getInt(0, 256));
+}
+
+//-----------------------------------------------------------------------------
+
+std::vector<int> addRandomStyles(TPalette *palette, TRandom &rnd, int count) {
+  TPalette::Page *page = palette->getPage(0);
+
+  std::vector<int> styleIds;
+  for (int s = 0; s < count; ++s)
+    styleIds.push_back(page->getStyleId(page->addStyle(randomColor(rnd))));
+
+  return styleIds;
+}
+
+//-----------------------------------------------------------------------------
+
+//! Adds every procedural stroke style (the special styles not reading
+//! library files) to the palette.
+std::vector<int> addStrokeStyles(TPalette *palette) {
+  TPalette::Page *page = palette->getPage(0);
+
+  std::vector<int> tags;
+  TColorStyle::getAllTags(tags);
+
+  std::vector<int> styleIds;
+  for (int tagId : tags) {
+    // Image pattern styles (2000, 2800 and the obsolete 100), vector brushes
+    // (3000) and mypaint brushes (4001) need a pattern or brush file from the
+    // library. The color and black cleanup styles (2001, 2002) only belong to
+    // cleanup palettes.
+    if (tagId == 100 || tagId == 2000 || tagId == 2800 || tagId == 3000 ||
+        tagId == 4001 || tagId == 2001 || tagId == 2002)
+      continue;
+
+    TColorStyle *style = TColorStyle::create(tagId);
+    if (style->isRasterStyle() || !style->isStrokeStyle() ||
+        style->isRegionStyle()) {
+      delete style;
+      continue;
+    }
+
+    styleIds.push_back(page->getStyleId(page->addStyle(style)));
+  }
+
+  return styleIds;
+}
+
+//===================================================================
+//    Images
+//-------------------------------------------------------------------
+
+//! Overlapping filled ellipses below a set of open wavy strokes.
+TVectorImageP makeVectorFrame(TPalette *palette,
+                              const std::vector<int> &styleIds, TRandom &rnd,
+                              int regionsCount, int strokesCount) {
+  TVectorImageP vi = new TVectorImage;
+  vi->setPalette(palette);
+
+  std::vector<TPointD> centers;
+  for (int r = 0; r < regionsCount; ++r) {
+    TPointD center(random(rnd, -c_stageHalfWidth, c_stageHalfWidth),
+                   random(rnd, -c_stageHalfHeight, c_stageHalfHeight));
+
+    TStroke *stroke = makeEllipticStroke(random(rnd, 1.0, 3.0), center,
+                                         random(rnd, 8.0, 40.0),
+                                         random(rnd, 8.0, 40.0));
+    stroke->setStyle(1);
+    vi->addStroke(stroke);
+
+    centers.push_back(center);
+  }
+
+  vi->findRegions();
+
+  for (int r = 0; r < regionsCount; ++r)
+    vi->fill(centers[r], styleIds[rnd.getInt(0, (int)styleIds.size())]);
+
+  const int chunksCount = 16;
+
+  for (int s = 0; s < strokesCount; ++s) {
+    TPointD pos(random(rnd, -c_stageHalfWidth, c_stageHalfWidth),
+                random(rnd, -c_stageHalfHeight, c_stageHalfHeight));
+    double angle = random(rnd, 0.0, M_2PI), thick = random(rnd, 0.5, 4.0);
+
+    std::vector<TThickPoint> points;
+    for (int p = 0; p < 2 * chunksCount + 1; ++p) {
+      points.push_back(TThickPoint(pos, thick * random(rnd, 0.5, 1.5)));
+
+      angle += random(rnd, -0.5, 0.5);
+      pos += 6.0 * TPointD(cos(angle), sin(angle));
+    }
+
+    TStroke *stroke = new TStroke(points);
+    stroke->setStyle(styleIds[rnd.getInt(0, (int)styleIds.size())]);
+    vi->addStroke(stroke);
+  }
+
+  return vi;
+}
+
+//-------------------------------------------------------------------
+
+//! A moving disc painted on a ToonzRaster level, outlined by a black ink.
+struct Disc {
+  TPointD m_center, m_speed;
+  double m_radius;
+  int m_styleId;
+};
+
+std::vector<Disc> makeDiscs(TRandom &rnd, const std::vector<int> &styleIds,
+                            int count) {
+  std::vector<Disc> discs;
+  for (int d = 0; d < count; ++d) {
+    Disc disc = {TPointD(random(rnd, 0.0, c_cameraRes.lx),
+                         random(rnd, 0.0, c_cameraRes.ly)),
+                 TPointD(random(rnd, -8.0, 8.0), random(rnd, -8.0, 8.0)),
+                 random(rnd, 10.0, 120.0),
+                 styleIds[rnd.getInt(0, (int)styleIds.size())]};
+    discs.push_back(disc);
+  }
+
+  return discs;
+}
+
+//-------------------------------------------------------------------
+
+TToonzImageP makeToonzFrame(TPalette *palette, const std::vector<Disc> &discs,
+                            int frame) {
+  const double inkWidth = 3.0;
+
+  TRasterCM32P ras(c_cameraRes);
+  ras->fill(TPixelCM32());
+
+  ras->lock();
+  for (const Disc &disc : discs) {
+    TPointD center    = disc.m_center + frame * disc.m_speed;
+    double inkRadius  = disc.m_radius + 0.5 * inkWidth;
+    double outRadius  = disc.m_radius + inkWidth;
+    double inkOpaqueR = 0.5 * inkWidth - 1.0;
+
+    int x0 = std::max(0, tfloor(center.x - outRadius)),
+        x1 = std::min(ras->getLx() - 1, tceil(center.x + outRadius)),
+        y0 = std::max(0, tfloor(center.y - outRadius)),
+        y1 = std::min(ras->getLy() - 1, tceil(center.y + outRadius));
+
+    for (int y = y0; y <= y1; ++y) {
+      TPixelCM32 *pix = ras->pixels(y) + x0;
+      for (int x = x0; x <= x1; ++x, ++pix) {
+        double dist = norm(TPointD(x, y) - center);
+        if (dist >= outRadius) continue;
+
+        int paint = (dist < inkRadius) ? disc.m_styleId : pix->getPaint();
+        int tone  = tcrop(
+            tround(255.0 * (fabs(dist - inkRadius) - inkOpaqueR)), 0, 255);
+
+        *pix = TPixelCM32(1, paint, tone);
+      }
+    }
+  }
+  ras->unlock();
+
+  TToonzImageP ti(ras, ras->getBounds());
+  ti->setPalette(palette);
+  ti->setDpi(c_dpi, c_dpi);
+
+  return ti;
+}
+
+//-------------------------------------------------------------------
+
+//! A white hexagon on transparent background, used as bokeh iris.
+TRasterImageP makeIrisImage(int size) {
+  TRaster32P ras(size, size);
+  ras->fill(TPixel32::Transparent);
+
+  TPointD center(0.5 * size, 0.5 * size);
+  double apothem = 0.45 * size;
+
+  ras->lock();
+  for (int y = 0; y < size; ++y) {
+    TPixel32 *pix = ras->pixels(y);
+    for (int x = 0; x < size; ++x, ++pix) {
+      TPointD p(TPointD(x + 0.5, y + 0.5) - center);
+
+      bool inside = true;
+      for (int e = 0; e < 6 && inside; ++e) {
+        double angle = e * M_PI / 3.0;
+        inside = (p.x * cos(angle) + p.y * sin(angle) < apothem);
+      }
+
+      if (inside) *pix = TPixel32::White;
+    }
+  }
+  ras->unlock();
+
+  TRasterImageP ri(ras);
+  ri->setDpi(c_dpi, c_dpi);
+
+  return ri;
+}
+
+//-------------------------------------------------------------------
+
+//! A striped capsule on transparent background, used as plastic texture.
+TRaster32P makeBodyRaster(const TDimension &size) {
+  TRaster32P ras(size);
+  ras->fill(TPixel32::Transparent);
+
+  double radius = 0.5 * size.ly - 8.0;
+  TPointD a(8.0 + radius, 0.5 * size.ly), b(size.lx - 8.0 - radius, a.y);
+
+  ras->lock();
+  for (int y = 0; y < size.ly; ++y) {
+    TPixel32 *pix = ras->pixels(y);
+    for (int x = 0; x < size.lx; ++x, ++pix) {
+      TPointD p(x + 0.5, y + 0.5);
+      TPointD q(tcrop(p.x, a.x, b.x), a.y);
+      if (norm(p - q) >= radius) continue;
+
+      *pix = ((x / 32) % 2) ? TPixel32(220, 120, 40) : TPixel32(40, 120, 220);
+    }
+  }
+  ras->unlock();
+
+  return ras;
+}
+
+//===================================================================
+//    Scene building
+//-------------------------------------------------------------------
+
+std::unique_ptr<ToonzScene> newScene(const TFilePath &scenePath) {
+  std::unique_ptr<ToonzScene> scene(new ToonzScene());
+  TProjectManager::instance()->initializeScene(scene.get());
+
+  // Levels are written relative to the scene, in $scenefolder
+  scene->setScenePath(scenePath);
+
+  TCamera *camera = scene->getCurrentCamera();
+  camera->setRes(c_cameraRes);
+  camera->setSize(
+      TDimensionD(c_cameraRes.lx / c_dpi, c_cameraRes.ly / c_dpi));
+
+  scene->getProperties()->setBgColor(TPixel32::White);
+
+  return scene;
+}
+
+//-------------------------------------------------------------------
+
+TXshSimpleLevel *newLevel(ToonzScene *scene, int type,
+                          const std::wstring &name, const std::wstring &ext,
+                          const TDimension &res = TDimension()) {
+  bool frameNumbered = (type == OVL_XSHLEVEL || type == MESH_XSHLEVEL);
+  TFilePath path     = TFilePath("$scenefolder") +
+                   TFilePath(name + (frameNumbered ? L".." : L".") + ext);
+
+  TXshSimpleLevel *sl = scene->createNewLevel(type, name, res, c_dpi, path)
+                            ->getSimpleLevel();
+  if (type == MESH_XSHLEVEL) {
+    LevelProperties *prop = sl->getProperties();
+    prop->setDpiPolicy(LevelProperties::DP_ImageDpi);
+    prop->setDpi(c_dpi);
+  }
+
+  return sl;
+}
+
+//-------------------------------------------------------------------
+
+//! Appends a column exposing the level's frames in a loop, and returns its
+//! index.
+int addLevelColumn(TXsheet *xsh, TXshSimpleLevel *sl) {
+  std::vector<TFrameId> fids;
+  sl->getFids(fids);
+
+  int col = xsh->getColumnCount();
+  xsh->insertColumn(col, TXshColumn::toColumnType(sl->getType()));
+
+  for (int r = 0; r < c_frameCount; ++r)
+    xsh->setCell(r, col, TXshCell(sl, fids[r % fids.size()]));
+
+  return col;
+}
+
+//-------------------------------------------------------------------
+
+TFx *createFx(const std::string &fxId) {
+  TFx *fx = TFx::create(fxId);
+  if (!fx) throw TException("Unknown fx: " + fxId);
+
+  return fx;
+}
+
+//-------------------------------------------------------------------
+
+//! Adds a normal fx to the fx dag; it's not connected to the xsheet node.
+TFx *addFx(TXsheet *xsh, const std::string &fxId) {
+  TFx *fx = createFx(fxId);
+
+  FxDag *dag = xsh->getFxDag();
+  dag->getInternalFxs()->addFx(fx);
+  dag->assignUniqueId(fx);
+
+  return fx;
+}
+
+//-------------------------------------------------------------------
+
+//! Appends a zerary fx column and returns its column fx.
+TZeraryColumnFx *addZeraryColumn(TXsheet *xsh, const std::string &fxId) {
+  TFx *fx = createFx(fxId);
+
+  TXshZeraryFxColumn *column = new TXshZeraryFxColumn(c_frameCount);
+  column->getZeraryColumnFx()->setZeraryFx(fx);
+  xsh->getFxDag()->assignUniqueId(fx);
+
+  xsh->insertColumn(xsh->getColumnCount(), column);
+
+  return column->getZeraryColumnFx();
+}
+
+//-------------------------------------------------------------------
+
+//! Makes fx the only input of the xsheet node.
+void setXsheetInput(TXsheet *xsh, TFx *fx) {
+  FxDag *dag = xsh->getFxDag();
+
+  TFxSet *terminals = dag->getTerminalFxs();
+  while (terminals->getFxCount() > 0)
+    dag->removeFromXsheet(terminals->getFx(0));
+
+  dag->addToXsheet(fx);
+}
+
+//-------------------------------------------------------------------
+
+void setBoolParam(TFx *fx, const std::string &paramName, bool value) {
+  TBoolParamP param = TParamP(fx->getParams()->getParam(paramName));
+  assert(param);
+  param->setValue(value);
+}
+
+//-------------------------------------------------------------------
+
+TFx *columnFx(TXsheet *xsh, int col) { return xsh->getColumn(col)->getFx(); }
+
+//-------------------------------------------------------------------
+
+void saveScene(ToonzScene *scene) {
+  std::vector<TXshLevel *> levels;
+  scene->getLevelSet()->listLevels(levels);
+
+  for (TXshLevel *level : levels)
+    if (TXshSimpleLevel *sl = level->getSimpleLevel()) sl->save();
+
+  scene->save(scene->getScenePath());
+}
+
+//-------------------------------------------------------------------
+
+TXshSimpleLevel *addVectorLevel(ToonzScene *scene, const std::wstring &name,
+                                TRandom &rnd, int framesCount,
+                                int regionsCount, int strokesCount) {
+  TXshSimpleLevel *sl = newLevel(scene, PLI_XSHLEVEL, name, L"pli");
+
+  TPalette *palette         = sl->getPalette();
+  std::vector<int> styleIds = addRandomStyles(palette, rnd, 16);
+
+  for (int f = 0; f < framesCount; ++f)
+    sl->setFrame(TFrameId(f + 1), makeVectorFrame(palette, styleIds, rnd,
+                                                  regionsCount, strokesCount));
+
+  return sl;
+}
+
+//-------------------------------------------------------------------
+
+TXshSimpleLevel *addToonzLevel(ToonzScene *scene, const std::wstring &name,
+                               TRandom &rnd, int framesCount, int stylesCount,
+                               int discsCount) {
+  TXshSimpleLevel *sl =
+      newLevel(scene, TZP_XSHLEVEL, name, L"tlv", c_cameraRes);
+
+  TPalette *palette       = sl->getPalette();
+  std::vector<Disc> discs =
+      makeDiscs(rnd, addRandomStyles(palette, rnd, stylesCount), discsCount);
+
+  for (int f = 0; f < framesCount; ++f)
+    sl->setFrame(TFrameId(f + 1), makeToonzFrame(palette, discs, f));
+
+  return sl;
+}
+
+//===================================================================
+//    Scenes
+//-------------------------------------------------------------------
+
+void makeVectorScene(const TFilePath &folder) {
+  std::unique_ptr<ToonzScene> scene(newScene(folder + "vector.tnz"));
+  TXsheet *xsh = scene->getXsheet();
+  TRandom rnd(1);
+
+  for (int c = 0; c < 4; ++c)
+    addLevelColumn(xsh, addVectorLevel(scene.get(),
+                                       L"vector" + std::to_wstring(c + 1),
+                                       rnd, 12, 200, 200));
+
+  saveScene(scene.get());
+}
+
+//-------------------------------------------------------------------
+
+void makeStrokesScene(const TFilePath &folder) {
+  std::unique_ptr<ToonzScene> scene(newScene(folder + "strokes.tnz"));
+  TXsheet *xsh = scene->getXsheet();
+  TRandom rnd(7);
+
+  // Dense strokes with procedural styles, sampled along their length
+  for (int c = 0; c < 2; ++c) {
+    TXshSimpleLevel *sl = newLevel(
+        scene.get(), PLI_XSHLEVEL, L"strokes" + std::to_wstring(c + 1), L"pli");
+
+    TPalette *palette         = sl->getPalette();
+    std::vector<int> styleIds = addStrokeStyles(palette);
+
+    for (int f = 0; f < 12; ++f)
+      sl->setFrame(TFrameId(f + 1),
+                   makeVectorFrame(palette, styleIds, rnd, 0, 400));
+
+    addLevelColumn(xsh, sl);
+  }
+
+  saveScene(scene.get());
+}
+
+//-------------------------------------------------------------------
+
+void makeToonzRasterScene(const TFilePath &folder) {
+  std::unique_ptr<ToonzScene> scene(newScene(folder + "tlv.tnz"));
+  TXsheet *xsh = scene->getXsheet();
+  TRandom rnd(2);
+
+  // Large palettes, to stress the colormap conversion
+  for (int c = 0; c < 3; ++c)
+    addLevelColumn(xsh,
+                   addToonzLevel(scene.get(), L"tlv" + std::to_wstring(c + 1),
+                                 rnd, 12, 250, 150));
+
+  saveScene(scene.get());
+}
+
+//-------------------------------------------------------------------
+
+void makeFxDagScene(const TFilePath &folder) {
+  std::unique_ptr<ToonzScene> scene(newScene(folder + "fxdag.tnz"));
+  TXsheet *xsh = scene->getXsheet();
+  TRandom rnd(3);
+
+  int col   = addLevelColumn(xsh, addToonzLevel(scene.get(), L"tlv", rnd, 12,
+                                                32, 60));
+  TFx *grad = addZeraryColumn(xsh, "STD_radialGradientFx");
+
+  TFx *base = addFx(xsh, "overFx");
+  base->connect("Source1", columnFx(xsh, col));
+  base->connect("Source2", grad);
+
+  // A deep chain, with the base image joining it again every few fxs
+  static const char *const chainIds[] = {"STD_blurFx", "STD_brightContFx",
+                                         "STD_hsvScaleFx", "STD_glowFx"};
+
+  const int chainLength = 32;
+
+  TFx *fx = base;
+  for (int i = 0; i < chainLength; ++i) {
+    TFx *next = addFx(xsh, chainIds[i % 4]);
+    switch (i % 4) {
+    case 0:
+      TFxUtil::setParam(next, "value", 3.0);
+      break;
+    case 1:
+      TFxUtil::setParam(next, "brightness", 5.0);
+      TFxUtil::setParam(next, "contrast", 5.0);
+      break;
+    case 2:
+      TFxUtil::setParam(next, "hue", 10.0);
+      break;
+    case 3:
+      TFxUtil::setParam(next, "value", 10.0);
+      next->connect("Light", base);
+      break;
+    }
+    next->connect("Source", fx);
+    fx = next;
+
+    if (i % 8 == 7) {
+      TFx *blend = addFx(xsh, (i % 16 == 7) ? "addFx" : "multFx");
+      blend->connect("Source1", fx);
+      blend->connect("Source2", base);
+      fx = blend;
+    }
+  }
+
+  setXsheetInput(xsh, fx);
+
+  saveScene(scene.get());
+}
+
+//-------------------------------------------------------------------
+
+void makeParticlesScene(const TFilePath &folder) {
+  std::unique_ptr<ToonzScene> scene(newScene(folder + "particles.tnz"));
+  TXsheet *xsh = scene->getXsheet();
+  TRandom rnd(4);
+
+  int col = addLevelColumn(
+      xsh, addVectorLevel(scene.get(), L"particle", rnd, 1, 6, 4));
+
+  TZeraryColumnFx *particlesColumnFx =
+      addZeraryColumn(xsh, "STD_particlesFx");
+
+  TFx *particles = particlesColumnFx->getZeraryFx();
+  TFxUtil::setParam(particles, "birth_rate", 400.0);
+  particles->connect("Texture1", columnFx(xsh, col));
+
+  setXsheetInput(xsh, particlesColumnFx);
+
+  saveScene(scene.get());
+}
+
+//-------------------------------------------------------------------
+
+void makeBokehScene(const TFilePath &folder) {
+  std::unique_ptr<ToonzScene> scene(newScene(folder + "bokeh.tnz"));
+  TXsheet *xsh = scene->getXsheet();
+  TRandom rnd(5);
+
+  TXshSimpleLevel *iris =
+      newLevel(scene.get(), OVL_XSHLEVEL, L"iris", L"png", TDimension(64, 64));
+  iris->setFrame(TFrameId(1), makeIrisImage(64));
+
+  int layerCols[] = {
+      addLevelColumn(xsh,
+                     addVectorLevel(scene.get(), L"far", rnd, 6, 100, 100)),
+      addLevelColumn(xsh,
+                     addToonzLevel(scene.get(), L"mid", rnd, 6, 32, 60)),
+      addLevelColumn(xsh,
+                     addVectorLevel(scene.get(), L"near", rnd, 6, 40, 40))};
+
+  int irisCol = addLevelColumn(xsh, iris);
+
+  TFx *bokeh = addFx(xsh, "STD_iwa_BokehFx");
+  bokeh->connect("Iris", columnFx(xsh, irisCol));
+
+  const double distances[] = {0.8, 0.5, 0.2};
+  for (int l = 0; l < 3; ++l) {
+    std::string layer = std::to_string(l + 1);
+    bokeh->connect("Source" + layer, columnFx(xsh, layerCols[l]));
+    TFxUtil::setParam(bokeh, "distance" + layer, distances[l]);
+  }
+
+  setXsheetInput(xsh, bokeh);
+
+  saveScene(scene.get());
+}
+
+//-------------------------------------------------------------------
+
+void makePegbarsScene(const TFilePath &folder) {
+  std::unique_ptr<ToonzScene> scene(newScene(folder + "pegbars.tnz"));
+  TXsheet *xsh = scene->getXsheet();
+  TRandom rnd(6);
+
+  // Many columns hanging from a deep pegbar chain. Every few pegbars one
+  // moves along a spline.
+  const int pegbarsCount = 400, columnsCount = 40;
+
+  TStageObjectTree *tree = xsh->getStageObjectTree();
+
+  for (int p = 0; p < pegbarsCount; ++p) {
+    TStageObject *pegbar = xsh->getStageObject(TStageObjectId::PegbarId(p));
+    if (p > 0) pegbar->setParent(TStageObjectId::PegbarId(p - 1));
+
+    TDoubleParam *angle = pegbar->getParam(TStageObject::T_Angle);
+    angle->setValue(0, 0.0);
+    angle->setValue(c_frameCount - 1, random(rnd, -3.0, 3.0));
+
+    if (p % 10 == 0) {
+      std::vector<TThickPoint> points;
+      for (int i = 0; i < 9; ++i)
+        points.push_back(
+            TThickPoint(TPointD(-4.0 + i, random(rnd, -2.0, 2.0)), 0.0));
+
+      TStageObjectSpline *spline = tree->createSpline();
+      spline->setStroke(new TStroke(points));
+      pegbar->setSpline(spline);
+
+      TDoubleParam *posPath = pegbar->getParam(TStageObject::T_Path);
+      posPath->setValue(0, 0.0);
+      posPath->setValue(c_frameCount - 1, 100.0);
+    } else {
+      TDoubleParam *x = pegbar->getParam(TStageObject::T_X);
+      x->setValue(0, 0.0);
+      x->setValue(c_frameCount - 1, random(rnd, -0.02, 0.02));
+    }
+  }
+
+  TXshSimpleLevel *sl =
+      addVectorLevel(scene.get(), L"pegbars", rnd, 1, 10, 10);
+
+  for (int c = 0; c < columnsCount; ++c) {
+    int col = addLevelColumn(xsh, sl);
+    xsh->getStageObject(TStageObjectId::ColumnId(col))
+        ->setParent(TStageObjectId::PegbarId(
+            (c + 1) * pegbarsCount / columnsCount - 1));
+  }
+
+  saveScene(scene.get());
+}
+
+//-------------------------------------------------------------------
+
+void makePlasticScene(const TFilePath &folder) {
+  std::unique_ptr<ToonzScene> scene(newScene(folder + "plastic.tnz"));
+  TXsheet *xsh = scene->getXsheet();
+
+  const TDimension bodyRes(640, 240);
+  TRaster32P bodyRas = makeBodyRaster(bodyRes);
+
+  TXshSimpleLevel *body =
+      newLevel(scene.get(), OVL_XSHLEVEL, L"body", L"png", bodyRes);
+  {
+    TRasterImageP ri(bodyRas);
+    ri->setDpi(c_dpi, c_dpi);
+    body->setFrame(TFrameId(1), ri);
+  }
+
+  TXshSimpleLevel *mesh =
+      newLevel(scene.get(), MESH_XSHLEVEL, L"body_mesh", L"mesh");
+  {
+    MeshBuilderOptions opts = {5, 12.0, 1000, TPixel64::Transparent};
+
+    TMeshImageP mi = buildMesh(bodyRas, opts);
+    transform(mi, TTranslation(-bodyRas->getCenterD()));
+    mi->setDpi(c_dpi, c_dpi);
+    mesh->setFrame(TFrameId(1), mi);
+  }
+
+  int meshCol = addLevelColumn(xsh, mesh);
+  int bodyCol = addLevelColumn(xsh, body);
+
+  xsh->getStageObject(TStageObjectId::ColumnId(bodyCol))
+      ->setParent(TStageObjectId::ColumnId(meshCol));
+
+  // A 5 vertices chain along the capsule, waving during the scene
+  PlasticSkeletonP skeleton = new PlasticSkeleton;
+
+  int v = -1;
+  for (int i = 0; i < 5; ++i)
+    v = skeleton->addVertex(
+        PlasticSkeletonVertex(TPointD(-240.0 + 120.0 * i, 0.0)), v);
+
+  PlasticSkeletonDeformationP sd = new PlasticSkeletonDeformation;
+  sd->attach(1, skeleton.getPointer());
+
+  for (v = 1; v < 5; ++v) {
+    const TDoubleParamP &angle =
+        sd->vertexDeformation(1, v)->m_params[SkVD::ANGLE];
+
+    angle->setValue(0, 0.0);
+    angle->setValue(c_frameCount / 2, (v % 2) ? 30.0 : -30.0);
+    angle->setValue(c_frameCount - 1, 0.0);
+  }
+
+  xsh->getStageObject(TStageObjectId::ColumnId(meshCol))
+      ->setPlasticSkeletonDeformation(sd);
+
+  saveScene(scene.get());
+}
+
+//-------------------------------------------------------------------
+
+//! Every ino blend mode, chained on the same back layer. The scene is written
+//! once per channel width, so renders from two builds can be compared frame
+//! by frame in both the 8 and 16 bits blend paths.
+void makeBlendsScene(const TFilePath &folder, const std::wstring &name,
+                     int bpp) {
+  std::unique_ptr<ToonzScene> scene(newScene(folder + (name + L".tnz")));
+  TXsheet *xsh = scene->getXsheet();
+  TRandom rnd(8);
+
+  TOutputProperties *output = scene->getProperties()->getOutputProperties();
+  TRenderSettings rs        = output->getRenderSettings();
+  rs.m_bpp                  = bpp;
+  output->setRenderSettings(rs);
+
+  if (bpp == 64) {
+    TEnumProperty *tifBpp = dynamic_cast<TEnumProperty *>(
+        output->getFileFormatProperties("tif")->getProperty("Bits Per Pixel"));
+    if (tifBpp) tifBpp->setValue(L"64(RGBM)");
+  }
+
+  // Discs on transparent background, so that both the transparent and the
+  // opaque pixels of each layer go through the blend functions
+  int backCol   = addLevelColumn(
+      xsh, addToonzLevel(scene.get(), name + L"_back", rnd, 6, 32, 60));
+  int foreCols[] = {
+      addLevelColumn(xsh, addToonzLevel(scene.get(), name + L"_fore", rnd, 6,
+                                        32, 60)),
+      addLevelColumn(xsh, addVectorLevel(scene.get(), name + L"_vector", rnd,
+                                         6, 60, 60))};
+
+  static const char *const blendIds[] = {
+      "STD_inoOverFx",          "STD_inoDarkenFx",
+      "STD_inoMultiplyFx",      "STD_inoColorBurnFx",
+      "STD_inoLinearBurnFx",    "STD_inoDarkerColorFx",
+      "STD_inoLightenFx",       "STD_inoScreenFx",
+      "STD_inoColorDodgeFx",    "STD_inoLinearDodgeFx",
+      "STD_inoLighterColorFx",  "STD_inoOverlayFx",
+      "STD_inoSoftLightFx",     "STD_inoHardLightFx",
+      "STD_inoVividLightFx",    "STD_inoLinearLightFx",
+      "STD_inoPinLightFx",      "STD_inoHardMixFx",
+      "STD_inoCrossDissolveFx", "STD_inoAddFx",
+      "STD_inoDivideFx",        "STD_inoSubtractFx",
+      "STD_inoSubtractFx"};
+
+  const int blendsCount = sizeof(blendIds) / sizeof(blendIds[0]);
+
+  TFx *fx = columnFx(xsh, backCol);
+  for (int i = 0; i < blendsCount; ++i) {
+    TFx *blend = addFx(xsh, blendIds[i]);
+    blend->connect("Fore", columnFx(xsh, foreCols[i % 2]));
+    blend->connect("Back", fx);
+
+    // Both clipping mask settings, and the 2 subtract alpha modes
+    if (i % 4 >= 2) setBoolParam(blend, "clipping_mask", false);
+    if (i == blendsCount - 1) setBoolParam(blend, "alpha_rendering", false);
+
+    fx = blend;
+  }
+
+  setXsheetInput(xsh, fx);
+
+  saveScene(scene.get());
+}
+
+}  // namespace
+
+//***********************************************************************************
+//    makeBenchmarkScenes  implementation
+//***********************************************************************************
+
+void makeBenchmarkScenes(const TFilePath &folder) {
+  if (TFileStatus(folder).doesExist() &&
+      !TSystem::readDirectory(folder, false).empty())
+    throw TException("The folder " + ::to_string(folder) + " is not empty");
+
+  TSystem::mkDir(folder);
+
+  makeVectorScene(folder);
+  makeStrokesScene(folder);
+  makeToonzRasterScene(folder);
+  makeFxDagScene(folder);
+  makeParticlesScene(folder);
+  makeBokehScene(folder);
+  makePegbarsScene(folder);
+  makePlasticScene(folder);
+  makeBlendsScene(folder, L"blends", 32);
+  makeBlendsScene(folder, L"blends64", 64);
+}
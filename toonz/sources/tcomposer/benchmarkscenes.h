@@ -0,0 +1,29 @@
+#pragma once
+
+#ifndef BENCHMARKSCENES_H
+#define BENCHMARKSCENES_H
+
+class TFilePath;
+
+//! Writes the synthetic render benchmark scenes, together with their levels,
+//! to the specified folder (which must not exist or be empty). Every scene is
+//! built from fixed random seeds, so repeated runs produce the same files.
+/*!
+  The set covers the main render paths:
+
+  \li \b vector: dense ToonzVector levels with filled regions
+  \li \b strokes: dense ToonzVector strokes with procedural stroke styles
+  \li \b tlv: ToonzRaster levels with large palettes
+  \li \b fxdag: a deep chain of standard raster fxs
+  \li \b particles: a particles fx with a vector texture
+  \li \b bokeh: a 3-layer iwa bokeh with a raster iris
+  \li \b pegbars: columns hanging from a 400 pegbars deep hierarchy
+  \li \b plastic: a skeleton-animated plastic mesh
+  \li \b blends, \b blends64: every ino blend mode chained, rendered at 8
+      and 16 bits per channel
+
+  \throw TException on failure.
+*/
+void makeBenchmarkScenes(const TFilePath &folder);
+
+#endif  // BENCHMARKSCENES_H
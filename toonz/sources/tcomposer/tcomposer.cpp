@@ -6,6 +6,8 @@
 // TFarmController includes
 #include "tfarmcontroller.h"
 
+#include "benchmarkscenes.h"
+
 // TnzStdfx includes
 #include "stdfx/shaderfx.h"
 
@@ -44,6 +46,7 @@
 #include "tunit.h"
 #include "tenv.h"
 #include "tpassivecachemanager.h"
+#include "tpredictivecachemanager.h"
 //#include "tcacheresourcepool.h"
 
 // TnzCore includes
@@ -70,11 +73,23 @@
 #include <QApplication>
 #include <QWaitCondition>
 #include <QMessageBox>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QFile>
+
+// STD includes
+#include <algorithm>
 
 #ifdef _WIN32
 #ifndef x64
 #include <float.h>
 #endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
 #endif
 
 //==================================================================================
@@ -210,6 +225,42 @@ TFarmController *FarmController = 0;
 TUserLogAppend *m_userLog;
 QString TaskId;
 
+// Benchmark mode: completion time of each rendered frame, measured from the
+// render start
+bool BenchmarkMode = false;
+QElapsedTimer RenderTimer;
+std::vector<std::pair<int, double>> FrameCompletionTimes;
+// Scene load phases: scene file parsing, then level loading (seconds)
+double SceneParseTime = 0.0, LevelsLoadTime = 0.0;
+
+//-------------------------------------------------------------------------------
+
+//! Returns the peak resident set size of the process, in KB.
+TINT64 getPeakRss() {
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS pmc;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+    return pmc.PeakWorkingSetSize >> 10;
+  return 0;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef MACOSX
+  return usage.ru_maxrss >> 10;  // bytes
+#else
+  return usage.ru_maxrss;  // KB
+#endif
+#endif
+}
+
+//-------------------------------------------------------------------------------
+
+void recordFrameCompletion(int frame) {
+  if (BenchmarkMode)
+    FrameCompletionTimes.push_back(
+        std::make_pair(frame, RenderTimer.nsecsElapsed() / 1.0e9));
+}
+
 //-------------------------------------------------------------------------------
 
 void tcomposerRunOutOfContMemHandler(unsigned long size) {
@@ -263,6 +314,7 @@ bool MyMovieRenderListener::onFrameCompleted(int frame) {
   cout << msg << endl;
   m_userLog->info(msg);
   DVGui::info(QString::fromStdString(msg));
+  recordFrameCompletion(frame + 1);
   if (FarmController) {
     try {
       FarmController->taskProgress(TaskId,
@@ -346,6 +398,7 @@ bool MyMultimediaRenderListener::onFrameCompleted(int frame, int column) {
                ", frame " + std::to_string(actualFrame) + " computed";
   cout << msg << endl;
   m_userLog->info(msg);
+  recordFrameCompletion(actualFrame);
   if (FarmController) {
     try {
       FarmController->taskProgress(TaskId,
@@ -472,6 +525,7 @@ static std::pair<int, int> generateMovie(ToonzScene *scene, const TFilePath &fp,
                 multimediaRenderer.getColumnsCount());
     multimediaRenderer.addListener(listener);
 
+    RenderTimer.start();
     multimediaRenderer.start();
 
     //----------------- main thread remains above until render is done
@@ -532,6 +586,7 @@ static std::pair<int, int> generateMovie(ToonzScene *scene, const TFilePath &fp,
       movieRenderer.addFrame(r, fx);
     }
 
+    RenderTimer.start();
     movieRenderer.start();
 
     // Start main loop
@@ -548,6 +603,94 @@ static std::pair<int, int> generateMovie(ToonzScene *scene, const TFilePath &fp,
   }
 }
 
+//==================================================================================
+
+static void writeBenchmarkReport(const TFilePath &reportPath,
+                                 const TFilePath &scenePath,
+                                 const TDimension &cameraRes, int shrink,
+                                 int threadCount, int maxTileSize,
+                                 const std::pair<int, int> &framePair,
+                                 double loadTime) {
+  double renderTime = RenderTimer.nsecsElapsed() / 1.0e9;
+
+  QJsonObject report;
+  report["application"] =
+      QString::fromStdString(TEnv::getApplicationFullName());
+  report["scene"]   = scenePath.getQString();
+  report["width"]   = cameraRes.lx / shrink;
+  report["height"]  = cameraRes.ly / shrink;
+  report["shrink"]  = shrink;
+  report["threads"] = threadCount;
+  if (maxTileSize != (std::numeric_limits<int>::max)())
+    report["maxTileSize"] = maxTileSize;  // MB
+
+  report["framesCompleted"] = framePair.first;
+  report["framesRequested"] = framePair.second;
+  report["loadTime"]        = loadTime;  // seconds
+  report["sceneParseTime"]  = SceneParseTime;
+  report["levelsLoadTime"]  = LevelsLoadTime;
+  report["renderTime"]      = renderTime;
+  report["fps"] = (renderTime > 0.0) ? framePair.first / renderTime : 0.0;
+
+  QJsonArray frames;
+  for (const std::pair<int, double> &frameTime : FrameCompletionTimes) {
+    QJsonObject frame;
+    frame["frame"] = frameTime.first;
+    frame["time"]  = frameTime.second;  // seconds since render start
+    frames.append(frame);
+  }
+  report["frames"] = frames;
+
+  report["rasterPeak"] =  // KB
+      (double)TBigMemoryManager::instance()->getAllocationPeak();
+  report["peakRss"] = (double)getPeakRss();  // KB
+
+  // Node results shared between the rendered frames
+  const TPredictiveCacheManager::SharingStats &stats =
+      TPredictiveCacheManager::instance()->getSharingStats();
+  QJsonObject sharing;
+  sharing["requestedEvaluations"] = stats.m_requestedEvaluations;
+  sharing["savedEvaluations"]     = stats.m_savedEvaluations;
+  sharing["sharedResults"]        = stats.m_sharedResults;
+  sharing["crossFrameResults"]    = stats.m_crossFrameResults;
+  sharing["droppedResults"]       = stats.m_droppedResults;
+  sharing["retainedMemory"]       = (double)stats.m_retainedMemory;  // KB
+  report["sharing"]               = sharing;
+
+  // Fx types sorted by decreasing self time
+  std::map<std::string, TRasterFx::ComputeTiming> timings =
+      TRasterFx::getComputeTimings();
+  std::vector<std::pair<double, std::string>> sortedTimings;
+  for (auto it = timings.begin(); it != timings.end(); ++it)
+    sortedTimings.push_back(std::make_pair(it->second.m_selfTime, it->first));
+  std::sort(sortedTimings.rbegin(), sortedTimings.rend());
+
+  QJsonArray fxs;
+  for (const std::pair<double, std::string> &sortedTiming : sortedTimings) {
+    const TRasterFx::ComputeTiming &timing = timings[sortedTiming.second];
+    QJsonObject fx;
+    fx["type"]     = QString::fromStdString(sortedTiming.second);
+    fx["calls"]    = timing.m_calls;
+    fx["selfTime"] = timing.m_selfTime / 1000.0;  // seconds
+    fxs.append(fx);
+  }
+  report["fxs"] = fxs;
+
+  QFile file(reportPath.getQString());
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    string msg =
+        "Couldn't write the benchmark report " + ::to_string(reportPath);
+    cout << msg << endl;
+    m_userLog->error(msg);
+    return;
+  }
+  file.write(QJsonDocument(report).toJson());
+
+  string msg = "Benchmark report written to " + ::to_string(reportPath);
+  cout << msg << endl;
+  m_userLog->info(msg);
+}
+
 //==================================================================================
 //
 // main()
@@ -578,8 +721,14 @@ int main(int argc, char *argv[]) {
   StringQualifier tileSize("-maxtilesize n",
                            "Enable tile rendering of max n MB per tile");
   StringQualifier tmsg("-tmsg val", "only internal use");
-  usageLine = srcName + dstName + range + stepOpt + shrinkOpt + multimedia +
-              farmData + idq + nthreads + tileSize + tmsg;
+  FilePathQualifier benchmark(
+      "-benchmark reportFile",
+      "Write render timings and memory usage to reportFile (JSON)");
+  TCli::Switcher makeBenchmarkScenesOpt(
+      "-makebenchmarkscenes",
+      "Write the synthetic benchmark scenes to folder, then quit");
+  TCli::FilePathArgument benchmarkScenesFolder(
+      "folder", "Benchmark scenes folder (must not exist or be empty)");
 
   // system path qualifiers
   std::map<QString, std::unique_ptr<TCli::QualifierT<TFilePath>>>
@@ -608,7 +757,10 @@ int main(int argc, char *argv[]) {
   }
 
   Usage usage(argv[0]);
-  usage.add(usageLine);
+  usage.add(usageLine + srcName + dstName + range + stepOpt + shrinkOpt +
+            multimedia + farmData + idq + nthreads + tileSize + tmsg +
+            benchmark);
+  usage.add(usageLine + makeBenchmarkScenesOpt + benchmarkScenesFolder);
   if (!usage.parse(argc, argv)) exit(1);
 
   QHash<QString, QString> argumentPathValues;
@@ -762,6 +914,24 @@ int main(int argc, char *argv[]) {
     loadShaderInterfaces(ToonzFolder::getLibraryFolder() +
                          TFilePath("shaders"));
 
+    if (makeBenchmarkScenesOpt.isSelected()) {
+      TFilePath folder = benchmarkScenesFolder.getValue();
+      try {
+        makeBenchmarkScenes(folder);
+      } catch (TException &e) {
+        msg = "Couldn't write the benchmark scenes: " +
+              ::to_string(e.getMessage());
+        cerr << msg << endl;
+        m_userLog->error(msg);
+        return -2;
+      }
+
+      msg = "Benchmark scenes written to " + ::to_string(folder);
+      cout << msg << endl;
+      m_userLog->info(msg);
+      return 0;
+    }
+
     //#endif
 
     //---------------------------------------------------------
@@ -800,8 +970,18 @@ int main(int argc, char *argv[]) {
     TImageStyle::setCurrentScene(scene);
 
     try {
+      // Same as ToonzScene::load(), timing each phase
+      QElapsedTimer loadTimer;
+      loadTimer.start();
       Sw2.start();
-      scene->load(srcFilePath);
+
+      scene->loadNoResources(srcFilePath);
+      SceneParseTime = loadTimer.nsecsElapsed() / 1.0e9;
+
+      scene->loadResources();
+      scene->setVersionNumber(VersionNumber());
+      LevelsLoadTime = loadTimer.nsecsElapsed() / 1.0e9 - SceneParseTime;
+
       Sw2.stop();
     } catch (TException &e) {
       cout << ::to_string(e.getMessage()) << endl;
@@ -942,6 +1122,11 @@ int main(int argc, char *argv[]) {
     // TPassiveCacheManager...
     TPassiveCacheManager::instance()->setEnabled(false);
 
+    if (benchmark.isSelected()) {
+      BenchmarkMode = true;
+      TRasterFx::enableComputeTimings(true);
+    }
+
 #ifdef _WIN32
 #ifndef x64
     // On 32-bit architecture, there could be cases in which initialization
@@ -986,6 +1171,13 @@ int main(int argc, char *argv[]) {
     cout << msg + msg2;
     m_userLog->info(msg + msg2);
     DVGui::info(QString::fromStdString(msg));
+
+    if (BenchmarkMode) {
+      TDimension cameraRes = scene->getCurrentCamera()->getRes();
+      writeBenchmarkReport(benchmark.getValue(), srcFilePath, cameraRes,
+                           shrink, threadCount, maxTileSize, framePair,
+                           Sw2.getTotalTime() / 1000.0);
+    }
     TImageCache::instance()->clear(true);
   } catch (TException &e) {
     msg = "Untrapped exception: " + ::to_string(e.getMessage()), cout << msg
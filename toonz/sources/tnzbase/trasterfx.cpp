@@ -21,6 +21,13 @@
 #include "tfxcachemanager.h"
 #include "trenderer.h"
 
+// Qt includes
+#include <QElapsedTimer>
+#include <QThread>
+
+// STD includes
+#include <atomic>
+
 // Diagnostics
 //#define DIAGNOSTICS
 #ifdef DIAGNOSTICS
@@ -360,6 +367,66 @@ FX_IDENTIFIER_IS_HIDDEN(TrFx, "trFx")
 // render
 // results. Please refer to the ResourceBuilder documentation in
 // tfxcachemanager.cpp
+namespace {
+
+//! Per-fx type compute timings, see TRasterFx::enableComputeTimings().
+struct ComputeTimings {
+  QMutex m_mutex;  //!< Guards m_timings and m_nestedTimes
+  std::atomic<bool> m_enabled;
+
+  std::map<std::string, TRasterFx::ComputeTiming> m_timings;
+
+  //! Stack of time (ns) spent in nested computes, for each render thread
+  std::map<Qt::HANDLE, std::vector<qint64>> m_nestedTimes;
+
+  ComputeTimings() : m_enabled(false) {}
+
+  static ComputeTimings &instance() {
+    static ComputeTimings theInstance;
+    return theInstance;
+  }
+};
+
+//------------------------------------------------------------------------------
+
+//! Measures a doCompute() call. Input fxs are computed inside their output's
+//! doCompute(), so their time is subtracted from the output's one.
+class ComputeTimingScope {
+  std::string m_fxType;
+  QElapsedTimer m_timer;
+
+public:
+  ComputeTimingScope(const std::string &fxType) : m_fxType(fxType) {
+    ComputeTimings &timings = ComputeTimings::instance();
+    {
+      QMutexLocker sl(&timings.m_mutex);
+      timings.m_nestedTimes[QThread::currentThreadId()].push_back(0);
+    }
+    m_timer.start();
+  }
+
+  ~ComputeTimingScope() {
+    qint64 elapsed = m_timer.nsecsElapsed();
+
+    ComputeTimings &timings = ComputeTimings::instance();
+    QMutexLocker sl(&timings.m_mutex);
+
+    std::vector<qint64> &nestedTimes =
+        timings.m_nestedTimes[QThread::currentThreadId()];
+    qint64 nested = nestedTimes.back();
+    nestedTimes.pop_back();
+    if (!nestedTimes.empty()) nestedTimes.back() += elapsed;
+
+    TRasterFx::ComputeTiming &timing = timings.m_timings[m_fxType];
+    ++timing.m_calls;
+    timing.m_selfTime += (elapsed - nested) / 1.0e6;
+  }
+};
+
+}  // namespace
+
+//------------------------------------------------------------------------------
+
 class FxResourceBuilder final : public ResourceBuilder {
   TRasterFxP m_rfx;
   double m_frame;
@@ -447,7 +514,12 @@ void FxResourceBuilder::compute(const TRectD &tileRect) {
 #endif
 
   buildTileToCalculate(tileRect);
-  m_rfx->doCompute(*m_currTile, m_frame, *m_rs);
+
+  if (TRasterFx::areComputeTimingsEnabled()) {
+    ComputeTimingScope timing(m_rfx->getFxType());
+    m_rfx->doCompute(*m_currTile, m_frame, *m_rs);
+  } else
+    m_rfx->doCompute(*m_currTile, m_frame, *m_rs);
 
 #ifdef DIAGNOSTICS
   sw.stop();
@@ -528,6 +600,35 @@ TRasterFx::~TRasterFx() { delete m_rasFxImp; }
 
 //--------------------------------------------------
 
+void TRasterFx::enableComputeTimings(bool on) {
+  ComputeTimings::instance().m_enabled = on;
+}
+
+//--------------------------------------------------
+
+bool TRasterFx::areComputeTimingsEnabled() {
+  return ComputeTimings::instance().m_enabled;
+}
+
+//--------------------------------------------------
+
+std::map<std::string, TRasterFx::ComputeTiming>
+TRasterFx::getComputeTimings() {
+  ComputeTimings &timings = ComputeTimings::instance();
+  QMutexLocker sl(&timings.m_mutex);
+  return timings.m_timings;
+}
+
+//--------------------------------------------------
+
+void TRasterFx::clearComputeTimings() {
+  ComputeTimings &timings = ComputeTimings::instance();
+  QMutexLocker sl(&timings.m_mutex);
+  timings.m_timings.clear();
+}
+
+//--------------------------------------------------
+
 TAffine TRasterFx::handledAffine(const TRenderSettings &info, double frame) {
   return (info.m_affine.a11 == info.m_affine.a22 && info.m_affine.a12 == 0 &&
           info.m_affine.a21 == 0 && info.m_affine.a13 == 0 &&
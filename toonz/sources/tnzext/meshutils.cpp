@@ -2,6 +2,7 @@
 
 // TnzCore includes
 #include "tgl.h"
+#include "tthread.h"
 
 // TnzExt includes
 #include "ext/ttexturesstorage.h"
@@ -524,3 +525,260 @@ GL_SRC_ALPHA, while the latter uses GL_ONE. The result is a PREMULTIPLIED image.
 
   glPopAttrib();
 }
+
+//***********************************************************************************************
+//    Software drawing  implementation
+//***********************************************************************************************
+
+namespace {
+
+//! Face data shared by all the row bands of a software draw.
+struct RasterFace {
+  TPointD m_p[3];  //!< Vertices in output pixels, counterclockwise.
+  bool m_border[3];  //!< Whether the edge opposite to each vertex is on the
+                     //! mesh border.
+  TAffine m_rasToTex;  //!< Output pixels to m_level texels transform.
+  int m_level;         //!< Texture mipmap level.
+};
+
+//-------------------------------------------------------------------------------
+
+//! Adds halved levels to the mipmap chain of a premultiplied texture, until
+//! the specified level or a single pixel is reached.
+void buildMipmaps(std::vector<TRaster32P> &levels, int maxLevel) {
+  while ((int)levels.size() <= maxLevel) {
+    const TRaster32P src = levels.back();
+    int lx = src->getLx(), ly = src->getLy();
+    if (lx == 1 && ly == 1) break;
+
+    TRaster32P dst((lx + 1) >> 1, (ly + 1) >> 1);
+    for (int y = 0; y < dst->getLy(); ++y) {
+      TPixel32 *pix = dst->pixels(y);
+      for (int x = 0; x < dst->getLx(); ++x, ++pix) {
+        // Texels beyond the source count as transparent, like in sample()
+        int r = 0, g = 0, b = 0, m = 0;
+        for (int j = 2 * y; j < std::min(2 * y + 2, ly); ++j) {
+          const TPixel32 *s = src->pixels(j);
+          for (int i = 2 * x; i < std::min(2 * x + 2, lx); ++i)
+            r += s[i].r, g += s[i].g, b += s[i].b, m += s[i].m;
+        }
+        *pix = TPixel32((r + 2) >> 2, (g + 2) >> 2, (b + 2) >> 2,
+                        (m + 2) >> 2);
+      }
+    }
+
+    levels.push_back(dst);
+  }
+}
+
+//-------------------------------------------------------------------------------
+
+//! Bilinear texture lookup, with GL_CLAMP to a transparent border.
+inline void sample(const TRaster32P &tex, TPointD t, double (&out)[4]) {
+  int lx = tex->getLx(), ly = tex->getLy();
+  t.x = tcrop(t.x - 0.5, -1.0, (double)lx);
+  t.y = tcrop(t.y - 0.5, -1.0, (double)ly);
+
+  int x0 = tfloor(t.x), y0 = tfloor(t.y);
+  double fx = t.x - x0, fy = t.y - y0;
+
+  out[0] = out[1] = out[2] = out[3] = 0.0;
+  for (int j = 0; j < 2; ++j) {
+    int y = y0 + j;
+    if (y < 0 || y >= ly) continue;
+
+    const TPixel32 *row = tex->pixels(y);
+    double wy           = j ? fy : 1.0 - fy;
+    for (int i = 0; i < 2; ++i) {
+      int x = x0 + i;
+      if (x < 0 || x >= lx) continue;
+
+      double w = wy * (i ? fx : 1.0 - fx);
+      out[0] += w * row[x].r, out[1] += w * row[x].g;
+      out[2] += w * row[x].b, out[3] += w * row[x].m;
+    }
+  }
+}
+
+//-------------------------------------------------------------------------------
+
+//! Draws the faces, in order, on the ras scanlines [y0, y1].
+void drawFaceRows(const TRaster32P &ras, const std::vector<RasterFace> &faces,
+                  const std::vector<TRaster32P> &levels, int y0, int y1) {
+  int lx = ras->getLx();
+
+  for (const RasterFace &face : faces) {
+    const TPointD *p = face.m_p;
+
+    // Border edges fade out over one pixel outside the face, like the
+    // antialiased lines drawn by tglDraw()
+    double margin =
+        (face.m_border[0] || face.m_border[1] || face.m_border[2]) ? 1.0 : 0.0;
+
+    TRectD faceRect(std::min({p[0].x, p[1].x, p[2].x}) - margin,
+                    std::min({p[0].y, p[1].y, p[2].y}) - margin,
+                    std::max({p[0].x, p[1].x, p[2].x}) + margin,
+                    std::max({p[0].y, p[1].y, p[2].y}) + margin);
+    faceRect *= TRectD(0, y0, lx, y1 + 1);
+
+    int xMin = std::max(tfloor(faceRect.x0), 0),
+        xMax = std::min(tceil(faceRect.x1), lx) - 1,
+        yMin = std::max(tfloor(faceRect.y0), y0),
+        yMax = std::min(tceil(faceRect.y1) - 1, y1);
+    if (xMin > xMax || yMin > yMax) continue;
+
+    // Edge functions, as signed distances from the edges (positive inside).
+    // Ties on shared edges go to one face only, by the top-left rule.
+    double a[3], b[3], c[3];
+    bool tieInside[3];
+    for (int k = 0; k < 3; ++k) {
+      const TPointD &e0 = p[(k + 1) % 3], &e1 = p[(k + 2) % 3];
+      TPointD d         = e1 - e0;
+      double len        = norm(d);
+
+      a[k] = -d.y / len, b[k] = d.x / len;
+      c[k]         = -(a[k] * e0.x + b[k] * e0.y);
+      tieInside[k] = (d.y > 0.0 || (d.y == 0.0 && d.x < 0.0));
+    }
+
+    const TRaster32P &tex = levels[face.m_level];
+    double s[4];
+
+    for (int y = yMin; y <= yMax; ++y) {
+      TPointD pos(xMin + 0.5, y + 0.5);
+
+      double e[3];
+      for (int k = 0; k < 3; ++k) e[k] = a[k] * pos.x + b[k] * pos.y + c[k];
+
+      TPixel32 *pix = ras->pixels(y) + xMin;
+      for (int x = xMin; x <= xMax; ++x, ++pix, pos.x += 1.0) {
+        double cov = 1.0;
+        for (int k = 0; k < 3; ++k) {
+          if (face.m_border[k])
+            cov *= tcrop(e[k] + 1.0, 0.0, 1.0);
+          else if (e[k] < 0.0 || (e[k] == 0.0 && !tieInside[k]))
+            cov = 0.0;
+          e[k] += a[k];
+        }
+        if (cov <= 0.0) continue;
+
+        sample(tex, face.m_rasToTex * pos, s);
+
+        // Premultiplied 'over'
+        double k = 1.0 - cov * s[3] / 255.0;
+        pix->r   = (UCHAR)std::min(cov * s[0] + pix->r * k + 0.5, 255.0);
+        pix->g   = (UCHAR)std::min(cov * s[1] + pix->g * k + 0.5, 255.0);
+        pix->b   = (UCHAR)std::min(cov * s[2] + pix->b * k + 0.5, 255.0);
+        pix->m   = (UCHAR)std::min(cov * s[3] + pix->m * k + 0.5, 255.0);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+//-------------------------------------------------------------------------------
+
+void tDraw(const TRaster32P &ras, const TMeshImage &meshImage,
+           const TRaster32P &texture, const TAffine &meshToTexAff,
+           const TAffine &meshToRasAff,
+           const PlasticDeformerDataGroup &group) {
+  const std::vector<TTextureMeshP> &meshes = meshImage.meshes();
+
+  typedef std::vector<std::pair<int, int>> SortedFacesVector;
+  const SortedFacesVector &sortedFaces = group.m_sortedFaces;
+
+  TRectD rasRect(0, 0, ras->getLx(), ras->getLy());
+
+  std::vector<RasterFace> faces;
+  faces.reserve(sortedFaces.size());
+
+  // Map each face to output and texture pixels, in the same order and with
+  // the same border edges as tglDraw()
+  SortedFacesVector::const_iterator sft, sfEnd(sortedFaces.end());
+  for (sft = sortedFaces.begin(); sft != sfEnd; ++sft) {
+    int f = sft->first, m = sft->second;
+
+    const TTextureMesh *mesh = meshes[m].getPointer();
+    const double *dstCoords  = group.m_datas[m].m_output.get();
+
+    const TTextureMesh::face_type &fc = mesh->face(f);
+
+    const TTextureMesh::edge_type &ed0 = mesh->edge(fc.edge(0)),
+                                  &ed1 = mesh->edge(fc.edge(1)),
+                                  &ed2 = mesh->edge(fc.edge(2));
+
+    int v[3];
+    v[0] = ed0.vertex(0);
+    v[1] = ed0.vertex(1);
+    v[2] = ed1.vertex((ed1.vertex(0) == v[0]) | (ed1.vertex(0) == v[1]));
+
+    int e1ovi = (ed1.vertex(0) == v[1]) | (ed1.vertex(1) == v[1]),
+        e2ovi = 1 - e1ovi;
+
+    RasterFace face;
+    face.m_border[2]     = (ed0.facesCount() < 2);
+    face.m_border[e2ovi] = (ed1.facesCount() < 2);
+    face.m_border[e1ovi] = (ed2.facesCount() < 2);
+
+    TPointD t[3];
+    for (int k = 0; k < 3; ++k) {
+      const double *d = dstCoords + (v[k] << 1);
+      face.m_p[k]     = meshToRasAff * TPointD(d[0], d[1]);
+      t[k]            = meshToTexAff * mesh->vertex(v[k]).P();
+    }
+
+    double area = cross(face.m_p[1] - face.m_p[0], face.m_p[2] - face.m_p[0]);
+    if (area == 0.0) continue;
+    if (area < 0.0) {
+      std::swap(face.m_p[1], face.m_p[2]);
+      std::swap(face.m_border[1], face.m_border[2]);
+      std::swap(t[1], t[2]);
+    }
+
+    TRectD faceRect(face.m_p[0], face.m_p[0]);
+    faceRect += TRectD(face.m_p[1], face.m_p[1]);
+    faceRect += TRectD(face.m_p[2], face.m_p[2]);
+    if (!faceRect.enlarge(1.0).overlaps(rasRect)) continue;
+
+    face.m_rasToTex =
+        TAffine(t[1] - t[0], t[2] - t[0], t[0]) *
+        TAffine(face.m_p[1] - face.m_p[0], face.m_p[2] - face.m_p[0],
+                face.m_p[0])
+            .inv();
+
+    // Pick the mipmap level where a pixel spans at most 2 texels. Magnified
+    // and mildly minified faces sample the texture itself, like GL_LINEAR.
+    double scale = std::max(norm(face.m_rasToTex.rowX()),
+                            norm(face.m_rasToTex.rowY()));
+    face.m_level = (scale >= 2.0) ? std::min(tfloor(log2(scale)), 16) : 0;
+
+    faces.push_back(face);
+  }
+
+  if (faces.empty()) return;
+
+  texture->lock();
+  ras->lock();
+
+  std::vector<TRaster32P> levels(1, texture);
+  int maxLevel = 0;
+  for (const RasterFace &face : faces)
+    maxLevel = std::max(maxLevel, face.m_level);
+  buildMipmaps(levels, maxLevel);
+
+  for (RasterFace &face : faces) {
+    face.m_level = std::min(face.m_level, (int)levels.size() - 1);
+    if (face.m_level > 0)
+      face.m_rasToTex = TScale(1.0 / (1 << face.m_level)) * face.m_rasToTex;
+  }
+
+  // Split the output in row bands. Each band draws every face, in order.
+  int lx = ras->getLx(), ly = ras->getLy();
+  TThread::runInBands(lx, ly, [&](int y0, int y1) {
+    drawFaceRows(ras, faces, levels, y0, y1 - 1);
+  });
+
+  ras->unlock();
+  texture->unlock();
+}
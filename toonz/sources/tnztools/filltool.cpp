@@ -962,6 +962,7 @@ void doFill(const TImageP &img, const TPointD &pos, FillParameters &params,
     }
 
     if (tileSaver.getTileSet()->getTileCount() != 0) {
+      tileSet->shrinkToChanges(ras);
       static int count = 0;
       TSystem::outputDebug("FILL" + std::to_string(count++) + "\n");
       if (offs != TPoint())
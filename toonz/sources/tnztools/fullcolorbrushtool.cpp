@@ -383,6 +383,7 @@ void FullColorBrushTool::paintEnd() {
 
   if (m_tileSet->getTileCount() > 0) {
     delete m_tileSaver;
+    m_tileSet->shrinkToChanges(ras);
     TTool::Application *app   = TTool::getApplication();
     TXshLevel *level          = app->getCurrentLevel()->getLevel();
     TXshSimpleLevelP simLevel = level->getSimpleLevel();
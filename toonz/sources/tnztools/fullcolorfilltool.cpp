@@ -110,6 +110,7 @@ void doFill(const TImageP &img, const TPointD &pos, FillParameters &params,
     fullColorFill(ras, params, &tileSaver);
 
     if (tileSaver.getTileSet()->getTileCount() != 0) {
+      tileSet->shrinkToChanges(ras);
       static int count = 0;
       TSystem::outputDebug("RASTERFILL" + std::to_string(count++) + "\n");
       if (offs != TPoint())
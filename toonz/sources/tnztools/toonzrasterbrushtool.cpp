@@ -1343,6 +1343,7 @@ void ToonzRasterBrushTool::finishRasterBrush(const TPointD &pos,
     m_workRas->unlock();
 
     if (m_tileSet->getTileCount() > 0) {
+      m_tileSet->shrinkToChanges(ti->getRaster());
       TRasterCM32P subras = ras->extract(m_strokeRect)->clone();
       TUndoManager::manager()->add(new MyPaintBrushUndo(
           m_tileSet, simLevel.getPointer(), frameId, m_isFrameCreated,
@@ -1391,6 +1392,7 @@ void ToonzRasterBrushTool::finishRasterBrush(const TPointD &pos,
     invalidate(invalidateRect.enlarge(2));
 
     if (m_tileSet->getTileCount() > 0) {
+      m_tileSet->shrinkToChanges(ti->getRaster());
       TUndoManager::manager()->add(new RasterBrushUndo(
           m_tileSet, m_rasterTrack->getPointsSequence(),
           m_rasterTrack->getStyleId(), m_rasterTrack->isSelective(),
@@ -1479,6 +1481,7 @@ void ToonzRasterBrushTool::finishRasterBrush(const TPointD &pos,
     m_bluredBrush = 0;
 
     if (m_tileSet->getTileCount() > 0) {
+      m_tileSet->shrinkToChanges(ti->getRaster());
       TUndoManager::manager()->add(new RasterBluredBrushUndo(
           m_tileSet, m_points, m_styleId, (DrawOrder)m_drawOrder.getIndex(),
           simLevel.getPointer(), frameId, m_rasThickness.getValue().second,
@@ -9,6 +9,7 @@
 #include "filebrowser.h"
 #include "tconvert.h"
 #include "tsystem.h"
+#include "tlevel_io.h"
 #include "toonz/toonzscene.h"
 #include "toonz/namebuilder.h"
 #include "toonz/tproject.h"
@@ -58,6 +59,11 @@ MyFileSystemWatcher::MyFileSystemWatcher() {
 
   bool ret = connect(m_watcher, SIGNAL(directoryChanged(const QString &)), this,
                      SIGNAL(directoryChanged(const QString &)));
+  // image sequences in the changed folder must be looked up again
+  ret = ret && connect(m_watcher, &QFileSystemWatcher::directoryChanged, this,
+                       [](const QString &path) {
+                         TLevelReader::invalidateFolderIndex(TFilePath(path));
+                       });
   assert(ret);
 }
 
@@ -63,6 +63,9 @@
 #include <QAction>
 #include <QMainWindow>
 #include <QToolButton>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
 
 using namespace DVGui;
 
@@ -221,24 +224,6 @@ Vectorizer::~Vectorizer() {
 
 //-----------------------------------------------------------------------------
 
-TVectorImageP Vectorizer::doVectorize(TImageP img, TPalette *palette,
-                                      const VectorizerConfiguration &conf) {
-  TToonzImageP ti  = img;
-  TRasterImageP ri = img;
-
-  if (!ti && !ri) return TVectorImageP();
-
-  VectorizerCore vCore;
-  connect(&vCore, SIGNAL(partialDone(int, int)), this,
-          SIGNAL(partialDone(int, int)));
-  connect(this, SIGNAL(transmitCancel()), &vCore, SLOT(onCancel()),
-          Qt::DirectConnection);  // Direct connection *must* be
-                                  // established for child cancels
-  return vCore.vectorize(img, conf, palette);
-}
-
-//-----------------------------------------------------------------------------
-
 void Vectorizer::setLevel(const TXshSimpleLevelP &level) {
   m_level = level;
 
@@ -352,58 +337,105 @@ int Vectorizer::doVectorize() {
 
   int count = 0;
 
-  std::vector<TFrameId>::const_iterator ft, fEnd = m_fids.end();
-  for (ft = m_fids.begin(); ft != fEnd; ++ft) {
-    // Retrieve the image to be vectorized
-    TImageP img;
-    if (sl->getType() == OVL_XSHLEVEL || sl->getType() == TZP_XSHLEVEL ||
-        sl->getType() == TZI_XSHLEVEL)
-      img = sl->getFullsampledFrame(*ft, ImageManager::dontPutInCache);
+  // Frames are loaded and vectorized in batches, one frame per thread. Each
+  // frame is reported as soon as it is converted, with the overall throughput.
+  int threadsCount = std::max(1, QThread::idealThreadCount());
+  int framesDone   = 0;
+  QMutex framesDoneMutex;
+  QElapsedTimer timer;
+  timer.start();
+
+  std::vector<TFrameId>::const_iterator ft = m_fids.begin(),
+                                        fEnd = m_fids.end();
+  while (ft != fEnd && !m_isCanceled) {
+    std::vector<TImageP> images;
+    std::vector<TFrameId> fids;
+    QStringList labelNames;
+    std::vector<CenterlineConfiguration> cConfs;
+    std::vector<NewOutlineConfiguration> oConfs;
 
-    if (!img) continue;
+    for (; ft != fEnd && (int)images.size() < threadsCount; ++ft) {
+      // Retrieve the image to be vectorized
+      TImageP img;
+      if (sl->getType() == OVL_XSHLEVEL || sl->getType() == TZP_XSHLEVEL ||
+          sl->getType() == TZI_XSHLEVEL)
+        img = sl->getFullsampledFrame(*ft, ImageManager::dontPutInCache);
 
-    // Build image-toonz coordinate transformation
-    TAffine dpiAff = getDpiAffine(sl, *ft, true);
-    double factor  = norm(dpiAff * TPointD(1, 0));
+      if (!img) continue;
 
-    TPointD center;
-    if (TToonzImageP ti = img)
-      center = ti->getRaster()->getCenterD();
-    else if (TRasterImageP ri = img)
-      center = ri->getRaster()->getCenterD();
+      // Build image-toonz coordinate transformation
+      TAffine dpiAff = getDpiAffine(sl, *ft, true);
+      double factor  = norm(dpiAff * TPointD(1, 0));
 
-    // Build vectorizer configuration
-    double weight = (ft->getNumber() - 1 - frameRange[0]) /
-                    std::max(frameRange[1] - frameRange[0], 1.0);
-    weight = tcrop(weight, 0.0, 1.0);
+      TPointD center;
+      if (TToonzImageP ti = img)
+        center = ti->getRaster()->getCenterD();
+      else if (TRasterImageP ri = img)
+        center = ri->getRaster()->getCenterD();
 
-    locals.updateConfig(weight);  // TEMPORARY
+      // Build vectorizer configuration
+      double weight = (ft->getNumber() - 1 - frameRange[0]) /
+                      std::max(frameRange[1] - frameRange[0], 1.0);
+      weight = tcrop(weight, 0.0, 1.0);
 
-    configuration.m_affine     = dpiAff * TTranslation(-center);
-    configuration.m_thickScale = factor;
+      locals.updateConfig(weight);  // TEMPORARY
 
-    // Build vectorization label to be displayed
-    QString labelName = QString::fromStdWString(sl->getShortName());
-    labelName.push_back(' ');
-    labelName.append(QString::fromStdString(ft->expand(TFrameId::NO_PAD)));
+      configuration.m_affine     = dpiAff * TTranslation(-center);
+      configuration.m_thickScale = factor;
 
-    emit frameName(labelName);
+      if (m_params.m_isOutline)
+        oConfs.push_back(locals.m_oConf);
+      else
+        cConfs.push_back(locals.m_cConf);
 
-    // Perform vectorization
-    if (TVectorImageP vi =
-            doVectorize(img, m_vLevel->getPalette(), configuration)) {
-      TFrameId fid = *ft;
+      images.push_back(img);
+      fids.push_back(*ft);
 
-      if (fid.getNumber() < 0) fid = TFrameId(1, ft->getLetter());
+      // Build vectorization label to be displayed
+      QString labelName = QString::fromStdWString(sl->getShortName());
+      labelName.push_back(' ');
+      labelName.append(QString::fromStdString(ft->expand(TFrameId::NO_PAD)));
+
+      labelNames.push_back(labelName);
+    }
 
-      m_vLevel->setFrame(fid, vi);
-      vi->setPalette(m_vLevel->getPalette());
+    std::vector<const VectorizerConfiguration *> confs;
+    for (int i = 0; i < (int)images.size(); ++i)
+      confs.push_back(m_params.m_isOutline
+                          ? static_cast<VectorizerConfiguration *>(&oConfs[i])
+                          : static_cast<VectorizerConfiguration *>(&cConfs[i]));
 
-      emit frameDone(++count);
+    // Perform vectorization
+    std::vector<TVectorImageP> vis;
+    {
+      VectorizerCore vCore;
+      connect(&vCore, &VectorizerCore::imageDone, this,
+              [&](int i) {
+                QMutexLocker sl(&framesDoneMutex);
+
+                double seconds = std::max(timer.elapsed(), qint64(1)) / 1000.0;
+                emit frameName(tr("%1 (%2 frames/s)")
+                                   .arg(labelNames[i])
+                                   .arg(++framesDone / seconds, 0, 'f', 1));
+                emit frameDone(framesDone);
+              },
+              Qt::DirectConnection);  // Emitted from the converting threads
+      connect(this, SIGNAL(transmitCancel()), &vCore, SLOT(onCancel()),
+              Qt::DirectConnection);
+
+      vCore.vectorize(images, confs, m_vLevel->getPalette(), vis);
     }
 
-    // Stop if canceled
-    if (m_isCanceled) break;
+    for (int i = 0; i < (int)vis.size(); ++i) {
+      if (!vis[i]) continue;
+
+      TFrameId fid = fids[i];
+      if (fid.getNumber() < 0) fid = TFrameId(1, fids[i].getLetter());
+
+      m_vLevel->setFrame(fid, vis[i]);
+      vis[i]->setPalette(m_vLevel->getPalette());
+      ++count;
+    }
   }
 
   m_dialogShown = false;
@@ -929,8 +961,6 @@ bool VectorizerPopup::apply() {
           SLOT(onFrameName(QString)), Qt::QueuedConnection);
   connect(m_vectorizer, SIGNAL(frameDone(int)), this, SLOT(onFrameDone(int)),
           Qt::QueuedConnection);
-  connect(m_vectorizer, SIGNAL(partialDone(int, int)), this,
-          SLOT(onPartialDone(int, int)), Qt::QueuedConnection);
   // We DON'T want the progress bar to be hidden at cancel press - since its
   // modal
   // behavior prevents the user to interfere with a possibly still active
@@ -976,7 +1006,6 @@ bool VectorizerPopup::apply() {
     // Re-initialize progress Bar
     m_progressDialog->setMaximum(fids.size() * 100);
     m_progressDialog->setValue(0);
-    m_currFrame = 0;
 
     // Re-initialize vectorizer
     m_vectorizer->setLevel(sl);
@@ -1060,31 +1089,6 @@ void VectorizerPopup::onFrameName(QString frameName) {
 void VectorizerPopup::onFrameDone(int frameCount) {
   m_progressDialog->setValue(
       frameCount * 100);  // 100 multiplier stands for partial progresses
-  m_currFrame = frameCount;
-}
-
-//-----------------------------------------------------------------------------
-
-void VectorizerPopup::onPartialDone(int partial, int total) {
-  int value = (m_currFrame + partial / (double)total) * 100.0;
-
-  // NOTA: Puo' essere che la seguente non sia vera - dipende dall'ordine di
-  // esecuzione dei segnali
-  // onFrameDone e onPartialDone - se i primi si fanno in massa prima... Puo'
-  // generare uno stack overflow...
-  // NOTA: Non va ancora bene. Cosi' si attenua largamente il problema, ma a
-  // volte puo' ancora succedere.
-  if (value > m_progressDialog->value() + 5 &&
-      value < m_progressDialog->maximum()) {
-    // qDebug("Partial %d of %d;  Value %d of %d", partial, total, value,
-    // m_progressDialog->maximum());
-    m_progressDialog->setValue(value);
-  }
-  /*else
-{
-if(value != m_progressDialog->value())
-qDebug("ERRORE: VALORE PB= %d; Valore: %d",m_progressDialog->value(),value);
-}*/
 }
 
 //-----------------------------------------------------------------------------
@@ -187,8 +187,6 @@ private:
   VectorizerSwatchArea *m_swatchArea;
   DVGui::ProgressDialog *m_progressDialog;
 
-  int m_currFrame;
-
   TSceneHandle *m_sceneHandle;
 
 private:
@@ -214,9 +212,6 @@ private slots:
   void onFrameName(QString frameName);
   void onFrameDone(int frameCount);
 
-  void onPartialDone(int partial, int total);  //!< Partial progress \p partial
-                                               //! of \p total was done for
-  //! current frame.
   void onFinished();
 
   void updateSceneSettings();
@@ -292,14 +287,11 @@ public:
 
 signals:
 
-  //! Frame name is emitted at beginning of a frame vectorization
-  //! to be displayed above the progress bar
+  //! Frame name is emitted as a frame is converted, with the throughput so
+  //! far, to be displayed above the progress bar
   void frameName(QString);
   void frameDone(int);
 
-  //! Forwards the VectorizerCore::partialDone(int,int) signal.
-  void partialDone(int, int);
-
   //! Transmits a user cancel downward to VectorizerCore.
   void transmitCancel();
 
@@ -333,11 +325,6 @@ private:
 
 private:
   int doVectorize();  //!< Start vectorization of input frames.
-
-  //! Makes connections to low-level partial progress signals and cancel slots,
-  //! and invokes the low-level vectorization of \b img.
-  TVectorImageP doVectorize(TImageP img, TPalette *palette,
-                            const VectorizerConfiguration &conf);
 };
 
 #endif  // VECTORIZERPOPUP_H
@@ -219,6 +219,7 @@ XsheetViewer::XsheetViewer(QWidget *parent, Qt::WFlags flags)
     , m_scrubRow1(-1)
     , m_isCurrentFrameSwitched(false)
     , m_isCurrentColumnSwitched(false)
+    , m_lastCurrentRow(-1)
     , m_isComputingSize(false)
     , m_currentNoteIndex(0)
     , m_qtModifiers(0)
@@ -1398,20 +1399,20 @@ void XsheetViewer::scrollToColumn(int col) {
   int x0 = columnToLayerAxis(col);
   int x1 = columnToLayerAxis(colNext);
 
-  if (orientation()->isVerticalTimeline())
-    scrollToHorizontalRange(x0, x1);
-  else {
+  if (orientation()->isVerticalTimeline()) {
+    if (!scrollToHorizontalRange(x0, x1)) updateCellColumnAree();
+  } else {
     if (colNext == col) x1 += m_orientation->cellHeight();
 
-    scrollToVerticalRange(x0, x1);
+    if (!scrollToVerticalRange(x0, x1)) updateCellColumnAree();
   }
 }
 
 //-----------------------------------------------------------------------------
 
-void XsheetViewer::scrollToHorizontalRange(int x0, int x1) {
+bool XsheetViewer::scrollToHorizontalRange(int x0, int x1) {
   QRect visibleRect = m_cellArea->visibleRegion().boundingRect();
-  if (visibleRect.isEmpty()) return;
+  if (visibleRect.isEmpty()) return false;
   int visibleLeft  = visibleRect.left();
   int visibleRight = visibleRect.right();
 
@@ -1420,7 +1421,7 @@ void XsheetViewer::scrollToHorizontalRange(int x0, int x1) {
     if (!TApp::instance()->getCurrentFrame()->isPlaying() ||
         Preferences::instance()->isXsheetAutopanEnabled()) {
       scroll(QPoint(deltaX, 0));
-      return;
+      return true;
     }
   }
   if (visibleRight < x1) {  // If they are out of right visible region
@@ -1428,13 +1429,10 @@ void XsheetViewer::scrollToHorizontalRange(int x0, int x1) {
     if (!TApp::instance()->getCurrentFrame()->isPlaying() ||
         Preferences::instance()->isXsheetAutopanEnabled()) {
       scroll(QPoint(deltaX, 0));
-      return;
+      return true;
     }
   }
-  if (orientation()->isVerticalTimeline())
-    updateCellColumnAree();
-  else
-    updateCellRowAree();
+  return false;
 }
 
 //-----------------------------------------------------------------------------
@@ -1443,19 +1441,43 @@ void XsheetViewer::scrollToRow(int row) {
   int y0 = rowToFrameAxis(row);
   int y1 = rowToFrameAxis(row + 1);
 
-  if (orientation()->isVerticalTimeline())
-    scrollToVerticalRange(y0, y1);
-  else
-    scrollToHorizontalRange(y0, y1);
+  bool scrolled = orientation()->isVerticalTimeline()
+                      ? scrollToVerticalRange(y0, y1)
+                      : scrollToHorizontalRange(y0, y1);
+  int lastRow      = m_lastCurrentRow;
+  m_lastCurrentRow = row;
+  if (scrolled) return;
+
+  // Only the current time indicator and the focus cell have moved: repaint
+  // the cells of the previous and of the new current row, not the whole area
+  m_rowArea->update(m_rowArea->visibleRegion());
+  if (lastRow < 0)
+    m_cellArea->update(m_cellArea->visibleRegion());
+  else {
+    updateCellRows(lastRow, lastRow);
+    updateCellRows(row, row);
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+void XsheetViewer::updateCellRows(int row0, int row1) {
+  QRect visibleRect = m_cellArea->visibleRegion().boundingRect();
+  NumberRange frameAxis(rowToFrameAxis(row0), rowToFrameAxis(row1 + 1));
+  // include the separator lines at the rows' boundaries
+  frameAxis = frameAxis.adjusted(-2, 2);
+  QRect rowsRect    = orientation()->frameLayerRect(
+      frameAxis, orientation()->layerSide(visibleRect));
+  m_cellArea->update(rowsRect & visibleRect);
 }
 
 //-----------------------------------------------------------------------------
 
-void XsheetViewer::scrollToVerticalRange(int y0, int y1) {
+bool XsheetViewer::scrollToVerticalRange(int y0, int y1) {
   int yMin          = min(y0, y1);
   int yMax          = max(y0, y1);
   QRect visibleRect = m_cellArea->visibleRegion().boundingRect();
-  if (visibleRect.isEmpty()) return;
+  if (visibleRect.isEmpty()) return false;
   int visibleTop    = visibleRect.top();
   int visibleBottom = visibleRect.bottom();
 
@@ -1464,7 +1486,7 @@ void XsheetViewer::scrollToVerticalRange(int y0, int y1) {
     if (!TApp::instance()->getCurrentFrame()->isPlaying() ||
         Preferences::instance()->isXsheetAutopanEnabled()) {
       scroll(QPoint(0, deltaY));
-      return;
+      return true;
     }
   }
 
@@ -1473,13 +1495,10 @@ void XsheetViewer::scrollToVerticalRange(int y0, int y1) {
     if (!TApp::instance()->getCurrentFrame()->isPlaying() ||
         Preferences::instance()->isXsheetAutopanEnabled()) {
       scroll(QPoint(0, deltaY));
-      return;
+      return true;
     }
   }
-  if (orientation()->isVerticalTimeline())
-    updateCellRowAree();
-  else
-    updateCellColumnAree();
+  return false;
 }
 
 //-----------------------------------------------------------------------------
@@ -1499,6 +1518,8 @@ void XsheetViewer::onSelectionSwitched(TSelection *oldSelection,
  */
 void XsheetViewer::onSelectionChanged(TSelection *selection) {
   if ((TSelection *)getCellSelection() == selection) {
+    // frame switches no longer repaint the whole cell area
+    m_cellArea->update(m_cellArea->visibleRegion());
     changeWindowTitle();
     if (Preferences::instance()->isInputCellsWithoutDoubleClickingEnabled()) {
       TCellSelection *cellSel = getCellSelection();
@@ -1602,8 +1623,9 @@ void XsheetViewer::setCurrentNoteIndex(int currentNoteIndex) {
                    QPoint(pos.x, pos.y);  // actually xy
   QSize size(XsheetGUI::NoteWidth, XsheetGUI::NoteHeight);
   QRect noteRect(topLeft, size);
-  scrollToHorizontalRange(noteRect.left(), noteRect.right());
-  scrollToVerticalRange(noteRect.top(), noteRect.bottom());
+  bool scrolledH = scrollToHorizontalRange(noteRect.left(), noteRect.right());
+  bool scrolledV = scrollToVerticalRange(noteRect.top(), noteRect.bottom());
+  if (!scrolledH && !scrolledV) updateAllAree();
 }
 
 //-----------------------------------------------------------------------------
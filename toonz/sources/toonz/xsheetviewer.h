@@ -566,6 +566,8 @@ class XsheetViewer final : public QFrame, public SaveLoadQSettings {
 
   bool m_isCurrentFrameSwitched;
   bool m_isCurrentColumnSwitched;
+  // row of the last painted current-time indicator
+  int m_lastCurrentRow;
 
   XsheetGUI::DragTool *m_dragTool;
 
@@ -1219,9 +1221,11 @@ public:
 
 protected:
   void scrollToColumn(int col);
-  void scrollToHorizontalRange(int x0, int x1);
+  // the scrollTo*Range() functions return true if the view was scrolled
+  bool scrollToHorizontalRange(int x0, int x1);
   void scrollToRow(int row);
-  void scrollToVerticalRange(int y0, int y1);
+  bool scrollToVerticalRange(int y0, int y1);
+  void updateCellRows(int row0, int row1);
 
   void showEvent(QShowEvent *) override;
   void hideEvent(QHideEvent *) override;
@@ -15,6 +15,7 @@
 #include "toonz/toonzscene.h"
 #include "toonz/sceneproperties.h"
 #include "toonz/txsheet.h"
+#include "toonz/tstageobjecttree.h"
 #include "toonz/tcamera.h"
 #include "toonz/preferences.h"
 #include "toonz/trasterimageutils.h"
@@ -240,6 +241,19 @@ void MovieRenderer::Imp::prepareForStart() {
     }
   };
 
+  // Stage object placements are read concurrently by the render threads:
+  // precompute them once for the whole frame range
+  if (!m_framesToBeRendered.empty()) {
+    double f0 = m_framesToBeRendered[0].first, f1 = f0;
+    for (size_t f = 1; f != m_framesToBeRendered.size(); ++f) {
+      f0 = std::min(f0, m_framesToBeRendered[f].first);
+      f1 = std::max(f1, m_framesToBeRendered[f].first);
+    }
+
+    m_scene->getXsheet()->getStageObjectTree()->cachePlacements(tfloor(f0),
+                                                                tceil(f1));
+  }
+
   TOutputProperties *oprop = m_scene->getProperties()->getOutputProperties();
   double frameRate         = (double)oprop->getFrameRate();
 
@@ -739,6 +753,9 @@ void MovieRenderer::Imp::onRenderFinished(bool isCanceled) {
   m_levelUpdaterA.reset();
   m_levelUpdaterB.reset();
 
+  // Placements may be edited again from now on
+  m_scene->getXsheet()->getStageObjectTree()->dropPlacements();
+
   if (!m_failure) {
     // Inform listeners of the render completion
     std::set<MovieRenderer::Listener *>::iterator it;
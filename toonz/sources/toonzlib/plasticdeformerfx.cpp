@@ -27,6 +27,7 @@
 #include "tgldisplaylistsmanager.h"
 #include "tconvert.h"
 #include "trop.h"
+#include "tenv.h"
 
 #include <QOpenGLFramebufferObject>
 #include <QOffscreenSurface>
@@ -36,6 +37,8 @@
 
 FX_IDENTIFIER_IS_HIDDEN(PlasticDeformerFx, "plasticDeformerFx")
 
+TEnv::IntVar PlasticSoftwareRender("PlasticSoftwareRender", 0);
+
 //***************************************************************************************************
 //    Local namespace
 //***************************************************************************************************
@@ -351,11 +354,24 @@ void PlasticDeformerFx::doCompute(TTile &tile, double frame,
   TTile inTile;
   m_port->allocateAndCompute(inTile, bbox.getP00(), tileSize, TRasterP(), frame,
                              texInfo);
+  TRaster32P tex(inTile.getRaster());
+
+  // Without a surface to draw on, or when explicitly requested (render nodes
+  // with no GPU), draw the textured mesh in software
+  if (PlasticSoftwareRender != 0 || !info.m_offScreenSurface) {
+    TRaster32P ras(tile.getRaster());
+    ras->clear();
+
+    tDraw(ras, *mi, tex, TTranslation(-bbox.getP00()) * meshToTextureAff,
+          TTranslation(-tile.m_pos) * info.m_affine * meshToWorldMeshAff,
+          *dataGroup);
+    return;
+  }
+
   QOpenGLContext *context;
   // Draw the textured mesh
   {
     // Prepare texture
-    TRaster32P tex(inTile.getRaster());
     TRop::depremultiply(tex);  // Textures must be stored depremultiplied.
                                // See docs about the tglDraw() below.
     static TAtomicVar var;
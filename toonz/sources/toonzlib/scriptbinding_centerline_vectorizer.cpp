@@ -9,6 +9,32 @@
 #include "tpalette.h"
 #include "ttoonzimage.h"
 
+namespace {
+
+// Sets in conf the transform from the image to the stage's reference
+bool setImageTransform(const TImageP &src, CenterlineConfiguration &conf) {
+  TAffine dpiAff;
+  double factor = Stage::inch;
+  double dpix = factor / 72, dpiy = factor / 72;
+  TPointD center;
+  if (TRasterImageP ri = src) {
+    ri->getDpi(dpix, dpiy);
+    center = ri->getRaster()->getCenterD();
+  } else if (TToonzImageP ti = src) {
+    ti->getDpi(dpix, dpiy);
+    center = ti->getRaster()->getCenterD();
+  } else
+    return false;
+  if (dpix != 0.0 && dpiy != 0.0) dpiAff = TScale(factor / dpix, factor / dpiy);
+  factor                                 = norm(dpiAff * TPointD(1, 0));
+
+  conf.m_affine     = dpiAff * TTranslation(-center);
+  conf.m_thickScale = factor;
+  return true;
+}
+
+}  // namespace
+
 namespace TScriptBinding {
 
 CenterlineVectorizer::CenterlineVectorizer() {
@@ -29,24 +55,8 @@ QScriptValue CenterlineVectorizer::ctor(QScriptContext *context,
 QScriptValue CenterlineVectorizer::vectorizeImage(const TImageP &src,
                                                   TPalette *palette) {
   VectorizerCore vc;
-  TAffine dpiAff;
-  double factor = Stage::inch;
-  double dpix = factor / 72, dpiy = factor / 72;
-  TPointD center;
-  if (TRasterImageP ri = src) {
-    ri->getDpi(dpix, dpiy);
-    center = ri->getRaster()->getCenterD();
-  } else if (TToonzImageP ti = src) {
-    ti->getDpi(dpix, dpiy);
-    center = ti->getRaster()->getCenterD();
-  } else {
+  if (!setImageTransform(src, *m_parameters))
     return context()->throwError(QObject::tr("Vectorization failed"));
-  }
-  if (dpix != 0.0 && dpiy != 0.0) dpiAff = TScale(factor / dpix, factor / dpiy);
-  factor                                 = norm(dpiAff * TPointD(1, 0));
-
-  m_parameters->m_affine     = dpiAff * TTranslation(-center);
-  m_parameters->m_thickScale = factor;
 
   palette->addRef();  // if there are no other references the vectorize() method
                       // below can destroy the palette
@@ -90,19 +100,46 @@ QScriptValue CenterlineVectorizer::vectorize(QScriptValue arg) {
     QScriptValue newLevel = create(engine(), new Level());
     QList<TFrameId> fids;
     level->getFrameIds(fids);
+
+    // the whole level is vectorized at once, frames in parallel
+    std::vector<TImageP> images;
+    std::vector<TFrameId> imageFids;
+    std::vector<CenterlineConfiguration> confs;
     for (const TFrameId &fid : fids) {
       TImageP srcImg = level->getImg(fid);
       if (srcImg && (srcImg->getType() == TImage::RASTER ||
                      srcImg->getType() == TImage::TOONZ_RASTER)) {
-        QScriptValue newFrame = vectorizeImage(srcImg, palette);
-        if (newFrame.isError()) {
-          return newFrame;
-        }
-        QScriptValueList args;
-        args << QString::fromStdString(fid.expand()) << newFrame;
-        newLevel.property("setFrame").call(newLevel, args);
+        confs.push_back(*m_parameters);
+        if (!setImageTransform(srcImg, confs.back()))
+          return context()->throwError(QObject::tr("Vectorization failed"));
+        images.push_back(srcImg);
+        imageFids.push_back(fid);
       }
     }
+
+    std::vector<const VectorizerConfiguration *> confPtrs;
+    for (const CenterlineConfiguration &conf : confs)
+      confPtrs.push_back(&conf);
+
+    palette->addRef();  // see vectorizeImage()
+    std::vector<TVectorImageP> vis;
+    VectorizerCore vc;
+    vc.vectorize(images, confPtrs, palette, vis);
+
+    for (int i = 0; i < (int)vis.size(); ++i) {
+      if (!vis[i]) {
+        palette->release();
+        return context()->throwError(QObject::tr("Vectorization failed"));
+      }
+      vis[i]->setPalette(palette);
+
+      QScriptValue newFrame = engine()->newQObject(
+          new Image(vis[i]), QScriptEngine::AutoOwnership);
+      QScriptValueList args;
+      args << QString::fromStdString(imageFids[i].expand()) << newFrame;
+      newLevel.property("setFrame").call(newLevel, args);
+    }
+    palette->release();
     return newLevel;
   } else {
     // should never happen
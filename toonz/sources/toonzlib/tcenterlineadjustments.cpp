@@ -2,6 +2,8 @@
 
 #include "tcenterlinevectP.h"
 
+#include <QMutex>
+
 //==========================================================================
 
 //*********************************
@@ -19,6 +21,9 @@ VectorizerCoreGlobals *globals;
 std::vector<unsigned int> contourFamilyOfOrganized;
 JointSequenceGraph *currJSGraph;
 ContourFamily *currContourFamily;
+
+// Guards the above, since images may be vectorized concurrently
+QMutex globalsMutex;
 };
 
 //==========================================================================
@@ -42,6 +47,7 @@ typedef std::map<UINT, UINT, std::less<UINT>> uintMap;
 
 // void organizeGraphs(SkeletonList* skeleton)
 void organizeGraphs(SkeletonList *skeleton, VectorizerCoreGlobals &g) {
+  QMutexLocker locker(&globalsMutex);
   globals = &g;
 
   SkeletonList::iterator currGraphPtr;
@@ -952,6 +958,7 @@ void JunctionArea::apply() {
 
 // void inline junctionRecovery(Contours* polygons)
 void junctionRecovery(Contours *polygons, VectorizerCoreGlobals &g) {
+  QMutexLocker locker(&globalsMutex);
   globals = &g;
 
   unsigned int i, j;
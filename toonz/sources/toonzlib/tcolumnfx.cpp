@@ -15,6 +15,8 @@
 #include "tropcm.h"
 #include "tofflinegl.h"
 #include "tvectorrenderdata.h"
+#include "tvectorrasterizer.h"
+#include "tenv.h"
 
 // TnzBase includes
 #include "ttzpimagefx.h"
@@ -79,6 +81,10 @@ TFxDeclarationT<TZeraryColumnFx> zeraryColumnFxInfo(
 TFxDeclarationT<TXsheetFx> infoTXsheetFx(TFxInfo("Toonz_xsheetFx", true));
 TFxDeclarationT<TOutputFx> infoTOutputFx(TFxInfo("Toonz_outputFx", true));
 
+// Solid color vector levels are drawn by TVectorRasterizer rather than
+// TOfflineGL when non-zero
+TEnv::IntVar VectorSoftwareRender("VectorSoftwareRender", 0);
+
 //****************************************************************************************
 //    Local namespace  -  misc functions
 //****************************************************************************************
@@ -1023,7 +1029,6 @@ void TLevelColumnFx::doCompute(TTile &tile, double frame,
       // Deal separately
       applyTzpFxsOnVector(vectorImage, tile, frame, info);
     } else {
-      QMutexLocker m(&m_mutex);
       bBox = info.m_affine * vectorImage->getBBox();
       TDimension size(tile.getRaster()->getSize());
 
@@ -1031,15 +1036,45 @@ void TLevelColumnFx::doCompute(TTile &tile, double frame,
                     TScale(1.0 / info.m_shrinkX, 1.0 / info.m_shrinkY) *
                     info.m_affine;
 
+      // Works on a copy of the image when the palette has to change
       applyCmappedFx(vectorImage, info.m_data, (int)frame);
       TPalette *vpalette = vectorImage->getPalette();
       assert(vpalette);
-      m_isCachable = !vpalette->isAnimated();
-      int oldFrame = vpalette->getFrame();
+      bool isCachable = !vpalette->isAnimated();
+      int oldFrame    = vpalette->getFrame();
 
       TVectorRenderData rd(TVectorRenderData::ProductionSettings(), aff,
                            TRect(size), vpalette);
 
+      if (VectorSoftwareRender != 0 &&
+          TVectorRasterizer::isSupported(vectorImage.getPointer(), rd)) {
+        // Solid colors only: draw in software. m_mutex guards the shared GL
+        // context, so it is held just for m_isCachable - and frames of the
+        // same column are drawn concurrently.
+        {
+          QMutexLocker m(&m_mutex);
+          m_isCachable = isCachable;
+        }
+
+        TRaster32P ras32(tile.getRaster());
+        TRaster32P outRas = ras32 ? ras32 : TRaster32P(size);
+        outRas->clear();
+
+        if (!isCachable) vpalette->mutex()->lock();
+
+        vpalette->setFrame((int)frame);
+        TVectorRasterizer::draw(outRas, vectorImage.getPointer(), rd);
+        vpalette->setFrame(oldFrame);
+
+        if (!isCachable) vpalette->mutex()->unlock();
+
+        if (!ras32) TRop::copy(tile.getRaster(), outRas);
+        return;
+      }
+
+      QMutexLocker m(&m_mutex);
+      m_isCachable = isCachable;
+
       if (!m_offlineContext || m_offlineContext->getLx() < size.lx ||
           m_offlineContext->getLy() < size.ly) {
         if (m_offlineContext) delete m_offlineContext;
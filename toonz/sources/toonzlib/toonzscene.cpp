@@ -50,6 +50,11 @@ TOfflineGL *currentOfflineGL = 0;
 
 #include <QProgressDialog>
 
+// STD includes
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
 #ifdef MACOSX
 #include <QSurfaceFormat>
 #include <QOffscreenSurface>
@@ -417,8 +422,55 @@ void ToonzScene::loadResources(bool withProgressDialog) {
     progressDialog->show();
   }
 
-  int i;
-  for (i = 0; i < m_levelSet->getLevelCount(); i++) {
+  // Level files are opened and their infos read by a pool of threads, a
+  // bounded number of levels ahead of the (serial) level loads below. Loads
+  // still happen in the level set order, so levels depending on others
+  // (sub-xsheets, shared palettes) find them as they used to.
+  static const int c_prefetchThreadsCount = 8, c_prefetchWindow = 64;
+
+  int i, count = m_levelSet->getLevelCount();
+
+  std::vector<std::vector<TFilePath>> infoPaths(count);
+  for (i = 0; i < count; i++)
+    if (TXshSimpleLevel *sl = m_levelSet->getLevel(i)->getSimpleLevel())
+      infoPaths[i] = sl->getInfoPaths();
+
+  std::mutex mutex;
+  std::condition_variable prefetchedCondition;
+  std::vector<bool> prefetched(count, false);
+  int nextPrefetch = 0, loadedCount = 0;
+
+  auto prefetchInfos = [&]() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+      prefetchedCondition.wait(lock, [&]() {
+        return nextPrefetch == count ||
+               nextPrefetch < loadedCount + c_prefetchWindow;
+      });
+      if (nextPrefetch == count) return;
+
+      int l = nextPrefetch++;
+
+      lock.unlock();
+      for (const TFilePath &path : infoPaths[l])
+        TXshSimpleLevel::prefetchInfo(path);
+      lock.lock();
+
+      prefetched[l] = true;
+      prefetchedCondition.notify_all();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (i = 0; i < std::min(c_prefetchThreadsCount, count); i++)
+    threads.push_back(std::thread(prefetchInfos));
+
+  for (i = 0; i < count; i++) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      prefetchedCondition.wait(lock, [&]() { return prefetched[i]; });
+    }
+
     if (progressDialog) progressDialog->setValue(i + 1);
 
     TXshLevel *level = m_levelSet->getLevel(i);
@@ -426,7 +478,25 @@ void ToonzScene::loadResources(bool withProgressDialog) {
       level->load();
     } catch (...) {
     }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      loadedCount = i + 1;
+    }
+    prefetchedCondition.notify_all();
   }
+
+  for (std::thread &thread : threads) thread.join();
+  TXshSimpleLevel::releasePrefetchedInfos();
+
+  // Levels added by the loads above
+  for (; i < m_levelSet->getLevelCount(); i++) {
+    try {
+      m_levelSet->getLevel(i)->load();
+    } catch (...) {
+    }
+  }
+
   getXsheet()->updateFrameCount();
 }
 
@@ -12,6 +12,7 @@
 #include "tstroke.h"
 #include "trasterimage.h"
 #include "tmathutil.h"
+#include "tthread.h"
 
 // tcg includes
 #include "tcg/tcg_numeric_ops.h"
@@ -1544,6 +1545,35 @@ TVectorImageP VectorizerCore::vectorize(const TImageP &img,
 
 //-----------------------------------------------------------------
 
+void VectorizerCore::vectorize(
+    const std::vector<TImageP> &images,
+    const std::vector<const VectorizerConfiguration *> &configurations,
+    TPalette *palette, std::vector<TVectorImageP> &results) {
+  assert(images.size() == configurations.size());
+
+  int count = (int)images.size();
+  results.assign(count, TVectorImageP());
+
+  int rangesCount = count;
+  for (int i = 0; i < count; ++i)
+    if (configurations[i]->m_outline && !TToonzImageP(images[i]))
+      rangesCount = 1;
+
+  // One image per range, so that threads take the next image as soon as they
+  // are free. Each image is converted by its own core.
+  TThread::runInRanges(count, rangesCount, [&](int i0, int i1) {
+    for (int i = i0; i < i1 && !isCanceled(); ++i) {
+      VectorizerCore core;
+      core.m_batchOwner = this;
+
+      results[i] = core.vectorize(images[i], *configurations[i], palette);
+      emit imageDone(i);
+    }
+  });
+}
+
+//-----------------------------------------------------------------
+
 void VectorizerCore::emitPartialDone(void) {
   emit partialDone(m_currPartial++, m_totalPartials);
 }
@@ -25,13 +25,17 @@
 #include "tconvert.h"
 #include "tundo.h"
 #include "tconst.h"
+#include "tthread.h"
 
 // Qt includes
 #include <QMetaObject>
+#include <QThread>
 
 // STD includes
+#include <algorithm>
 #include <fstream>
 #include <set>
+#include <map>
 
 using namespace std;
 
@@ -509,9 +513,10 @@ void TStageObject::onChange(const class TParamChange &c) {
   // Thus, we're just SCHEDULING for a data refresh. The actual refresh happens
   // whenever the scheduled data is accessed.
 
-  if (c.m_keyframeChanged)
+  if (c.m_keyframeChanged) {
     m_lazyData.invalidate();  // Both invalidate placement AND keyframes
-  else
+    dropPlacements();
+  } else
     invalidate();  // Invalidate placement only
 }
 
@@ -1340,70 +1345,87 @@ TAffine TStageObject::computeLocalPlacement(double frame) {
   frame = paramsTime(frame);
 
   if (lazyData().m_time != frame) {
-    double sc  = m_scale->getValue(frame);
-    double sx  = sc * m_scalex->getValue(frame);
-    double sy  = sc * m_scaley->getValue(frame);
-    double ang = m_rot->getValue(frame);
-    double shx = m_shearx->getValue(frame);
-    double shy = m_sheary->getValue(frame);
-
-    TPointD position;
-    double posPath = 0;
-    switch (m_status & STATUS_MASK) {
-    case XY:
-      position.x = m_x->getValue(frame) * Stage::inch;
-      position.y = m_y->getValue(frame) * Stage::inch;
-      break;
-    case PATH:
-      assert(m_spline);
-      assert(m_spline->getStroke());
-      posPath = m_spline->getStroke()->getLength() *
-                m_posPath->getValue(frame) * 0.01;
-      position = m_spline->getStroke()->getPointAtLength(posPath);
-      break;
-    case PATH_AIM:
-      assert(m_spline);
-      assert(m_spline->getStroke());
-      posPath = m_spline->getStroke()->getLength() *
-                m_posPath->getValue(frame) * 0.01;
-
-      position = m_spline->getStroke()->getPointAtLength(posPath);
-      if (m_spline->getStroke()->getLength() > 1e-5)
-        ang +=
-            rad2degree(atan(m_spline->getStroke()->getSpeedAtLength(posPath)));
-      break;
-    case IK:
-      return computeIkRootOffset(frame);
-      break;
-    }
+    if ((m_status & STATUS_MASK) == IK) return computeIkRootOffset(frame);
+
+    m_localPlacement = localPlacement(frame);
+  }
 
-    TAffine shear = TAffine::shear(shx, shy);
+  return m_localPlacement;
+}
 
-    TPointD handlePos = getHandlePos(m_handle, (int)frame);
-    TPointD center    = (m_center + handlePos) * Stage::inch;
+//-----------------------------------------------------------------------------
 
-    TPointD pos = m_offset;
-    if (m_parent) pos += m_parent->getHandlePos(m_parentHandle, (int)frame);
-    pos = pos * Stage::inch + position;
+TAffine TStageObject::localPlacement(double frame) const {
+  double sc  = m_scale->getValue(frame);
+  double sx  = sc * m_scalex->getValue(frame);
+  double sy  = sc * m_scaley->getValue(frame);
+  double ang = m_rot->getValue(frame);
+  double shx = m_shearx->getValue(frame);
+  double shy = m_sheary->getValue(frame);
 
-    m_localPlacement = TTranslation(pos) * makeRotation(ang) * shear *
-                       TScale(sx, sy) * TTranslation(-center);
+  TPointD position;
+  double posPath = 0;
+  switch (m_status & STATUS_MASK) {
+  case XY:
+    position.x = m_x->getValue(frame) * Stage::inch;
+    position.y = m_y->getValue(frame) * Stage::inch;
+    break;
+  case PATH:
+    assert(m_spline);
+    assert(m_spline->getStroke());
+    posPath = m_spline->getStroke()->getLength() *
+              m_posPath->getValue(frame) * 0.01;
+    position = m_spline->getStroke()->getPointAtLength(posPath);
+    break;
+  case PATH_AIM:
+    assert(m_spline);
+    assert(m_spline->getStroke());
+    posPath = m_spline->getStroke()->getLength() *
+              m_posPath->getValue(frame) * 0.01;
+
+    position = m_spline->getStroke()->getPointAtLength(posPath);
+    if (m_spline->getStroke()->getLength() > 1e-5)
+      ang += rad2degree(atan(m_spline->getStroke()->getSpeedAtLength(posPath)));
+    break;
+  case IK:
+    assert(false);  // Dealt with by computeIkRootOffset()
+    break;
   }
 
-  return m_localPlacement;
+  TAffine shear = TAffine::shear(shx, shy);
+
+  TPointD handlePos = getHandlePos(m_handle, (int)frame);
+  TPointD center    = (m_center + handlePos) * Stage::inch;
+
+  TPointD pos = m_offset;
+  if (m_parent) pos += m_parent->getHandlePos(m_parentHandle, (int)frame);
+  pos = pos * Stage::inch + position;
+
+  return TTranslation(pos) * makeRotation(ang) * shear * TScale(sx, sy) *
+         TTranslation(-center);
 }
 
 //-----------------------------------------------------------------------------
 
 TAffine TStageObject::getPlacement(double t) {
+  // Frames precomputed by cachePlacements() need no lazy data update, and
+  // can be read concurrently
+  std::shared_ptr<const PlacementTable> table =
+      std::atomic_load(&m_placementTable);
+  if (table) {
+    double r = t - table->m_r0;
+    if (r >= 0 && r < table->m_placements.size() && r == (int)r)
+      return table->m_placements[(int)r];
+  }
+
   double &time = lazyData().m_time;
 
   if (time == t) return m_absPlacement;
   if (time != -1) {
     if (!m_parent)
-      invalidate();
+      invalidateTime();
     else
-      findRoot(t)->invalidate();
+      findRoot(t)->invalidateTime();
   }
 
   double tt = paramsTime(t);
@@ -1465,12 +1487,143 @@ void TStageObject::invalidate(LazyData &ld) const {
   ld.m_time = -1;
 
   std::list<TStageObject *>::const_iterator cit = m_children.begin();
-  for (; cit != m_children.end(); ++cit) (*cit)->invalidate();
+  for (; cit != m_children.end(); ++cit) (*cit)->invalidateTime();
+}
+
+//-----------------------------------------------------------------------------
+
+void TStageObject::invalidate() {
+  invalidate(m_lazyData(tcg::direct_access));
+  dropPlacements();
+}
+
+//-----------------------------------------------------------------------------
+
+void TStageObject::dropPlacements() {
+  std::atomic_store(&m_placementTable,
+                    std::shared_ptr<const PlacementTable>());
+
+  std::list<TStageObject *>::const_iterator cit = m_children.begin();
+  for (; cit != m_children.end(); ++cit) (*cit)->dropPlacements();
+}
+
+//-----------------------------------------------------------------------------
+
+bool TStageObject::isIkDriven() const {
+  for (const TStageObject *obj = this; obj; obj = obj->m_parent)
+    if ((obj->m_status & STATUS_MASK) == IK) return true;
+
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+
+bool TStageObject::hasPlainPlacement() const {
+  // Hook handles go through the xsheet cells and the plastic deformations
+  if ((m_handle.length() > 1 && m_handle[0] == 'H') ||
+      (m_parentHandle.length() > 1 && m_parentHandle[0] == 'H'))
+    return false;
+
+  // Expression, file and similar shape segments update their data lazily
+  const TDoubleParamP params[] = {m_x,      m_y,      m_rot,
+                                  m_scalex, m_scaley, m_scale,
+                                  m_posPath, m_shearx, m_sheary};
+  for (const TDoubleParamP &param : params) {
+    int k, kCount = param->getKeyframeCount();
+    for (k = 0; k != kCount; ++k)
+      if (!TDoubleKeyframe::isKeyframeBased(param->getKeyframe(k).m_type))
+        return false;
+  }
+
+  return true;
 }
 
 //-----------------------------------------------------------------------------
 
-void TStageObject::invalidate() { invalidate(m_lazyData(tcg::direct_access)); }
+void TStageObject::cachePlacements(const std::vector<TStageObject *> &objects,
+                                   int r0, int r1) {
+  // Fewer placements per thread would cost more to dispatch than to compute
+  static const int c_minPlacementsPerRange = 4096;
+
+  if (r1 < r0) return;
+
+  // Stale tables would be read back by the sequential evaluations below
+  std::vector<TStageObject *>::const_iterator ot;
+  for (ot = objects.begin(); ot != objects.end(); ++ot)
+    std::atomic_store(&(*ot)->m_placementTable,
+                      std::shared_ptr<const PlacementTable>());
+
+  int count = r1 - r0 + 1, i, n = (int)objects.size();
+
+  std::vector<std::shared_ptr<PlacementTable>> tables(n);
+  std::vector<int> parents(n, -1);
+  std::vector<bool> parallel(n, false);
+  std::map<const TStageObject *, int> indexes;
+  int parallelCount = 0;
+
+  for (i = 0; i != n; ++i) {
+    TStageObject *obj = objects[i];
+    indexes[obj]      = i;
+
+    // Inverse kinematics evaluates the chain's placements with the root
+    // temporarily moved; tables would be read back at the wrong time
+    if (obj->isIkDriven()) continue;
+
+    tables[i].reset(new PlacementTable);
+    tables[i]->m_r0 = r0;
+    tables[i]->m_placements.resize(count);
+
+    std::map<const TStageObject *, int>::iterator pt =
+        obj->m_parent ? indexes.find(obj->m_parent) : indexes.end();
+    if (pt != indexes.end()) parents[i] = pt->second;
+
+    if (obj->hasPlainPlacement() && (!obj->m_parent || parents[i] >= 0)) {
+      // Warm up the keyframes table, so that the threads below just read it
+      obj->localPlacement(obj->paramsTime(obj->paramsTime(r0)));
+
+      // Lengths at the spline's ends or control points are looked up without
+      // computing the stroke caches, so the placement above may not build
+      // them
+      if (obj->isPathEnabled() && obj->m_spline)
+        obj->m_spline->getStroke()->computeCaches();
+
+      parallel[i] = true;
+      ++parallelCount;
+    } else {
+      std::vector<TAffine> &placements = tables[i]->m_placements;
+      for (int r = 0; r != count; ++r)
+        placements[r] = obj->getPlacement(r0 + r);
+    }
+  }
+
+  // Each thread processes all the objects, parents first, on its own frames
+  auto computeFrames = [&](int ra, int rb) {
+    for (int o = 0; o != n; ++o) {
+      if (!parallel[o]) continue;
+
+      const TStageObject *obj          = objects[o];
+      std::vector<TAffine> &placements = tables[o]->m_placements;
+      const TAffine *parentPlacements =
+          (parents[o] >= 0) ? &tables[parents[o]]->m_placements[0] : 0;
+
+      for (int r = ra; r != rb; ++r) {
+        TAffine local =
+            obj->localPlacement(obj->paramsTime(obj->paramsTime(r0 + r)));
+        placements[r] = parentPlacements ? parentPlacements[r] * local : local;
+      }
+    }
+  };
+
+  int rangesCount = (int)std::min<double>(
+      QThread::idealThreadCount(),
+      (double)parallelCount * count / c_minPlacementsPerRange);
+  TThread::runInRanges(count, rangesCount, computeFrames);
+
+  for (i = 0; i != n; ++i)
+    if (tables[i])
+      std::atomic_store(&objects[i]->m_placementTable,
+                        std::shared_ptr<const PlacementTable>(tables[i]));
+}
 
 //-----------------------------------------------------------------------------
 
@@ -541,6 +541,36 @@ void TStageObjectTree::invalidateAll() {
 
 //-----------------------------------------------------------------------------
 
+void TStageObjectTree::cachePlacements(int r0, int r1) {
+  // Sort the objects breadth-first, so that parents come before children
+  std::vector<TStageObject *> objects;
+
+  std::map<TStageObjectId, TStageObject *>::iterator it;
+  for (it = m_imp->m_pegbarTable.begin(); it != m_imp->m_pegbarTable.end();
+       ++it)
+    if (it->second->getParent() == TStageObjectId::NoneId)
+      objects.push_back(it->second);
+
+  for (size_t i = 0; i != objects.size(); ++i) {
+    const std::list<TStageObject *> &children = objects[i]->getChildren();
+    objects.insert(objects.end(), children.begin(), children.end());
+  }
+
+  TStageObject::cachePlacements(objects, r0, r1);
+}
+
+//-----------------------------------------------------------------------------
+
+void TStageObjectTree::dropPlacements() {
+  std::map<TStageObjectId, TStageObject *>::iterator it;
+  for (it = m_imp->m_pegbarTable.begin(); it != m_imp->m_pegbarTable.end();
+       ++it)
+    if (it->second->getParent() == TStageObjectId::NoneId)
+      it->second->dropPlacements();
+}
+
+//-----------------------------------------------------------------------------
+
 void TStageObjectTree::setHandleManager(HandleManager *hm) {
   m_imp->m_handleManager = hm;
 }
@@ -5,6 +5,75 @@
 #include "timagecache.h"
 #include "ttoonzimage.h"
 #include "trasterimage.h"
+#include "tthread.h"
+
+//------------------------------------------------------------------------------------------
+
+namespace {
+
+class TileCompressor final : public TThread::Runnable {
+  std::vector<std::string> m_ids;
+
+public:
+  TileCompressor(const std::vector<std::string> &ids) : m_ids(ids) {}
+
+  void run() override {
+    // tiles removed in the meantime are just not found
+    for (int i = 0; i < (int)m_ids.size(); ++i)
+      TImageCache::instance()->compress(m_ids[i]);
+  }
+};
+
+//------------------------------------------------------------------------------------------
+
+TThread::Executor &compressorExecutor() {
+  static TThread::Executor executor;
+  static bool initialized = false;
+  if (!initialized) {
+    executor.setMaxActiveTasks(1);
+    initialized = true;
+  }
+  return executor;
+}
+
+//------------------------------------------------------------------------------------------
+
+//! Returns the box of the pixels that differ between two rasters of the
+//! same size and type, or an empty rect if they are equal.
+TRect getChangedRect(const TRasterP &ras0, const TRasterP &ras1) {
+  assert(ras0->getSize() == ras1->getSize());
+  assert(ras0->getPixelSize() == ras1->getPixelSize());
+
+  int lx = ras0->getLx(), ly = ras0->getLy();
+  int pixSize = ras0->getPixelSize();
+
+  TRect rect;
+  ras0->lock();
+  ras1->lock();
+  for (int y = 0; y < ly; ++y) {
+    const UCHAR *row0 = ras0->getRawData() + y * ras0->getWrap() * pixSize;
+    const UCHAR *row1 = ras1->getRawData() + y * ras1->getWrap() * pixSize;
+    if (memcmp(row0, row1, lx * pixSize) == 0) continue;
+
+    int x0 = 0, x1 = lx - 1;
+    while (memcmp(row0 + x0 * pixSize, row1 + x0 * pixSize, pixSize) == 0)
+      ++x0;
+    while (memcmp(row0 + x1 * pixSize, row1 + x1 * pixSize, pixSize) == 0)
+      --x1;
+
+    if (rect.isEmpty())
+      rect = TRect(x0, y, x1, y);
+    else
+      rect += TRect(x0, y, x1, y);
+  }
+  ras1->unlock();
+  ras0->unlock();
+
+  return rect;
+}
+
+}  // namespace
+
 //------------------------------------------------------------------------------------------
 
 TTileSet::Tile::Tile() : m_rasterBounds(TRect()), m_dim(), m_pixelSize(0) {}
@@ -52,11 +121,25 @@ TRect TTileSet::getBBox() const {
 int TTileSet::getMemorySize() const {
   int i, size = 0;
   for (i = 0; i < m_tiles.size(); i++) {
-    size += m_tiles[i]->getSize();
+    // tiles not in the cache (disabled) count for their raw size
+    int tileSize = TImageCache::instance()->getMemUsage(
+        m_tiles[i]->id().toStdString());
+    size += tileSize ? tileSize : m_tiles[i]->getSize();
   }
   return size;
 }
 
+//------------------------------------------------------------------------------------------
+
+void TTileSet::compressTiles() const {
+  if (m_tiles.empty()) return;
+
+  std::vector<std::string> ids;
+  for (int i = 0; i < (int)m_tiles.size(); i++)
+    ids.push_back(m_tiles[i]->id().toStdString());
+  compressorExecutor().addTask(new TileCompressor(ids));
+}
+
 //******************************************************************************************
 
 TTileSetCM32::Tile::Tile() : TTileSet::Tile() {}
@@ -109,6 +192,35 @@ void TTileSetCM32::add(const TRasterP &ras, TRect rect) {
 
 //------------------------------------------------------------------------------------------
 
+void TTileSetCM32::shrinkToChanges(const TRasterCM32P &ras) {
+  Tiles tiles;
+  for (int i = 0; i < (int)m_tiles.size(); i++) {
+    Tile *tile = static_cast<Tile *>(m_tiles[i]);
+    TRasterCM32P oldRas;
+    tile->getRaster(oldRas);
+    if (!oldRas || !ras->getBounds().contains(tile->m_rasterBounds)) {
+      tiles.push_back(tile);
+      continue;
+    }
+
+    TRect rect =
+        getChangedRect(oldRas, ras->extract(tile->m_rasterBounds));
+    if (rect == oldRas->getBounds())
+      tiles.push_back(tile);
+    else {
+      if (!rect.isEmpty())
+        tiles.push_back(new Tile(oldRas->extract(rect)->clone(),
+                                 tile->m_rasterBounds.getP00() + rect.getP00()));
+      delete tile;
+    }
+  }
+  m_tiles.swap(tiles);
+
+  compressTiles();
+}
+
+//------------------------------------------------------------------------------------------
+
 const TTileSetCM32::Tile *TTileSetCM32::getTile(int index) const {
   assert(0 <= index && index < getTileCount());
   TTileSetCM32::Tile *tile = dynamic_cast<TTileSetCM32::Tile *>(m_tiles[index]);
@@ -187,6 +299,36 @@ void TTileSetFullColor::add(const TRasterP &ras, TRect rect) {
 
 //------------------------------------------------------------------------------------------
 
+void TTileSetFullColor::shrinkToChanges(const TRasterP &ras) {
+  Tiles tiles;
+  for (int i = 0; i < (int)m_tiles.size(); i++) {
+    Tile *tile = static_cast<Tile *>(m_tiles[i]);
+    TRasterP oldRas;
+    tile->getRaster(oldRas);
+    if (!oldRas || !ras->getBounds().contains(tile->m_rasterBounds) ||
+        oldRas->getPixelSize() != ras->getPixelSize()) {
+      tiles.push_back(tile);
+      continue;
+    }
+
+    TRect rect =
+        getChangedRect(oldRas, ras->extract(tile->m_rasterBounds));
+    if (rect == oldRas->getBounds())
+      tiles.push_back(tile);
+    else {
+      if (!rect.isEmpty())
+        tiles.push_back(new Tile(oldRas->extract(rect)->clone(),
+                                 tile->m_rasterBounds.getP00() + rect.getP00()));
+      delete tile;
+    }
+  }
+  m_tiles.swap(tiles);
+
+  compressTiles();
+}
+
+//------------------------------------------------------------------------------------------
+
 const TTileSetFullColor::Tile *TTileSetFullColor::getTile(int index) const {
   assert(0 <= index && index < getTileCount());
   TTileSetFullColor::Tile *tile =
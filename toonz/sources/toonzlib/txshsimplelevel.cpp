@@ -1007,6 +1007,43 @@ public:
 
 } loadingLevelRange;
 
+//-----------------------------------------------------------------------------
+
+// Level readers opened by TXshSimpleLevel::prefetchInfo(), by decoded path
+struct PrefetchedInfo {
+  TLevelReaderP m_lr;
+  TLevelP m_level;
+};
+
+QMutex PrefetchedInfosMutex;
+std::map<std::wstring, PrefetchedInfo> PrefetchedInfos;
+
+//-----------------------------------------------------------------------------
+
+//! Returns a reader for the specified path, storing its level info in
+//! \a level. A prefetched reader is taken over, if any.
+TLevelReaderP openLevelReader(const TFilePath &path, TLevelP &level) {
+  {
+    QMutexLocker locker(&PrefetchedInfosMutex);
+
+    std::map<std::wstring, PrefetchedInfo>::iterator it =
+        PrefetchedInfos.find(path.getWideString());
+    if (it != PrefetchedInfos.end()) {
+      TLevelReaderP lr = it->second.m_lr;
+      level            = it->second.m_level;
+      PrefetchedInfos.erase(it);
+
+      return lr;
+    }
+  }
+
+  TLevelReaderP lr(path);  // May throw
+  assert(lr);
+
+  level = lr->loadInfo();
+  return lr;
+}
+
 //-----------------------------------------------------------------------------
 }  // namespace
 //-----------------------------------------------------------------------------
@@ -1068,6 +1105,56 @@ static TFilePath getLevelPathAndSetNameWithPsdLevelName(
 
 // Nota: load() NON fa clearFrames(). si limita ad aggiungere le informazioni
 // relative ai frames su disco
+std::vector<TFilePath> TXshSimpleLevel::getInfoPaths() const {
+  std::vector<TFilePath> paths;
+  if (!getScene()) return paths;
+
+  if (m_scannedPath != TFilePath())
+    paths.push_back(getScene()->decodeFilePath(m_scannedPath));
+
+  // Old psd paths are fixed by load() itself
+  if (m_path.getType() != "psd" ||
+      getScene()->getVersionNumber().first >= 71)
+    paths.push_back(getScene()->decodeFilePath(m_path));
+
+  // Movie readers may go through an external process, keep them serial
+  std::vector<TFilePath>::iterator pt = paths.begin();
+  while (pt != paths.end())
+    pt = isMovieType(*pt) ? paths.erase(pt) : pt + 1;
+
+  return paths;
+}
+
+//-----------------------------------------------------------------------------
+
+void TXshSimpleLevel::prefetchInfo(const TFilePath &path) {
+  PrefetchedInfo info;
+  try {
+    if (!TSystem::doesExistFileOrLevel(path)) return;
+
+    info.m_lr    = TLevelReaderP(path);
+    info.m_level = info.m_lr->loadInfo();
+
+    // load() asks for the first frame's image info, too
+    if (info.m_level->getFrameCount() > 0)
+      info.m_lr->getImageInfo(info.m_level->begin()->first);
+  } catch (...) {
+    return;  // load() will meet the same failure, and deal with it
+  }
+
+  QMutexLocker locker(&PrefetchedInfosMutex);
+  PrefetchedInfos[path.getWideString()] = info;
+}
+
+//-----------------------------------------------------------------------------
+
+void TXshSimpleLevel::releasePrefetchedInfos() {
+  QMutexLocker locker(&PrefetchedInfosMutex);
+  PrefetchedInfos.clear();
+}
+
+//-----------------------------------------------------------------------------
+
 void TXshSimpleLevel::load() {
   getProperties()->setCreator("");
   QString creator;
@@ -1087,9 +1174,8 @@ void TXshSimpleLevel::load() {
     static const int ScannedCleanuppedMask = Scanned | Cleanupped;
     TFilePath path = getScene()->decodeFilePath(m_scannedPath);
     if (TSystem::doesExistFileOrLevel(path)) {
-      TLevelReaderP lr(path);
-      assert(lr);
-      TLevelP level = lr->loadInfo();
+      TLevelP level;
+      TLevelReaderP lr = openLevelReader(path, level);
       if (!checkCreatorString(creator = lr->getCreator()))
         getProperties()->setIsForbidden(true);
       else
@@ -1104,9 +1190,8 @@ void TXshSimpleLevel::load() {
 
     path = getScene()->decodeFilePath(m_path);
     if (TSystem::doesExistFileOrLevel(path)) {
-      TLevelReaderP lr(path);
-      assert(lr);
-      TLevelP level = lr->loadInfo();
+      TLevelP level;
+      TLevelReaderP lr = openLevelReader(path, level);
       if (getType() & FULLCOLOR_TYPE)
         setPalette(FullColorPalette::instance()->getPalette(getScene()));
       else
@@ -1136,10 +1221,9 @@ void TXshSimpleLevel::load() {
     getProperties()->setDirtyFlag(
         false);  // Level is now supposedly loaded from disk
 
-    TLevelReaderP lr(path);  // May throw
-    assert(lr);
+    TLevelP level;
+    TLevelReaderP lr = openLevelReader(path, level);  // May throw
 
-    TLevelP level = lr->loadInfo();
     if (level->getFrameCount() > 0) {
       const TImageInfo *info = lr->getImageInfo(level->begin()->first);
 
@@ -1081,24 +1081,25 @@ TSoundTrackP TXshSoundColumn::getOverallSoundTrack(int fromFrame, int toFrame,
     // comes later..)
     if ((levelStartFrame > toFrame && levelEndFrame > toFrame)) break;
 
-    // Extract the right soundTrack (using the offsets)
-    // (pay attention to convert it before)
-    TSoundTrackP s = soundLevel->getSoundTrack();
-    if (!s) continue;
-    TSoundTrackP soundTrack = TSop::convert(s, format);
+    // Extract the right soundTrack (using the offsets), then convert only
+    // the extracted samples: the level's whole track is never resampled
+    TSoundTrackP soundTrack = soundLevel->getSoundTrack();
+    if (!soundTrack) continue;
+
+    double srcSamplePerFrame = soundTrack->getSampleRate() / fps;
 
     int s0delta                              = 0;
     if (fromFrame > levelStartFrame) s0delta = fromFrame - levelStartFrame;
 
-    int s0 = (l->getStartOffset() + s0delta) * samplePerFrame;
+    int s0 = (l->getStartOffset() + s0delta) * srcSamplePerFrame;
 
     int s1delta                          = 0;
     if (toFrame < levelEndFrame) s1delta = levelEndFrame - toFrame;
     int s1 = (soundLevel->getFrameCount() - l->getEndOffset() - s1delta) *
-             samplePerFrame;
+             srcSamplePerFrame;
 
     if (s1 > 0 && s1 >= s0) {
-      soundTrack = soundTrack->extract(s0, s1);
+      soundTrack = TSop::convert(soundTrack->extract(s0, s1), format);
 
       // Copy the sound track
       overallSoundTrack->copy(
@@ -38,12 +38,23 @@
 #include "toonz/preferences.h"
 #include "toonz/sceneresources.h"
 #include "toonz/stage2.h"
+#include "toonz/toonzfolders.h"
 
 // TnzQt includes
 #include "toonzqt/gutil.h"
 
 #include "toonzqt/icongenerator.h"
 
+// Qt includes
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDir>
+#include <QImage>
+#include <QCryptographicHash>
+#include <QThread>
+#include <QTimer>
+
 //=============================================================================
 
 //===================================
@@ -194,6 +205,100 @@ void makeChessBackground(const TRaster32P &ras) {
   ras->unlock();
 }
 
+//-----------------------------------------------------------------------------
+
+// Icons generated from files are also kept on disk, as png files in the cache
+// folder. They are stored under a hash of the file path, its modification
+// time and size, the frame and the icon size, so that a file changed on disk
+// just gets a new entry.
+// Loading a stored icon touches its file, and the store is pruned to its size
+// limit once per session, least recently used icons first.
+
+const qint64 c_iconStoreBytes = 128 << 20;
+
+TFilePath iconStoreFolder;
+bool iconStoreInitialized = false;
+
+void pruneIconStore() {
+  QDir dir(iconStoreFolder.getQString());
+  QFileInfoList icons =
+      dir.entryInfoList(QStringList("*.png"), QDir::Files, QDir::Time);
+
+  // Most recently used first
+  qint64 bytes = 0;
+  for (int i = 0; i < icons.size(); ++i) {
+    bytes += icons[i].size();
+    if (bytes > c_iconStoreBytes) QFile::remove(icons[i].absoluteFilePath());
+  }
+}
+
+// Must be called in the main thread, before any icon is looked up
+void initIconStore() {
+  if (iconStoreInitialized) return;
+  iconStoreInitialized = true;
+
+  TFilePath cacheRoot = ToonzFolder::getCacheRootFolder();
+  if (!cacheRoot.isEmpty() && QDir(cacheRoot.getQString()).mkpath("icons")) {
+    iconStoreFolder = cacheRoot + "icons";
+    pruneIconStore();
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+TFilePath getStoredIconPath(const TFilePath &path, const TFrameId &fid,
+                            const TDimension &iconSize) {
+  TFilePath sourcePath = path;
+  if (path.isLevelName()) {
+    // frames of a sequence are separate files - the first one is not known
+    // without reading the folder
+    if (fid == TFrameId::NO_FRAME) return TFilePath();
+    sourcePath = path.withFrame(fid);
+  }
+
+  if (iconStoreFolder.isEmpty()) return TFilePath();
+
+  QFileInfo fi(sourcePath.getQString());
+  if (!fi.exists()) return TFilePath();
+
+  QString key = QString("%1|%2|%3|%4|%5x%6")
+                    .arg(fi.absoluteFilePath())
+                    .arg(fi.lastModified().toMSecsSinceEpoch())
+                    .arg(fi.size())
+                    .arg(QString::fromStdString(fid.expand()))
+                    .arg(iconSize.lx)
+                    .arg(iconSize.ly);
+  QByteArray hash =
+      QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex();
+  return iconStoreFolder + (hash.toStdString() + ".png");
+}
+
+//-----------------------------------------------------------------------------
+
+TRaster32P loadStoredIcon(const TFilePath &storedPath,
+                          const TDimension &iconSize) {
+  if (storedPath.isEmpty()) return TRaster32P();
+
+  QImage image;
+  if (!image.load(storedPath.getQString(), "PNG") ||
+      image.size() != QSize(iconSize.lx, iconSize.ly))
+    return TRaster32P();
+
+  try {
+    TSystem::touchFile(storedPath);
+  } catch (...) {
+  }
+
+  return rasterFromQImage(image.convertToFormat(QImage::Format_ARGB32));
+}
+
+//-----------------------------------------------------------------------------
+
+void storeIcon(const TFilePath &storedPath, const TRaster32P &icon) {
+  if (storedPath.isEmpty()) return;
+  rasterToQImage(icon).save(storedPath.getQString(), "PNG");
+}
+
 }  // namespace
 
 //=============================================================================
@@ -448,6 +553,8 @@ class IconRenderer : public TThread::Runnable {
 
   bool m_started;
   bool m_terminated;
+  bool m_fileRequest;
+  bool m_submitted;
 
 public:
   IconRenderer(const std::string &id, const TDimension &iconSize);
@@ -463,6 +570,8 @@ public:
 
   bool &hasStarted() { return m_started; }
   bool &wasTerminated() { return m_terminated; }
+  bool &isFileRequest() { return m_fileRequest; }
+  bool &isSubmitted() { return m_submitted; }
 };
 
 //-----------------------------------------------------------------------------
@@ -472,11 +581,15 @@ IconRenderer::IconRenderer(const std::string &id, const TDimension &iconSize)
     , m_iconSize(iconSize)
     , m_id(id)
     , m_started(false)
-    , m_terminated(false) {
+    , m_terminated(false)
+    , m_fileRequest(false)
+    , m_submitted(false) {
   connect(this, SIGNAL(started(TThread::RunnableP)), IconGenerator::instance(),
           SLOT(onStarted(TThread::RunnableP)));
   connect(this, SIGNAL(finished(TThread::RunnableP)), IconGenerator::instance(),
           SLOT(onFinished(TThread::RunnableP)));
+  connect(this, SIGNAL(exception(TThread::RunnableP)),
+          IconGenerator::instance(), SLOT(onException(TThread::RunnableP)));
   connect(this, SIGNAL(canceled(TThread::RunnableP)), IconGenerator::instance(),
           SLOT(onCanceled(TThread::RunnableP)), Qt::QueuedConnection);
   connect(this, SIGNAL(terminated(TThread::RunnableP)),
@@ -944,7 +1057,16 @@ public:
 
   static std::string getId(const TFilePath &path, const TFrameId &fid);
 
+  //! Returns true if the icon of the file is drawn with OpenGL, in which case
+  //! it is rendered in the icon generator's main thread.
+  static bool needsGLContext(const TFilePath &path);
+
   void run() override;
+
+private:
+  TRaster32P getStoredIcon(TRaster32P (*generate)(const TFilePath &,
+                                                  const TDimension &,
+                                                  const TFrameId &));
 };
 
 //-----------------------------------------------------------------------------
@@ -990,6 +1112,31 @@ std::string FileIconRenderer::getId(const TFilePath &path,
 
 //-----------------------------------------------------------------------------
 
+bool FileIconRenderer::needsGLContext(const TFilePath &path) {
+  std::string type(path.getType());
+  return type == "pli" || type == "mesh" || type == "tnz" || type == "tab";
+}
+
+//-----------------------------------------------------------------------------
+
+//! Returns the icon from the persistent icon store, generating and storing it
+//! in case it is missing.
+TRaster32P FileIconRenderer::getStoredIcon(
+    TRaster32P (*generate)(const TFilePath &, const TDimension &,
+                           const TFrameId &)) {
+  TDimension iconSize(getIconSize());
+  TFilePath storedPath = ::getStoredIconPath(m_path, m_fid, iconSize);
+
+  TRaster32P icon = ::loadStoredIcon(storedPath, iconSize);
+  if (!icon) {
+    icon = generate(m_path, iconSize, m_fid);
+    if (icon) ::storeIcon(storedPath, icon);
+  }
+  return icon;
+}
+
+//-----------------------------------------------------------------------------
+
 TRaster32P IconGenerator::generateVectorFileIcon(const TFilePath &path,
                                                  const TDimension &iconSize,
                                                  const TFrameId &fid) {
@@ -1179,8 +1326,7 @@ void FileIconRenderer::run() {
       iconRaster = IconGenerator::generateSceneFileIcon(m_path, iconSize,
                                                         m_fid.getNumber() - 1);
     else if (type == "pli")
-      iconRaster =
-          IconGenerator::generateVectorFileIcon(m_path, iconSize, m_fid);
+      iconRaster = getStoredIcon(IconGenerator::generateVectorFileIcon);
     else if (type == "tpl") {
       QImage palette(":Resources/paletteicon.svg");
       setIcon(rasterFromQImage(palette));
@@ -1216,10 +1362,9 @@ void FileIconRenderer::run() {
       setIcon(rasterFromQPixmap(psdPath));
       return;
     } else if (type == "mesh")
-      iconRaster = IconGenerator::generateMeshFileIcon(m_path, iconSize, m_fid);
+      iconRaster = getStoredIcon(IconGenerator::generateMeshFileIcon);
     else if (TFileType::isViewable(TFileType::getInfo(m_path)) || type == "tlv")
-      iconRaster =
-          IconGenerator::generateRasterFileIcon(m_path, iconSize, m_fid);
+      iconRaster = getStoredIcon(IconGenerator::generateRasterFileIcon);
     else if (type == "mpath") {
       QPixmap motionPath(svgToPixmap(":Resources/motionpath_fileicon.svg",
                                      QSize(iconSize.lx, iconSize.ly),
@@ -1335,9 +1480,20 @@ void SceneIconRenderer::run() { setIcon(generateIcon(getIconSize())); }
 //
 //-----------------------------------
 
-IconGenerator::IconGenerator() : m_iconSize(FilmstripIconSize) {
+IconGenerator::IconGenerator()
+    : m_iconSize(FilmstripIconSize)
+    , m_requestBatch(0)
+    , m_requestBatchOpen(false)
+    , m_submittedRequests(0)
+    , m_submittedFileRequests(0) {
   m_executor.setMaxActiveTasks(1);  // Only one thread to render icons...
   m_executor.setDedicatedThreads(true);
+
+  // ... except for file icons which need no OpenGL context: decoding them is
+  // mostly waiting on disk (or network) reads
+  m_fileExecutor.setMaxActiveTasks(
+      std::max(1, QThread::idealThreadCount() / 2));
+  m_fileExecutor.setDedicatedThreads(true);
 }
 
 //-----------------------------------------------------------------------------
@@ -1376,13 +1532,81 @@ TOfflineGL *IconGenerator::getOfflineGLContext() {
 //-----------------------------------------------------------------------------
 
 void IconGenerator::addTask(const std::string &id,
-                            TThread::RunnableP iconRenderer) {
+                            TThread::RunnableP iconRenderer, bool noGL) {
+  // Requests made in the same event loop cycle - typically, while repainting
+  // the visible items of a view - form a batch, and later batches are
+  // rendered first. So the icons on screen come before those requested by
+  // views which have been scrolled away in the meantime.
+  // The order is kept here rather than through scheduling priorities, which
+  // would rank icons above the other tasks of the shared thread queue.
+  if (!m_requestBatchOpen) {
+    m_requestBatchOpen = true;
+    if (m_pendingRequests.empty() && m_pendingFileRequests.empty())
+      m_requestBatch = 0;
+    ++m_requestBatch;
+    QTimer::singleShot(0, this, SLOT(closeRequestBatch()));
+  }
+  static_cast<IconRenderer *>(iconRenderer.getPointer())->isFileRequest() =
+      noGL;
+
   iconsMap.insert(id);
-  m_executor.addTask(iconRenderer);
+  (noGL ? m_pendingFileRequests : m_pendingRequests)
+      .insert(std::make_pair(-m_requestBatch, iconRenderer));
+
+  submitRequests();
+}
+
+//-----------------------------------------------------------------------------
+
+namespace {
+
+// Passes the executor the first pending requests, up to the number of tasks
+// it runs at once
+void submitPendingRequests(
+    TThread::Executor &executor,
+    std::multimap<int, TThread::RunnableP> &pendingRequests,
+    int &submittedRequests) {
+  while (!pendingRequests.empty() &&
+         submittedRequests < executor.maxActiveTasks()) {
+    TThread::RunnableP iconRenderer = pendingRequests.begin()->second;
+    pendingRequests.erase(pendingRequests.begin());
+
+    static_cast<IconRenderer *>(iconRenderer.getPointer())->isSubmitted() =
+        true;
+    ++submittedRequests;
+    executor.addTask(iconRenderer);
+  }
+}
+
+}  // namespace
+
+//-----------------------------------------------------------------------------
+
+void IconGenerator::submitRequests() {
+  submitPendingRequests(m_executor, m_pendingRequests, m_submittedRequests);
+  submitPendingRequests(m_fileExecutor, m_pendingFileRequests,
+                        m_submittedFileRequests);
+}
+
+//-----------------------------------------------------------------------------
+
+//! Makes room in the executor of a request which has been finished or
+//! canceled - running requests may report both.
+void IconGenerator::onRequestDone(TThread::RunnableP iconRenderer) {
+  IconRenderer *ir = static_cast<IconRenderer *>(iconRenderer.getPointer());
+  if (!ir->isSubmitted()) return;
+
+  ir->isSubmitted() = false;
+  --(ir->isFileRequest() ? m_submittedFileRequests : m_submittedRequests);
+  submitRequests();
 }
 
 //-----------------------------------------------------------------------------
 
+void IconGenerator::closeRequestBatch() { m_requestBatchOpen = false; }
+
+//-----------------------------------------------------------------------------
+
 QPixmap IconGenerator::getIcon(TXshLevel *xl, const TFrameId &fid,
                                bool filmStrip, bool onDemand) {
   if (!xl) return QPixmap();
@@ -1700,7 +1924,9 @@ QPixmap IconGenerator::getIcon(const TFilePath &path, const TFrameId &fid) {
   // with high-dpi (i.e. devPixRatio > 1.0).
   if (::getIcon(id, pix, 0, fileIconSize)) return pix;
 
-  addTask(id, new FileIconRenderer(fileIconSize, path, fid));
+  initIconStore();
+  addTask(id, new FileIconRenderer(fileIconSize, path, fid),
+          !FileIconRenderer::needsGLContext(path));
 
   return QPixmap();
 }
@@ -1710,7 +1936,9 @@ QPixmap IconGenerator::getIcon(const TFilePath &path, const TFrameId &fid) {
 void IconGenerator::invalidate(const TFilePath &path, const TFrameId &fid) {
   std::string id = FileIconRenderer::getId(path, fid);
   removeIcon(id);
-  addTask(id, new FileIconRenderer(TDimension(80, 60), path, fid));
+  initIconStore();
+  addTask(id, new FileIconRenderer(TDimension(80, 60), path, fid),
+          !FileIconRenderer::needsGLContext(path));
 }
 
 //-----------------------------------------------------------------------------
@@ -1754,7 +1982,20 @@ void IconGenerator::remap(const std::string &newIconId,
 
 //-----------------------------------------------------------------------------
 
-void IconGenerator::clearRequests() { m_executor.cancelAll(); }
+void IconGenerator::clearRequests() {
+  // Pending requests were never started, as for canceled ones
+  std::multimap<int, TThread::RunnableP>::iterator it;
+  for (it = m_pendingRequests.begin(); it != m_pendingRequests.end(); ++it)
+    removeIcon(static_cast<IconRenderer *>(it->second.getPointer())->getId());
+  for (it = m_pendingFileRequests.begin(); it != m_pendingFileRequests.end();
+       ++it)
+    removeIcon(static_cast<IconRenderer *>(it->second.getPointer())->getId());
+  m_pendingRequests.clear();
+  m_pendingFileRequests.clear();
+
+  m_executor.cancelAll();
+  m_fileExecutor.cancelAll();
+}
 
 //-----------------------------------------------------------------------------
 
@@ -1790,6 +2031,8 @@ void IconGenerator::onCanceled(TThread::RunnableP iconRenderer) {
   if (!ir->hasStarted()) {
     removeIcon(ir->getId());
   }
+
+  onRequestDone(iconRenderer);
 }
 
 //-----------------------------------------------------------------------------
@@ -1797,6 +2040,8 @@ void IconGenerator::onCanceled(TThread::RunnableP iconRenderer) {
 void IconGenerator::onFinished(TThread::RunnableP iconRenderer) {
   IconRenderer *ir = static_cast<IconRenderer *>(iconRenderer.getPointer());
 
+  onRequestDone(iconRenderer);
+
   // if the icon was generated in TToonzImage format, cache it instead
   ToonzImageIconRenderer *tir = dynamic_cast<ToonzImageIconRenderer *>(ir);
   if (tir) {
@@ -1823,6 +2068,8 @@ void IconGenerator::onFinished(TThread::RunnableP iconRenderer) {
 void IconGenerator::onException(TThread::RunnableP iconRenderer) {
   IconRenderer *ir = static_cast<IconRenderer *>(iconRenderer.getPointer());
 
+  onRequestDone(iconRenderer);
+
   if (ir->wasTerminated()) m_iconsTerminationLoop.quit();
 }
 